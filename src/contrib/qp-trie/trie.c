@@ -1015,6 +1015,56 @@ int trie_apply(trie_t *tbl, int (*f)(trie_val_t *, void *), void *d)
 	return apply_nodes(&tbl->root, f, d);
 }
 
+/*! \brief Maximum number of subtries the trie can be split into. */
+#define SPLIT_MAX 256
+
+/*!
+ * \brief Split the trie into at most max subtries, in order.
+ *
+ * Branches are expanded level by level until there are enough subtries.
+ */
+static uint split_nodes(node_t *root, node_t **out, uint max)
+{
+	assert(max <= SPLIT_MAX);
+	out[0] = root;
+	uint count = 1;
+	bool expanded = true;
+	while (count < max && expanded) {
+		node_t *next[SPLIT_MAX];
+		uint next_count = 0;
+		expanded = false;
+		for (uint i = 0; i < count; ++i) {
+			node_t *t = out[i];
+			uint n = isbranch(t) ? branch_weight(t) : 1;
+			if (n > 1 && next_count + n + (count - i - 1) <= max) {
+				for (uint j = 0; j < n; ++j)
+					next[next_count++] = twig(t, j);
+				expanded = true;
+			} else {
+				next[next_count++] = t;
+			}
+		}
+		memcpy(out, next, next_count * sizeof(*next));
+		count = next_count;
+	}
+	return count;
+}
+
+int trie_apply_part(trie_t *tbl, uint part, uint parts,
+                    int (*f)(trie_val_t *, void *), void *d)
+{
+	assert(tbl && f && part < parts);
+	if (!tbl->weight)
+		return KNOT_EOK;
+	node_t *nodes[SPLIT_MAX];
+	uint count = split_nodes(&tbl->root, nodes, MIN(parts, SPLIT_MAX));
+	uint from = (uint64_t)count * part / parts;
+	uint to = (uint64_t)count * (part + 1) / parts;
+	for (uint i = from; i < to; ++i)
+		ERR_RETURN(apply_nodes(nodes[i], f, d));
+	return KNOT_EOK;
+}
+
 /* These are all thin wrappers around static Tns* functions. */
 trie_it_t* trie_it_begin(trie_t *tbl)
 {
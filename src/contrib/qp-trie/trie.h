@@ -107,6 +107,18 @@ int trie_get_leq(trie_t *tbl, const trie_key_t *key, uint32_t len, trie_val_t **
  */
 int trie_apply(trie_t *tbl, int (*f)(trie_val_t *, void *), void *d);
 
+/*!
+ * \brief Apply a function to every trie_val_t in one of the parts, in order.
+ *
+ * The trie is split along its branches into (at most) the given number of
+ * disjoint parts, each covering a contiguous range of keys. Applying to
+ * all the parts is equivalent to trie_apply().
+ *
+ * \return KNOT_EOK if success or KNOT_E* if error.
+ */
+int trie_apply_part(trie_t *tbl, unsigned part, unsigned parts,
+                    int (*f)(trie_val_t *, void *), void *d);
+
 /*!
  * \brief Remove an item, returning KNOT_EOK if succeeded or KNOT_ENOENT if not found.
  *
@@ -20,6 +20,8 @@
 
 #pragma once
 
+#include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 /*!
@@ -50,3 +52,22 @@ static inline uint8_t knot_tolower(uint8_t c) {
 
 	return tolower_table[c];
 }
+
+/*!
+ * \brief Bulk ASCII lowercasing operations.
+ *
+ * Label length octets of a domain name in wire format are never changed by
+ * lowercasing, so these can be applied to whole names.
+ */
+struct knot_tolower_api {
+	/*! \brief Copy \a len bytes converted to lowercase (\a dst may equal \a src). */
+	void (*copy)(uint8_t *dst, const uint8_t *src, size_t len);
+	/*! \brief Compare \a len bytes case-insensitively. */
+	bool (*equal)(const uint8_t *a, const uint8_t *b, size_t len);
+};
+
+/*! \brief The best implementation for the CPU, selected at startup. */
+extern struct knot_tolower_api KNOT_TOLOWER;
+
+/*! \brief Particular implementations (AVX2 one is empty if not compiled in). */
+extern const struct knot_tolower_api KNOT_TOLOWER_GENERIC, KNOT_TOLOWER_AVX2;
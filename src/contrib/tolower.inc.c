@@ -0,0 +1,139 @@
+/*  Copyright (C) 2024 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Bulk lowercasing kernels, included by tolower-*.c with USE_* defined.
+ *
+ * A byte is uppercase iff (c - 'A') as unsigned is at most 'Z' - 'A',
+ * such bytes get the 0x20 bit set.
+ */
+
+#include "contrib/tolower.h"
+
+#if USE_AVX2
+	#include <immintrin.h>
+	#define VEC_SIZE 32
+	typedef __m256i vec_t;
+
+	static inline vec_t vec_load(const uint8_t *p)
+	{
+		return _mm256_loadu_si256((const vec_t *)p);
+	}
+
+	static inline void vec_store(uint8_t *p, vec_t v)
+	{
+		_mm256_storeu_si256((vec_t *)p, v);
+	}
+
+	static inline vec_t vec_lower(vec_t v)
+	{
+		vec_t off = _mm256_sub_epi8(v, _mm256_set1_epi8('A'));
+		vec_t upper = _mm256_cmpeq_epi8(_mm256_min_epu8(off, _mm256_set1_epi8('Z' - 'A')), off);
+		return _mm256_or_si256(v, _mm256_and_si256(upper, _mm256_set1_epi8(0x20)));
+	}
+
+	static inline bool vec_equal(vec_t a, vec_t b)
+	{
+		return (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(a, b)) == UINT32_MAX;
+	}
+#elif USE_SSE2
+	#include <emmintrin.h>
+	#define VEC_SIZE 16
+	typedef __m128i vec_t;
+
+	static inline vec_t vec_load(const uint8_t *p)
+	{
+		return _mm_loadu_si128((const vec_t *)p);
+	}
+
+	static inline void vec_store(uint8_t *p, vec_t v)
+	{
+		_mm_storeu_si128((vec_t *)p, v);
+	}
+
+	static inline vec_t vec_lower(vec_t v)
+	{
+		vec_t off = _mm_sub_epi8(v, _mm_set1_epi8('A'));
+		vec_t upper = _mm_cmpeq_epi8(_mm_min_epu8(off, _mm_set1_epi8('Z' - 'A')), off);
+		return _mm_or_si128(v, _mm_and_si128(upper, _mm_set1_epi8(0x20)));
+	}
+
+	static inline bool vec_equal(vec_t a, vec_t b)
+	{
+		return _mm_movemask_epi8(_mm_cmpeq_epi8(a, b)) == 0xFFFF;
+	}
+#elif USE_NEON
+	#include <arm_neon.h>
+	#define VEC_SIZE 16
+	typedef uint8x16_t vec_t;
+
+	static inline vec_t vec_load(const uint8_t *p)
+	{
+		return vld1q_u8(p);
+	}
+
+	static inline void vec_store(uint8_t *p, vec_t v)
+	{
+		vst1q_u8(p, v);
+	}
+
+	static inline vec_t vec_lower(vec_t v)
+	{
+		uint8x16_t upper = vcleq_u8(vsubq_u8(v, vdupq_n_u8('A')), vdupq_n_u8('Z' - 'A'));
+		return vorrq_u8(v, vandq_u8(upper, vdupq_n_u8(0x20)));
+	}
+
+	static inline bool vec_equal(vec_t a, vec_t b)
+	{
+		return vminvq_u8(vceqq_u8(a, b)) == UINT8_MAX;
+	}
+#endif
+
+static void tolower_copy(uint8_t *dst, const uint8_t *src, size_t len)
+{
+	size_t i = 0;
+#ifdef VEC_SIZE
+	for (; i + VEC_SIZE <= len; i += VEC_SIZE) {
+		vec_store(dst + i, vec_lower(vec_load(src + i)));
+	}
+#endif
+	for (; i < len; i++) {
+		dst[i] = knot_tolower(src[i]);
+	}
+}
+
+static bool tolower_equal(const uint8_t *a, const uint8_t *b, size_t len)
+{
+	size_t i = 0;
+#ifdef VEC_SIZE
+	for (; i + VEC_SIZE <= len; i += VEC_SIZE) {
+		if (!vec_equal(vec_lower(vec_load(a + i)), vec_lower(vec_load(b + i)))) {
+			return false;
+		}
+	}
+#endif
+	for (; i < len; i++) {
+		if (knot_tolower(a[i]) != knot_tolower(b[i])) {
+			return false;
+		}
+	}
+	return true;
+}
+
+#define KNOT_TOLOWER_INITIALIZER { \
+	.copy = tolower_copy, \
+	.equal = tolower_equal, \
+}
@@ -194,6 +194,43 @@ int fdset_remove(fdset_t *set, const unsigned idx)
 	return KNOT_EOK;
 }
 
+int fdset_set_events(fdset_t *set, const unsigned idx, const fdset_event_t events)
+{
+	if (set == NULL || idx >= set->n) {
+		return KNOT_EINVAL;
+	}
+
+#ifdef HAVE_EPOLL
+	if (set->ev[idx].events == events) {
+		return KNOT_EOK;
+	}
+	struct epoll_event ev = {
+		.data.u64 = idx,
+		.events = events
+	};
+	if (epoll_ctl(set->pfd, EPOLL_CTL_MOD, set->ev[idx].data.fd, &ev) != 0) {
+		return knot_map_errno();
+	}
+	set->ev[idx].events = events;
+#elif HAVE_KQUEUE
+	if (set->ev[idx].filter == events) {
+		return KNOT_EOK;
+	}
+	/* Read and write are distinct filters, replace the old one. */
+	struct kevent ev[2];
+	EV_SET(&ev[0], set->ev[idx].ident, set->ev[idx].filter, EV_DELETE, 0, 0, NULL);
+	EV_SET(&ev[1], set->ev[idx].ident, events, EV_ADD, 0, 0, (void *)(intptr_t)idx);
+	if (kevent(set->pfd, ev, 2, NULL, 0, NULL) < 0) {
+		return knot_map_errno();
+	}
+	set->ev[idx] = ev[1];
+#else
+	set->pfd[idx].events = events;
+#endif
+
+	return KNOT_EOK;
+}
+
 int fdset_poll(fdset_t *set, fdset_it_t *it, const unsigned offset, const int timeout_ms)
 {
 	if (it == NULL) {
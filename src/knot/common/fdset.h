@@ -139,6 +139,19 @@ int fdset_add(fdset_t *set, const int fd, const fdset_event_t events, void *ctx)
  */
 int fdset_remove(fdset_t *set, const unsigned idx);
 
+/*!
+ * \brief Change the watched events of a file descriptor.
+ *
+ * \note Not to be used on a file descriptor removed via iterator.
+ *
+ * \param set     Target set.
+ * \param idx     Index of the file descriptor.
+ * \param events  New mask of watched events.
+ *
+ * \return Error code, KNOT_EOK if success.
+ */
+int fdset_set_events(fdset_t *set, const unsigned idx, const fdset_event_t events);
+
 /*!
  * \brief Wait for receive events.
  *
@@ -386,6 +399,26 @@ inline static bool fdset_it_is_pollin(const fdset_it_t *it)
 #endif
 }
 
+/*!
+ * \brief Decide if event referenced by iterator is POLLOUT event.
+ *
+ * \param it  Target iterator.
+ *
+ * \retval Logical flag represents 'POLLOUT' event received.
+ */
+inline static bool fdset_it_is_pollout(const fdset_it_t *it)
+{
+	assert(it);
+
+#ifdef HAVE_EPOLL
+	return it->ptr->events & EPOLLOUT;
+#elif HAVE_KQUEUE
+	return it->ptr->filter == EVFILT_WRITE;
+#else
+	return it->set->pfd[it->idx].revents & POLLOUT;
+#endif
+}
+
 /*!
  * \brief Decide if event referenced by iterator is error event.
  *
@@ -126,6 +126,7 @@ static void init_cache(
 	static bool   first_init = true;
 	static bool   running_tcp_reuseport;
 	static bool   running_socket_affinity;
+	static unsigned running_udp_backend;
 	static bool   running_xdp_udp;
 	static bool   running_xdp_tcp;
 	static uint16_t running_xdp_quic;
@@ -137,6 +138,7 @@ static void init_cache(
 	static size_t running_tcp_threads;
 	static size_t running_xdp_threads;
 	static size_t running_bg_threads;
+	static size_t running_xfr_threads;
 	static size_t running_quic_clients;
 	static size_t running_quic_outbufs;
 	static size_t running_quic_idle;
@@ -144,6 +146,8 @@ static void init_cache(
 	if (first_init || reinit_cache) {
 		running_tcp_reuseport = conf_get_bool(conf, C_SRV, C_TCP_REUSEPORT);
 		running_socket_affinity = conf_get_bool(conf, C_SRV, C_SOCKET_AFFINITY);
+		conf_val_t backend_val = conf_get(conf, C_SRV, C_UDP_BACKEND);
+		running_udp_backend = conf_opt(&backend_val);
 		running_xdp_udp = conf_get_bool(conf, C_XDP, C_UDP);
 		running_xdp_tcp = conf_get_bool(conf, C_XDP, C_TCP);
 		running_xdp_quic = 0;
@@ -158,6 +162,7 @@ static void init_cache(
 		running_tcp_threads = conf_tcp_threads(conf);
 		running_xdp_threads = conf_xdp_threads(conf);
 		running_bg_threads = conf_bg_threads(conf);
+		running_xfr_threads = conf_get_int(conf, C_SRV, C_XFR_WORKERS);
 		running_quic_clients = conf_get_int(conf, C_SRV, C_QUIC_MAX_CLIENTS);
 		running_quic_outbufs = conf_get_int(conf, C_SRV, C_QUIC_OUTBUF_MAX_SIZE);
 		running_quic_idle = conf_get_int(conf, C_SRV, C_QUIC_IDLE_CLOSE);
@@ -199,6 +204,8 @@ static void init_cache(
 
 	conf->cache.srv_socket_affinity = running_socket_affinity;
 
+	conf->cache.srv_udp_backend = running_udp_backend;
+
 	val = conf_get(conf, C_SRV, C_DBUS_EVENT);
 	while (val.code == KNOT_EOK) {
 		conf->cache.srv_dbus_event |= conf_opt(&val);
@@ -213,6 +220,11 @@ static void init_cache(
 
 	conf->cache.srv_bg_threads = running_bg_threads;
 
+	conf->cache.srv_xfr_threads = running_xfr_threads;
+
+	val = conf_get(conf, C_SRV, C_XFR_ZONE_LIMIT);
+	conf->cache.srv_xfr_zone_limit = conf_int(&val);
+
 	conf->cache.srv_tcp_max_clients = conf_tcp_max_clients(conf);
 
 	val = conf_get(conf, C_XDP, C_TCP_MAX_CLIENTS);
@@ -38,9 +38,12 @@
 #define CONF_MAX_TCP_WORKERS	256
 /*! Maximum number of background workers. */
 #define CONF_MAX_BG_WORKERS	512
+/*! Maximum number of transfer workers. */
+#define CONF_MAX_XFR_WORKERS	64
 /*! Maximum number of concurrent DB readers. */
 #define CONF_MAX_DB_READERS	(CONF_MAX_UDP_WORKERS + CONF_MAX_TCP_WORKERS + \
-				 CONF_MAX_BG_WORKERS + 10 + 128 /* Utils, XDP workers */)
+				 CONF_MAX_BG_WORKERS + CONF_MAX_XFR_WORKERS + \
+				 10 + 128 /* Utils, XDP workers */)
 
 /*! Configuration specific logging. */
 #define CONF_LOG(severity, msg, ...) do { \
@@ -149,6 +152,8 @@ typedef struct {
 		size_t srv_tcp_threads;
 		size_t srv_xdp_threads;
 		size_t srv_bg_threads;
+		size_t srv_xfr_threads;
+		unsigned srv_xfr_zone_limit;
 		size_t srv_tcp_max_clients;
 		size_t xdp_tcp_max_clients;
 		size_t xdp_tcp_inbuf_max_size;
@@ -168,6 +173,7 @@ typedef struct {
 		uint16_t xdp_ring_size;
 		uint16_t xdp_busypoll_budget;
 		uint16_t xdp_busypoll_timeout;
+		unsigned srv_udp_backend;
 		int ctl_timeout;
 		bool xdp_udp;
 		bool xdp_tcp;
@@ -23,6 +23,7 @@
 #include "knot/conf/confio.h"
 #include "knot/conf/tools.h"
 #include "knot/common/log.h"
+#include "knot/journal/journal_shard.h"
 #include "knot/updates/acl.h"
 #include "knot/zone/zone-load.h"
 #include "libknot/rrtype/opt.h"
@@ -195,6 +196,12 @@ static const knot_lookup_t catalog_roles[] = {
 	{ 0, NULL }
 };
 
+static const knot_lookup_t udp_backends[] = {
+	{ UDP_BACKEND_MMSG,     "mmsg" },
+	{ UDP_BACKEND_IO_URING, "io-uring" },
+	{ 0, NULL }
+};
+
 static const knot_lookup_t dbus_events[] = {
 	{ DBUS_EVENT_NONE,            "none" },
 	{ DBUS_EVENT_RUNNING,         "running" },
@@ -222,6 +229,8 @@ static const yp_item_t desc_server[] = {
 	{ C_UDP_WORKERS,          YP_TINT,  YP_VINT = { 1, CONF_MAX_UDP_WORKERS, YP_NIL } },
 	{ C_TCP_WORKERS,          YP_TINT,  YP_VINT = { 1, CONF_MAX_TCP_WORKERS, YP_NIL } },
 	{ C_BG_WORKERS,           YP_TINT,  YP_VINT = { 1, CONF_MAX_BG_WORKERS, YP_NIL } },
+	{ C_XFR_WORKERS,          YP_TINT,  YP_VINT = { 0, CONF_MAX_XFR_WORKERS, 0 } },
+	{ C_XFR_ZONE_LIMIT,       YP_TINT,  YP_VINT = { 0, INT32_MAX, 0 } },
 	{ C_ASYNC_START,          YP_TBOOL, YP_VNONE },
 	{ C_TCP_IDLE_TIMEOUT,     YP_TINT,  YP_VINT = { 1, INT32_MAX, 10, YP_STIME } },
 	{ C_TCP_IO_TIMEOUT,       YP_TINT,  YP_VINT = { 0, INT32_MAX, 500 } },
@@ -236,6 +245,7 @@ static const yp_item_t desc_server[] = {
 	{ C_RMT_POOL_TIMEOUT,     YP_TINT,  YP_VINT = { 1, INT32_MAX, 5, YP_STIME } },
 	{ C_RMT_RETRY_DELAY,      YP_TINT,  YP_VINT = { 0, INT32_MAX, 0 } },
 	{ C_SOCKET_AFFINITY,      YP_TBOOL, YP_VNONE },
+	{ C_UDP_BACKEND,          YP_TOPT,  YP_VOPT = { udp_backends, UDP_BACKEND_MMSG } },
 	{ C_UDP_MAX_PAYLOAD,      YP_TINT,  YP_VINT = { KNOT_EDNS_MIN_DNSSEC_PAYLOAD,
 	                                                KNOT_EDNS_MAX_UDP_PAYLOAD,
 	                                                1232, YP_SSIZE } },
@@ -308,21 +318,23 @@ static const yp_item_t desc_stats[] = {
 };
 
 static const yp_item_t desc_database[] = {
-	{ C_STORAGE,             YP_TSTR,  YP_VSTR = { STORAGE_DIR } },
-	{ C_JOURNAL_DB,          YP_TSTR,  YP_VSTR = { "journal" } },
-	{ C_JOURNAL_DB_MODE,     YP_TOPT,  YP_VOPT = { journal_modes, JOURNAL_MODE_ROBUST } },
-	{ C_JOURNAL_DB_MAX_SIZE, YP_TINT,  YP_VINT = { MEGA(1), VIRT_MEM_LIMIT(TERA(100)),
-	                                               VIRT_MEM_LIMIT(GIGA(20)), YP_SSIZE } },
-	{ C_KASP_DB,             YP_TSTR,  YP_VSTR = { "keys" } },
-	{ C_KASP_DB_MAX_SIZE,    YP_TINT,  YP_VINT = { MEGA(5), VIRT_MEM_LIMIT(GIGA(100)),
-	                                               MEGA(500), YP_SSIZE } },
-	{ C_TIMER_DB,            YP_TSTR,  YP_VSTR = { "timers" } },
-	{ C_TIMER_DB_MAX_SIZE,   YP_TINT,  YP_VINT = { MEGA(1), VIRT_MEM_LIMIT(GIGA(100)),
-	                                               MEGA(100), YP_SSIZE } },
-	{ C_CATALOG_DB,          YP_TSTR,  YP_VSTR = { "catalog" } },
-	{ C_CATALOG_DB_MAX_SIZE, YP_TINT,  YP_VINT = { MEGA(5), VIRT_MEM_LIMIT(GIGA(100)),
-	                                               VIRT_MEM_LIMIT(GIGA(20)), YP_SSIZE } },
-	{ C_COMMENT,             YP_TSTR,  YP_VNONE },
+	{ C_STORAGE,                 YP_TSTR,  YP_VSTR = { STORAGE_DIR } },
+	{ C_JOURNAL_DB,              YP_TSTR,  YP_VSTR = { "journal" } },
+	{ C_JOURNAL_DB_MODE,         YP_TOPT,  YP_VOPT = { journal_modes, JOURNAL_MODE_ROBUST } },
+	{ C_JOURNAL_DB_MAX_SIZE,     YP_TINT,  YP_VINT = { MEGA(1), VIRT_MEM_LIMIT(TERA(100)),
+	                                                   VIRT_MEM_LIMIT(GIGA(20)), YP_SSIZE } },
+	{ C_JOURNAL_DB_GROUP_COMMIT, YP_TINT,  YP_VINT = { 0, 1000, 0 } },
+	{ C_JOURNAL_DB_SHARDS,       YP_TINT,  YP_VINT = { 1, JOURNAL_SHARDS_MAX, 1 } },
+	{ C_KASP_DB,                 YP_TSTR,  YP_VSTR = { "keys" } },
+	{ C_KASP_DB_MAX_SIZE,        YP_TINT,  YP_VINT = { MEGA(5), VIRT_MEM_LIMIT(GIGA(100)),
+	                                                   MEGA(500), YP_SSIZE } },
+	{ C_TIMER_DB,                YP_TSTR,  YP_VSTR = { "timers" } },
+	{ C_TIMER_DB_MAX_SIZE,       YP_TINT,  YP_VINT = { MEGA(1), VIRT_MEM_LIMIT(GIGA(100)),
+	                                                   MEGA(100), YP_SSIZE } },
+	{ C_CATALOG_DB,              YP_TSTR,  YP_VSTR = { "catalog" } },
+	{ C_CATALOG_DB_MAX_SIZE,     YP_TINT,  YP_VINT = { MEGA(5), VIRT_MEM_LIMIT(GIGA(100)),
+	                                                   VIRT_MEM_LIMIT(GIGA(20)), YP_SSIZE } },
+	{ C_COMMENT,                 YP_TSTR,  YP_VNONE },
 	{ NULL }
 };
 
@@ -477,14 +489,20 @@ static const yp_item_t desc_policy[] = {
 	{ C_DEFAULT_TTL,         YP_TINT,  YP_VINT = { 1, INT32_MAX, DEFAULT_TTL, YP_STIME }, FLAGS }, \
 	{ C_ZONEFILE_SYNC,       YP_TINT,  YP_VINT = { -1, INT32_MAX, 0, YP_STIME } }, \
 	{ C_ZONEFILE_LOAD,       YP_TOPT,  YP_VOPT = { zonefile_load, ZONEFILE_LOAD_WHOLE } }, \
+	{ C_ZONEFILE_SNAP,       YP_TBOOL, YP_VNONE }, \
 	{ C_JOURNAL_CONTENT,     YP_TOPT,  YP_VOPT = { journal_content, JOURNAL_CONTENT_CHANGES }, FLAGS }, \
 	{ C_JOURNAL_MAX_USAGE,   YP_TINT,  YP_VINT = { KILO(40), SSIZE_MAX, MEGA(100), YP_SSIZE } }, \
 	{ C_JOURNAL_MAX_DEPTH,   YP_TINT,  YP_VINT = { 2, SSIZE_MAX, 20 } }, \
+	{ C_JOURNAL_COMPRESSION, YP_TBOOL, YP_VNONE }, \
 	{ C_IXFR_BENEVOLENT,     YP_TBOOL, YP_VNONE }, \
 	{ C_IXFR_BY_ONE,         YP_TBOOL, YP_VNONE }, \
 	{ C_IXFR_FROM_AXFR,      YP_TBOOL, YP_VNONE }, \
 	{ C_ZONE_MAX_SIZE,       YP_TINT,  YP_VINT = { 0, SSIZE_MAX, SSIZE_MAX, YP_SSIZE }, FLAGS }, \
 	{ C_ADJUST_THR,          YP_TINT,  YP_VINT = { 1, UINT16_MAX, 1 } }, \
+	{ C_ANS_CACHE,           YP_TINT,  YP_VINT = { 0, UINT32_MAX, 0 } }, \
+	{ C_AXFR_CACHE,          YP_TBOOL, YP_VNONE }, \
+	{ C_NSEC3_CACHE,         YP_TINT,  YP_VINT = { 0, UINT32_MAX, 0 } }, \
+	{ C_RRSIG_INDEX,         YP_TBOOL, YP_VNONE }, \
 	{ C_DNSSEC_SIGNING,      YP_TBOOL, YP_VNONE, FLAGS }, \
 	{ C_DNSSEC_VALIDATION,   YP_TBOOL, YP_VNONE, FLAGS }, \
 	{ C_DNSSEC_POLICY,       YP_TREF,  YP_VREF = { C_POLICY }, FLAGS, { check_ref_dflt } }, \
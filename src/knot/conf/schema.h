@@ -24,11 +24,13 @@
 #define C_ADDR			"\x07""address"
 #define C_ADJUST_THR		"\x0E""adjust-threads"
 #define C_ALG			"\x09""algorithm"
+#define C_ANS_CACHE		"\x0C""answer-cache"
 #define C_ANS_ROTATION		"\x0F""answer-rotation"
 #define C_ANY			"\x03""any"
 #define C_APPEND		"\x06""append"
 #define C_ASYNC_START		"\x0B""async-start"
 #define C_AUTO_ACL		"\x0D""automatic-acl"
+#define C_AXFR_CACHE		"\x0A""axfr-cache"
 #define C_BACKEND		"\x07""backend"
 #define C_BACKLOG		"\x07""backlog"
 #define C_BG_WORKERS		"\x12""background-workers"
@@ -76,10 +78,13 @@
 #define C_IXFR_BENEVOLENT	"\x0F""ixfr-benevolent"
 #define C_IXFR_BY_ONE		"\x0B""ixfr-by-one"
 #define C_IXFR_FROM_AXFR	"\x0E""ixfr-from-axfr"
+#define C_JOURNAL_COMPRESSION	"\x13""journal-compression"
 #define C_JOURNAL_CONTENT	"\x0F""journal-content"
 #define C_JOURNAL_DB		"\x0A""journal-db"
+#define C_JOURNAL_DB_GROUP_COMMIT	"\x17""journal-db-group-commit"
 #define C_JOURNAL_DB_MAX_SIZE	"\x13""journal-db-max-size"
 #define C_JOURNAL_DB_MODE	"\x0F""journal-db-mode"
+#define C_JOURNAL_DB_SHARDS	"\x11""journal-db-shards"
 #define C_JOURNAL_MAX_DEPTH	"\x11""journal-max-depth"
 #define C_JOURNAL_MAX_USAGE	"\x11""journal-max-usage"
 #define C_KASP_DB		"\x07""kasp-db"
@@ -110,6 +115,7 @@
 #define C_NSEC3_OPT_OUT		"\x0D""nsec3-opt-out"
 #define C_NSEC3_SALT_LEN	"\x11""nsec3-salt-length"
 #define C_NSEC3_SALT_LIFETIME	"\x13""nsec3-salt-lifetime"
+#define C_NSEC3_CACHE		"\x10""nsec3-hash-cache"
 #define C_NSID			"\x04""nsid"
 #define C_OFFLINE_KSK		"\x0B""offline-ksk"
 #define C_PARENT		"\x06""parent"
@@ -138,6 +144,7 @@
 #define C_RMT_POOL_TIMEOUT	"\x13""remote-pool-timeout"
 #define C_RMT_RETRY_DELAY	"\x12""remote-retry-delay"
 #define C_ROUTE_CHECK		"\x0B""route-check"
+#define C_RRSIG_INDEX		"\x12""rrsig-expiry-index"
 #define C_RRSIG_LIFETIME	"\x0E""rrsig-lifetime"
 #define C_RRSIG_PREREFRESH	"\x11""rrsig-pre-refresh"
 #define C_RRSIG_REFRESH		"\x0D""rrsig-refresh"
@@ -175,6 +182,7 @@
 #define C_TLS			"\x03""tls"
 #define C_TPL			"\x08""template"
 #define C_UDP			"\x03""udp"
+#define C_UDP_BACKEND		"\x0B""udp-backend"
 #define C_UDP_MAX_PAYLOAD	"\x0F""udp-max-payload"
 #define C_UDP_MAX_PAYLOAD_IPV4	"\x14""udp-max-payload-ipv4"
 #define C_UDP_MAX_PAYLOAD_IPV6	"\x14""udp-max-payload-ipv6"
@@ -188,8 +196,11 @@
 #define C_VERSION		"\x07""version"
 #define C_VIA			"\x03""via"
 #define C_XDP			"\x03""xdp"
+#define C_XFR_WORKERS		"\x0B""xfr-workers"
+#define C_XFR_ZONE_LIMIT	"\x0E""xfr-zone-limit"
 #define C_ZONE			"\x04""zone"
 #define C_ZONEFILE_LOAD		"\x0D""zonefile-load"
+#define C_ZONEFILE_SNAP		"\x11""zonefile-snapshot"
 #define C_ZONEFILE_SYNC		"\x0D""zonefile-sync"
 #define C_ZONEMD_GENERATE	"\x0F""zonemd-generate"
 #define C_ZONEMD_VERIFY		"\x0D""zonemd-verify"
@@ -269,6 +280,11 @@ enum {
 	CATALOG_ROLE_MEMBER    = 3,
 };
 
+enum {
+	UDP_BACKEND_MMSG     = 0,
+	UDP_BACKEND_IO_URING = 1,
+};
+
 enum {
 	DBUS_EVENT_NONE            = 0,
 	DBUS_EVENT_RUNNING         = (1 << 0),
@@ -1070,6 +1070,14 @@ static int check_zone_or_tpl(
 		}
 	}
 
+#ifndef ENABLE_ZSTD
+	conf_val_t compression = conf_get_wrap(args, C_JOURNAL_COMPRESSION);
+	if (conf_bool(&compression)) {
+		args->err_str = "journal compression is not available";
+		return KNOT_ENOTSUP;
+	}
+#endif
+
 	conf_val_t signing = conf_get_wrap(args, C_DNSSEC_SIGNING);
 	if (conf_bool(&signing)) {
 		conf_val_t validation = conf_get_wrap(args, C_DNSSEC_VALIDATION);
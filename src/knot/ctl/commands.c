@@ -659,10 +659,16 @@ static int init_backup(ctl_args_t *args, bool restore_mode)
 	// The present timer db size is not up-to-date, use the maximum one.
 	conf_val_t timer_db_size = conf_db_param(conf(), C_TIMER_DB_MAX_SIZE);
 
+	// The zone journals from all shards are backed up into one journal DB.
+	size_t journal_db_size = 0;
+	for (unsigned i = 0; i < args->server->journal_shards; i++) {
+		journal_db_size += knot_lmdb_copy_size(&args->server->journaldb[i]);
+	}
+
 	int ret = zone_backup_init(restore_mode, filters, forced, backup_dir,
 	                           knot_lmdb_copy_size(&args->server->kaspdb),
 	                           conf_int(&timer_db_size),
-	                           knot_lmdb_copy_size(&args->server->journaldb),
+	                           journal_db_size,
 	                           knot_lmdb_copy_size(&args->server->catalog.db),
 	                           &ctx);
 
@@ -1564,7 +1570,7 @@ static bool zone_names_distinct(const knot_dname_t *zone, void *data)
 static int drop_journal_if_orphan(const knot_dname_t *for_zone, void *ctx)
 {
 	server_t *server = ctx;
-	zone_journal_t j = { &server->journaldb, for_zone };
+	zone_journal_t j = { server_journaldb(server, for_zone), for_zone };
 	if (!zone_exists(for_zone, server->zone_db)) {
 		return journal_scrape_with_md(j, false);
 	}
@@ -1698,9 +1704,14 @@ static int orphans_purge(ctl_args_t *args)
 
 		// Purge zone journals of unconfigured zones.
 		if (only_orphan || MATCH_AND_FILTER(args, CTL_FILTER_PURGE_JOURNAL)) {
-			ret = journals_walk(&args->server->journaldb,
-			                    drop_journal_if_orphan, args->server);
-			log_if_orphans_error(NULL, ret, "journal", &failed);
+			for (unsigned i = 0; i < args->server->journal_shards; i++) {
+				ret = journals_walk(&args->server->journaldb[i],
+				                    drop_journal_if_orphan, args->server);
+				if (ret == KNOT_ENODB) {
+					continue; // shard not created yet
+				}
+				log_if_orphans_error(NULL, ret, "journal", &failed);
+			}
 		}
 
 		// Purge timers of unconfigured zones.
@@ -1745,7 +1756,7 @@ static int orphans_purge(ctl_args_t *args)
 
 				// Purge zone journal.
 				if (only_orphan || MATCH_AND_FILTER(args, CTL_FILTER_PURGE_JOURNAL)) {
-					zone_journal_t j = { &args->server->journaldb, zone_name };
+					zone_journal_t j = { server_journaldb(args->server, zone_name), zone_name };
 					ret = journal_scrape_with_md(j, true);
 					log_if_orphans_error(zone_name, ret, "journal", &failed);
 				}
@@ -2002,13 +2013,17 @@ static int server_status(ctl_args_t *args)
 	if (strcasecmp(type, "version") == 0) {
 		ret = snprintf(buff, sizeof(buff), "%s", PACKAGE_VERSION);
 	} else if (strcasecmp(type, "workers") == 0) {
-		int running_bkg_wrk, wrk_queue;
-		worker_pool_status(args->server->workers, false, &running_bkg_wrk, &wrk_queue);
+		int running_bkg_wrk, wrk_queue, wrk_queue_prio[WORKER_PRIO_COUNT];
+		worker_pool_status(args->server->workers, false, &running_bkg_wrk,
+		                   &wrk_queue, wrk_queue_prio);
 		ret = snprintf(buff, sizeof(buff), "UDP workers: %zu, TCP workers: %zu, "
-		               "XDP workers: %zu, background workers: %zu (running: %d, pending: %d)",
+		               "XDP workers: %zu, transfer workers: %zu, background workers: %zu "
+		               "(running: %d, pending: %d [high: %d, normal: %d, low: %d])",
 		               conf()->cache.srv_udp_threads, conf()->cache.srv_tcp_threads,
-		               conf()->cache.srv_xdp_threads, conf()->cache.srv_bg_threads,
-		               running_bkg_wrk, wrk_queue);
+		               conf()->cache.srv_xdp_threads, conf()->cache.srv_xfr_threads,
+		               conf()->cache.srv_bg_threads,
+		               running_bkg_wrk, wrk_queue, wrk_queue_prio[WORKER_PRIO_HIGH],
+		               wrk_queue_prio[WORKER_PRIO_NORMAL], wrk_queue_prio[WORKER_PRIO_LOW]);
 	} else if (strcasecmp(type, "configure") == 0) {
 		ret = snprintf(buff, sizeof(buff), "%s", configure_summary);
 	} else if (strcasecmp(type, "cert-key") == 0) {
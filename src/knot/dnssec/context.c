@@ -371,3 +371,19 @@ int kdnssec_validation_ctx(conf_t *conf, kdnssec_ctx_t *ctx, const zone_contents
 	ctx->validation_mode = true;
 	return KNOT_EOK;
 }
+
+void zone_sign_stats_merge(zone_sign_stats_t *stats, const zone_sign_stats_t *local)
+{
+	if (stats == NULL || (local->rrsig_count == 0 && local->expire == 0 &&
+	                      local->verify_time == 0 && local->verify_batches == 0)) {
+		return;
+	}
+
+	knot_spin_lock(&stats->lock);
+	stats->rrsig_count += local->rrsig_count;
+	stats->expire = knot_time_min(stats->expire, local->expire);
+	stats->verify_time += local->verify_time;
+	stats->verify_count += local->verify_count;
+	stats->verify_batches += local->verify_batches;
+	knot_spin_unlock(&stats->lock);
+}
@@ -26,6 +26,9 @@
 typedef struct {
 	size_t rrsig_count;
 	knot_time_t expire;
+	uint64_t verify_time;  // Time spent in signature verification by all threads (usecs).
+	size_t verify_count;   // RRSIGs verified in the key batches.
+	size_t verify_batches; // Batches of verified RRSIGs made by the same key.
 
 	knot_spin_t lock;
 } zone_sign_stats_t;
@@ -91,3 +94,11 @@ int kdnssec_ctx_commit(kdnssec_ctx_t *ctx);
  * \brief Cleanup DNSSEC signing context.
  */
 void kdnssec_ctx_deinit(kdnssec_ctx_t *ctx);
+
+/*!
+ * \brief Merge thread-local statistics into the shared ones.
+ *
+ * \param stats  Shared statistics, updated under their lock (can be NULL).
+ * \param local  Statistics gathered by a single thread.
+ */
+void zone_sign_stats_merge(zone_sign_stats_t *stats, const zone_sign_stats_t *local);
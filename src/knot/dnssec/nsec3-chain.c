@@ -16,16 +16,27 @@
 
 #include <assert.h>
 
+#include "libdnssec/error.h"
 #include "libknot/dname.h"
 #include "knot/dnssec/nsec-chain.h"
 #include "knot/dnssec/nsec3-chain.h"
 #include "knot/dnssec/zone-sign.h"
 #include "knot/dnssec/zone-nsec.h"
+#include "knot/worker/parallel.h"
 #include "knot/zone/adjust.h"
 #include "knot/zone/zone-diff.h"
 #include "contrib/base32hex.h"
+#include "contrib/macros.h"
 #include "contrib/wire_ctx.h"
 
+/*! \brief Number of nodes whose owners are hashed at once. */
+#define NSEC3_HASH_BATCH	64
+
+/*! \brief Approximate number of zone nodes in one part of a resumable build. */
+#define NSEC3_BUILD_PART_NODES	16384
+/*! \brief Maximal number of parts of a resumable build (finer split not possible). */
+#define NSEC3_BUILD_PARTS_MAX	256
+
 static bool nsec3_empty(const zone_node_t *node, const dnssec_nsec3_params_t *params)
 {
 	bool opt_out = (params->flags & KNOT_NSEC3_FLAG_OPT_OUT);
@@ -57,6 +68,19 @@ static bool node_should_be_signed_nsec3(const zone_node_t *n)
 	return false;
 }
 
+/*!
+ * \brief Free a newly created NSEC3 node.
+ */
+static void free_nsec3_node(zone_node_t *node)
+{
+	// newly allocated NSEC3 nodes
+	knot_rdataset_t *nsec3 = node_rdataset(node, KNOT_RRTYPE_NSEC3);
+	knot_rdataset_t *rrsig = node_rdataset(node, KNOT_RRTYPE_RRSIG);
+	knot_rdataset_clear(nsec3, NULL);
+	knot_rdataset_clear(rrsig, NULL);
+	node_free(node, NULL);
+}
+
 /*!
  * \brief Custom NSEC3 tree free function.
  *
@@ -67,13 +91,7 @@ static void free_nsec3_tree(zone_tree_t *nodes)
 
 	zone_tree_it_t it = { 0 };
 	for ((void)zone_tree_it_begin(nodes, &it); !zone_tree_it_finished(&it); zone_tree_it_next(&it)) {
-		zone_node_t *node = zone_tree_it_val(&it);
-		// newly allocated NSEC3 nodes
-		knot_rdataset_t *nsec3 = node_rdataset(node, KNOT_RRTYPE_NSEC3);
-		knot_rdataset_t *rrsig = node_rdataset(node, KNOT_RRTYPE_RRSIG);
-		knot_rdataset_clear(nsec3, NULL);
-		knot_rdataset_clear(rrsig, NULL);
-		node_free(node, NULL);
+		free_nsec3_node(zone_tree_it_val(&it));
 	}
 
 	zone_tree_it_free(&it);
@@ -224,29 +242,25 @@ static zone_node_t *create_nsec3_node(const knot_dname_t *owner,
 /*!
  * \brief Create new NSEC3 node for given regular node.
  *
- * \param node       Node for which the NSEC3 node is created.
- * \param apex       Zone apex node.
- * \param params     NSEC3 hash function parameters.
- * \param ttl        TTL of the new NSEC3 node.
+ * \param node         Node for which the NSEC3 node is created.
+ * \param nsec3_owner  Hashed owner of the node.
+ * \param apex         Zone apex node.
+ * \param params       NSEC3 hash function parameters.
+ * \param ttl          TTL of the new NSEC3 node.
  *
  * \return Error code, KNOT_EOK if successful.
  */
 static zone_node_t *create_nsec3_node_for_node(const zone_node_t *node,
+                                               const knot_dname_t *nsec3_owner,
                                                zone_node_t *apex,
                                                const dnssec_nsec3_params_t *params,
                                                uint32_t ttl)
 {
 	assert(node);
+	assert(nsec3_owner);
 	assert(apex);
 	assert(params);
 
-	knot_dname_storage_t nsec3_owner;
-	int ret = knot_create_nsec3_owner(nsec3_owner, sizeof(nsec3_owner),
-	                                  node->owner, apex->owner, params);
-	if (ret != KNOT_EOK) {
-		return NULL;
-	}
-
 	dnssec_nsec_bitmap_t *rr_types = dnssec_nsec_bitmap_new();
 	if (!rr_types) {
 		return NULL;
@@ -398,13 +412,224 @@ static int reconnect_nsec3_nodes2(zone_node_t *a, zone_node_t *b,
 	return ret;
 }
 
+/*!
+ * \brief Create NSEC3 nodes for a batch of regular nodes.
+ *
+ * The owner names are hashed at once, which is faster than one by one.
+ */
+static int create_nsec3_nodes_batch(zone_node_t *nodes[], size_t count,
+                                    zone_node_t *apex,
+                                    const dnssec_nsec3_params_t *params,
+                                    uint32_t ttl, zone_tree_t *nsec3_nodes)
+{
+	size_t hash_length = dnssec_nsec3_hash_length(params->algorithm);
+	if (hash_length == 0) {
+		return knot_error_from_libdnssec(DNSSEC_INVALID_NSEC3_ALGORITHM);
+	}
+
+	dnssec_binary_t names[count];
+	dnssec_binary_t hashes[count];
+	uint8_t hash_buf[count][hash_length];
+	for (size_t i = 0; i < count; i++) {
+		names[i].data = nodes[i]->owner;
+		names[i].size = knot_dname_size(nodes[i]->owner);
+		hashes[i].data = hash_buf[i];
+		hashes[i].size = hash_length;
+	}
+
+	int ret = dnssec_nsec3_hash_batch(names, count, params, hashes);
+	if (ret != DNSSEC_EOK) {
+		return knot_error_from_libdnssec(ret);
+	}
+
+	for (size_t i = 0; i < count; i++) {
+		knot_dname_storage_t nsec3_owner;
+		ret = knot_nsec3_hash_to_dname(nsec3_owner, sizeof(nsec3_owner),
+		                               hashes[i].data, hashes[i].size,
+		                               apex->owner);
+		if (ret != KNOT_EOK) {
+			return ret;
+		}
+
+		zone_node_t *nsec3_node = create_nsec3_node_for_node(nodes[i], nsec3_owner,
+		                                                     apex, params, ttl);
+		if (nsec3_node == NULL) {
+			return KNOT_ENOMEM;
+		}
+
+		ret = zone_tree_insert(nsec3_nodes, &nsec3_node);
+		if (ret != KNOT_EOK) {
+			return ret;
+		}
+	}
+
+	return KNOT_EOK;
+}
+
+typedef struct {
+	const zone_contents_t *zone;
+	const dnssec_nsec3_params_t *params;
+	uint32_t ttl;
+	unsigned num_threads;
+	unsigned parts;
+	unsigned part_from;
+	unsigned part_to;
+	zone_tree_t *nsec3_nodes;
+	zone_node_t *batch[NSEC3_HASH_BATCH];
+	size_t batch_count;
+} nsec3_create_args_t;
+
+static int flush_nsec3_batch(nsec3_create_args_t *args)
+{
+	int ret = create_nsec3_nodes_batch(args->batch, args->batch_count,
+	                                   args->zone->apex, args->params,
+	                                   args->ttl, args->nsec3_nodes);
+	args->batch_count = 0;
+	return ret;
+}
+
+static int collect_nsec3_node(zone_node_t *node, void *data)
+{
+	nsec3_create_args_t *args = data;
+
+	if (node->flags & NODE_FLAGS_NONAUTH || nsec3_empty(node, args->params) || node->flags & NODE_FLAGS_DELETED) {
+		return KNOT_EOK;
+	}
+
+	args->batch[args->batch_count++] = node;
+	if (args->batch_count == NSEC3_HASH_BATCH) {
+		return flush_nsec3_batch(args);
+	}
+
+	return KNOT_EOK;
+}
+
+static int create_nsec3_parts(unsigned idx, void *ctx)
+{
+	nsec3_create_args_t *args = (nsec3_create_args_t *)ctx + idx;
+	zone_tree_t *tree = args->zone->nodes;
+
+	int ret = KNOT_EOK;
+	if (args->parts == 1) {
+		ret = zone_tree_apply(tree, collect_nsec3_node, args);
+	} else {
+		for (unsigned part = args->part_from + idx; part < args->part_to && ret == KNOT_EOK;
+		     part += args->num_threads) {
+			ret = zone_tree_apply_part(tree, part, args->parts, collect_nsec3_node, args);
+		}
+	}
+
+	if (ret == KNOT_EOK && args->batch_count > 0) {
+		ret = flush_nsec3_batch(args);
+	}
+
+	return ret;
+}
+
+/*!
+ * \brief Move all nodes of a partial NSEC3 tree into the resulting one.
+ *
+ * The partial tree is freed, including the nodes which failed to be moved.
+ */
+static int merge_nsec3_tree(zone_tree_t *to, zone_tree_t **from)
+{
+	zone_tree_it_t it = { 0 };
+	int ret = zone_tree_it_begin(*from, &it);
+	if (ret != KNOT_EOK) {
+		free_nsec3_tree(*from);
+		*from = NULL;
+		return ret;
+	}
+
+	while (!zone_tree_it_finished(&it)) {
+		zone_node_t *node = zone_tree_it_val(&it);
+		if (ret == KNOT_EOK) {
+			ret = zone_tree_insert(to, &node);
+		}
+		if (ret != KNOT_EOK) {
+			free_nsec3_node(node);
+		}
+		zone_tree_it_next(&it);
+	}
+	zone_tree_it_free(&it);
+	zone_tree_free(from);
+
+	return ret;
+}
+
+/*!
+ * \brief Create NSEC3 nodes for a range of parts of the zone tree.
+ *
+ * With more threads, each of them fills its own partial tree from its parts
+ * of the range, the partial trees are merged afterwards.
+ *
+ * \param zone         Zone.
+ * \param params       NSEC3 params.
+ * \param ttl          TTL for the created NSEC records.
+ * \param num_threads  Number of threads to create the NSEC3 nodes with.
+ * \param parts        Number of parts the zone tree is split into.
+ * \param part_from    First part of the range.
+ * \param part_to      Part after the last one of the range.
+ * \param nsec3_nodes  Tree whereto new NSEC3 nodes will be added.
+ *
+ * \return Error code, KNOT_EOK if successful.
+ */
+static int create_nsec3_nodes_parts(const zone_contents_t *zone,
+                                    const dnssec_nsec3_params_t *params,
+                                    uint32_t ttl,
+                                    unsigned num_threads,
+                                    unsigned parts,
+                                    unsigned part_from,
+                                    unsigned part_to,
+                                    zone_tree_t *nsec3_nodes)
+{
+	assert(part_from < part_to && part_to <= parts);
+
+	num_threads = MIN(num_threads, part_to - part_from);
+
+	nsec3_create_args_t args[num_threads];
+	memset(args, 0, sizeof(args));
+
+	int result = KNOT_EOK;
+	for (unsigned i = 0; i < num_threads; i++) {
+		args[i].zone = zone;
+		args[i].params = params;
+		args[i].ttl = ttl;
+		args[i].num_threads = num_threads;
+		args[i].parts = parts;
+		args[i].part_from = part_from;
+		args[i].part_to = part_to;
+		args[i].nsec3_nodes = (num_threads == 1) ? nsec3_nodes : zone_tree_create(false);
+		if (args[i].nsec3_nodes == NULL) {
+			result = KNOT_ENOMEM;
+			break;
+		}
+	}
+
+	if (result == KNOT_EOK) {
+		result = parallel_run(num_threads, create_nsec3_parts, args);
+	}
+
+	if (num_threads > 1) {
+		for (unsigned i = 0; i < num_threads && args[i].nsec3_nodes != NULL; i++) {
+			if (result == KNOT_EOK) {
+				result = merge_nsec3_tree(nsec3_nodes, &args[i].nsec3_nodes);
+			} else {
+				free_nsec3_tree(args[i].nsec3_nodes);
+			}
+		}
+	}
+
+	return result;
+}
+
 /*!
  * \brief Create NSEC3 node for each regular node in the zone.
  *
  * \param zone         Zone.
  * \param params       NSEC3 params.
  * \param ttl          TTL for the created NSEC records.
- * \param cds_in_apex  Hint to guess apex node type bitmap: false=just DNSKEY, true=DNSKEY,CDS,CDNSKEY.
+ * \param num_threads  Number of threads to create the NSEC3 nodes with.
  * \param nsec3_nodes  Tree whereto new NSEC3 nodes will be added.
  * \param update       Zone update for possible NSEC removals
  *
@@ -413,12 +638,14 @@ static int reconnect_nsec3_nodes2(zone_node_t *a, zone_node_t *b,
 static int create_nsec3_nodes(const zone_contents_t *zone,
                               const dnssec_nsec3_params_t *params,
                               uint32_t ttl,
+                              unsigned num_threads,
                               zone_tree_t *nsec3_nodes,
                               zone_update_t *update)
 {
 	assert(zone);
 	assert(nsec3_nodes);
 	assert(update);
+	assert(num_threads > 0);
 
 	zone_tree_delsafe_it_t it = { 0 };
 	int result = zone_tree_delsafe_it_begin(zone->nodes, &it, false); // delsafe - removing nodes that contain only NSEC+RRSIG
@@ -434,30 +661,24 @@ static int create_nsec3_nodes(const zone_contents_t *zone,
 		if (result != KNOT_EOK) {
 			break;
 		}
-		if (node->flags & NODE_FLAGS_NONAUTH || nsec3_empty(node, params) || node->flags & NODE_FLAGS_DELETED) {
-			zone_tree_delsafe_it_next(&it);
-			continue;
-		}
-
-		zone_node_t *nsec3_node;
-		nsec3_node = create_nsec3_node_for_node(node, zone->apex,
-							params, ttl);
-		if (!nsec3_node) {
-			result = KNOT_ENOMEM;
-			break;
-		}
-
-		result = zone_tree_insert(nsec3_nodes, &nsec3_node);
-		if (result != KNOT_EOK) {
-			break;
-		}
 
 		zone_tree_delsafe_it_next(&it);
 	}
 
 	zone_tree_delsafe_it_free(&it);
+	if (result != KNOT_EOK) {
+		return result;
+	}
 
-	return result;
+	/*!
+	 * The NSEC3 nodes are created in a second pass, when no more nodes
+	 * can be removed, so that the zone tree can be split among threads
+	 * and the nodes can be collected in batches.
+	 */
+	unsigned parts = (num_threads == 1) ? 1 : num_threads * PARALLEL_PARTS_PER_THREAD;
+
+	return create_nsec3_nodes_parts(zone, params, ttl, num_threads,
+	                                parts, 0, parts, nsec3_nodes);
 }
 
 /*!
@@ -515,7 +736,8 @@ static int fix_nsec3_for_node(zone_update_t *update, const dnssec_nsec3_params_t
 
 	// add NSEC3 with correct bitmap
 	if (!shall_no_nsec && ret == KNOT_EOK) {
-		zone_node_t *new_nsec3_n = create_nsec3_node_for_node(new_n, update->new_cont->apex, params, ttl);
+		zone_node_t *new_nsec3_n = create_nsec3_node_for_node(new_n, for_node_hashed,
+		                                                      update->new_cont->apex, params, ttl);
 		if (new_nsec3_n == NULL) {
 			return KNOT_ENOMEM;
 		}
@@ -625,6 +847,7 @@ int delete_nsec3_chain(zone_update_t *up)
 int knot_nsec3_create_chain(const zone_contents_t *zone,
                             const dnssec_nsec3_params_t *params,
                             uint32_t ttl,
+                            unsigned num_threads,
                             zone_update_t *update)
 {
 	assert(zone);
@@ -635,7 +858,7 @@ int knot_nsec3_create_chain(const zone_contents_t *zone,
 		return KNOT_ENOMEM;
 	}
 
-	int result = create_nsec3_nodes(zone, params, ttl, nsec3_nodes, update);
+	int result = create_nsec3_nodes(zone, params, ttl, num_threads, nsec3_nodes, update);
 	if (result != KNOT_EOK) {
 		free_nsec3_tree(nsec3_nodes);
 		return result;
@@ -655,6 +878,76 @@ int knot_nsec3_create_chain(const zone_contents_t *zone,
 	return result;
 }
 
+int knot_nsec3_build_init(knot_nsec3_build_t *build, const zone_contents_t *zone,
+                          const dnssec_nsec3_params_t *params, uint32_t ttl)
+{
+	if (build == NULL || zone == NULL || params == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	memset(build, 0, sizeof(*build));
+
+	build->nsec3_nodes = zone_tree_create(false);
+	if (build->nsec3_nodes == NULL) {
+		return KNOT_ENOMEM;
+	}
+
+	size_t parts = MIN(zone_tree_count(zone->nodes) / NSEC3_BUILD_PART_NODES,
+	                   NSEC3_BUILD_PARTS_MAX);
+	build->parts = MAX(parts, 1);
+	build->params = *params;
+	build->ttl = ttl;
+
+	return KNOT_EOK;
+}
+
+int knot_nsec3_build_step(knot_nsec3_build_t *build, const zone_contents_t *zone,
+                          unsigned num_threads, unsigned max_parts)
+{
+	if (build == NULL || zone == NULL || num_threads == 0 || max_parts == 0) {
+		return KNOT_EINVAL;
+	}
+
+	if (knot_nsec3_build_finished(build)) {
+		return KNOT_EOK;
+	}
+
+	unsigned part_to = MIN(build->parts, build->parts_done + max_parts);
+	int ret = create_nsec3_nodes_parts(zone, &build->params, build->ttl, num_threads,
+	                                   build->parts, build->parts_done, part_to,
+	                                   build->nsec3_nodes);
+	if (ret == KNOT_EOK) {
+		build->parts_done = part_to;
+	}
+
+	return ret;
+}
+
+int knot_nsec3_build_apply(knot_nsec3_build_t *build, zone_update_t *update)
+{
+	if (build == NULL || update == NULL || !knot_nsec3_build_finished(build)) {
+		return KNOT_EINVAL;
+	}
+
+	int ret = knot_nsec_chain_iterate_create(build->nsec3_nodes,
+	                                         connect_nsec3_nodes, NULL);
+	if (ret == KNOT_EOK) {
+		ret = zone_update_nsec3_nodes(update, build->nsec3_nodes);
+	}
+
+	return ret;
+}
+
+void knot_nsec3_build_deinit(knot_nsec3_build_t *build)
+{
+	if (build == NULL || build->nsec3_nodes == NULL) {
+		return;
+	}
+
+	free_nsec3_tree(build->nsec3_nodes);
+	memset(build, 0, sizeof(*build));
+}
+
 int knot_nsec3_fix_chain(zone_update_t *update,
                          const dnssec_nsec3_params_t *params,
                          uint32_t ttl)
@@ -668,7 +961,7 @@ int knot_nsec3_fix_chain(zone_update_t *update,
 		if (ret != KNOT_EOK) {
 			return ret;
 		}
-		return knot_nsec3_create_chain(update->new_cont, params, ttl, update);
+		return knot_nsec3_create_chain(update->new_cont, params, ttl, 1, update);
 	}
 
 	int ret = fix_nsec3_nodes(update, params, ttl);
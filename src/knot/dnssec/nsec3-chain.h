@@ -30,18 +30,89 @@ int delete_nsec3_chain(zone_update_t *up);
 /*!
  * \brief Creates new NSEC3 chain, add differences from current into a changeset.
  *
- * \param zone       Zone to be checked.
- * \param params     NSEC3 parameters.
- * \param ttl        TTL for new records.
- * \param update     Zone update to stare immediate changes into.
+ * The new chain is built aside from the zone contents, possibly by more
+ * threads, and only the differences are stored into the update.
+ *
+ * \param zone         Zone to be checked.
+ * \param params       NSEC3 parameters.
+ * \param ttl          TTL for new records.
+ * \param num_threads  Number of threads to build the chain with.
+ * \param update       Zone update to stare immediate changes into.
  *
  * \return KNOT_E*
  */
 int knot_nsec3_create_chain(const zone_contents_t *zone,
                             const dnssec_nsec3_params_t *params,
                             uint32_t ttl,
+                            unsigned num_threads,
                             zone_update_t *update);
 
+/*!
+ * \brief New NSEC3 chain being built aside from the zone in resumable steps.
+ */
+typedef struct {
+	dnssec_nsec3_params_t params; // NSEC3 parameters, the salt isn't owned.
+	uint32_t ttl;                 // TTL for new records.
+	zone_tree_t *nsec3_nodes;     // New NSEC3 nodes built so far.
+	unsigned parts;               // Number of parts the zone tree is split into.
+	unsigned parts_done;          // Number of parts already processed.
+} knot_nsec3_build_t;
+
+/*!
+ * \brief Initialize a resumable build of a new NSEC3 chain.
+ *
+ * The number of parts is derived from the size of the zone.
+ *
+ * \param build   Build to be initialized.
+ * \param zone    Zone contents the chain will be built from.
+ * \param params  NSEC3 parameters (the salt must outlive the build).
+ * \param ttl     TTL for new records.
+ *
+ * \return KNOT_E*
+ */
+int knot_nsec3_build_init(knot_nsec3_build_t *build, const zone_contents_t *zone,
+                          const dnssec_nsec3_params_t *params, uint32_t ttl);
+
+/*!
+ * \brief Create NSEC3 nodes for the next parts of the zone tree.
+ *
+ * The zone contents must be the same in all steps of the build.
+ *
+ * \param build        Build in progress.
+ * \param zone         Zone contents the chain is built from.
+ * \param num_threads  Number of threads to build the parts with.
+ * \param max_parts    Maximal number of parts processed in this step.
+ *
+ * \return KNOT_E*
+ */
+int knot_nsec3_build_step(knot_nsec3_build_t *build, const zone_contents_t *zone,
+                          unsigned num_threads, unsigned max_parts);
+
+/*!
+ * \brief Check if all parts of the zone tree have been processed.
+ */
+inline static bool knot_nsec3_build_finished(const knot_nsec3_build_t *build)
+{
+	return build->parts_done >= build->parts;
+}
+
+/*!
+ * \brief Connect the finished chain and store its differences from the current one.
+ *
+ * The NSEC3PARAM record isn't updated. The build can't be applied again.
+ *
+ * \param build   Finished build.
+ * \param update  Zone update to store the differences into.
+ *
+ * \return KNOT_E*
+ */
+int knot_nsec3_build_apply(knot_nsec3_build_t *build, zone_update_t *update);
+
+/*!
+ * \brief Free the NSEC3 nodes of the build.
+ */
+void knot_nsec3_build_deinit(knot_nsec3_build_t *build);
+
 /*!
  * \brief Updates zone's NSEC3 chain to follow the differences in zone update.
  *
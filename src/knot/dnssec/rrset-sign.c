@@ -157,6 +157,24 @@ static int sign_ctx_add_self(dnssec_sign_ctx_t *ctx, const uint8_t *rdata)
  */
 static int sign_ctx_add_records(dnssec_sign_ctx_t *ctx, const knot_rrset_t *covered)
 {
+	dnssec_binary_t rrset_wire = { 0 };
+	int result = knot_covered_to_wire(covered, &rrset_wire);
+	if (result != KNOT_EOK) {
+		return result;
+	}
+
+	result = dnssec_sign_add(ctx, &rrset_wire);
+	dnssec_binary_free(&rrset_wire);
+
+	return result;
+}
+
+int knot_covered_to_wire(const knot_rrset_t *covered, dnssec_binary_t *wire)
+{
+	if (knot_rrset_empty(covered) || wire == NULL) {
+		return KNOT_EINVAL;
+	}
+
 	size_t rrwl = knot_rrset_size_estimate(covered);
 	uint8_t *rrwf = malloc(rrwl);
 	if (!rrwf) {
@@ -169,13 +187,10 @@ static int sign_ctx_add_records(dnssec_sign_ctx_t *ctx, const knot_rrset_t *cove
 		return written;
 	}
 
-	dnssec_binary_t rrset_wire = { 0 };
-	rrset_wire.size = written;
-	rrset_wire.data = rrwf;
-	int result = dnssec_sign_add(ctx, &rrset_wire);
-	free(rrwf);
+	wire->size = written;
+	wire->data = rrwf;
 
-	return result;
+	return KNOT_EOK;
 }
 
 int knot_sign_ctx_add_data(dnssec_sign_ctx_t *ctx,
@@ -195,12 +210,29 @@ int knot_sign_ctx_add_data(dnssec_sign_ctx_t *ctx,
 }
 
 /*!
- * \brief Create RRSIG RDATA.
+ * \brief Get number of labels for the RRSIG Labels field.
+ */
+static uint8_t rrsig_owner_labels(const knot_dname_t *owner)
+{
+	uint8_t owner_labels = knot_dname_labels(owner, NULL);
+	if (knot_dname_is_wildcard(owner)) {
+		owner_labels -= 1;
+	}
+
+	return owner_labels;
+}
+
+/*!
+ * \brief Create RRSIG RDATA for multiple keys at once.
+ *
+ * The covered RRs are converted to canonical wire format just once and all
+ * the signatures are computed in one batch into a single buffer.
  *
  * \param[in]  rrsigs        RR set with RRSIGS.
- * \param[in]  ctx           DNSSEC signing context.
  * \param[in]  covered       RR covered by the signature.
- * \param[in]  key           Key used for signing.
+ * \param[in]  keys          Keys used for signing.
+ * \param[in]  ctxs          DNSSEC signing contexts of the keys.
+ * \param[in]  count         Number of keys.
  * \param[in]  sig_incepted  Timestamp of signature inception.
  * \param[in]  sig_expires   Timestamp of signature expiration.
  * \param[in]  sign_flags    Signing flags.
@@ -208,82 +240,123 @@ int knot_sign_ctx_add_data(dnssec_sign_ctx_t *ctx,
  *
  * \return Error code, KNOT_EOK if successful.
  */
-static int rrsigs_create_rdata(knot_rrset_t *rrsigs, dnssec_sign_ctx_t *ctx,
-                               const knot_rrset_t *covered,
-                               const dnssec_key_t *key,
-                               uint32_t sig_incepted, uint32_t sig_expires,
-                               dnssec_sign_flags_t sign_flags,
-                               knot_mm_t *mm)
+static int rrsigs_create_rdata(knot_rrset_t *rrsigs, const knot_rrset_t *covered,
+                               const dnssec_key_t *keys[], dnssec_sign_ctx_t *ctxs[],
+                               size_t count, uint32_t sig_incepted, uint32_t sig_expires,
+                               dnssec_sign_flags_t sign_flags, knot_mm_t *mm)
 {
 	assert(rrsigs);
 	assert(rrsigs->type == KNOT_RRTYPE_RRSIG);
 	assert(!knot_rrset_empty(covered));
-	assert(key);
-
-	size_t header_size = rrsig_rdata_header_size(key);
-	assert(header_size != 0);
+	assert(count > 0);
 
-	uint8_t owner_labels = knot_dname_labels(covered->owner, NULL);
-	if (knot_dname_is_wildcard(covered->owner)) {
-		owner_labels -= 1;
+	size_t rrwl = knot_rrset_size_estimate(covered);
+	size_t header_sizes[count], sig_sizes[count];
+	size_t total = rrwl;
+	for (size_t i = 0; i < count; i++) {
+		header_sizes[i] = rrsig_rdata_header_size(keys[i]);
+		sig_sizes[i] = dnssec_sign_size(ctxs[i]);
+		if (header_sizes[i] == 0 || sig_sizes[i] == 0) {
+			return KNOT_EINVAL;
+		}
+		total += header_sizes[i] + rrwl + sig_sizes[i];
 	}
 
-	uint8_t header[header_size];
-	int res = rrsig_write_rdata(header, header_size,
-	                            key, covered->type, owner_labels,
-	                            covered->ttl, sig_incepted, sig_expires);
-	assert(res == KNOT_EOK);
-
-	res = dnssec_sign_init(ctx);
-	if (res != KNOT_EOK) {
-		return res;
+	// Layout: RRs wire, then for each key: RRSIG header, RRs copy, signature.
+	uint8_t *buf = malloc(total);
+	if (buf == NULL) {
+		return KNOT_ENOMEM;
 	}
 
-	res = knot_sign_ctx_add_data(ctx, header, covered);
-	if (res != KNOT_EOK) {
-		return res;
+	int written = knot_rrset_to_wire_extra(covered, buf, rrwl, 0, NULL, 0);
+	if (written < 0) {
+		free(buf);
+		return written;
 	}
 
-	dnssec_binary_t signature = { 0 };
-	res = dnssec_sign_write(ctx, sign_flags, &signature);
-	if (res != DNSSEC_EOK) {
-		return res;
+	uint8_t owner_labels = rrsig_owner_labels(covered->owner);
+
+	dnssec_sign_job_t jobs[count];
+	uint8_t *pos = buf + rrwl;
+	for (size_t i = 0; i < count; i++) {
+		int res = rrsig_write_rdata(pos, header_sizes[i],
+		                            keys[i], covered->type, owner_labels,
+		                            covered->ttl, sig_incepted, sig_expires);
+		assert(res == KNOT_EOK);
+		memcpy(pos + header_sizes[i], buf, written);
+
+		jobs[i] = (dnssec_sign_job_t) {
+			.ctx = ctxs[i],
+			.data = { .data = pos, .size = header_sizes[i] + written },
+			.signature = { .data = pos + header_sizes[i] + rrwl, .size = sig_sizes[i] },
+		};
+		pos += header_sizes[i] + rrwl + sig_sizes[i];
 	}
-	assert(signature.size > 0);
 
-	size_t rrsig_size = header_size + signature.size;
-	uint8_t rrsig[rrsig_size];
-	memcpy(rrsig, header, header_size);
-	memcpy(rrsig + header_size, signature.data, signature.size);
+	int ret = dnssec_sign_batch(jobs, count, sign_flags);
 
-	dnssec_binary_free(&signature);
+	for (size_t i = 0; i < count && ret == KNOT_EOK; i++) {
+		assert(jobs[i].signature.size > 0);
 
-	return knot_rrset_add_rdata(rrsigs, rrsig, rrsig_size, mm);
+		size_t rrsig_size = header_sizes[i] + jobs[i].signature.size;
+		uint8_t rrsig[rrsig_size];
+		memcpy(rrsig, jobs[i].data.data, header_sizes[i]);
+		memcpy(rrsig + header_sizes[i], jobs[i].signature.data, jobs[i].signature.size);
+
+		ret = knot_rrset_add_rdata(rrsigs, rrsig, rrsig_size, mm);
+	}
+
+	free(buf);
+
+	return ret;
 }
 
-int knot_sign_rrset(knot_rrset_t *rrsigs, const knot_rrset_t *covered,
-                    const dnssec_key_t *key, dnssec_sign_ctx_t *sign_ctx,
-                    const kdnssec_ctx_t *dnssec_ctx, knot_mm_t *mm)
+int knot_sign_rrset_keys(knot_rrset_t *rrsigs, const knot_rrset_t *covered,
+                         const dnssec_key_t *keys[], dnssec_sign_ctx_t *sign_ctxs[],
+                         size_t count, const kdnssec_ctx_t *dnssec_ctx,
+                         zone_sign_stats_t *stats, knot_mm_t *mm)
 {
-	if (knot_rrset_empty(covered) || !key || !sign_ctx || !dnssec_ctx ||
-	    rrsigs->type != KNOT_RRTYPE_RRSIG ||
+	if (rrsigs == NULL || knot_rrset_empty(covered) || keys == NULL ||
+	    sign_ctxs == NULL || !dnssec_ctx || rrsigs->type != KNOT_RRTYPE_RRSIG ||
 	    !knot_dname_is_equal(rrsigs->owner, covered->owner)
 	) {
 		return KNOT_EINVAL;
 	}
 
+	for (size_t i = 0; i < count; i++) {
+		if (keys[i] == NULL || sign_ctxs[i] == NULL) {
+			return KNOT_EINVAL;
+		}
+	}
+
+	if (count == 0) {
+		return KNOT_EOK;
+	}
+
 	uint64_t sig_incept = dnssec_ctx->now - RRSIG_INCEPT_IN_PAST;
 	uint64_t sig_expire = dnssec_ctx->now + dnssec_ctx->policy->rrsig_lifetime;
 	dnssec_sign_flags_t sign_flags = dnssec_ctx->policy->reproducible_sign ?
 	                                 DNSSEC_SIGN_REPRODUCIBLE : DNSSEC_SIGN_NORMAL;
 
-	int ret = rrsigs_create_rdata(rrsigs, sign_ctx, covered, key, (uint32_t)sig_incept,
-	                              (uint32_t)sig_expire, sign_flags, mm);
+	int ret = rrsigs_create_rdata(rrsigs, covered, keys, sign_ctxs, count,
+	                              (uint32_t)sig_incept, (uint32_t)sig_expire,
+	                              sign_flags, mm);
+	if (ret == KNOT_EOK && stats != NULL) {
+		stats->rrsig_count += count;
+		stats->expire = knot_time_min(stats->expire, sig_expire);
+	}
+	return ret;
+}
+
+int knot_sign_rrset(knot_rrset_t *rrsigs, const knot_rrset_t *covered,
+                    const dnssec_key_t *key, dnssec_sign_ctx_t *sign_ctx,
+                    const kdnssec_ctx_t *dnssec_ctx, knot_mm_t *mm)
+{
+	zone_sign_stats_t stats = { 0 };
+	int ret = knot_sign_rrset_keys(rrsigs, covered, &key, &sign_ctx, 1, dnssec_ctx,
+	                               &stats, mm);
 	if (ret == KNOT_EOK) {
-		knot_spin_lock(&dnssec_ctx->stats->lock);
-		dnssec_ctx->stats->rrsig_count++;
-		dnssec_ctx->stats->expire = knot_time_min(dnssec_ctx->stats->expire, sig_expire);
-		knot_spin_unlock(&dnssec_ctx->stats->lock);
+		zone_sign_stats_merge(dnssec_ctx->stats, &stats);
 	}
 	return ret;
 }
@@ -295,6 +368,10 @@ int knot_sign_rrset2(knot_rrset_t *rrsigs, const knot_rrset_t *rrset,
 		return KNOT_EINVAL;
 	}
 
+	const dnssec_key_t *keys[sign_ctx->count + 1];
+	dnssec_sign_ctx_t *ctxs[sign_ctx->count + 1];
+	size_t count = 0;
+
 	for (size_t i = 0; i < sign_ctx->count; i++) {
 		zone_key_t *key = &sign_ctx->keys[i];
 
@@ -302,14 +379,23 @@ int knot_sign_rrset2(knot_rrset_t *rrsigs, const knot_rrset_t *rrset,
 			continue;
 		}
 
-		int ret = knot_sign_rrset(rrsigs, rrset, key->key, sign_ctx->sign_ctxs[i],
-		                          sign_ctx->dnssec_ctx, mm);
-		if (ret != KNOT_EOK) {
-			return ret;
-		}
+		keys[count] = key->key;
+		ctxs[count] = sign_ctx->sign_ctxs[i];
+		count++;
 	}
 
-	return KNOT_EOK;
+	if (count == 0) {
+		return KNOT_EOK;
+	}
+
+	// a module signing context is shared by the query processing threads
+	zone_sign_stats_t stats = { 0 };
+	int ret = knot_sign_rrset_keys(rrsigs, rrset, keys, ctxs, count,
+	                               sign_ctx->dnssec_ctx, &stats, mm);
+	if (ret == KNOT_EOK) {
+		zone_sign_stats_merge(sign_ctx->dnssec_ctx->stats, &stats);
+	}
+	return ret;
 }
 
 int knot_synth_rrsig(uint16_t type, const knot_rdataset_t *rrsig_rrs,
@@ -373,19 +459,17 @@ static bool is_expired_signature(const knot_rdata_t *rrsig, knot_time_t now,
 	return now >= expire64 - refresh_before || now < incept64;
 }
 
-int knot_check_signature(const knot_rrset_t *covered,
-                    const knot_rrset_t *rrsigs, size_t pos,
-                    const dnssec_key_t *key,
-                    dnssec_sign_ctx_t *sign_ctx,
-                    const kdnssec_ctx_t *dnssec_ctx,
-                    knot_timediff_t refresh,
-                    bool skip_crypto)
+/*!
+ * \brief Check RRSIG validity, the covered RRs are either in wire format or not.
+ */
+static int check_signature(const knot_rrset_t *covered,
+                           const dnssec_binary_t *covered_wire,
+                           const knot_rrset_t *rrsigs, size_t pos,
+                           dnssec_sign_ctx_t *sign_ctx,
+                           const kdnssec_ctx_t *dnssec_ctx,
+                           knot_timediff_t refresh,
+                           bool skip_crypto)
 {
-	if (knot_rrset_empty(covered) || knot_rrset_empty(rrsigs) || !key ||
-	    !sign_ctx || !dnssec_ctx) {
-		return KNOT_EINVAL;
-	}
-
 	knot_rdata_t *rrsig = knot_rdataset_at(&rrsigs->rrs, pos);
 	assert(rrsig);
 
@@ -415,7 +499,14 @@ int knot_check_signature(const knot_rrset_t *covered,
 		return result;
 	}
 
-	result = knot_sign_ctx_add_data(sign_ctx, rrsig->data, covered);
+	if (covered_wire != NULL) {
+		result = sign_ctx_add_self(sign_ctx, rrsig->data);
+		if (result == KNOT_EOK) {
+			result = dnssec_sign_add(sign_ctx, covered_wire);
+		}
+	} else {
+		result = knot_sign_ctx_add_data(sign_ctx, rrsig->data, covered);
+	}
 	if (result != KNOT_EOK) {
 		return result;
 	}
@@ -426,3 +517,36 @@ int knot_check_signature(const knot_rrset_t *covered,
 
 	return dnssec_sign_verify(sign_ctx, sign_cmp, &signature);
 }
+
+int knot_check_signature(const knot_rrset_t *covered,
+                    const knot_rrset_t *rrsigs, size_t pos,
+                    const dnssec_key_t *key,
+                    dnssec_sign_ctx_t *sign_ctx,
+                    const kdnssec_ctx_t *dnssec_ctx,
+                    knot_timediff_t refresh,
+                    bool skip_crypto)
+{
+	if (knot_rrset_empty(covered) || knot_rrset_empty(rrsigs) || !key ||
+	    !sign_ctx || !dnssec_ctx) {
+		return KNOT_EINVAL;
+	}
+
+	return check_signature(covered, NULL, rrsigs, pos, sign_ctx, dnssec_ctx,
+	                       refresh, skip_crypto);
+}
+
+int knot_check_signature_wire(const dnssec_binary_t *covered_wire,
+                              const knot_rrset_t *rrsigs, size_t pos,
+                              dnssec_sign_ctx_t *sign_ctx,
+                              const kdnssec_ctx_t *dnssec_ctx,
+                              knot_timediff_t refresh,
+                              bool skip_crypto)
+{
+	if ((!skip_crypto && (covered_wire == NULL || covered_wire->data == NULL)) ||
+	    knot_rrset_empty(rrsigs) || !sign_ctx || !dnssec_ctx) {
+		return KNOT_EINVAL;
+	}
+
+	return check_signature(NULL, covered_wire, rrsigs, pos, sign_ctx, dnssec_ctx,
+	                       refresh, skip_crypto);
+}
@@ -41,6 +41,32 @@ int knot_sign_rrset(knot_rrset_t *rrsigs,
                     const kdnssec_ctx_t *dnssec_ctx,
                     knot_mm_t *mm);
 
+/*!
+ * \brief Create RRSIG RRs for given RR set with multiple keys at once.
+ *
+ * The RR set is converted to canonical wire format only once for all
+ * the keys and the signatures are computed in a single batch.
+ *
+ * \param rrsigs      RR set with RRSIGs into which the results will be added.
+ * \param covered     RR set to create new signatures for.
+ * \param keys        Signing keys.
+ * \param sign_ctxs   Signing contexts of the keys.
+ * \param count       Number of the keys.
+ * \param dnssec_ctx  DNSSEC context.
+ * \param stats       Statistics of the calling thread to be updated (can be NULL).
+ * \param mm          Memory context.
+ *
+ * \return Error code, KNOT_EOK if successful.
+ */
+int knot_sign_rrset_keys(knot_rrset_t *rrsigs,
+                         const knot_rrset_t *covered,
+                         const dnssec_key_t *keys[],
+                         dnssec_sign_ctx_t *sign_ctxs[],
+                         size_t count,
+                         const kdnssec_ctx_t *dnssec_ctx,
+                         zone_sign_stats_t *stats,
+                         knot_mm_t *mm);
+
 /*!
  * \brief Create RRSIG RR for given RR set, choose which key to use.
  *
@@ -74,6 +100,18 @@ int knot_sign_ctx_add_data(dnssec_sign_ctx_t *ctx,
                            const uint8_t *rrsig_rdata,
                            const knot_rrset_t *covered);
 
+/*!
+ * \brief Convert the RRs covered by signatures to canonical wire format.
+ *
+ * Requires all DNAMEs in canonical form and all RRs ordered canonically.
+ *
+ * \param covered  Covered RRs.
+ * \param wire     Output: wire format, to be freed with dnssec_binary_free().
+ *
+ * \return Error code, KNOT_EOK if successful.
+ */
+int knot_covered_to_wire(const knot_rrset_t *covered, dnssec_binary_t *wire);
+
 /*!
  * \brief Creates new RRS using \a rrsig_rrs as a source. Only those RRs that
  *        cover given \a type are copied into \a out_sig
@@ -119,3 +157,27 @@ int knot_check_signature(const knot_rrset_t *covered,
                          const kdnssec_ctx_t *dnssec_ctx,
                          knot_timediff_t refresh,
                          bool skip_crypto);
+
+/*!
+ * \brief Check if RRSIG signature is valid, the covered RRs are in wire format.
+ *
+ * The covered RRs are converted to wire format by knot_covered_to_wire()
+ * just once for all the RRSIGs covering them.
+ *
+ * \param covered_wire  Covered RRs in canonical wire format (unused if skip_crypto).
+ * \param rrsigs        RR set with RRSIGs.
+ * \param pos           Number of RRSIG RR in 'rrsigs' to be validated.
+ * \param sign_ctx      Signing context of the signing key.
+ * \param dnssec_ctx    DNSSEC context.
+ * \param refresh       Consider RRSIG expired when gonna expire this soon.
+ * \param skip_crypto   All RRSIGs in this node have been verified, just check validity.
+ *
+ * \return Error code, KNOT_EOK if successful and the signature is valid.
+ * \retval KNOT_DNSSEC_EINVALID_SIGNATURE  The signature is invalid.
+ */
+int knot_check_signature_wire(const dnssec_binary_t *covered_wire,
+                              const knot_rrset_t *rrsigs, size_t pos,
+                              dnssec_sign_ctx_t *sign_ctx,
+                              const kdnssec_ctx_t *dnssec_ctx,
+                              knot_timediff_t refresh,
+                              bool skip_crypto);
@@ -32,6 +32,20 @@
 #include "knot/zone/adjust.h"
 #include "knot/zone/digest.h"
 
+/*! \brief Restarts of the background NSEC3 re-salt before finishing it at once. */
+#define NSEC3_RESALT_RESTARTS	3
+
+/*!
+ * \brief NSEC3 re-salt running in background.
+ */
+struct zone_nsec3_resalt {
+	dnssec_binary_t salt;             // New NSEC3 salt.
+	knot_nsec3_build_t build;         // New NSEC3 chain being built.
+	const zone_contents_t *contents;  // Zone contents the chain is built from.
+	uint32_t serial;                  // SOA serial of the zone contents.
+	unsigned restarts;                // Restarts due to the zone changes.
+};
+
 static knot_time_t schedule_next(kdnssec_ctx_t *kctx, const zone_keyset_t *keyset,
 				 knot_time_t keys_expire, knot_time_t rrsigs_expire)
 {
@@ -144,6 +158,28 @@ static int check_offline_records(kdnssec_ctx_t *ctx)
 	return KNOT_EOK;
 }
 
+/*!
+ * \brief Check if the NSEC3 re-salt is to be left to the background event.
+ *
+ * Only a periodic re-salt of an already loaded zone is done in background,
+ * other salt changes take place at once. A re-salt in progress is kept.
+ */
+static bool nsec3resalt_background(const kdnssec_ctx_t *ctx, const zone_t *zone)
+{
+	if (zone->nsec3_resalt != NULL) {
+		return true;
+	}
+
+	const knot_kasp_policy_t *policy = ctx->policy;
+	knot_time_t created = ctx->zone->nsec3_salt_created;
+
+	return zone->contents != NULL && policy->nsec3_enabled &&
+	       policy->nsec3_salt_lifetime > 0 && policy->nsec3_salt_length > 0 &&
+	       ctx->zone->nsec3_salt.size == policy->nsec3_salt_length &&
+	       created != 0 && knot_time_cmp(ctx->now, created) >= 0 &&
+	       knot_time_cmp(knot_time_plus(created, policy->nsec3_salt_lifetime), ctx->now) <= 0;
+}
+
 int knot_dnssec_zone_sign(zone_update_t *update,
                           conf_t *conf,
                           zone_sign_flags_t flags,
@@ -220,8 +256,10 @@ int knot_dnssec_zone_sign(zone_update_t *update,
 		goto done;
 	}
 
-	// perform nsec3resalt if pending
-	if (roll_flags & KEY_ROLL_ALLOW_NSEC3RESALT) {
+	// perform nsec3resalt if pending, possibly leave it to the background event
+	if ((roll_flags & KEY_ROLL_BG_NSEC3RESALT) && nsec3resalt_background(&ctx, update->zone)) {
+		reschedule->plan_nsec3resalt = true;
+	} else if (roll_flags & KEY_ROLL_ALLOW_NSEC3RESALT) {
 		bool issbaz = update->zone->contents == NULL
 		            ? true /* dont perform opportunistic resalt upon cold start */
 		            : is_soa_signed_by_all_zsks(&keyset, node_rdataset(update->zone->contents->apex, KNOT_RRTYPE_RRSIG));
@@ -468,6 +506,216 @@ done:
 	return result;
 }
 
+int knot_dnssec_nsec3resalt_step(conf_t *conf, zone_t *zone,
+                                 zone_sign_reschedule_t *reschedule)
+{
+	if (conf == NULL || zone == NULL || reschedule == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	if (zone->contents == NULL) {
+		return KNOT_EEMPTYZONE;
+	}
+
+	kdnssec_ctx_t ctx = { 0 };
+	int ret = kdnssec_ctx_init(conf, &ctx, zone->name, zone_kaspdb(zone), NULL);
+	if (ret != KNOT_EOK) {
+		log_zone_error(zone->name, "DNSSEC, failed to initialize signing context (%s)",
+		               knot_strerror(ret));
+		return ret;
+	}
+
+	update_policy_from_zone(ctx.policy, zone->contents);
+
+	conf_val_t val = conf_zone_get(conf, C_DNSSEC_SIGNING, zone->name);
+	if (!conf_bool(&val) || !ctx.policy->nsec3_enabled) {
+		ret = KNOT_ENOTSUP;
+		goto done;
+	}
+
+	struct zone_nsec3_resalt *resalt = zone->nsec3_resalt;
+	if (resalt == NULL) {
+		resalt = calloc(1, sizeof(*resalt));
+		if (resalt == NULL) {
+			ret = KNOT_ENOMEM;
+			goto done;
+		}
+		zone->nsec3_resalt = resalt;
+
+		ret = generate_salt(&resalt->salt, ctx.policy->nsec3_salt_length);
+		if (ret != KNOT_EOK) {
+			goto done;
+		}
+		log_zone_info(zone->name, "DNSSEC, NSEC3 re-salt started in background");
+	} else if (resalt->contents != zone->contents ||
+	           resalt->serial != zone_contents_serial(zone->contents)) {
+		knot_nsec3_build_deinit(&resalt->build);
+		resalt->restarts++;
+		log_zone_info(zone->name, "DNSSEC, zone changed, restarting NSEC3 re-salt");
+	}
+
+	if (resalt->build.nsec3_nodes == NULL) {
+		ret = knot_zone_nsec3_build_init(&resalt->build, zone->contents, &ctx,
+		                                 &resalt->salt);
+		if (ret != KNOT_EOK) {
+			goto done;
+		}
+		resalt->contents = zone->contents;
+		resalt->serial = zone_contents_serial(zone->contents);
+	}
+
+	// One part per thread, the rest at once if the zone changes too often.
+	unsigned threads = ctx.policy->signing_threads;
+	unsigned max_parts = (resalt->restarts < NSEC3_RESALT_RESTARTS) ?
+	                     threads : resalt->build.parts;
+	ret = knot_nsec3_build_step(&resalt->build, zone->contents, threads, max_parts);
+	if (ret == KNOT_EOK && !knot_nsec3_build_finished(&resalt->build)) {
+		ret = KNOT_EAGAIN;
+	}
+
+done:
+	if (ret != KNOT_EOK && ret != KNOT_EAGAIN) {
+		log_zone_error(zone->name, "DNSSEC, failed to build NSEC3 chain with new salt (%s)",
+		               knot_strerror(ret));
+		reschedule->next_sign = knot_dnssec_failover_delay(&ctx);
+	}
+
+	kdnssec_ctx_deinit(&ctx);
+
+	return ret;
+}
+
+int knot_dnssec_nsec3resalt_apply(zone_update_t *update, conf_t *conf,
+                                  zone_sign_reschedule_t *reschedule)
+{
+	if (update == NULL || conf == NULL || reschedule == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	struct zone_nsec3_resalt *resalt = update->zone->nsec3_resalt;
+	if (resalt == NULL || resalt->build.nsec3_nodes == NULL ||
+	    !knot_nsec3_build_finished(&resalt->build) ||
+	    resalt->contents != update->zone->contents) {
+		return KNOT_EINVAL;
+	}
+
+	const knot_dname_t *zone_name = update->new_cont->apex->owner;
+	kdnssec_ctx_t ctx = { 0 };
+	zone_keyset_t keyset = { 0 };
+
+	int result = kdnssec_ctx_init(conf, &ctx, zone_name, zone_kaspdb(update->zone), NULL);
+	if (result != KNOT_EOK) {
+		log_zone_error(zone_name, "DNSSEC, failed to initialize signing context (%s)",
+		               knot_strerror(result));
+		return result;
+	}
+
+	update_policy_from_zone(ctx.policy, update->new_cont);
+
+	// create placeholder ZONEMD to be signed and later filled in
+	conf_val_t val = conf_zone_get(conf, C_ZONEMD_GENERATE, zone_name);
+	unsigned zonemd_alg = conf_opt(&val);
+	if (zonemd_alg != ZONE_DIGEST_NONE) {
+		result = zone_update_add_digest(update, zonemd_alg, true);
+		if (result != KNOT_EOK) {
+			log_zone_error(zone_name, "DNSSEC, failed to reserve dummy ZONEMD (%s)",
+			               knot_strerror(result));
+			goto done;
+		}
+	}
+
+	result = load_zone_keys(&ctx, &keyset, false);
+	if (result != KNOT_EOK) {
+		log_zone_error(zone_name, "DNSSEC, failed to load keys (%s)",
+		               knot_strerror(result));
+		goto done;
+	}
+
+	result = knot_zone_nsec3_build_apply(&resalt->build, update);
+	if (result != KNOT_EOK) {
+		log_zone_error(zone_name, "DNSSEC, failed to replace NSEC3 chain (%s)",
+		               knot_strerror(result));
+		goto done;
+	}
+
+	result = knot_zone_sign_nsec3_nodes(update, &keyset, &ctx);
+	if (result == KNOT_EOK) {
+		result = knot_zone_sign_apex_rr(update, KNOT_RRTYPE_NSEC3PARAM, &keyset, &ctx);
+	}
+	if (result != KNOT_EOK) {
+		log_zone_error(zone_name, "DNSSEC, failed to sign NSEC3 chain (%s)",
+		               knot_strerror(result));
+		goto done;
+	}
+
+	result = zone_update_increment_soa(update, conf);
+	if (result == KNOT_EOK) {
+		result = knot_zone_sign_apex_rr(update, KNOT_RRTYPE_SOA, &keyset, &ctx);
+	}
+	if (result != KNOT_EOK) {
+		log_zone_error(zone_name, "DNSSEC, failed to update SOA record (%s)",
+		               knot_strerror(result));
+		goto done;
+	}
+
+	// fill in ZONEMD if desired
+	if (zonemd_alg != ZONE_DIGEST_NONE && zonemd_alg != ZONE_DIGEST_REMOVE) {
+		result = zone_update_add_digest(update, zonemd_alg, false);
+		if (result == KNOT_EOK) {
+			result = knot_zone_sign_apex_rr(update, KNOT_RRTYPE_ZONEMD, &keyset, &ctx);
+		}
+		if (result != KNOT_EOK) {
+			log_zone_error(zone_name, "DNSSEC, failed to update ZONEMD record (%s)",
+			               knot_strerror(result));
+			goto done;
+		}
+	}
+
+	// the new salt takes effect with the update to be committed right away
+	dnssec_binary_free(&ctx.zone->nsec3_salt);
+	ctx.zone->nsec3_salt = resalt->salt;
+	ctx.zone->nsec3_salt_created = ctx.now;
+	resalt->salt = (dnssec_binary_t){ 0 };
+	result = kdnssec_ctx_commit(&ctx);
+	if (result != KNOT_EOK) {
+		log_zone_error(zone_name, "DNSSEC, failed to update NSEC3 salt (%s)",
+		               knot_strerror(result));
+		goto done;
+	}
+
+	log_zone_info(zone_name, "DNSSEC, NSEC3 re-salted, serial %u, new RRSIGs %zu",
+	              zone_contents_serial(update->new_cont), ctx.stats->rrsig_count);
+
+done:
+	if (result == KNOT_EOK) {
+		reschedule->last_nsec3resalt = ctx.now;
+		if (ctx.policy->nsec3_salt_lifetime > 0) {
+			reschedule->next_nsec3resalt = knot_time_plus(ctx.now, ctx.policy->nsec3_salt_lifetime);
+		}
+		update->new_cont->dnssec_expire = knot_time_min(update->zone->contents->dnssec_expire,
+		                                                ctx.stats->expire);
+	} else {
+		reschedule->next_sign = knot_dnssec_failover_delay(&ctx);
+	}
+
+	free_zone_keys(&keyset);
+	kdnssec_ctx_deinit(&ctx);
+
+	return result;
+}
+
+void knot_dnssec_nsec3resalt_free(zone_t *zone)
+{
+	if (zone == NULL || zone->nsec3_resalt == NULL) {
+		return;
+	}
+
+	knot_nsec3_build_deinit(&zone->nsec3_resalt->build);
+	dnssec_binary_free(&zone->nsec3_resalt->salt);
+	free(zone->nsec3_resalt);
+	zone->nsec3_resalt = NULL;
+}
+
 knot_time_t knot_dnssec_failover_delay(const kdnssec_ctx_t *ctx)
 {
 	if (ctx->policy == NULL) {
@@ -510,6 +758,7 @@ int knot_dnssec_validate_zone(zone_update_t *update, validation_conf_t *val_conf
 		ctx.now = val_conf->now;
 	}
 
+	struct timespec begin = time_now();
 	ret = knot_zone_check_nsec_chain(update, &ctx, val_conf->incremental);
 	if (ret == KNOT_EOK) {
 		assert(ctx.validation_mode);
@@ -519,6 +768,14 @@ int knot_dnssec_validate_zone(zone_update_t *update, validation_conf_t *val_conf
 			ret = knot_zone_sign(update, NULL, &ctx);
 		}
 	}
+	struct timespec end = time_now();
+	log_zone_debug(update->new_cont->apex->owner,
+	               "DNSSEC, %svalidation, RRSIGs %zu, threads %u, time %.02f seconds, "
+	               "verifying time %.02f seconds, verified RRSIGs %zu in %zu key batches",
+	               val_conf->incremental ? "incremental " : "",
+	               ctx.stats->rrsig_count, ctx.policy->signing_threads,
+	               time_diff_ms(&begin, &end) / 1000.0, ctx.stats->verify_time / 1000000.0,
+	               ctx.stats->verify_count, ctx.stats->verify_batches);
 end:
 	if (val_conf->log_plan) {
 		const char *msg_valid = val_conf->incremental ? "incremental " : "";
@@ -38,6 +38,7 @@ typedef enum {
 	                             KEY_ROLL_ALLOW_ZSK_ROLL |
 	                             KEY_ROLL_ALLOW_NSEC3RESALT,
 	KEY_ROLL_PRESERVE_FUTURE   = (1 << 5),
+	KEY_ROLL_BG_NSEC3RESALT    = (1 << 6),
 } zone_sign_roll_flags_t;
 
 typedef struct {
@@ -48,6 +49,7 @@ typedef struct {
 	bool keys_changed;
 	bool plan_ds_check;
 	bool plan_dnskey_sync;
+	bool plan_nsec3resalt;
 } zone_sign_reschedule_t;
 
 typedef struct {
@@ -108,6 +110,45 @@ int knot_dnssec_sign_update(zone_update_t *update, conf_t *conf);
 int knot_dnssec_nsec3resalt(kdnssec_ctx_t *ctx, bool soa_rrsigs_ok,
                             knot_time_t *salt_changed, knot_time_t *when_resalt);
 
+/*!
+ * \brief Build the NSEC3 chain with a new salt in background, next step.
+ *
+ * The first step generates the new salt. Each step creates the new NSEC3
+ * records for one part of the zone per signing thread, so that other zone
+ * events can run between the steps. If the zone contents changed since
+ * the previous step, the build is restarted. After several restarts, all
+ * the remaining parts are built at once.
+ *
+ * \param conf        Knot configuration.
+ * \param zone        Zone to be re-salted.
+ * \param reschedule  Out: next signing attempt if failed.
+ *
+ * \retval KNOT_EAGAIN  if another step is needed.
+ * \retval KNOT_EOK     if the new chain is ready to be applied.
+ * \return KNOT_E*
+ */
+int knot_dnssec_nsec3resalt_step(conf_t *conf, zone_t *zone,
+                                 zone_sign_reschedule_t *reschedule);
+
+/*!
+ * \brief Replace the NSEC3 chain with the one built in background and sign it.
+ *
+ * The new salt is stored into KASP DB, the update is to be committed at once.
+ *
+ * \param update      Zone update with current zone contents.
+ * \param conf        Knot configuration.
+ * \param reschedule  Out: next re-salt, or next signing attempt if failed.
+ *
+ * \return KNOT_E*
+ */
+int knot_dnssec_nsec3resalt_apply(zone_update_t *update, conf_t *conf,
+                                  zone_sign_reschedule_t *reschedule);
+
+/*!
+ * \brief Drop the background NSEC3 re-salt of the zone, if any.
+ */
+void knot_dnssec_nsec3resalt_free(zone_t *zone);
+
 /*!
  * \brief When DNSSEC signing failed, re-plan on this time.
  *
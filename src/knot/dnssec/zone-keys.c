@@ -698,21 +698,31 @@ zone_sign_ctx_t *zone_sign_ctx(const zone_keyset_t *keyset, const kdnssec_ctx_t
 zone_sign_ctx_t *zone_validation_ctx(const kdnssec_ctx_t *dnssec_ctx)
 {
 	size_t count = dnssec_ctx->zone->num_keys;
-	zone_sign_ctx_t *ctx = calloc(1, sizeof(*ctx) + count * sizeof(*ctx->sign_ctxs));
+	zone_sign_ctx_t *ctx = calloc(1, sizeof(*ctx) + count * sizeof(*ctx->sign_ctxs) +
+	                                 count * sizeof(*ctx->verify_keys));
 	if (ctx == NULL) {
 		return NULL;
 	}
 
 	ctx->sign_ctxs = (dnssec_sign_ctx_t **)(ctx + 1);
+	ctx->verify_keys = (zone_verify_key_t *)(ctx->sign_ctxs + count);
 	ctx->count = count;
 	ctx->keys = NULL;
 	ctx->dnssec_ctx = dnssec_ctx;
 	for (size_t i = 0; i < ctx->count; i++) {
-		int ret = dnssec_sign_new(&ctx->sign_ctxs[i], dnssec_ctx->zone->keys[i].key);
+		const knot_kasp_key_t *key = &dnssec_ctx->zone->keys[i];
+		int ret = dnssec_sign_new(&ctx->sign_ctxs[i], key->key);
 		if (ret != DNSSEC_EOK) {
 			zone_sign_ctx_free(ctx);
 			return NULL;
 		}
+
+		ctx->verify_keys[i] = (zone_verify_key_t) {
+			.keytag = dnssec_key_get_keytag(key->key),
+			.algorithm = dnssec_key_get_algorithm(key->key),
+			.is_ksk = key->is_ksk,
+			.is_zsk = key->is_zsk,
+		};
 	}
 
 	return ctx;
@@ -721,6 +731,9 @@ zone_sign_ctx_t *zone_validation_ctx(const kdnssec_ctx_t *dnssec_ctx)
 void zone_sign_ctx_free(zone_sign_ctx_t *ctx)
 {
 	if (ctx != NULL) {
+		if (ctx->dnssec_ctx != NULL) {
+			zone_sign_stats_merge(ctx->dnssec_ctx->stats, &ctx->stats);
+		}
 		for (size_t i = 0; i < ctx->count; i++) {
 			if (ctx->keys != NULL) {
 				dnssec_key_free(ctx->keys[i].key);
@@ -53,6 +53,16 @@ typedef struct {
 	zone_key_t *keys;
 } zone_keyset_t;
 
+/*!
+ * \brief DNSKEY parameters cached for matching of the RRSIGs being verified.
+ */
+typedef struct {
+	uint16_t keytag;
+	uint8_t algorithm;
+	bool is_ksk;
+	bool is_zsk;
+} zone_verify_key_t;
+
 /*!
  * \brief Signing context used for single signing thread.
  */
@@ -60,7 +70,9 @@ typedef struct {
 	size_t count;                     // number of keys in keyset
 	zone_key_t *keys;                 // keys in keyset
 	dnssec_sign_ctx_t **sign_ctxs;    // signing buffers for keys in keyset
+	zone_verify_key_t *verify_keys;   // cached DNSKEY parameters (validation only)
 	const kdnssec_ctx_t *dnssec_ctx;  // dnssec context
+	zone_sign_stats_t stats;          // thread-local stats, merged into dnssec context on free
 } zone_sign_ctx_t;
 
 /*!
@@ -176,6 +188,10 @@ zone_sign_ctx_t *zone_sign_ctx(const zone_keyset_t *keyset, const kdnssec_ctx_t
 
 /*!
  * \brief Initialize local validating context.
+ *
+ * The public keys are imported once per DNSKEY for the whole validation,
+ * their key tags and algorithms are cached in the context.
+ *
  * \param dnssec_ctx  DNSSEC context.
  * \return New local validating context or NULL.
  */
@@ -184,6 +200,7 @@ zone_sign_ctx_t *zone_validation_ctx(const kdnssec_ctx_t *dnssec_ctx);
 /*!
  * \brief Free local signing context.
  *
+ * \note The locally gathered statistics are added to the DNSSEC context.
  * \note This doesn't free the underlying keyset.
  *
  * \param ctx  Local context to be freed.
@@ -313,7 +313,7 @@ static dnssec_nsec3_params_t nsec3param_init(const knot_kasp_policy_t *policy,
 }
 
 // int: returns KNOT_E* if error
-static int zone_nsec_ttl(zone_contents_t *zone)
+static int zone_nsec_ttl(const zone_contents_t *zone)
 {
 	knot_rrset_t soa = node_rrset(zone->apex, KNOT_RRTYPE_SOA);
 	if (knot_rrset_empty(&soa)) {
@@ -347,7 +347,7 @@ int knot_zone_create_nsec_chain(zone_update_t *update, const kdnssec_ctx_t *ctx)
 
 	if (ctx->policy->nsec3_enabled) {
 		ret = knot_nsec3_create_chain(update->new_cont, &params, nsec_ttl,
-		                              update);
+		                              ctx->policy->signing_threads, update);
 	} else {
 		ret = knot_nsec_create_chain(update, nsec_ttl);
 		if (ret == KNOT_EOK) {
@@ -357,6 +357,39 @@ int knot_zone_create_nsec_chain(zone_update_t *update, const kdnssec_ctx_t *ctx)
 	return ret;
 }
 
+int knot_zone_nsec3_build_init(knot_nsec3_build_t *build, const zone_contents_t *zone,
+                               const kdnssec_ctx_t *ctx, const dnssec_binary_t *salt)
+{
+	if (build == NULL || zone == NULL || ctx == NULL || salt == NULL ||
+	    !ctx->policy->nsec3_enabled) {
+		return KNOT_EINVAL;
+	}
+
+	int nsec_ttl = zone_nsec_ttl(zone);
+	if (nsec_ttl < 0) {
+		return nsec_ttl;
+	}
+
+	dnssec_nsec3_params_t params = nsec3param_init(ctx->policy, ctx->zone);
+	params.salt = *salt;
+
+	return knot_nsec3_build_init(build, zone, &params, nsec_ttl);
+}
+
+int knot_zone_nsec3_build_apply(knot_nsec3_build_t *build, zone_update_t *update)
+{
+	if (build == NULL || update == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	int ret = knot_nsec3param_update(update, &build->params, build->ttl);
+	if (ret != KNOT_EOK) {
+		return ret;
+	}
+
+	return knot_nsec3_build_apply(build, update);
+}
+
 int knot_zone_fix_nsec_chain(zone_update_t *update,
                              const zone_keyset_t *zone_keys,
                              const kdnssec_ctx_t *ctx)
@@ -389,8 +422,8 @@ int knot_zone_fix_nsec_chain(zone_update_t *update,
 		log_zone_info(update->zone->name, "DNSSEC, re-creating whole NSEC%s chain",
 		              (ctx->policy->nsec3_enabled ? "3" : ""));
 		if (ctx->policy->nsec3_enabled) {
-			ret = knot_nsec3_create_chain(update->new_cont, &params,
-			                              nsec_ttl_new, update);
+			ret = knot_nsec3_create_chain(update->new_cont, &params, nsec_ttl_new,
+			                              ctx->policy->signing_threads, update);
 		} else {
 			ret = knot_nsec_create_chain(update, nsec_ttl_new);
 		}
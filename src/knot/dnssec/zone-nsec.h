@@ -19,6 +19,7 @@
 #include <stdbool.h>
 
 #include "knot/dnssec/context.h"
+#include "knot/dnssec/nsec3-chain.h"
 #include "knot/dnssec/zone-keys.h"
 #include "knot/updates/zone-update.h"
 #include "knot/zone/contents.h"
@@ -133,6 +134,29 @@ int knot_nsec3param_update(zone_update_t *update,
  */
 int knot_zone_create_nsec_chain(zone_update_t *update, const kdnssec_ctx_t *ctx);
 
+/*!
+ * \brief Start a resumable build of the NSEC3 chain with a new salt.
+ *
+ * \param build  Build to be initialized.
+ * \param zone   Zone contents the chain will be built from.
+ * \param ctx    Signing context.
+ * \param salt   New NSEC3 salt (must outlive the build).
+ *
+ * \return Error code, KNOT_EOK if successful.
+ */
+int knot_zone_nsec3_build_init(knot_nsec3_build_t *build, const zone_contents_t *zone,
+                               const kdnssec_ctx_t *ctx, const dnssec_binary_t *salt);
+
+/*!
+ * \brief Replace the NSEC3 chain and NSEC3PARAM with the finished build.
+ *
+ * \param build   Finished build of the NSEC3 chain.
+ * \param update  Zone update to be updated with the new chain.
+ *
+ * \return Error code, KNOT_EOK if successful.
+ */
+int knot_zone_nsec3_build_apply(knot_nsec3_build_t *build, zone_update_t *update);
+
 /*!
  * \brief Fix NSEC or NSEC3 chain after zone was updated, and sign the changed NSECs.
  *
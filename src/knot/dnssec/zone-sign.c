@@ -15,7 +15,6 @@
  */
 
 #include <assert.h>
-#include <pthread.h>
 #include <sys/types.h>
 
 #include "libdnssec/error.h"
@@ -27,8 +26,10 @@
 #include "knot/dnssec/key_records.h"
 #include "knot/dnssec/rrset-sign.h"
 #include "knot/dnssec/zone-sign.h"
+#include "knot/worker/parallel.h"
 #include "libknot/libknot.h"
 #include "libknot/dynarray.h"
+#include "contrib/openbsd/siphash.h"
 #include "contrib/wire_ctx.h"
 
 typedef struct {
@@ -161,6 +162,87 @@ static bool valid_signature_exists(const knot_rrset_t *covered,
 	return found_valid;
 }
 
+/*!
+ * \brief Verify all RRSIGs made by one validated key in a batch.
+ *
+ * The matching RRSIGs are selected by the cached key tag and algorithm first,
+ * then verified using the same key context and the covered RR set converted
+ * to canonical wire format just once for all the keys.
+ *
+ * \param covered         RR set with covered records.
+ * \param covered_wire    In/out: canonical wire of the covered records (lazily created).
+ * \param rrsigs          RR set with RRSIGs.
+ * \param key             Cached parameters of the validated key.
+ * \param ctx             Signing context of the key.
+ * \param dnssec_ctx      DNSSEC context.
+ * \param skip_crypto     All RRSIGs in this node have been verified, just check validity.
+ * \param invalid_map     Out: found valid (bit VALID_SIG_FOUND) and invalid count
+ *                             positions of RRSIG with matching algo+keytag+type.
+ * \param at              Out: RRSIG position.
+ * \param stats           Statistics to be updated.
+ *
+ * \return The signature exists and is valid.
+ */
+static bool valid_signature_batch(const knot_rrset_t *covered,
+                                  dnssec_binary_t *covered_wire,
+                                  const knot_rrset_t *rrsigs,
+                                  const zone_verify_key_t *key,
+                                  dnssec_sign_ctx_t *ctx,
+                                  const kdnssec_ctx_t *dnssec_ctx,
+                                  bool skip_crypto,
+                                  uint8_t *invalid_map,
+                                  uint16_t *at,
+                                  zone_sign_stats_t *stats)
+{
+	if (knot_rrset_empty(rrsigs)) {
+		return false;
+	}
+
+	uint16_t batch[rrsigs->rrs.count];
+	uint16_t batch_size = 0;
+
+	knot_rdata_t *rdata = rrsigs->rrs.rdata;
+	for (uint16_t i = 0; i < rrsigs->rrs.count; i++) {
+		if (knot_rrsig_key_tag(rdata) == key->keytag &&
+		    knot_rrsig_alg(rdata) == key->algorithm &&
+		    knot_rrsig_type_covered(rdata) == covered->type) {
+			batch[batch_size++] = i;
+		}
+		rdata = knot_rdataset_next(rdata);
+	}
+	if (batch_size == 0) {
+		return false;
+	}
+
+	int wire_ret = KNOT_EOK;
+	if (!skip_crypto) {
+		if (covered_wire->data == NULL) {
+			wire_ret = knot_covered_to_wire(covered, covered_wire);
+		}
+		stats->verify_batches++;
+		stats->verify_count += batch_size;
+	}
+
+	bool found_valid = false;
+	for (uint16_t j = 0; j < batch_size; j++) {
+		uint16_t i = batch[j];
+		int ret = wire_ret;
+		if (ret == KNOT_EOK) {
+			ret = knot_check_signature_wire(covered_wire, rrsigs, i, ctx,
+			                                dnssec_ctx, 0, skip_crypto);
+		}
+		if (ret == KNOT_EOK) {
+			*at = i;
+			invalid_map[i] |= VALID_SIG_FOUND;
+			found_valid = true; // continue searching for invalid RRSIG
+		} else if ((++invalid_map[i] & ~VALID_SIG_FOUND) == VALID_KEYTAG_LIMIT) {
+			return found_valid;
+		}
+	}
+
+	return found_valid;
+}
+
 /*!
  * \brief Note earliest expiration of a signature.
  *
@@ -243,6 +325,10 @@ static int add_missing_rrsigs(const knot_rrset_t *covered,
 		}
 	}
 
+	const dnssec_key_t *sign_keys[sign_ctx->count + 1];
+	dnssec_sign_ctx_t *sign_ctxs[sign_ctx->count + 1];
+	size_t sign_count = 0;
+
 	for (size_t i = 0; i < sign_ctx->count && result == KNOT_EOK; i++) {
 		const zone_key_t *key = &sign_ctx->keys[i];
 		if (!knot_zone_sign_use_key(key, covered)) {
@@ -256,14 +342,19 @@ static int add_missing_rrsigs(const knot_rrset_t *covered,
 		                           sign_ctx->dnssec_ctx, refresh, skip_crypto, NULL, &valid_at)) {
 			knot_rdata_t *valid_rr = knot_rdataset_at(&rrsigs->rrs, valid_at);
 			result = knot_rdataset_remove(&to_remove.rrs, valid_rr, NULL);
-			knot_spin_lock(&sign_ctx->dnssec_ctx->stats->lock);
 			note_earliest_expiration(valid_rr, sign_ctx->dnssec_ctx->now,
-			                         &sign_ctx->dnssec_ctx->stats->expire);
-			knot_spin_unlock(&sign_ctx->dnssec_ctx->stats->lock);
+			                         &sign_ctx->stats.expire);
 			continue;
 		}
-		result = knot_sign_rrset(&to_add, covered, key->key, sign_ctx->sign_ctxs[i],
-		                         sign_ctx->dnssec_ctx, NULL);
+		sign_keys[sign_count] = key->key;
+		sign_ctxs[sign_count] = sign_ctx->sign_ctxs[i];
+		sign_count++;
+	}
+
+	if (sign_count > 0 && result == KNOT_EOK) {
+		result = knot_sign_rrset_keys(&to_add, covered, sign_keys, sign_ctxs,
+		                              sign_count, sign_ctx->dnssec_ctx,
+		                              &sign_ctx->stats, NULL);
 	}
 
 	if (!knot_rrset_empty(&to_remove) && result == KNOT_EOK) {
@@ -317,26 +408,40 @@ int knot_validate_rrsigs(const knot_rrset_t *covered,
 	uint8_t val_inval_map[1 + rrsigs->rrs.count]; // Ensure the size isn't 0 (UBSAN).
 	memset(val_inval_map, 0, sizeof(val_inval_map));
 
+	struct timespec begin = { 0 };
+	if (!skip_crypto) {
+		begin = time_now();
+	}
+
+	dnssec_binary_t covered_wire = { 0 };
 	bool valid_exists = false;
 	for (size_t i = 0; i < sign_ctx->count; i++) {
-		const knot_kasp_key_t *key = &sign_ctx->dnssec_ctx->zone->keys[i];
+		const zone_verify_key_t *key = &sign_ctx->verify_keys[i];
 		if (!key_used(key->is_ksk, key->is_zsk, covered->type,
 		              covered->owner, sign_ctx->dnssec_ctx->zone->dname)) {
 			continue;
 		}
 
 		uint16_t valid_at;
-		if (valid_signature_exists(covered, rrsigs, key->key, sign_ctx->sign_ctxs[i],
-		                           sign_ctx->dnssec_ctx, 0, skip_crypto, val_inval_map, &valid_at)) {
+		if (valid_signature_batch(covered, &covered_wire, rrsigs, key,
+		                          sign_ctx->sign_ctxs[i], sign_ctx->dnssec_ctx,
+		                          skip_crypto, val_inval_map, &valid_at,
+		                          &sign_ctx->stats)) {
 			valid_exists = true;
 			knot_rdata_t *valid_rr = knot_rdataset_at(&rrsigs->rrs, valid_at);
 			note_earliest_expiration(valid_rr, sign_ctx->dnssec_ctx->now, valid_until);
 		}
 
-		knot_spin_lock(&sign_ctx->dnssec_ctx->stats->lock);
-		sign_ctx->dnssec_ctx->stats->rrsig_count++;
-		sign_ctx->dnssec_ctx->stats->expire = knot_time_min(sign_ctx->dnssec_ctx->stats->expire, *valid_until);
-		knot_spin_unlock(&sign_ctx->dnssec_ctx->stats->lock);
+		sign_ctx->stats.rrsig_count++;
+		sign_ctx->stats.expire = knot_time_min(sign_ctx->stats.expire, *valid_until);
+	}
+
+	dnssec_binary_free(&covered_wire);
+
+	if (!skip_crypto) {
+		struct timespec end = time_now();
+		struct timespec diff = time_diff(&begin, &end);
+		sign_ctx->stats.verify_time += diff.tv_sec * 1000000 + diff.tv_nsec / 1000;
 	}
 
 	for (int i = 0; i < rrsigs->rrs.count; i++) {
@@ -542,11 +647,6 @@ typedef struct {
 	changeset_t changeset;
 	dnssec_validation_hint_t *hint;
 	size_t num_threads;
-	size_t thread_index;
-	size_t rrset_index;
-	int errcode;
-	int thread_init_errcode;
-	pthread_t thread;
 } node_sign_args_t;
 
 /*!
@@ -566,18 +666,24 @@ static int sign_node(zone_node_t *node, void *data)
 		return KNOT_EOK;
 	}
 
-	if (args->rrset_index++ % args->num_threads != args->thread_index) {
-		return KNOT_EOK;
-	}
-
 	return sign_node_rrsets(node, args->sign_ctx, &args->changeset, args->hint);
 }
 
-static void *tree_sign_thread(void *_arg)
+static int tree_sign_parts(unsigned idx, void *ctx)
 {
-	node_sign_args_t *arg = _arg;
-	arg->errcode = zone_tree_apply(arg->tree, sign_node, _arg);
-	return NULL;
+	node_sign_args_t *arg = (node_sign_args_t *)ctx + idx;
+
+	if (arg->num_threads == 1) {
+		return zone_tree_apply(arg->tree, sign_node, arg);
+	}
+
+	unsigned parts = arg->num_threads * PARALLEL_PARTS_PER_THREAD;
+	int ret = KNOT_EOK;
+	for (unsigned part = idx; part < parts && ret == KNOT_EOK; part += arg->num_threads) {
+		ret = zone_tree_apply_part(arg->tree, part, parts, sign_node, arg);
+	}
+
+	return ret;
 }
 
 static int set_signed(zone_node_t *node, _unused_ void *data)
@@ -627,10 +733,6 @@ static int zone_tree_sign(zone_tree_t *tree,
 		}
 		args[i].hint = &update->validation_hint;
 		args[i].num_threads = num_threads;
-		args[i].thread_index = i;
-		args[i].rrset_index = 0;
-		args[i].errcode = KNOT_EOK;
-		args[i].thread_init_errcode = -1;
 	}
 	if (ret != KNOT_EOK) {
 		for (size_t i = 0; i < num_threads; i++) {
@@ -640,35 +742,12 @@ static int zone_tree_sign(zone_tree_t *tree,
 		return ret;
 	}
 
-	if (num_threads == 1) {
-		args[0].thread_init_errcode = 0;
-		tree_sign_thread(&args[0]);
-	} else {
-		// start working threads
-		for (size_t i = 0; i < num_threads; i++) {
-			args[i].thread_init_errcode =
-				pthread_create(&args[i].thread, NULL, tree_sign_thread, &args[i]);
-		}
-
-		// join those threads that have been really started
-		for (size_t i = 0; i < num_threads; i++) {
-			if (args[i].thread_init_errcode == 0) {
-				args[i].thread_init_errcode = pthread_join(args[i].thread, NULL);
-			}
-		}
-	}
+	ret = parallel_run(num_threads, tree_sign_parts, args);
 
-	// collect return code and results
+	// collect results
 	for (size_t i = 0; i < num_threads; i++) {
-		if (ret == KNOT_EOK) {
-			if (args[i].thread_init_errcode != 0) {
-				ret = knot_map_errno_code(args[i].thread_init_errcode);
-			} else {
-				ret = args[i].errcode;
-				if (ret == KNOT_EOK && !dnssec_ctx->validation_mode) {
-					ret = zone_update_apply_changeset(update, &args[i].changeset); // _fix not needed
-				}
-			}
+		if (ret == KNOT_EOK && !dnssec_ctx->validation_mode) {
+			ret = zone_update_apply_changeset(update, &args[i].changeset); // _fix not needed
 		}
 		assert(!dnssec_ctx->validation_mode || changeset_empty(&args[i].changeset));
 		changeset_clear(&args[i].changeset);
@@ -703,6 +782,96 @@ static int rrset_add_zone_ds(knot_rrset_t *rrset, zone_key_t *zone_key, dnssec_k
 	return knot_rrset_add_rdata(rrset, cds_rdata.data, cds_rdata.size, NULL);
 }
 
+/*!
+ * \brief Compute an identifier of the keys and their roles in signing.
+ *
+ * The identifier doesn't depend on the order of the keys.
+ */
+static uint64_t zone_keys_id(const zone_keyset_t *zone_keys)
+{
+	const SIPHASH_KEY hash_key = { 0 };
+	uint64_t id = 0;
+
+	for (size_t i = 0; i < zone_keys->count; i++) {
+		const zone_key_t *key = &zone_keys->keys[i];
+		uint8_t roles = key->is_ksk | (key->is_zsk << 1) | (key->is_active << 2) |
+		                (key->is_ksk_active_plus << 3) | (key->is_zsk_active_plus << 4);
+		dnssec_binary_t rdata = { 0 };
+		dnssec_key_get_rdata(key->key, &rdata);
+
+		SIPHASH_CTX ctx;
+		SipHash24_Init(&ctx, &hash_key);
+		SipHash24_Update(&ctx, &roles, sizeof(roles));
+		SipHash24_Update(&ctx, rdata.data, rdata.size);
+		id += SipHash24_End(&ctx);
+	}
+
+	return (id != 0) ? id : 1;
+}
+
+static int add_expiring_node(const knot_dname_t *owner, bool nsec3, void *ctx)
+{
+	zone_update_t *update = ctx;
+	zone_tree_t *tree = nsec3 ? update->new_cont->nsec3_nodes : update->new_cont->nodes;
+
+	zone_node_t *node = zone_tree_get(tree, owner);
+	if (node == NULL) {
+		return KNOT_EOK; // stale entry of a removed node
+	}
+
+	return zone_tree_insert(nsec3 ? update->a_ctx->nsec3_ptrs : update->a_ctx->node_ptrs, &node);
+}
+
+/*!
+ * \brief Update RRSIGs of the changed nodes and of the nodes indexed as expiring.
+ *
+ * \param update      Zone update with the expiry index in its contents.
+ * \param zone_keys   Zone keys.
+ * \param dnssec_ctx  DNSSEC context.
+ * \param until       End of the refresh period.
+ *
+ * \return Error code, KNOT_EOK if successful.
+ */
+static int zone_sign_expiring(zone_update_t *update,
+                              zone_keyset_t *zone_keys,
+                              const kdnssec_ctx_t *dnssec_ctx,
+                              knot_time_t until)
+{
+	expiry_index_t *idx = update->new_cont->expiry_index;
+
+	int result = expiry_index_apply(idx, until, add_expiring_node, update);
+	if (result == KNOT_EOK) {
+		// apex RRSIGs may come from offline KSK records with their own schedule
+		zone_node_t *apex = update->new_cont->apex;
+		result = zone_tree_insert(update->a_ctx->node_ptrs, &apex);
+	}
+	if (result != KNOT_EOK) {
+		return result;
+	}
+
+	result = zone_tree_sign(update->a_ctx->node_ptrs, dnssec_ctx->policy->signing_threads,
+	                        zone_keys, dnssec_ctx, update);
+	if (result == KNOT_EOK) {
+		result = zone_tree_sign(update->a_ctx->nsec3_ptrs, dnssec_ctx->policy->signing_threads,
+		                        zone_keys, dnssec_ctx, update);
+	}
+	if (result == KNOT_EOK) {
+		result = zone_tree_apply(update->a_ctx->node_ptrs, set_signed, NULL);
+	}
+	if (result == KNOT_EOK) {
+		result = zone_tree_apply(update->a_ctx->nsec3_ptrs, set_signed, NULL);
+	}
+	if (result == KNOT_EOK) {
+		// the signatures of the untouched nodes expire no sooner than their buckets start
+		knot_time_t next = expiry_index_next(idx, until);
+		knot_spin_lock(&dnssec_ctx->stats->lock);
+		dnssec_ctx->stats->expire = knot_time_min(dnssec_ctx->stats->expire, next);
+		knot_spin_unlock(&dnssec_ctx->stats->lock);
+	}
+
+	return result;
+}
+
 int knot_zone_sign(zone_update_t *update,
                    zone_keyset_t *zone_keys,
                    const kdnssec_ctx_t *dnssec_ctx)
@@ -714,6 +883,19 @@ int knot_zone_sign(zone_update_t *update,
 	}
 
 	int result;
+	bool whole = !(update->flags & UPDATE_INCREMENTAL);
+
+	/* With the signing keys unchanged since the zone was completely signed,
+	 * only the changed nodes and nodes with expiring RRSIGs need signing. */
+	expiry_index_t *idx = dnssec_ctx->validation_mode ? NULL : update->new_cont->expiry_index;
+	uint64_t keys_id = dnssec_ctx->validation_mode ? 0 : zone_keys_id(zone_keys);
+	knot_time_t until = knot_time_add(dnssec_ctx->now, dnssec_ctx->policy->rrsig_refresh_before +
+	                                                   dnssec_ctx->policy->rrsig_prerefresh);
+	if (idx != NULL && !whole && idx->keys_id == keys_id &&
+	    !dnssec_ctx->rrsig_drop_existing && !apex_dnssec_changed(update)) {
+		result = zone_sign_expiring(update, zone_keys, dnssec_ctx, until);
+		goto index;
+	}
 
 	result = zone_tree_sign(update->new_cont->nodes, dnssec_ctx->policy->signing_threads,
 	                        zone_keys, dnssec_ctx, update);
@@ -727,12 +909,31 @@ int knot_zone_sign(zone_update_t *update,
 		return result;
 	}
 
-	bool whole = !(update->flags & UPDATE_INCREMENTAL);
 	result = zone_tree_apply(whole ? update->new_cont->nodes : update->a_ctx->node_ptrs, set_signed, NULL);
 	if (result == KNOT_EOK) {
 		result = zone_tree_apply(whole ? update->new_cont->nsec3_nodes : update->a_ctx->nsec3_ptrs, set_signed, NULL);
 	}
 
+index:
+	if (result != KNOT_EOK || dnssec_ctx->validation_mode) {
+		return result;
+	}
+
+	// the new contents are indexed completely when adjusting
+	if (idx == NULL && whole) {
+		idx = expiry_index_new();
+		if (idx == NULL) {
+			return KNOT_ENOMEM;
+		}
+		update->new_cont->expiry_index = idx;
+	}
+
+	// the processed entries are obsolete, the re-signed nodes get indexed when adjusting
+	if (idx != NULL) {
+		idx->keys_id = keys_id;
+		result = expiry_index_drop(idx, until);
+	}
+
 	return result;
 }
 
@@ -962,6 +1163,24 @@ static int sign_in_changeset(zone_node_t *node, uint16_t rrtype,
 	return add_missing_rrsigs(&rr, &rrsigs, sign_ctx, skip_crypto, NULL, up);
 }
 
+int knot_zone_sign_nsec3_nodes(zone_update_t *update,
+                               zone_keyset_t *zone_keys,
+                               const kdnssec_ctx_t *dnssec_ctx)
+{
+	if (update == NULL || zone_keys == NULL || dnssec_ctx == NULL ||
+	    dnssec_ctx->policy->signing_threads < 1) {
+		return KNOT_EINVAL;
+	}
+
+	int ret = zone_tree_sign(update->a_ctx->nsec3_ptrs, dnssec_ctx->policy->signing_threads,
+	                         zone_keys, dnssec_ctx, update);
+	if (ret == KNOT_EOK) {
+		ret = zone_tree_apply(update->a_ctx->nsec3_ptrs, set_signed, NULL);
+	}
+
+	return ret;
+}
+
 int knot_zone_sign_nsecs_in_changeset(const zone_keyset_t *zone_keys,
                                       const kdnssec_ctx_t *dnssec_ctx,
                                       zone_update_t *update)
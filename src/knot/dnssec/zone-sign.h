@@ -106,6 +106,19 @@ int knot_zone_sign(zone_update_t *update,
                    zone_keyset_t *zone_keys,
                    const kdnssec_ctx_t *dnssec_ctx);
 
+/*!
+ * \brief Sign NSEC3 nodes changed by the update, using all signing threads.
+ *
+ * \param update      Zone update with the changed NSEC3 nodes.
+ * \param zone_keys   Zone keys.
+ * \param dnssec_ctx  DNSSEC context.
+ *
+ * \return Error code, KNOT_EOK if successful.
+ */
+int knot_zone_sign_nsec3_nodes(zone_update_t *update,
+                               zone_keyset_t *zone_keys,
+                               const kdnssec_ctx_t *dnssec_ctx);
+
 /*!
  * \brief Sign NSEC/NSEC3 nodes in changeset and update the changeset.
  *
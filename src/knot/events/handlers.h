@@ -24,6 +24,8 @@
 int event_load(conf_t *conf, zone_t *zone);
 /*! \brief Refresh a zone from a master. */
 int event_refresh(conf_t *conf, zone_t *zone);
+/*! \brief NOT A HANDLER, frees the primaries' records of the refresh SOA checks. */
+void event_refresh_deinit(void);
 /*! \brief Processes DDNS updates in the zone's DDNS queue. */
 int event_update(conf_t *conf, zone_t *zone);
 /*! \brief Empties in-memory zone contents. */
@@ -51,3 +53,5 @@ int event_ds_check(conf_t *conf, zone_t *zone);
 int event_ds_push(conf_t *conf, zone_t *zone);
 /*! \brief After DNSSEC sign, synchronize DNSKEY+CDNSKEY+CDS using DDNS. */
 int event_dnskey_sync(conf_t *conf, zone_t *zone);
+/*! \brief Builds new NSEC3 chain with new salt in background steps. */
+int event_nsec3resalt(conf_t *conf, zone_t *zone);
@@ -58,7 +58,8 @@ void event_dnssec_reschedule(conf_t *conf, zone_t *zone,
 	zone_events_schedule_at(zone,
 		ZONE_EVENT_DNSSEC, refresh_at ? (time_t)refresh_at : ignore,
 		ZONE_EVENT_DS_CHECK, refresh->plan_ds_check ? now : ignore,
-		ZONE_EVENT_DNSKEY_SYNC, refresh->plan_dnskey_sync ? now + jitter : ignore
+		ZONE_EVENT_DNSKEY_SYNC, refresh->plan_dnskey_sync ? now + jitter : ignore,
+		ZONE_EVENT_NSEC3RESALT, refresh->plan_nsec3resalt ? now : ignore
 	);
 	if (zone_changed) {
 		zone_schedule_notify(zone, 0);
@@ -70,7 +71,7 @@ int event_dnssec(conf_t *conf, zone_t *zone)
 	assert(zone);
 
 	zone_sign_reschedule_t resch = { 0 };
-	zone_sign_roll_flags_t r_flags = KEY_ROLL_ALLOW_ALL;
+	zone_sign_roll_flags_t r_flags = KEY_ROLL_ALLOW_ALL | KEY_ROLL_BG_NSEC3RESALT;
 	int sign_flags = 0;
 	bool zone_changed = false;
 
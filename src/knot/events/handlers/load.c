@@ -16,6 +16,7 @@
 
 #include <assert.h>
 #include <urcu.h>
+#include <unistd.h>
 
 #include "knot/catalog/generate.h"
 #include "knot/common/log.h"
@@ -27,6 +28,7 @@
 #include "knot/zone/digest.h"
 #include "knot/zone/reverse.h"
 #include "knot/zone/serial.h"
+#include "knot/zone/snapshot.h"
 #include "knot/zone/zone-diff.h"
 #include "knot/zone/zone-load.h"
 #include "knot/zone/zone.h"
@@ -55,6 +57,56 @@ static bool allowed_xfr(conf_t *conf, const zone_t *zone)
 	return false;
 }
 
+static int load_zonefile(conf_t *conf, zone_t *zone, const char *filename,
+                         const struct timespec *mtime, semcheck_optional_t mode,
+                         zone_contents_t **contents)
+{
+	conf_val_t val = conf_zone_get(conf, C_ZONEFILE_SNAP, zone->name);
+	if (!conf_bool(&val)) {
+		return zone_load_contents(conf, zone->name, contents, mode, false);
+	}
+
+	char *snapshot = zone_snapshot_path(filename);
+	if (snapshot == NULL) {
+		return KNOT_ENOMEM;
+	}
+
+	// Use the snapshot if it corresponds to the unchanged zone file.
+	if (zone->timers.snapshot_serial & SNAPSHOT_SERIAL_VALID) {
+		uint32_t serial = zone->timers.snapshot_serial;
+		int ret = zone_snapshot_load(snapshot, zone->name, mtime, serial, contents);
+		if (ret == KNOT_EOK) {
+			log_zone_info(zone->name, "zone file snapshot loaded, serial %u", serial);
+			free(snapshot);
+			return KNOT_EOK;
+		} else if (ret != KNOT_ENOENT) {
+			log_zone_warning(zone->name, "failed to load zone file snapshot '%s' (%s)",
+			                 snapshot, knot_strerror(ret));
+		}
+	}
+
+	int ret = zone_load_contents(conf, zone->name, contents, mode, false);
+	if (ret == KNOT_EOK && !zone_snapshot_allowed(filename)) {
+		// Changes of the included files wouldn't be detected.
+		zone->timers.snapshot_serial = 0;
+		(void)unlink(snapshot);
+		log_zone_info(zone->name, "zone file snapshot not used, zone file includes other files");
+	} else if (ret == KNOT_EOK) {
+		zone->timers.snapshot_serial = 0;
+		int snap_ret = zone_snapshot_write(snapshot, *contents, mtime);
+		if (snap_ret == KNOT_EOK) {
+			zone->timers.snapshot_serial = zone_contents_serial(*contents) |
+			                               SNAPSHOT_SERIAL_VALID;
+		} else {
+			log_zone_warning(zone->name, "failed to store zone file snapshot '%s' (%s)",
+			                 snapshot, knot_strerror(snap_ret));
+		}
+	}
+	free(snapshot);
+
+	return ret;
+}
+
 int event_load(conf_t *conf, zone_t *zone)
 {
 	zone_update_t up = { 0 };
@@ -118,7 +170,7 @@ int event_load(conf_t *conf, zone_t *zone)
 				}
 			}
 
-			ret = zone_load_contents(conf, zone->name, &zf_conts, mode, false);
+			ret = load_zonefile(conf, zone, filename, &mtime, mode, &zf_conts);
 		}
 		if (ret != KNOT_EOK) {
 			assert(!zf_conts);
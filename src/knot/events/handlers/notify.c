@@ -20,6 +20,7 @@
 #include "contrib/openbsd/siphash.h"
 #include "knot/common/log.h"
 #include "knot/conf/conf.h"
+#include "knot/query/async-requestor.h"
 #include "knot/query/query.h"
 #include "knot/query/requestor.h"
 #include "knot/server/server.h"
@@ -87,8 +88,36 @@ static const knot_layer_api_t NOTIFY_API = {
 	       flags2proto(flags), ((flags) & KNOT_REQUESTOR_REUSED), (remote)->key.name, \
 	       fmt, ## __VA_ARGS__)
 
+/*!
+ * \brief Log the NOTIFY result.
+ *
+ * \return True if the remote acknowledged the NOTIFY.
+ */
+static bool notify_log_result(const zone_t *zone, const knot_rrset_t *soa,
+                              const conf_remote_t *slave, unsigned layer_flags,
+                              const knot_pkt_t *resp, int ret, bool retry)
+{
+	const char *log_retry = retry ? "retry, " : "";
+
+	if (ret == KNOT_EOK && knot_pkt_ext_rcode(resp) == 0) {
+		NOTIFY_OUT_LOG(LOG_INFO, zone->name, slave, layer_flags,
+		               "%sserial %u", log_retry, knot_soa_serial(soa->rrs.rdata));
+		return true;
+	} else if (knot_pkt_ext_rcode(resp) == 0) {
+		NOTIFY_OUT_LOG(LOG_WARNING, zone->name, slave, layer_flags,
+		               "%sfailed (%s)", log_retry, knot_strerror(ret));
+	} else {
+		NOTIFY_OUT_LOG(LOG_WARNING, zone->name, slave, layer_flags,
+		               "%sserver responded with error '%s'",
+		               log_retry, knot_pkt_ext_rcode_name(resp));
+	}
+
+	return false;
+}
+
 static int send_notify(conf_t *conf, zone_t *zone, const knot_rrset_t *soa,
-                       const conf_remote_t *slave, int timeout, bool retry)
+                       const conf_remote_t *slave, int timeout, bool retry,
+                       bool *acked)
 {
 	struct notify_data data = {
 		.zone = zone->name,
@@ -116,36 +145,227 @@ static int send_notify(conf_t *conf, zone_t *zone, const knot_rrset_t *soa,
 
 	int ret = knot_requestor_exec(&requestor, req, timeout);
 
-	const char *log_retry = retry ? "retry, " : "";
+	*acked = notify_log_result(zone, soa, slave, requestor.layer.flags,
+	                           req->resp, ret, retry);
 
-	if (ret == KNOT_EOK && knot_pkt_ext_rcode(req->resp) == 0) {
-		NOTIFY_OUT_LOG(LOG_INFO, zone->name, slave,
-		               requestor.layer.flags,
-		               "%sserial %u", log_retry, knot_soa_serial(soa->rrs.rdata));
-		zone->timers.last_notified_serial = (knot_soa_serial(soa->rrs.rdata) | LAST_NOTIFIED_SERIAL_VALID);
-	} else if (knot_pkt_ext_rcode(req->resp) == 0) {
-		NOTIFY_OUT_LOG(LOG_WARNING, zone->name, slave,
-		               requestor.layer.flags,
-		               "%sfailed (%s)", log_retry, knot_strerror(ret));
+	knot_request_free(req, NULL);
+	knot_requestor_clear(&requestor);
+
+	return ret;
+}
+
+/*!
+ * \brief Remotes notified by one NOTIFY event, protected by zone->preferred_lock.
+ *
+ * The remotes notified asynchronously may finish after the event, the last
+ * one finalizes the round. The zone timers are updated only then, under
+ * the lock, not from the requestor thread which processed the response.
+ */
+typedef struct {
+	zone_t *zone;
+	knot_rrset_t *soa;
+	uint32_t retry_in;
+	bool retry;
+	bool failed;
+	bool cancelled;
+	bool acked;      // Some remote acknowledged the NOTIFY.
+	unsigned refs;
+} notify_round_t;
+
+/*! \brief Remote notified asynchronously, its addresses are tried in turn. */
+typedef struct {
+	knot_areq_job_t job;
+	struct notify_data data;
+	notify_round_t *round;
+	notifailed_rmt_hash rmt_hash;
+	bool acked;
+	int timeout;
+	knot_tsig_key_t key;
+	size_t addr_idx;
+	size_t addr_count;
+	conf_remote_t addrs[];
+} notify_async_t;
+
+static void notify_remote_done(notify_round_t *round, notifailed_rmt_hash *rmt_hash,
+                               int ret, bool acked)
+{
+	round->acked |= acked;
+	if (ret != KNOT_EOK) {
+		round->failed = true;
+		notifailed_rmt_dynarray_add(&round->zone->notifailed, rmt_hash);
 	} else {
-		NOTIFY_OUT_LOG(LOG_WARNING, zone->name, slave,
-		               requestor.layer.flags,
-		               "%sserver responded with error '%s'",
-		               log_retry, knot_pkt_ext_rcode_name(req->resp));
+		notifailed_rmt_dynarray_remove(&round->zone->notifailed, rmt_hash);
+	}
+}
+
+static void notify_round_release(notify_round_t *round)
+{
+	if (--round->refs > 0) {
+		return;
 	}
 
-	knot_request_free(req, NULL);
-	knot_requestor_clear(&requestor);
+	if (round->acked) {
+		uint32_t serial = knot_soa_serial(round->soa->rrs.rdata);
+		round->zone->timers.last_notified_serial = (serial | LAST_NOTIFIED_SERIAL_VALID);
+	}
+
+	if (round->failed && !round->cancelled) {
+		zone_t *zone = round->zone;
+		notifailed_rmt_dynarray_sort_dedup(&zone->notifailed);
+		zone_events_schedule_at(zone, ZONE_EVENT_NOTIFY, time(NULL) + round->retry_in);
+	}
+
+	knot_rrset_free(round->soa, NULL);
+	free(round);
+}
+
+static void notify_async_free(notify_async_t *notif)
+{
+	knot_tsig_key_deinit(&notif->key);
+	free(notif);
+}
+
+/*!
+ * \brief Prepare asynchronous NOTIFY of the remote, NULL if not possible.
+ */
+static notify_async_t *notify_async_new(conf_t *conf, notify_round_t *round,
+                                        conf_val_t *id, size_t addr_count,
+                                        notifailed_rmt_hash rmt_hash)
+{
+	zone_t *zone = round->zone;
+	if (zone->server == NULL || zone->server->requestor == NULL || addr_count == 0) {
+		return NULL;
+	}
+
+	notify_async_t *notif = calloc(1, sizeof(*notif) + addr_count * sizeof(conf_remote_t));
+	if (notif == NULL) {
+		return NULL;
+	}
+
+	for (size_t i = 0; i < addr_count; i++) {
+		notif->addrs[i] = conf_remote(conf, id, i);
+	}
+	if (notif->addrs[0].quic || notif->addrs[0].tls) {
+		free(notif);
+		return NULL;
+	}
+
+	/* The configuration isn't available after the event. */
+	if (notif->addrs[0].key.name != NULL &&
+	    knot_tsig_key_copy(&notif->key, &notif->addrs[0].key) != KNOT_EOK) {
+		free(notif);
+		return NULL;
+	}
+	for (size_t i = 0; i < addr_count; i++) {
+		notif->addrs[i].key = notif->key;
+		notif->addrs[i].pin = NULL;
+		notif->addrs[i].pin_len = 0;
+	}
+
+	notif->data.zone = zone->name;
+	notif->data.soa = round->soa;
+	notif->data.edns = query_edns_data_init(conf, &notif->addrs[0], 0);
+	notif->round = round;
+	notif->rmt_hash = rmt_hash;
+	notif->timeout = conf->cache.srv_tcp_remote_io_timeout;
+	notif->addr_count = addr_count;
+
+	return notif;
+}
+
+static void notify_async_done(knot_areq_job_t *job, int ret);
+
+static int notify_async_submit(notify_async_t *notif)
+{
+	const conf_remote_t *slave = &notif->addrs[notif->addr_idx];
+	notif->data.remote = slave;
+
+	knot_requestor_t *requestor = &notif->job.requestor;
+	knot_requestor_init(requestor, &NOTIFY_API, &notif->data, NULL);
+
+	knot_pkt_t *pkt = knot_pkt_new(NULL, KNOT_WIRE_MAX_PKTSIZE, NULL);
+	if (pkt == NULL) {
+		knot_requestor_clear(requestor);
+		return KNOT_ENOMEM;
+	}
+
+	knot_request_t *req = knot_request_make(NULL, slave, pkt, NULL, &notif->data.edns, 0);
+	if (req == NULL) {
+		knot_pkt_free(pkt);
+		knot_requestor_clear(requestor);
+		return KNOT_ENOMEM;
+	}
+
+	notif->job.request = req;
+	notif->job.timeout_ms = notif->timeout;
+	notif->job.owner = notif->round->zone;
+	notif->job.done = notify_async_done;
+
+	int ret = knot_areq_submit(notif->round->zone->server->requestor, &notif->job);
+	if (ret != KNOT_EOK) {
+		knot_request_free(req, NULL);
+		knot_requestor_clear(requestor);
+	}
 
 	return ret;
 }
 
+/*!
+ * \brief Submit NOTIFY to the next address or finish with the remote.
+ */
+static void notify_async_next(notify_async_t *notif, int ret)
+{
+	while (ret != KNOT_EOK && ret != KNOT_ECONNABORTED &&
+	       notif->addr_idx < notif->addr_count) {
+		ret = notify_async_submit(notif);
+		if (ret == KNOT_EOK) {
+			return;
+		}
+		notif->addr_idx++;
+	}
+
+	notify_round_t *round = notif->round;
+	pthread_mutex_lock(&round->zone->preferred_lock);
+	if (ret == KNOT_ECONNABORTED) {
+		round->cancelled = true;
+	} else {
+		notify_remote_done(round, &notif->rmt_hash, ret, notif->acked);
+	}
+	notify_round_release(round);
+	pthread_mutex_unlock(&round->zone->preferred_lock);
+
+	notify_async_free(notif);
+}
+
+static void notify_async_done(knot_areq_job_t *job, int ret)
+{
+	notify_async_t *notif = (notify_async_t *)job;
+
+	if (ret != KNOT_ECONNABORTED) {
+		notif->acked = notify_log_result(notif->round->zone, notif->round->soa,
+		                                 notif->data.remote, job->requestor.layer.flags,
+		                                 job->request->resp, ret, notif->round->retry);
+	}
+	knot_request_free(job->request, NULL);
+	knot_requestor_clear(&job->requestor);
+
+	notif->addr_idx++;
+	notify_async_next(notif, ret);
+}
+
+static void notify_async_start(notify_async_t *notif)
+{
+	pthread_mutex_lock(&notif->round->zone->preferred_lock);
+	notif->round->refs++;
+	pthread_mutex_unlock(&notif->round->zone->preferred_lock);
+
+	notify_async_next(notif, KNOT_ENOENT);
+}
+
 int event_notify(conf_t *conf, zone_t *zone)
 {
 	assert(zone);
 
-	bool failed = false;
-
 	if (zone_contents_is_empty(zone->contents)) {
 		return KNOT_EOK;
 	}
@@ -160,9 +380,25 @@ int event_notify(conf_t *conf, zone_t *zone)
 		return KNOT_ENOMEM;
 	}
 
+	notify_round_t *round = calloc(1, sizeof(*round));
+	if (round == NULL) {
+		knot_rrset_free(soa_cpy, NULL);
+		return KNOT_ENOMEM;
+	}
+	round->zone = zone;
+	round->soa = soa_cpy;
+	round->refs = 1;
+
+	round->retry_in = knot_soa_retry(soa_cpy->rrs.rdata);
+	conf_val_t val = conf_zone_get(conf, C_RETRY_MIN_INTERVAL, zone->name);
+	round->retry_in = MAX(round->retry_in, conf_int(&val));
+	val = conf_zone_get(conf, C_RETRY_MAX_INTERVAL, zone->name);
+	round->retry_in = MIN(round->retry_in, conf_int(&val));
+
 	// in case of re-try, NOTIFY only failed remotes
 	pthread_mutex_lock(&zone->preferred_lock);
 	bool retry = (zone->notifailed.size > 0);
+	round->retry = retry;
 
 	// send NOTIFY to each remote, use working address
 	conf_val_t notify = conf_zone_get(conf, C_NOTIFY, zone->name);
@@ -179,40 +415,37 @@ int event_notify(conf_t *conf, zone_t *zone)
 		conf_val_t addr = conf_id_get(conf, C_RMT, C_ADDR, iter.id);
 		size_t addr_count = conf_val_count(&addr);
 
+		// the result is processed asynchronously if possible
+		notify_async_t *notif = notify_async_new(conf, round, iter.id,
+		                                         addr_count, rmt_hash);
+		if (notif != NULL) {
+			notify_async_start(notif);
+			pthread_mutex_lock(&zone->preferred_lock);
+			conf_mix_iter_next(&iter);
+			continue;
+		}
+
 		int ret = KNOT_EOK;
+		bool acked = false;
 
 		for (int i = 0; i < addr_count; i++) {
 			conf_remote_t slave = conf_remote(conf, iter.id, i);
-			ret = send_notify(conf, zone, soa_cpy, &slave, timeout, retry);
+			ret = send_notify(conf, zone, soa_cpy, &slave, timeout, retry, &acked);
 			if (ret == KNOT_EOK) {
 				break;
 			}
 		}
 
 		pthread_mutex_lock(&zone->preferred_lock);
-		if (ret != KNOT_EOK) {
-			failed = true;
-			notifailed_rmt_dynarray_add(&zone->notifailed, &rmt_hash);
-		} else {
-			notifailed_rmt_dynarray_remove(&zone->notifailed, &rmt_hash);
-		}
+		notify_remote_done(round, &rmt_hash, ret, acked);
 
 		conf_mix_iter_next(&iter);
 	}
 
-	if (failed) {
-		notifailed_rmt_dynarray_sort_dedup(&zone->notifailed);
-
-		uint32_t retry_in = knot_soa_retry(soa_cpy->rrs.rdata);
-		conf_val_t val = conf_zone_get(conf, C_RETRY_MIN_INTERVAL, zone->name);
-		retry_in = MAX(retry_in, conf_int(&val));
-		val = conf_zone_get(conf, C_RETRY_MAX_INTERVAL, zone->name);
-		retry_in = MIN(retry_in, conf_int(&val));
-
-		zone_events_schedule_at(zone, ZONE_EVENT_NOTIFY, time(NULL) + retry_in);
-	}
+	// the retry is scheduled once all the remotes are finished
+	bool failed = round->failed;
+	notify_round_release(round);
 	pthread_mutex_unlock(&zone->preferred_lock);
-	knot_rrset_free(soa_cpy, NULL);
 
 	return failed ? KNOT_ERROR : KNOT_EOK;
 }
@@ -0,0 +1,67 @@
+/*  Copyright (C) 2024 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <assert.h>
+
+#include "knot/conf/conf.h"
+#include "knot/dnssec/zone-events.h"
+#include "knot/events/handlers.h"
+#include "knot/zone/zone.h"
+#include "libknot/errcode.h"
+
+int event_nsec3resalt(conf_t *conf, zone_t *zone)
+{
+	assert(zone);
+
+	zone_sign_reschedule_t resch = { 0 };
+	bool zone_changed = false;
+
+	int ret = knot_dnssec_nsec3resalt_step(conf, zone, &resch);
+	if (ret == KNOT_EAGAIN) {
+		// Yield to other events, continue with the next part later.
+		zone_events_schedule_now(zone, ZONE_EVENT_NSEC3RESALT);
+		return KNOT_EOK;
+	} else if (ret != KNOT_EOK) {
+		goto done;
+	}
+
+	zone_update_t up;
+	ret = zone_update_init(&up, zone, UPDATE_INCREMENTAL | UPDATE_NO_CHSET);
+	if (ret != KNOT_EOK) {
+		goto done;
+	}
+
+	ret = knot_dnssec_nsec3resalt_apply(&up, conf, &resch);
+	if (ret == KNOT_EOK) {
+		zone_changed = !zone_update_no_change(&up);
+		ret = zone_update_commit(conf, &up);
+	}
+	if (ret != KNOT_EOK) {
+		zone_changed = false;
+		zone_update_clear(&up);
+	}
+
+done:
+	knot_dnssec_nsec3resalt_free(zone);
+
+	knot_time_t next = knot_time_min(resch.next_sign, resch.next_nsec3resalt);
+	zone_events_schedule_at(zone, ZONE_EVENT_DNSSEC, next ? (time_t)next : -1);
+	if (zone_changed) {
+		zone_schedule_notify(zone, 0);
+	}
+
+	return ret;
+}
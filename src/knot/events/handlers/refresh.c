@@ -19,6 +19,7 @@
 #include <urcu.h>
 
 #include "contrib/mempattern.h"
+#include "contrib/sockaddr.h"
 #include "libdnssec/random.h"
 #include "knot/common/log.h"
 #include "knot/conf/conf.h"
@@ -26,6 +27,7 @@
 #include "knot/events/handlers.h"
 #include "knot/events/replan.h"
 #include "knot/nameserver/ixfr.h"
+#include "knot/query/async-requestor.h"
 #include "knot/query/layer.h"
 #include "knot/query/query.h"
 #include "knot/query/requestor.h"
@@ -187,6 +189,31 @@ static void limit_timer(conf_t *conf, const knot_dname_t *zone, uint32_t *timer,
 	}
 }
 
+static bool pkt_edns_expire(knot_pkt_t *pkt, uint32_t *edns_expire)
+{
+	uint8_t *expire_opt = knot_pkt_edns_option(pkt, KNOT_EDNS_OPTION_EXPIRE);
+	if (expire_opt != NULL && knot_edns_opt_get_length(expire_opt) == sizeof(uint32_t)) {
+		*edns_expire = knot_wire_read_u32(knot_edns_opt_get_data(expire_opt));
+		return true;
+	}
+
+	return false;
+}
+
+static void set_edns_expire(struct refresh_data *data, bool received,
+                            uint32_t edns_expire, bool strictly_follow)
+{
+	if (data->zone->is_catalog_flag) {
+		data->expire_timer = EXPIRE_TIMER_INVALID;
+		return;
+	}
+
+	if (received) {
+		data->expire_timer = strictly_follow ? edns_expire :
+				     MAX(edns_expire, data->zone->timers.next_expire - time(NULL));
+	}
+}
+
 /*!
  * \brief Modify the expire timer wrt the received EDNS EXPIRE (RFC 7314, section 4)
  *
@@ -198,17 +225,9 @@ static void limit_timer(conf_t *conf, const knot_dname_t *zone, uint32_t *timer,
  */
 static void consume_edns_expire(struct refresh_data *data, knot_pkt_t *pkt, bool strictly_follow)
 {
-	if (data->zone->is_catalog_flag) {
-		data->expire_timer = EXPIRE_TIMER_INVALID;
-		return;
-	}
-
-	uint8_t *expire_opt = knot_pkt_edns_option(pkt, KNOT_EDNS_OPTION_EXPIRE);
-	if (expire_opt != NULL && knot_edns_opt_get_length(expire_opt) == sizeof(uint32_t)) {
-		uint32_t edns_expire = knot_wire_read_u32(knot_edns_opt_get_data(expire_opt));
-		data->expire_timer = strictly_follow ? edns_expire :
-				     MAX(edns_expire, data->zone->timers.next_expire - time(NULL));
-	}
+	uint32_t edns_expire = 0;
+	bool received = pkt_edns_expire(pkt, &edns_expire);
+	set_edns_expire(data, received, edns_expire, strictly_follow);
 }
 
 static void finalize_timers_base(struct refresh_data *data, bool also_expire)
@@ -1434,6 +1453,465 @@ static int try_refresh(conf_t *conf, zone_t *zone, const conf_remote_t *master,
 	return ret;
 }
 
+/*! \brief Maximum of the SOA checks submitted to a primary within a second. */
+#define SOA_CHECK_BATCH   100
+/*! \brief Size of the SOA check query and response. */
+#define SOA_CHECK_PKTSIZE 4096
+
+/*!
+ * \brief SOA query preceding the refresh of a zone with contents.
+ *
+ * The query is sent to the first primary address by the asynchronous requestor,
+ * which pipelines the queries to the same primary over a single TCP connection
+ * from the connection pool. So the zones due for refresh at once, e.g. after
+ * a restart, are checked without occupying the workers and without opening
+ * a connection for each zone. Once the query finishes, the refresh event is
+ * scheduled again. If the zone is current, only the timers are updated,
+ * otherwise or on any error, the usual refresh follows.
+ */
+typedef struct refresh_soa_check {
+	knot_areq_job_t job;
+	zone_t *zone;
+	conf_remote_t remote;         //!< Primary address, with the key copy below.
+	knot_tsig_key_t key;
+	query_edns_data_t edns;
+	time_t batch;                 //!< Batch with a reserved place, 0 if submitted.
+
+	// result, protected by zone->preferred_lock:
+
+	bool finished;
+	int ret;
+	unsigned flags;               //!< Requestor flags.
+	uint16_t rcode;
+	bool has_serial;
+	uint32_t serial;
+	bool has_expire;
+	uint32_t edns_expire;
+} refresh_soa_check_t;
+
+/*!
+ * \brief SOA checks of a primary address.
+ *
+ * The checks of a primary are submitted in batches of at most SOA_CHECK_BATCH
+ * each second. A check exceeding the current batch reserves a place in the
+ * first batch with a free place and the refresh waits for it. So a burst of
+ * due refreshes, e.g. after a restart, is spread out evenly and each primary
+ * gets a smooth query rate, regardless of the other primaries.
+ */
+typedef struct soa_check_primary {
+	struct soa_check_primary *next;
+	struct sockaddr_storage addr;
+	unsigned running;             //!< Checks in progress.
+	time_t batch;                 //!< Last batch with a reserved place.
+	unsigned batch_size;          //!< Places reserved in the last batch.
+} soa_check_primary_t;
+
+static pthread_mutex_t soa_check_lock = PTHREAD_MUTEX_INITIALIZER;
+static soa_check_primary_t *soa_check_primaries = NULL;
+
+/*!
+ * \brief Get the record of the primary, drop the records no longer needed.
+ *
+ * \note Must be called with soa_check_lock held.
+ */
+static soa_check_primary_t *soa_check_primary(const struct sockaddr_storage *addr,
+                                              time_t now)
+{
+	soa_check_primary_t *found = NULL;
+	soa_check_primary_t **it = &soa_check_primaries;
+	while (*it != NULL) {
+		soa_check_primary_t *primary = *it;
+		if (sockaddr_cmp(&primary->addr, addr, false) == 0) {
+			found = primary;
+		} else if (primary->running == 0 && primary->batch < now) {
+			*it = primary->next;
+			free(primary);
+			continue;
+		}
+		it = &primary->next;
+	}
+
+	if (found == NULL) {
+		found = calloc(1, sizeof(*found));
+		if (found != NULL) {
+			memcpy(&found->addr, addr, sizeof(found->addr));
+			found->next = soa_check_primaries;
+			soa_check_primaries = found;
+		}
+	}
+
+	return found;
+}
+
+/*!
+ * \brief Reserve a place in the first batch of the primary with a free place.
+ *
+ * \return Time of the batch, 0 on error.
+ */
+static time_t soa_check_reserve(const struct sockaddr_storage *addr)
+{
+	time_t now = time(NULL);
+	time_t batch = 0;
+
+	pthread_mutex_lock(&soa_check_lock);
+	soa_check_primary_t *primary = soa_check_primary(addr, now);
+	if (primary != NULL) {
+		if (primary->batch < now) {
+			primary->batch = now;
+			primary->batch_size = 0;
+		} else if (primary->batch_size >= SOA_CHECK_BATCH) {
+			primary->batch++;
+			primary->batch_size = 0;
+		}
+		primary->batch_size++;
+		batch = primary->batch;
+	}
+	pthread_mutex_unlock(&soa_check_lock);
+
+	return batch;
+}
+
+/*!
+ * \brief Account a check of the primary started or finished.
+ */
+static bool soa_check_running(const struct sockaddr_storage *addr, bool started)
+{
+	pthread_mutex_lock(&soa_check_lock);
+	soa_check_primary_t *primary = soa_check_primary(addr, time(NULL));
+	if (primary != NULL) {
+		if (started) {
+			primary->running++;
+		} else if (primary->running > 0) {
+			primary->running--;
+		}
+	}
+	pthread_mutex_unlock(&soa_check_lock);
+
+	return primary != NULL;
+}
+
+void event_refresh_deinit(void)
+{
+	pthread_mutex_lock(&soa_check_lock);
+	while (soa_check_primaries != NULL) {
+		soa_check_primary_t *primary = soa_check_primaries;
+		soa_check_primaries = primary->next;
+		free(primary);
+	}
+	pthread_mutex_unlock(&soa_check_lock);
+}
+
+static int soa_check_begin(knot_layer_t *layer, void *data)
+{
+	layer->data = data;
+
+	return KNOT_STATE_PRODUCE;
+}
+
+static int soa_check_produce(knot_layer_t *layer, knot_pkt_t *pkt)
+{
+	refresh_soa_check_t *check = layer->data;
+
+	query_init_pkt(pkt);
+
+	int ret = knot_pkt_put_question(pkt, check->zone->name, KNOT_CLASS_IN,
+	                                KNOT_RRTYPE_SOA);
+	return (ret == KNOT_EOK) ? KNOT_STATE_CONSUME : KNOT_STATE_FAIL;
+}
+
+static int soa_check_consume(knot_layer_t *layer, knot_pkt_t *pkt)
+{
+	refresh_soa_check_t *check = layer->data;
+
+	/* The pipelined responses are matched only by the message ID. */
+	if (!knot_dname_is_equal(knot_pkt_qname(pkt), check->zone->name) ||
+	    knot_pkt_qtype(pkt) != KNOT_RRTYPE_SOA || knot_pkt_qclass(pkt) != KNOT_CLASS_IN) {
+		return KNOT_STATE_FAIL;
+	}
+
+	check->rcode = knot_pkt_ext_rcode(pkt);
+
+	const knot_pktsection_t *answer = knot_pkt_section(pkt, KNOT_ANSWER);
+	const knot_rrset_t *rr = answer->count == 1 ? knot_pkt_rr(answer, 0) : NULL;
+	if (rr != NULL && rr->type == KNOT_RRTYPE_SOA && rr->rrs.count == 1 &&
+	    knot_dname_is_case_equal(rr->owner, check->zone->name)) {
+		check->has_serial = true;
+		check->serial = knot_soa_serial(rr->rrs.rdata);
+	}
+	check->has_expire = pkt_edns_expire(pkt, &check->edns_expire);
+
+	return KNOT_STATE_DONE;
+}
+
+static const knot_layer_api_t SOA_CHECK_API = {
+	.begin = soa_check_begin,
+	.produce = soa_check_produce,
+	.consume = soa_check_consume,
+};
+
+/*!
+ * \brief Get the primary address tried first by the refresh, if applicable.
+ */
+static bool soa_check_remote(conf_t *conf, zone_t *zone, conf_remote_t *remote)
+{
+	conf_val_t val = conf_zone_get(conf, C_MASTER_PIN_TOL, zone->name);
+	if (conf_int(&val) > 0) {
+		return false; // The pinned primary is tried first.
+	}
+
+	conf_val_t masters = conf_zone_get(conf, C_MASTER, zone->name);
+	conf_mix_iter_t iter;
+	conf_mix_iter_init(conf, &masters, &iter);
+	if (iter.id->code != KNOT_EOK) {
+		return false;
+	}
+
+	*remote = conf_remote(conf, iter.id, 0);
+	return !remote->quic && !remote->tls;
+}
+
+static void soa_check_clear(refresh_soa_check_t *check)
+{
+	knot_request_free(check->job.request, NULL);
+	knot_requestor_clear(&check->job.requestor);
+	knot_tsig_key_deinit(&check->key);
+	check->job.request = NULL;
+	check->remote.key = check->key;
+}
+
+static void soa_check_done(knot_areq_job_t *job, int ret)
+{
+	refresh_soa_check_t *check = (refresh_soa_check_t *)job;
+	zone_t *zone = check->zone;
+
+	check->flags = job->requestor.layer.flags;
+	soa_check_clear(check);
+	(void)soa_check_running(&check->remote.addr, false);
+
+	pthread_mutex_lock(&zone->preferred_lock);
+	if (ret == KNOT_ECONNABORTED) {
+		zone->soa_check = NULL;
+		free(check);
+	} else {
+		check->finished = true;
+		check->ret = ret;
+	}
+	pthread_mutex_unlock(&zone->preferred_lock);
+
+	if (ret != KNOT_ECONNABORTED) {
+		zone_events_schedule_now(zone, ZONE_EVENT_REFRESH);
+	}
+}
+
+/*!
+ * \brief Submit the SOA check of the zone to the primary.
+ *
+ * \retval true   The refresh continues asynchronously.
+ * \retval false  The usual refresh needed, the check is freed.
+ */
+static bool soa_check_submit(conf_t *conf, zone_t *zone, refresh_soa_check_t *check,
+                             const conf_remote_t *remote)
+{
+	/* The configuration isn't available after the event. */
+	if (remote->key.name != NULL && knot_tsig_key_copy(&check->key, &remote->key) != KNOT_EOK) {
+		free(check);
+		return false;
+	}
+	check->zone = zone;
+	check->remote = *remote;
+	check->remote.key = check->key;
+	check->remote.pin = NULL;
+	check->remote.pin_len = 0;
+	check->edns = query_edns_data_init(conf, &check->remote, QUERY_EDNS_OPT_EXPIRE);
+	check->batch = 0;
+
+	knot_requestor_t *requestor = &check->job.requestor;
+	knot_requestor_init(requestor, &SOA_CHECK_API, check, NULL);
+
+	knot_pkt_t *pkt = knot_pkt_new(NULL, SOA_CHECK_PKTSIZE, NULL);
+	knot_pkt_t *resp = knot_pkt_new(NULL, SOA_CHECK_PKTSIZE, NULL);
+	knot_request_t *req = NULL;
+	if (pkt != NULL && resp != NULL) {
+		req = knot_request_make(NULL, &check->remote, pkt, NULL, &check->edns, 0);
+	}
+	if (req == NULL) {
+		knot_pkt_free(pkt);
+		knot_pkt_free(resp);
+		soa_check_clear(check);
+		free(check);
+		return false;
+	}
+	/* Don't keep a maximum-sized response buffer for each pending check. */
+	knot_pkt_free(req->resp);
+	req->resp = resp;
+
+	check->job.request = req;
+	check->job.timeout_ms = conf->cache.srv_tcp_remote_io_timeout;
+	check->job.pipeline = true;
+	check->job.owner = zone;
+	check->job.done = soa_check_done;
+
+	if (!soa_check_running(&check->remote.addr, true)) {
+		soa_check_clear(check);
+		free(check);
+		return false;
+	}
+
+	pthread_mutex_lock(&zone->preferred_lock);
+	zone->soa_check = check;
+	pthread_mutex_unlock(&zone->preferred_lock);
+
+	if (knot_areq_submit(zone->server->requestor, &check->job) != KNOT_EOK) {
+		pthread_mutex_lock(&zone->preferred_lock);
+		zone->soa_check = NULL;
+		pthread_mutex_unlock(&zone->preferred_lock);
+		(void)soa_check_running(&check->remote.addr, false);
+		soa_check_clear(check);
+		free(check);
+		return false;
+	}
+
+	return true;
+}
+
+/*!
+ * \brief Start the SOA check of the zone or wait for its batch.
+ *
+ * \param check  Check with a place reserved in a batch, or NULL.
+ *
+ * \retval true   The refresh continues asynchronously.
+ * \retval false  The usual refresh needed, the check is freed.
+ */
+static bool soa_check_start(conf_t *conf, zone_t *zone, refresh_soa_check_t *check)
+{
+	conf_remote_t remote;
+	if (zone->server == NULL || zone->server->requestor == NULL ||
+	    zone->contents == NULL || !soa_check_remote(conf, zone, &remote)) {
+		free(check);
+		return false;
+	}
+
+	/* The primary changed since the reservation. */
+	if (check != NULL && sockaddr_cmp(&remote.addr, &check->remote.addr, false) != 0) {
+		free(check);
+		check = NULL;
+	}
+
+	if (check == NULL) {
+		check = calloc(1, sizeof(*check));
+		if (check == NULL) {
+			return false;
+		}
+		check->zone = zone;
+		memcpy(&check->remote.addr, &remote.addr, sizeof(check->remote.addr));
+		check->batch = soa_check_reserve(&remote.addr);
+		if (check->batch == 0) {
+			free(check);
+			return false;
+		}
+
+		/* Wait for the batch with the reserved place, e.g. after a restart. */
+		if (check->batch > time(NULL)) {
+			pthread_mutex_lock(&zone->preferred_lock);
+			zone->soa_check = check;
+			pthread_mutex_unlock(&zone->preferred_lock);
+			zone_events_schedule_at(zone, ZONE_EVENT_REFRESH, check->batch);
+			return true;
+		}
+	}
+
+	return soa_check_submit(conf, zone, check, &remote);
+}
+
+/*!
+ * \brief Finish the refresh by the SOA check if the zone is current.
+ *
+ * \retval true   The refresh is done.
+ * \retval false  The usual refresh needed.
+ */
+static bool soa_check_finish(conf_t *conf, zone_t *zone, refresh_soa_check_t *check)
+{
+	conf_remote_t remote;
+	if (check->ret != KNOT_EOK || check->rcode != KNOT_RCODE_NOERROR ||
+	    !check->has_serial || !soa_check_remote(conf, zone, &remote) ||
+	    sockaddr_cmp(&remote.addr, &check->remote.addr, false) != 0) {
+		return false;
+	}
+
+	uint32_t local_serial;
+	if (zone->contents == NULL || slave_zone_serial(zone, conf, &local_serial) != KNOT_EOK ||
+	    !serial_is_current(local_serial, check->serial)) {
+		return false;
+	}
+
+	knot_layer_t layer = { .flags = check->flags };
+	struct refresh_data data = {
+		.layer = &layer,
+		.zone = zone,
+		.conf = conf,
+		.remote = &remote,
+		.expire_timer = EXPIRE_TIMER_INVALID,
+	};
+
+	if (serial_is_current(check->serial, local_serial)) {
+		set_edns_expire(&data, check->has_expire, check->edns_expire, false);
+		finalize_timers(&data);
+		char expires_in[32] = "";
+		fill_expires_in(expires_in, sizeof(expires_in), &data);
+		REFRESH_LOG_PROTO(LOG_INFO, &data,
+		                  "remote serial %u, zone is up-to-date%s",
+		                  check->serial, expires_in);
+	} else {
+		finalize_timers_noexpire(&data);
+		REFRESH_LOG_PROTO(LOG_INFO, &data,
+		                  "remote serial %u, remote is outdated", check->serial);
+	}
+
+	zone->zonefile.bootstrap_cnt = 0;
+	replan_from_timers(conf, zone);
+
+	return true;
+}
+
+/*!
+ * \brief Refresh the zone by the SOA check, if possible.
+ *
+ * \retval true   The refresh is done or continues asynchronously.
+ * \retval false  The usual refresh needed.
+ */
+static bool refresh_by_soa_check(conf_t *conf, zone_t *zone)
+{
+	/* A blocking refresh is expected to be complete when the event finishes. */
+	pthread_mutex_lock(&zone->events.mx);
+	bool blocking = zone->events.blocking[ZONE_EVENT_REFRESH] != NULL;
+	pthread_mutex_unlock(&zone->events.mx);
+
+	pthread_mutex_lock(&zone->preferred_lock);
+	refresh_soa_check_t *check = zone->soa_check;
+	bool preferred = zone->preferred_master != NULL;
+	if (check != NULL && (check->finished || check->batch > 0)) {
+		zone->soa_check = NULL;
+	}
+	pthread_mutex_unlock(&zone->preferred_lock);
+
+	if (check == NULL || check->batch > 0) {
+		/* A new check or a check waiting for its batch. */
+		if (blocking || preferred) {
+			free(check);
+			return false;
+		}
+		return soa_check_start(conf, zone, check);
+	} else if (!check->finished) {
+		return !blocking; // The event is scheduled again once finished.
+	}
+
+	/* The notifying primary is preferred regardless of the result. */
+	bool done = !preferred && soa_check_finish(conf, zone, check);
+	free(check);
+
+	return done;
+}
+
 int event_refresh(conf_t *conf, zone_t *zone)
 {
 	assert(zone);
@@ -1450,6 +1928,10 @@ int event_refresh(conf_t *conf, zone_t *zone)
 		zone->zonefile.retransfer = true;
 	}
 
+	if (!trctx.force_axfr && refresh_by_soa_check(conf, zone)) {
+		return KNOT_EOK;
+	}
+
 	conf_val_t val = conf_zone_get(conf, C_IXFR_BY_ONE, zone->name);
 	trctx.ixfr_by_one = conf_bool(&val);
 	val = conf_zone_get(conf, C_IXFR_FROM_AXFR, zone->name);
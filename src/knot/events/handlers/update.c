@@ -15,6 +15,7 @@
  */
 
 #include <assert.h>
+#include <poll.h>
 
 #include "knot/conf/tools.h"
 #include "knot/events/handlers.h"
@@ -393,8 +394,15 @@ static void send_update_response(conf_t *conf, zone_t *zone, knot_request_t *req
 		}
 
 		if (net_is_stream(req->fd) && req->tls_req_ctx.conn != NULL) {
-			(void)knot_tls_send_dns(req->tls_req_ctx.conn,
-			                        req->resp->wire, req->resp->size);
+			/* The DoT sessions don't wait for the socket themselves. */
+			struct pollfd pfd = {
+				.fd = req->tls_req_ctx.conn->fd,
+				.events = POLLOUT
+			};
+			if (poll(&pfd, 1, conf->cache.srv_tcp_io_timeout) == 1) {
+				(void)knot_tls_send_dns(req->tls_req_ctx.conn,
+				                        req->resp->wire, req->resp->size);
+			}
 			knot_tls_conn_block(req->tls_req_ctx.conn, false);
 		}
 #ifdef ENABLE_QUIC
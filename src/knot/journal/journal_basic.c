@@ -61,6 +61,20 @@ void journal_make_header(void *chunk, uint32_t ch_serial_to, uint64_t now)
 	                        (uint64_t)0, now, (uint64_t)0);
 }
 
+#define COMPRESSED_OFFSET	(JOURNAL_HEADER_SIZE - sizeof(uint64_t))
+#define COMPRESSED_TAG		((uint64_t)0x7a737464 << 32) // "zstd"
+
+void journal_make_header_compressed(void *chunk, uint32_t plain_size)
+{
+	knot_wire_write_u64(chunk + COMPRESSED_OFFSET, COMPRESSED_TAG | plain_size);
+}
+
+uint32_t journal_chunk_plain_size(const MDB_val *chunk)
+{
+	uint64_t val = knot_wire_read_u64(chunk->mv_data + COMPRESSED_OFFSET);
+	return ((val & ~(uint64_t)UINT32_MAX) == COMPRESSED_TAG) ? (uint32_t)val : 0;
+}
+
 uint32_t journal_next_serial(const MDB_val *chunk)
 {
 	return knot_wire_read_u32(chunk->mv_data);
@@ -100,3 +114,9 @@ size_t journal_conf_max_changesets(zone_journal_t j)
 	conf_val_t val = conf_zone_get(j.conf, C_JOURNAL_MAX_DEPTH, j.zone);
 	return conf_int(&val);
 }
+
+bool journal_conf_compression(zone_journal_t j)
+{
+	conf_val_t val = conf_zone_get(j.conf, C_JOURNAL_COMPRESSION, j.zone);
+	return conf_bool(&val);
+}
@@ -99,6 +99,23 @@ void journal_make_header(void *chunk, uint32_t ch_serial_to, uint64_t now);
  */
 uint32_t journal_next_serial(const MDB_val *chunk);
 
+/*!
+ * \brief Mark the chunk header that the chunk data are compressed.
+ *
+ * \param chunk        Pointer to the changeset chunk with the header already made.
+ * \param plain_size   Size of the chunk data before compression.
+ */
+void journal_make_header_compressed(void *chunk, uint32_t plain_size);
+
+/*!
+ * \brief Obtain the size of the chunk data before compression.
+ *
+ * \param chunk   Any chunk of a serialized changeset.
+ *
+ * \return Uncompressed data size, 0 if the chunk data aren't compressed.
+ */
+uint32_t journal_chunk_plain_size(const MDB_val *chunk);
+
 /*!
  * \brief Obtain timestamp of the serialized changeset.
  *
@@ -136,3 +153,6 @@ size_t journal_conf_max_usage(zone_journal_t j);
 
 /*! \brief Return configured maximal depth of journal. */
 size_t journal_conf_max_changesets(zone_journal_t j);
+
+/*! \brief Return true if newly written changesets shall be compressed according to conf. */
+bool journal_conf_compression(zone_journal_t j);
@@ -0,0 +1,260 @@
+/*  Copyright (C) 2024 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "knot/journal/journal_batch.h"
+#include "knot/journal/journal_write.h"
+#include "contrib/atomic.h"
+#include "libknot/error.h"
+
+struct journal_batch {
+	knot_lmdb_db_t *db;
+	knot_atomic_uint64_t delay_ms;
+
+	pthread_t thread;
+	pthread_mutex_t lock;
+	pthread_cond_t queued;    // signalled to the writer on new insertion or stop
+	pthread_cond_t finished;  // broadcasted to submitters when a group is done
+
+	list_t queue;
+	size_t queue_len;
+	struct timespec first_at; // when the oldest queued insertion was submitted
+	bool stop;
+};
+
+static void move_req(journal_batch_req_t *req, list_t *to)
+{
+	rem_node(&req->n);
+	add_tail(to, &req->n);
+}
+
+/*!
+ * \brief Write the insertions in as few transactions as possible.
+ *
+ * An insertion failing within the transaction aborts it, so it's refused
+ * alone and the preceding ones are retried in a new transaction. If
+ * the transaction got committed in order to flush a zone (KNOT_EBUSY),
+ * the insertions up to the flushed one are done.
+ */
+static void write_group(knot_lmdb_db_t *db, list_t *todo, list_t *done)
+{
+	journal_batch_req_t *req, *nxt;
+
+	int ret = knot_lmdb_open(db);
+	if (ret != KNOT_EOK) {
+		WALK_LIST_DELSAFE(req, nxt, *todo) {
+			req->ret = ret;
+			move_req(req, done);
+		}
+		return;
+	}
+
+	while (!EMPTY_LIST(*todo)) {
+		knot_lmdb_txn_t txn = { 0 };
+		knot_lmdb_begin(db, &txn, true);
+
+		journal_batch_req_t *failed = NULL;
+		WALK_LIST(req, *todo) {
+			req->ret = journal_insert_txn(&txn, req->j, req->ch, req->extra, req->zdiff);
+			if (txn.ret != KNOT_EOK) {
+				failed = req;
+				break;
+			}
+		}
+
+		if (failed == NULL) {
+			knot_lmdb_commit(&txn);
+			WALK_LIST_DELSAFE(req, nxt, *todo) {
+				if (txn.ret != KNOT_EOK) {
+					req->ret = txn.ret;
+				}
+				move_req(req, done);
+			}
+		} else if (txn.ret == KNOT_EBUSY) {
+			WALK_LIST_DELSAFE(req, nxt, *todo) {
+				move_req(req, done);
+				if (req == failed) {
+					break;
+				}
+			}
+		} else {
+			knot_lmdb_abort(&txn);
+			move_req(failed, done);
+		}
+	}
+}
+
+static void *writer_thread(void *arg)
+{
+	journal_batch_t *batch = arg;
+
+	pthread_mutex_lock(&batch->lock);
+	while (true) {
+		while (EMPTY_LIST(batch->queue) && !batch->stop) {
+			pthread_cond_wait(&batch->queued, &batch->lock);
+		}
+		if (EMPTY_LIST(batch->queue)) {
+			break;
+		}
+
+		// Wait for more insertions, limited by the age of the oldest one.
+		uint64_t delay_ms = ATOMIC_GET(batch->delay_ms);
+		struct timespec deadline = batch->first_at;
+		deadline.tv_sec += delay_ms / 1000;
+		deadline.tv_nsec += (delay_ms % 1000) * 1000000;
+		if (deadline.tv_nsec >= 1000000000) {
+			deadline.tv_sec++;
+			deadline.tv_nsec -= 1000000000;
+		}
+		while (!batch->stop && batch->queue_len < JOURNAL_BATCH_MAX) {
+			if (pthread_cond_timedwait(&batch->queued, &batch->lock, &deadline) == ETIMEDOUT) {
+				break;
+			}
+		}
+
+		// Insertions left in the queue are already late, first_at is kept.
+		list_t todo, done;
+		init_list(&todo);
+		init_list(&done);
+		size_t taken = 0;
+		journal_batch_req_t *req, *nxt;
+		WALK_LIST_DELSAFE(req, nxt, batch->queue) {
+			if (taken == JOURNAL_BATCH_MAX) {
+				break;
+			}
+			move_req(req, &todo);
+			taken++;
+		}
+		batch->queue_len -= taken;
+		pthread_mutex_unlock(&batch->lock);
+
+		write_group(batch->db, &todo, &done);
+
+		pthread_mutex_lock(&batch->lock);
+		WALK_LIST_DELSAFE(req, nxt, done) {
+			req->done = true; // the submitter may free it once unlocked
+		}
+		pthread_cond_broadcast(&batch->finished);
+	}
+	pthread_mutex_unlock(&batch->lock);
+
+	return NULL;
+}
+
+journal_batch_t *journal_batch_new(knot_lmdb_db_t *db, unsigned delay_ms)
+{
+	journal_batch_t *batch = calloc(1, sizeof(*batch));
+	if (batch == NULL) {
+		return NULL;
+	}
+
+	batch->db = db;
+	ATOMIC_SET(batch->delay_ms, delay_ms);
+	init_list(&batch->queue);
+
+	pthread_condattr_t attr;
+	pthread_condattr_init(&attr);
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+	pthread_mutex_init(&batch->lock, NULL);
+	pthread_cond_init(&batch->queued, &attr);
+	pthread_cond_init(&batch->finished, NULL);
+	pthread_condattr_destroy(&attr);
+
+	if (pthread_create(&batch->thread, NULL, writer_thread, batch) != 0) {
+		pthread_cond_destroy(&batch->finished);
+		pthread_cond_destroy(&batch->queued);
+		pthread_mutex_destroy(&batch->lock);
+		free(batch);
+		return NULL;
+	}
+
+	return batch;
+}
+
+void journal_batch_free(journal_batch_t *batch)
+{
+	if (batch == NULL) {
+		return;
+	}
+
+	pthread_mutex_lock(&batch->lock);
+	batch->stop = true;
+	pthread_cond_signal(&batch->queued);
+	pthread_mutex_unlock(&batch->lock);
+
+	pthread_join(batch->thread, NULL);
+
+	pthread_cond_destroy(&batch->finished);
+	pthread_cond_destroy(&batch->queued);
+	pthread_mutex_destroy(&batch->lock);
+	free(batch);
+}
+
+void journal_batch_set_delay(journal_batch_t *batch, unsigned delay_ms)
+{
+	if (batch != NULL) {
+		ATOMIC_SET(batch->delay_ms, delay_ms);
+	}
+}
+
+bool journal_batch_enabled(journal_batch_t *batch)
+{
+	return batch != NULL && ATOMIC_GET(batch->delay_ms) > 0;
+}
+
+void journal_batch_submit(journal_batch_t *batch, journal_batch_req_t *req,
+                          zone_journal_t j, const changeset_t *ch,
+                          const changeset_t *extra, const zone_diff_t *zdiff)
+{
+	*req = (journal_batch_req_t) {
+		.j = j,
+		.ch = ch,
+		.extra = extra,
+		.zdiff = zdiff,
+	};
+
+	pthread_mutex_lock(&batch->lock);
+	if (EMPTY_LIST(batch->queue)) {
+		clock_gettime(CLOCK_MONOTONIC, &batch->first_at);
+	}
+	add_tail(&batch->queue, &req->n);
+	batch->queue_len++;
+	pthread_cond_signal(&batch->queued);
+	pthread_mutex_unlock(&batch->lock);
+}
+
+int journal_batch_wait(journal_batch_t *batch, journal_batch_req_t *req)
+{
+	pthread_mutex_lock(&batch->lock);
+	while (!req->done) {
+		pthread_cond_wait(&batch->finished, &batch->lock);
+	}
+	pthread_mutex_unlock(&batch->lock);
+
+	return req->ret;
+}
+
+int journal_batch_insert(journal_batch_t *batch, zone_journal_t j, const changeset_t *ch,
+                         const changeset_t *extra, const zone_diff_t *zdiff)
+{
+	journal_batch_req_t req;
+	journal_batch_submit(batch, &req, j, ch, extra, zdiff);
+	return journal_batch_wait(batch, &req);
+}
@@ -0,0 +1,100 @@
+/*  Copyright (C) 2024 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "contrib/ucw/lists.h"
+#include "knot/journal/journal_basic.h"
+#include "knot/journal/serialization.h"
+
+/*! \brief Maximal number of insertions committed in one transaction. */
+#define JOURNAL_BATCH_MAX	256
+
+/*!
+ * \brief Journal writer committing insertions of many zones together.
+ *
+ * Insertions are queued and a dedicated thread writes them into the journal
+ * DB within a single transaction, waiting at most the configured delay
+ * for more insertions to come. The DB synchronization then happens once
+ * for the whole group, according to the journal DB mode.
+ */
+typedef struct journal_batch journal_batch_t;
+
+/*! \brief Queued insertion, its result is available once it's done. */
+typedef struct {
+	node_t n;
+	zone_journal_t j;
+	const changeset_t *ch;
+	const changeset_t *extra;
+	const zone_diff_t *zdiff;
+	int ret;
+	bool done;
+} journal_batch_req_t;
+
+/*!
+ * \brief Create the journal writer and start its thread.
+ *
+ * \param db        Journal DB.
+ * \param delay_ms  Maximal time to wait for more insertions (0 disables the writer).
+ *
+ * \return New journal writer or NULL on error.
+ */
+journal_batch_t *journal_batch_new(knot_lmdb_db_t *db, unsigned delay_ms);
+
+/*!
+ * \brief Stop the writer thread, wait for queued insertions, and free the writer.
+ */
+void journal_batch_free(journal_batch_t *batch);
+
+/*!
+ * \brief Change the waiting time of the writer.
+ *
+ * \param batch     Journal writer.
+ * \param delay_ms  Maximal time to wait for more insertions (0 disables the writer).
+ */
+void journal_batch_set_delay(journal_batch_t *batch, unsigned delay_ms);
+
+/*!
+ * \brief Check if insertions shall be passed to the writer.
+ */
+bool journal_batch_enabled(journal_batch_t *batch);
+
+/*!
+ * \brief Queue an insertion, see journal_insert() for the parameters.
+ *
+ * \note The request and the inserted data must be kept until it's done.
+ *
+ * \param batch   Journal writer.
+ * \param req     Request to be initialized and queued.
+ */
+void journal_batch_submit(journal_batch_t *batch, journal_batch_req_t *req,
+                          zone_journal_t j, const changeset_t *ch,
+                          const changeset_t *extra, const zone_diff_t *zdiff);
+
+/*!
+ * \brief Wait until the queued insertion is committed or refused.
+ *
+ * \return KNOT_E* as from journal_insert().
+ */
+int journal_batch_wait(journal_batch_t *batch, journal_batch_req_t *req);
+
+/*!
+ * \brief Store changeset into journal via the writer and wait for the result.
+ *
+ * \return KNOT_E* as from journal_insert().
+ */
+int journal_batch_insert(journal_batch_t *batch, zone_journal_t j, const changeset_t *ch,
+                         const changeset_t *extra, const zone_diff_t *zdiff);
@@ -0,0 +1,237 @@
+/*  Copyright (C) 2024 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef ENABLE_ZSTD
+#include <zstd.h>
+#endif
+
+#include "knot/journal/journal_compress.h"
+#include "contrib/time.h"
+#include "libknot/error.h"
+
+struct journal_zctx {
+	bool compress;
+	uint8_t *buf;  // Buffer for a plain and a packed chunk (compression only).
+#ifdef ENABLE_ZSTD
+	union {
+		ZSTD_CCtx *cctx;
+		ZSTD_DCtx *dctx;
+	};
+#endif
+};
+
+journal_zctx_t *journal_zctx_new(bool compress)
+{
+#ifdef ENABLE_ZSTD
+	journal_zctx_t *ctx = calloc(1, sizeof(*ctx));
+	if (ctx == NULL) {
+		return NULL;
+	}
+
+	ctx->compress = compress;
+	if (compress) {
+		ctx->buf = malloc(2 * JOURNAL_CHUNK_MAX);
+		if (ctx->buf == NULL) {
+			free(ctx);
+			return NULL;
+		}
+		ctx->cctx = ZSTD_createCCtx();
+		if (ctx->cctx != NULL) {
+			// The chunk data are self-describing by the header, spare the frame overhead.
+			ZSTD_CCtx_setParameter(ctx->cctx, ZSTD_c_compressionLevel, JOURNAL_COMPRESS_LEVEL);
+			ZSTD_CCtx_setParameter(ctx->cctx, ZSTD_c_contentSizeFlag, 0);
+			ZSTD_CCtx_setParameter(ctx->cctx, ZSTD_c_checksumFlag, 0);
+		}
+	} else {
+		ctx->dctx = ZSTD_createDCtx();
+	}
+	if ((compress && ctx->cctx == NULL) || (!compress && ctx->dctx == NULL)) {
+		free(ctx->buf);
+		free(ctx);
+		return NULL;
+	}
+
+	return ctx;
+#else
+	return NULL;
+#endif
+}
+
+void journal_zctx_free(journal_zctx_t *ctx)
+{
+	if (ctx == NULL) {
+		return;
+	}
+
+#ifdef ENABLE_ZSTD
+	if (ctx->compress) {
+		ZSTD_freeCCtx(ctx->cctx);
+	} else {
+		ZSTD_freeDCtx(ctx->dctx);
+	}
+#endif
+	free(ctx->buf);
+	free(ctx);
+}
+
+static pthread_key_t thread_zctx_key;
+static pthread_once_t thread_zctx_once = PTHREAD_ONCE_INIT;
+
+static void thread_zctx_free(void *ctx)
+{
+	journal_zctx_free(ctx);
+}
+
+static void thread_zctx_init(void)
+{
+	(void)pthread_key_create(&thread_zctx_key, thread_zctx_free);
+}
+
+journal_zctx_t *journal_zctx_thread(void)
+{
+	(void)pthread_once(&thread_zctx_once, thread_zctx_init);
+
+	journal_zctx_t *ctx = pthread_getspecific(thread_zctx_key);
+	if (ctx == NULL) {
+		ctx = journal_zctx_new(true);
+		if (ctx != NULL && pthread_setspecific(thread_zctx_key, ctx) != 0) {
+			journal_zctx_free(ctx);
+			ctx = NULL;
+		}
+	}
+
+	return ctx;
+}
+
+uint8_t *journal_zctx_buf(journal_zctx_t *ctx)
+{
+	return (ctx != NULL) ? ctx->buf : NULL;
+}
+
+size_t journal_compress(journal_zctx_t *ctx, const uint8_t *src, size_t src_size,
+                        uint8_t *dst, size_t dst_size)
+{
+#ifdef ENABLE_ZSTD
+	if (ctx == NULL || !ctx->compress) {
+		return 0;
+	}
+
+	size_t ret = ZSTD_compress2(ctx->cctx, dst, dst_size, src, src_size);
+	return ZSTD_isError(ret) ? 0 : ret;
+#else
+	return 0;
+#endif
+}
+
+int journal_decompress(journal_zctx_t *ctx, const uint8_t *src, size_t src_size,
+                       uint8_t *dst, size_t dst_size)
+{
+#ifdef ENABLE_ZSTD
+	if (ctx == NULL || ctx->compress) {
+		return KNOT_EINVAL;
+	}
+
+	size_t ret = ZSTD_decompressDCtx(ctx->dctx, dst, dst_size, src, src_size);
+	return (ZSTD_isError(ret) || ret != dst_size) ? KNOT_EMALF : KNOT_EOK;
+#else
+	return KNOT_ENOTSUP;
+#endif
+}
+
+static bool is_chunk_key(const MDB_val *prefix, const MDB_val *key)
+{
+	static const char bootstrap[] = "bootstrap";
+
+	size_t rest = key->mv_size - prefix->mv_size;
+	const uint8_t *data = key->mv_data + prefix->mv_size;
+	if (rest == sizeof(bootstrap) + sizeof(uint32_t)) {
+		return memcmp(data, bootstrap, sizeof(bootstrap)) == 0;
+	}
+
+	// Serial and chunk ID, unlike a metadata name with the only zero byte at the end.
+	return rest == 2 * sizeof(uint32_t) && memchr(data, 0, rest - 1) != NULL;
+}
+
+int journal_chunk_stats(zone_journal_t j, journal_chunk_stats_t *stats)
+{
+	if (stats == NULL) {
+		return KNOT_EINVAL;
+	}
+	memset(stats, 0, sizeof(*stats));
+
+	int ret = knot_lmdb_open(j.db);
+	if (ret != KNOT_EOK) {
+		return ret;
+	}
+
+	journal_zctx_t *zctx = NULL;
+	uint8_t *buf = NULL;
+
+	knot_lmdb_txn_t txn = { 0 };
+	knot_lmdb_begin(j.db, &txn, false);
+	MDB_val prefix = journal_zone_prefix(j.zone);
+	knot_lmdb_foreach(&txn, &prefix) {
+		if (!is_chunk_key(&prefix, &txn.cur_key)) {
+			continue;
+		} else if (txn.cur_val.mv_size < JOURNAL_HEADER_SIZE) {
+			txn.ret = KNOT_EMALF;
+			break;
+		}
+		size_t stored = txn.cur_val.mv_size - JOURNAL_HEADER_SIZE;
+		uint32_t plain = journal_chunk_plain_size(&txn.cur_val);
+
+		stats->chunks++;
+		stats->stored_size += stored;
+		stats->plain_size += (plain > 0) ? plain : stored;
+		if (plain == 0) {
+			continue;
+		}
+		stats->compressed++;
+
+		if (zctx == NULL) {
+			zctx = journal_zctx_new(false);
+			buf = malloc(JOURNAL_CHUNK_MAX);
+			if (zctx == NULL || buf == NULL) {
+				txn.ret = (zctx == NULL) ? KNOT_ENOTSUP : KNOT_ENOMEM;
+				break;
+			}
+		}
+		if (plain > JOURNAL_CHUNK_MAX) {
+			txn.ret = KNOT_EMALF;
+			break;
+		}
+
+		struct timespec begin = time_now();
+		txn.ret = journal_decompress(zctx, txn.cur_val.mv_data + JOURNAL_HEADER_SIZE,
+		                             stored, buf, plain);
+		struct timespec end = time_now();
+		struct timespec diff = time_diff(&begin, &end);
+		stats->decompress_ns += diff.tv_sec * 1000000000 + diff.tv_nsec;
+		if (txn.ret != KNOT_EOK) {
+			break;
+		}
+	}
+	free(prefix.mv_data);
+	knot_lmdb_abort(&txn);
+
+	free(buf);
+	journal_zctx_free(zctx);
+
+	return txn.ret;
+}
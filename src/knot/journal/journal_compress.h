@@ -0,0 +1,110 @@
+/*  Copyright (C) 2024 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "knot/journal/journal_basic.h"
+
+/*! \brief Compression level used for journal chunks. */
+#define JOURNAL_COMPRESS_LEVEL	3
+
+typedef struct journal_zctx journal_zctx_t;
+
+/*!
+ * \brief Statistics of stored changeset chunks.
+ */
+typedef struct {
+	size_t chunks;           /*!< Number of chunks. */
+	size_t compressed;       /*!< Number of compressed chunks. */
+	uint64_t stored_size;    /*!< Total size of the chunk data as stored. */
+	uint64_t plain_size;     /*!< Total size of the chunk data uncompressed. */
+	uint64_t decompress_ns;  /*!< Time spent by decompression of all chunks. */
+} journal_chunk_stats_t;
+
+/*!
+ * \brief Create a (de)compression context.
+ *
+ * \param compress  True for compression, false for decompression context.
+ *
+ * \return New context, NULL if out of memory or compression not available.
+ */
+journal_zctx_t *journal_zctx_new(bool compress);
+
+/*!
+ * \brief Free the (de)compression context.
+ */
+void journal_zctx_free(journal_zctx_t *ctx);
+
+/*!
+ * \brief Get the compression context of the calling thread.
+ *
+ * The context is created on first use and freed when the thread exits.
+ *
+ * \return Compression context (don't free), NULL if out of memory or
+ *         compression not available.
+ */
+journal_zctx_t *journal_zctx_thread(void);
+
+/*!
+ * \brief Get the chunk buffer of a compression context.
+ *
+ * \return Buffer for 2 * JOURNAL_CHUNK_MAX bytes, NULL for decompression context.
+ */
+uint8_t *journal_zctx_buf(journal_zctx_t *ctx);
+
+/*!
+ * \brief Compress chunk data.
+ *
+ * \param ctx       Compression context.
+ * \param src       Chunk data.
+ * \param src_size  Chunk data size.
+ * \param dst       Output buffer.
+ * \param dst_size  Output buffer size.
+ *
+ * \return Compressed size, 0 if it doesn't fit into the output buffer or error.
+ */
+size_t journal_compress(journal_zctx_t *ctx, const uint8_t *src, size_t src_size,
+                        uint8_t *dst, size_t dst_size);
+
+/*!
+ * \brief Decompress chunk data.
+ *
+ * \param ctx       Decompression context.
+ * \param src       Compressed chunk data.
+ * \param src_size  Compressed chunk data size.
+ * \param dst       Output buffer.
+ * \param dst_size  Expected size of the decompressed data.
+ *
+ * \retval KNOT_EOK if success.
+ * \retval KNOT_ENOTSUP if compression not available.
+ * \retval KNOT_EMALF if the data are corrupted.
+ */
+int journal_decompress(journal_zctx_t *ctx, const uint8_t *src, size_t src_size,
+                       uint8_t *dst, size_t dst_size);
+
+/*!
+ * \brief Collect statistics of all chunks of the zone, measuring decompression time.
+ *
+ * \param j      Zone journal.
+ * \param stats  Output: chunk statistics.
+ *
+ * \return KNOT_E*
+ */
+int journal_chunk_stats(zone_journal_t j, journal_chunk_stats_t *stats);
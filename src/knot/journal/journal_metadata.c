@@ -329,6 +329,33 @@ done:
 	return tr.ret == KNOT_EOK ? tw.ret : tr.ret;
 }
 
+int journal_move_with_md(knot_lmdb_db_t *from, knot_lmdb_db_t *to, const knot_dname_t *zone)
+{
+	knot_lmdb_txn_t tr = { 0 }, tw = { 0 };
+	tr.ret = knot_lmdb_open(from);
+	tw.ret = knot_lmdb_open(to);
+	if (tr.ret != KNOT_EOK || tw.ret != KNOT_EOK) {
+		goto done;
+	}
+	knot_lmdb_begin(from, &tr, true);
+	knot_lmdb_begin(to, &tw, true);
+	update_last_inserter(&tr, NULL);
+	update_last_inserter(&tw, NULL);
+	MDB_val prefix = journal_zone_prefix(zone);
+	knot_lmdb_copy_prefix(&tr, &tw, &prefix);
+	free(prefix.mv_data);
+	update_last_inserter(&tw, NULL); // don't account the moved records to anyone
+	journal_del_zone(&tr, zone);
+	knot_lmdb_commit(&tw);
+	if (tw.ret == KNOT_EOK) {
+		knot_lmdb_commit(&tr);
+	} else {
+		knot_lmdb_abort(&tr);
+	}
+done:
+	return tr.ret == KNOT_EOK ? tw.ret : tr.ret;
+}
+
 int journal_set_flushed(zone_journal_t j)
 {
 	knot_lmdb_txn_t txn = { 0 };
@@ -140,6 +140,19 @@ int journal_scrape_with_md(zone_journal_t j, bool check_existence);
  */
 int journal_copy_with_md(knot_lmdb_db_t *from, knot_lmdb_db_t *to, const knot_dname_t *zone);
 
+/*!
+ * \brief Move all records related to this zone from one journal DB to another.
+ *
+ * \note The space occupied by the zone is accounted in the target DB afterwards.
+ *
+ * \param from   DB to move from.
+ * \param to     DB to move to.
+ * \param zone   Journal zone.
+ *
+ * \return KNOT_E*
+ */
+int journal_move_with_md(knot_lmdb_db_t *from, knot_lmdb_db_t *to, const knot_dname_t *zone);
+
 /*!
  * \brief Update the metadata stored in journal DB after a zone flush.
  *
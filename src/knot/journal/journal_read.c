@@ -16,6 +16,7 @@
 
 #include "knot/journal/journal_read.h"
 
+#include "knot/journal/journal_compress.h"
 #include "knot/journal/journal_metadata.h"
 #include "knot/journal/knot_lmdb.h"
 
@@ -35,6 +36,11 @@ struct journal_read {
 	uint32_t next;
 	uint32_t changesets_read;
 	uint32_t changesets_total;
+	uint8_t *rdata_buf;
+	size_t rdata_buf_size;
+	knot_dname_storage_t owner_buf;
+	journal_zctx_t *zctx;
+	uint8_t *chunk_buf;
 };
 
 int journal_read_get_error(const journal_read_t *ctx, int another_error)
@@ -42,10 +48,48 @@ int journal_read_get_error(const journal_read_t *ctx, int another_error)
 	return (ctx == NULL || ctx->txn.ret == KNOT_EOK ? another_error : ctx->txn.ret);
 }
 
-static void update_ctx_wire(journal_read_t *ctx)
+static int decompress_chunk(journal_read_t *ctx, uint32_t plain_size)
 {
-	ctx->wire = wire_ctx_init_const(ctx->txn.cur_val.mv_data, ctx->txn.cur_val.mv_size);
-	wire_ctx_skip(&ctx->wire, JOURNAL_HEADER_SIZE);
+	if (plain_size > JOURNAL_CHUNK_MAX) {
+		return KNOT_EMALF;
+	}
+
+	if (ctx->chunk_buf == NULL) {
+		ctx->zctx = journal_zctx_new(false);
+		if (ctx->zctx == NULL) {
+			return KNOT_ENOTSUP;
+		}
+		ctx->chunk_buf = malloc(JOURNAL_CHUNK_MAX);
+		if (ctx->chunk_buf == NULL) {
+			return KNOT_ENOMEM;
+		}
+	}
+
+	return journal_decompress(ctx->zctx, ctx->txn.cur_val.mv_data + JOURNAL_HEADER_SIZE,
+	                          ctx->txn.cur_val.mv_size - JOURNAL_HEADER_SIZE,
+	                          ctx->chunk_buf, plain_size);
+}
+
+static bool update_ctx_wire(journal_read_t *ctx)
+{
+	if (ctx->txn.cur_val.mv_size < JOURNAL_HEADER_SIZE) {
+		ctx->txn.ret = KNOT_EMALF;
+		return false;
+	}
+
+	uint32_t plain_size = journal_chunk_plain_size(&ctx->txn.cur_val);
+	if (plain_size == 0) {
+		ctx->wire = wire_ctx_init_const(ctx->txn.cur_val.mv_data, ctx->txn.cur_val.mv_size);
+		wire_ctx_skip(&ctx->wire, JOURNAL_HEADER_SIZE);
+		return true;
+	}
+
+	ctx->txn.ret = decompress_chunk(ctx, plain_size);
+	if (ctx->txn.ret != KNOT_EOK) {
+		return false;
+	}
+	ctx->wire = wire_ctx_init_const(ctx->chunk_buf, plain_size);
+	return true;
 }
 
 static bool go_correct_prefix(journal_read_t *ctx)
@@ -78,8 +122,7 @@ static bool go_next_changeset(journal_read_t *ctx, bool go_zone, const knot_dnam
 	}
 	ctx->next = journal_next_serial(&ctx->txn.cur_val);
 	ctx->timestamp = journal_ch_timestamp(&ctx->txn.cur_val);
-	update_ctx_wire(ctx);
-	return true;
+	return update_ctx_wire(ctx);
 }
 
 int journal_read_begin(zone_journal_t j, bool read_zone, uint32_t serial_from, journal_read_t **ctx)
@@ -120,6 +163,9 @@ void journal_read_end(journal_read_t *ctx)
 	if (ctx != NULL) {
 		free(ctx->key_prefix.mv_data);
 		knot_lmdb_abort(&ctx->txn);
+		free(ctx->rdata_buf);
+		free(ctx->chunk_buf);
+		journal_zctx_free(ctx->zctx);
 		free(ctx);
 	}
 }
@@ -138,7 +184,7 @@ static bool make_data_available(journal_read_t *ctx)
 			ctx->txn.ret = KNOT_EMALF;
 			return false;
 		}
-		update_ctx_wire(ctx);
+		return update_ctx_wire(ctx);
 	}
 	return true;
 }
@@ -189,6 +235,79 @@ bool journal_read_rrset(journal_read_t *ctx, knot_rrset_t *rrset, bool allow_nex
 	}
 }
 
+static int rdata_buf_reserve(journal_read_t *ctx, size_t size)
+{
+	if (size <= ctx->rdata_buf_size) {
+		return KNOT_EOK;
+	}
+
+	size_t new_size = MAX(size, 2 * ctx->rdata_buf_size);
+	uint8_t *new_buf = realloc(ctx->rdata_buf, new_size);
+	if (new_buf == NULL) {
+		return KNOT_ENOMEM;
+	}
+	ctx->rdata_buf = new_buf;
+	ctx->rdata_buf_size = new_size;
+
+	return KNOT_EOK;
+}
+
+bool journal_read_rrset_view(journal_read_t *ctx, knot_rrset_t *rrset, bool allow_next_changeset)
+{
+	knot_rrset_init_empty(rrset);
+	if (!make_data_available(ctx)) {
+		if (!allow_next_changeset || !go_next_changeset(ctx, false, ctx->zone)) {
+			return false;
+		}
+	}
+	// The chunk data may be replaced by the next chunk when reading the records.
+	knot_dname_t *owner = ctx->owner_buf;
+	int owner_size = knot_dname_to_wire(owner, ctx->wire.position, sizeof(ctx->owner_buf));
+	if (owner_size < 0) {
+		ctx->txn.ret = KNOT_EMALF;
+		return false;
+	}
+	wire_ctx_skip(&ctx->wire, owner_size);
+	uint16_t type = wire_ctx_read_u16(&ctx->wire);
+	uint16_t rclass = wire_ctx_read_u16(&ctx->wire);
+	uint16_t rrs_count = wire_ctx_read_u16(&ctx->wire);
+	uint32_t ttl = 0;
+	size_t size = 0;
+	for (int i = 0; i < rrs_count && ctx->wire.error == KNOT_EOK; i++) {
+		if (!make_data_available(ctx)) {
+			ctx->wire.error = KNOT_EFEWDATA;
+		}
+		uint32_t rr_ttl = wire_ctx_read_u32(&ctx->wire);
+		if (i == 0) {
+			ttl = rr_ttl;
+		}
+		uint16_t len = wire_ctx_read_u16(&ctx->wire);
+		if (ctx->wire.error == KNOT_EOK && wire_ctx_available(&ctx->wire) < len) {
+			ctx->wire.error = KNOT_EFEWDATA;
+		}
+		if (ctx->wire.error == KNOT_EOK) {
+			ctx->wire.error = rdata_buf_reserve(ctx, size + knot_rdata_size(len));
+		}
+		if (ctx->wire.error == KNOT_EOK) {
+			knot_rdata_init((knot_rdata_t *)(ctx->rdata_buf + size), len, ctx->wire.position);
+			size += knot_rdata_size(len);
+		}
+		wire_ctx_skip(&ctx->wire, len);
+	}
+	if (ctx->txn.ret == KNOT_EOK) {
+		ctx->txn.ret = ctx->wire.error == KNOT_ERANGE ? KNOT_EMALF : ctx->wire.error;
+	}
+	if (ctx->txn.ret != KNOT_EOK) {
+		return false;
+	}
+
+	knot_rrset_init(rrset, owner, type, rclass, ttl);
+	rrset->rrs.count = rrs_count;
+	rrset->rrs.size = size;
+	rrset->rrs.rdata = (knot_rdata_t *)ctx->rdata_buf;
+	return true;
+}
+
 void journal_read_clear_rrset(knot_rrset_t *rr)
 {
 	knot_rrset_clear(rr, NULL);
@@ -47,6 +47,21 @@ int journal_read_begin(zone_journal_t j, bool read_zone, uint32_t serial_from, j
  */
 bool journal_read_rrset(journal_read_t *ctx, knot_rrset_t *rr, bool allow_next_changeset);
 
+/*!
+ * \brief Read a single RRSet from a journal changeset without allocating it.
+ *
+ * The owner and the records are placed into buffers of the reading context.
+ * The RRSet is valid until the next read or the end of reading and it must
+ * not be cleared.
+ *
+ * \param ctx                    Journal reading context.
+ * \param rr                     Output: RRSet to be pointed to serialized data.
+ * \param allow_next_changeset   True to allow jumping to next changeset.
+ *
+ * \return False if no more RRSet in this changeset/journal, or failure.
+ */
+bool journal_read_rrset_view(journal_read_t *ctx, knot_rrset_t *rr, bool allow_next_changeset);
+
 /*!
  * \brief Free up heap allocations by journal_read_rrset().
  *
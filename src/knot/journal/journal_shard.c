@@ -0,0 +1,114 @@
+/*  Copyright (C) 2024 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+
+#include "knot/journal/journal_metadata.h"
+#include "knot/journal/journal_shard.h"
+#include "contrib/string.h"
+#include "contrib/ucw/lists.h"
+#include "libknot/error.h"
+
+unsigned journal_shard(const knot_dname_t *zone, unsigned shards)
+{
+	if (shards <= 1) {
+		return 0;
+	}
+
+	// FNV-1a, the result must be stable across restarts and platforms.
+	uint32_t hash = 2166136261u;
+	size_t size = knot_dname_size(zone);
+	for (size_t i = 0; i < size; i++) {
+		hash ^= zone[i];
+		hash *= 16777619u;
+	}
+
+	return hash % shards;
+}
+
+char *journal_shard_path(const char *base, unsigned shard)
+{
+	if (base == NULL) {
+		return NULL;
+	}
+
+	if (shard == 0) {
+		return strdup(base);
+	} else {
+		return sprintf_alloc("%s/shard%u", base, shard);
+	}
+}
+
+typedef struct {
+	unsigned shard;
+	unsigned shards;
+	list_t misplaced;
+} walk_ctx_t;
+
+static int add_misplaced(const knot_dname_t *zone, void *data)
+{
+	walk_ctx_t *ctx = data;
+	if (journal_shard(zone, ctx->shards) == ctx->shard) {
+		return KNOT_EOK;
+	}
+
+	knot_dname_t *copy = knot_dname_copy(zone, NULL);
+	if (copy == NULL || ptrlist_add(&ctx->misplaced, copy, NULL) == NULL) {
+		free(copy);
+		return KNOT_ENOMEM;
+	}
+
+	return KNOT_EOK;
+}
+
+int journal_shards_migrate(knot_lmdb_db_t *dbs, unsigned shards, size_t *moved)
+{
+	if (dbs == NULL || shards < 1 || shards > JOURNAL_SHARDS_MAX || moved == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	*moved = 0;
+
+	int ret = KNOT_EOK;
+	for (unsigned i = 0; i < JOURNAL_SHARDS_MAX && ret == KNOT_EOK; i++) {
+		if (knot_lmdb_exists(&dbs[i]) != KNOT_EOK) {
+			continue;
+		}
+
+		walk_ctx_t ctx = { .shard = i, .shards = shards };
+		init_list(&ctx.misplaced);
+		ret = journals_walk(&dbs[i], add_misplaced, &ctx);
+
+		ptrnode_t *n;
+		WALK_LIST(n, ctx.misplaced) {
+			if (ret != KNOT_EOK) {
+				break;
+			}
+			const knot_dname_t *zone = n->d;
+			ret = journal_move_with_md(&dbs[i], &dbs[journal_shard(zone, shards)], zone);
+			if (ret == KNOT_EOK) {
+				(*moved)++;
+			}
+		}
+		ptrlist_deep_free(&ctx.misplaced, NULL);
+
+		if (i >= shards) {
+			knot_lmdb_close(&dbs[i]);
+		}
+	}
+
+	return ret;
+}
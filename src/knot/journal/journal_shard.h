@@ -0,0 +1,60 @@
+/*  Copyright (C) 2024 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "knot/journal/knot_lmdb.h"
+#include "libknot/dname.h"
+
+/*! \brief Maximal number of journal DB shards. */
+#define JOURNAL_SHARDS_MAX	32
+
+/*!
+ * \brief Get the journal DB shard the zone belongs to.
+ *
+ * \param zone    Zone name (lower-case).
+ * \param shards  Number of shards.
+ *
+ * \return Shard index.
+ */
+unsigned journal_shard(const knot_dname_t *zone, unsigned shards);
+
+/*!
+ * \brief Get the directory of the journal DB shard.
+ *
+ * \note The first shard is stored directly in the base directory, so the journal
+ *       DB without sharding is its first shard.
+ *
+ * \param base   Journal DB directory.
+ * \param shard  Shard index.
+ *
+ * \return Allocated path or NULL on error.
+ */
+char *journal_shard_path(const char *base, unsigned shard);
+
+/*!
+ * \brief Move zone journals stored in a wrong shard into the right one.
+ *
+ * This is needed after the number of shards has changed. Shards beyond
+ * the number of shards in use are left empty and closed.
+ *
+ * \param dbs     Initialized DBs of all possible shards (JOURNAL_SHARDS_MAX).
+ * \param shards  Number of shards in use.
+ * \param moved   Output: number of moved zone journals.
+ *
+ * \return KNOT_E*
+ */
+int journal_shards_migrate(knot_lmdb_db_t *dbs, unsigned shards, size_t *moved);
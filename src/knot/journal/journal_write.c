@@ -25,23 +25,45 @@
 #include "libknot/error.h"
 
 static void journal_write_serialize(knot_lmdb_txn_t *txn, serialize_ctx_t *ser,
-                                    const knot_dname_t *apex, bool zij, uint32_t ch_from, uint32_t ch_to)
+                                    journal_zctx_t *zctx, const knot_dname_t *apex,
+                                    bool zij, uint32_t ch_from, uint32_t ch_to)
 {
 	MDB_val chunk;
 	uint32_t i = 0;
 	uint64_t now = knot_time();
+
+	// With compression, chunks are serialized into the context buffer first.
+	uint8_t *plain = journal_zctx_buf(zctx), *packed = NULL;
+	if (plain != NULL) {
+		packed = plain + JOURNAL_CHUNK_MAX;
+	}
+
 	while (serialize_unfinished(ser) && txn->ret == KNOT_EOK) {
+		size_t plain_size;
 		serialize_prepare(ser, JOURNAL_CHUNK_THRESH - JOURNAL_HEADER_SIZE,
-		                  JOURNAL_CHUNK_MAX - JOURNAL_HEADER_SIZE, &chunk.mv_size);
-		if (chunk.mv_size == 0) {
+		                  JOURNAL_CHUNK_MAX - JOURNAL_HEADER_SIZE, &plain_size);
+		if (plain_size == 0) {
 			break; // beware! If this is omitted, it creates empty chunk => EMALF when reading.
 		}
-		chunk.mv_size += JOURNAL_HEADER_SIZE;
+		size_t packed_size = 0;
+		if (plain != NULL) {
+			serialize_chunk(ser, plain, plain_size);
+			packed_size = journal_compress(zctx, plain, plain_size, packed, plain_size - 1);
+		}
+		chunk.mv_size = JOURNAL_HEADER_SIZE + (packed_size > 0 ? packed_size : plain_size);
 		chunk.mv_data = NULL;
 		MDB_val key = journal_make_chunk_key(apex, ch_from, zij, i);
 		if (knot_lmdb_insert(txn, &key, &chunk)) {
+			uint8_t *data = chunk.mv_data + JOURNAL_HEADER_SIZE;
 			journal_make_header(chunk.mv_data, ch_to, now);
-			serialize_chunk(ser, chunk.mv_data + JOURNAL_HEADER_SIZE, chunk.mv_size - JOURNAL_HEADER_SIZE);
+			if (packed_size > 0) {
+				journal_make_header_compressed(chunk.mv_data, plain_size);
+				memcpy(data, packed, packed_size);
+			} else if (plain != NULL) {
+				memcpy(data, plain, plain_size);
+			} else {
+				serialize_chunk(ser, data, plain_size);
+			}
 		}
 		free(key.mv_data);
 		i++;
@@ -52,7 +74,7 @@ static void journal_write_serialize(knot_lmdb_txn_t *txn, serialize_ctx_t *ser,
 	}
 }
 
-void journal_write_changeset(knot_lmdb_txn_t *txn, const changeset_t *ch)
+void journal_write_changeset(knot_lmdb_txn_t *txn, const changeset_t *ch, journal_zctx_t *zctx)
 {
 	serialize_ctx_t *ser = serialize_init(ch);
 	if (ser == NULL) {
@@ -60,30 +82,36 @@ void journal_write_changeset(knot_lmdb_txn_t *txn, const changeset_t *ch)
 		return;
 	}
 	if (ch->remove == NULL) {
-		journal_write_serialize(txn, ser, ch->soa_to->owner, true, 0, changeset_to(ch));
+		journal_write_serialize(txn, ser, zctx, ch->soa_to->owner, true, 0, changeset_to(ch));
 	} else {
-		journal_write_serialize(txn, ser, ch->soa_to->owner, false, changeset_from(ch), changeset_to(ch));
+		journal_write_serialize(txn, ser, zctx, ch->soa_to->owner, false, changeset_from(ch), changeset_to(ch));
 	}
 }
 
-void journal_write_zone(knot_lmdb_txn_t *txn, const zone_contents_t *z)
+void journal_write_zone(knot_lmdb_txn_t *txn, const zone_contents_t *z, journal_zctx_t *zctx)
 {
 	serialize_ctx_t *ser = serialize_zone_init(z);
 	if (ser == NULL) {
 		txn->ret = KNOT_ENOMEM;
 		return;
 	}
-	journal_write_serialize(txn, ser, z->apex->owner, true, 0, zone_contents_serial(z));
+	journal_write_serialize(txn, ser, zctx, z->apex->owner, true, 0, zone_contents_serial(z));
 }
 
-void journal_write_zone_diff(knot_lmdb_txn_t *txn, const zone_diff_t *z)
+static void journal_write_zone_diff(knot_lmdb_txn_t *txn, const zone_diff_t *z, journal_zctx_t *zctx)
 {
 	serialize_ctx_t *ser = serialize_zone_diff_init(z);
 	if (ser == NULL) {
 		txn->ret = KNOT_ENOMEM;
 		return;
 	}
-	journal_write_serialize(txn, ser, z->apex->owner, false, zone_diff_from(z), zone_diff_to(z));
+	journal_write_serialize(txn, ser, zctx, z->apex->owner, false, zone_diff_from(z), zone_diff_to(z));
+}
+
+static journal_zctx_t *conf_zctx(zone_journal_t j)
+{
+	// If not available, the changesets are written uncompressed.
+	return journal_conf_compression(j) ? journal_zctx_thread() : NULL;
 }
 
 static bool delete_one(knot_lmdb_txn_t *txn, bool del_zij, uint32_t del_serial,
@@ -136,7 +164,8 @@ void journal_merge(zone_journal_t j, knot_lmdb_txn_t *txn, bool merge_zij,
 		assert(del_next_serial == *original_serial_to);
 	}
 
-	journal_write_changeset(txn, &merge);
+	journal_zctx_t *zctx = conf_zctx(j);
+	journal_write_changeset(txn, &merge, zctx);
 	journal_read_clear_changeset(&merge);
 }
 
@@ -253,7 +282,8 @@ int journal_insert_zone(zone_journal_t j, const zone_contents_t *z)
 	update_last_inserter(&txn, j.zone);
 	journal_del_zone_txn(&txn, j.zone);
 
-	journal_write_zone(&txn, z);
+	journal_zctx_t *zctx = conf_zctx(j);
+	journal_write_zone(&txn, z, zctx);
 
 	journal_metadata_t md = { 0 };
 	md.flags = JOURNAL_SERIAL_TO_VALID;
@@ -265,8 +295,8 @@ int journal_insert_zone(zone_journal_t j, const zone_contents_t *z)
 	return txn.ret;
 }
 
-int journal_insert(zone_journal_t j, const changeset_t *ch, const changeset_t *extra,
-                   const zone_diff_t *zdiff)
+int journal_insert_txn(knot_lmdb_txn_t *txn, zone_journal_t j, const changeset_t *ch,
+                       const changeset_t *extra, const zone_diff_t *zdiff)
 {
 	assert(zdiff == NULL || (ch == NULL && extra == NULL));
 
@@ -288,23 +318,17 @@ int journal_insert(zone_journal_t j, const changeset_t *ch, const changeset_t *e
 	    (extra != NULL && serial_compare(extra_from, extra_to) != SERIAL_LOWER)) {
 		return KNOT_ESEMCHECK;
 	}
-	int ret = knot_lmdb_open(j.db);
-	if (ret != KNOT_EOK) {
-		return ret;
-	}
-	knot_lmdb_txn_t txn = { 0 };
 	journal_metadata_t md = { 0 };
-	knot_lmdb_begin(j.db, &txn, true);
-	journal_load_metadata(&txn, j.zone, &md);
+	journal_load_metadata(txn, j.zone, &md);
 
-	update_last_inserter(&txn, j.zone);
+	update_last_inserter(txn, j.zone);
 
 	if (extra != NULL) {
-		if (journal_contains(&txn, true, 0, j.zone)) {
-			txn.ret = KNOT_ESEMCHECK;
+		if (journal_contains(txn, true, 0, j.zone)) {
+			txn->ret = KNOT_ESEMCHECK;
 		}
 		uint64_t merged_freed = 0;
-		delete_merged(&txn, j.zone, &md, &merged_freed);
+		delete_merged(txn, j.zone, &md, &merged_freed);
 		ch_size += changeset_serialized_size(extra);
 		ch_size -= merged_freed;
 		md.flushed_upto = md.serial_to; // set temporarily
@@ -312,36 +336,56 @@ int journal_insert(zone_journal_t j, const changeset_t *ch, const changeset_t *e
 	}
 
 	size_t chs_limit = journal_conf_max_changesets(j);
-	journal_fix_occupation(j, &txn, &md, max_usage - ch_size, chs_limit - 1);
+	journal_fix_occupation(j, txn, &md, max_usage - ch_size, chs_limit - 1);
 
 	// avoid discontinuity
 	if ((md.flags & JOURNAL_SERIAL_TO_VALID) && md.serial_to != ch_from) {
-		if (journal_contains(&txn, true, 0, j.zone)) {
-			txn.ret = KNOT_ESEMCHECK;
+		if (journal_contains(txn, true, 0, j.zone)) {
+			txn->ret = KNOT_ESEMCHECK;
 		} else {
-			journal_del_zone_txn(&txn, j.zone);
+			journal_del_zone_txn(txn, j.zone);
 			memset(&md, 0, sizeof(md));
 		}
 	}
 
 	// avoid cycle
-	if (journal_contains(&txn, false, ch_to, j.zone)) {
-		journal_fix_occupation(j, &txn, &md, INT64_MAX, 1);
+	if (journal_contains(txn, false, ch_to, j.zone)) {
+		journal_fix_occupation(j, txn, &md, INT64_MAX, 1);
 	}
 
+	journal_zctx_t *zctx = conf_zctx(j);
 	if (zdiff == NULL) {
-		journal_write_changeset(&txn, ch);
+		journal_write_changeset(txn, ch, zctx);
 	} else {
-		journal_write_zone_diff(&txn, zdiff);
+		journal_write_zone_diff(txn, zdiff, zctx);
 	}
 	journal_metadata_after_insert(&md, ch_from, ch_to);
 
 	if (extra != NULL) {
-		journal_write_changeset(&txn, extra);
+		journal_write_changeset(txn, extra, zctx);
 		journal_metadata_after_extra(&md, extra_from, extra_to);
 	}
 
-	journal_store_metadata(&txn, j.zone, &md);
+	journal_store_metadata(txn, j.zone, &md);
+	return txn->ret;
+}
+
+int journal_insert(zone_journal_t j, const changeset_t *ch, const changeset_t *extra,
+                   const zone_diff_t *zdiff)
+{
+	int ret = knot_lmdb_open(j.db);
+	if (ret != KNOT_EOK) {
+		return ret;
+	}
+	knot_lmdb_txn_t txn = { 0 };
+	knot_lmdb_begin(j.db, &txn, true);
+
+	ret = journal_insert_txn(&txn, j, ch, extra, zdiff);
+	if (ret != KNOT_EOK) {
+		knot_lmdb_abort(&txn);
+		return ret;
+	}
+
 	knot_lmdb_commit(&txn);
 	return txn.ret;
 }
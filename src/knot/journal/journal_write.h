@@ -17,24 +17,27 @@
 #pragma once
 
 #include "knot/journal/journal_basic.h"
+#include "knot/journal/journal_compress.h"
 #include "knot/journal/journal_metadata.h"
 #include "knot/journal/serialization.h"
 
 /*!
  * \brief Serialize a changeset into chunks and write it into DB with no checks and metadata update.
  *
- * \param txn   Journal DB transaction.
- * \param ch    Changeset to be written.
+ * \param txn    Journal DB transaction.
+ * \param ch     Changeset to be written.
+ * \param zctx   Compression context, NULL to write uncompressed.
  */
-void journal_write_changeset(knot_lmdb_txn_t *txn, const changeset_t *ch);
+void journal_write_changeset(knot_lmdb_txn_t *txn, const changeset_t *ch, journal_zctx_t *zctx);
 
 /*!
  * \brief Serialize zone contents aka "bootstrap" changeset into journal, no checks.
  *
- * \param txn   Journal DB transaction.
- * \param z     Zone contents to be written.
+ * \param txn    Journal DB transaction.
+ * \param z      Zone contents to be written.
+ * \param zctx   Compression context, NULL to write uncompressed.
  */
-void journal_write_zone(knot_lmdb_txn_t *txn, const zone_contents_t *z);
+void journal_write_zone(knot_lmdb_txn_t *txn, const zone_contents_t *z, journal_zctx_t *zctx);
 
 /*!
  * \brief Merge all following changeset into one of journal changeset.
@@ -102,6 +105,26 @@ void journal_fix_occupation(zone_journal_t j, knot_lmdb_txn_t *txn, journal_meta
  */
 int journal_insert_zone(zone_journal_t j, const zone_contents_t *z);
 
+/*!
+ * \brief Store changeset into journal within a given transaction.
+ *
+ * Same as journal_insert(), but the transaction is neither opened nor committed.
+ *
+ * \param txn     Journal DB RW transaction.
+ * \param j       Zone journal.
+ * \param ch      Changeset to be stored.
+ * \param extra   Extra changeset to be stored in the role of merged changeset.
+ * \param zdiff   Zone diff to be stored instead of changeset.
+ *
+ * \note If the changeset is refused before touching the DB, the error is returned
+ *       and txn->ret stays untouched. KNOT_EBUSY in txn->ret means that the
+ *       transaction has been committed in the middle to allow zone flush.
+ *
+ * \return KNOT_E*
+ */
+int journal_insert_txn(knot_lmdb_txn_t *txn, zone_journal_t j, const changeset_t *ch,
+                       const changeset_t *extra, const zone_diff_t *zdiff);
+
 /*!
  * \brief Store changeset into journal, fulfilling quotas and updating metadata.
  *
@@ -22,6 +22,7 @@
 #include "libdnssec/error.h"
 #include "knot/include/module.h"
 #include "knot/modules/onlinesign/nsec_next.h"
+#include "knot/modules/onlinesign/sig_cache.h"
 // Next dependencies force static module!
 #include "knot/dnssec/ds_query.h"
 #include "knot/dnssec/key-events.h"
@@ -34,6 +35,7 @@
 
 #define MOD_POLICY	"\x06""policy"
 #define MOD_NSEC_BITMAP	"\x0B""nsec-bitmap"
+#define MOD_SIG_CACHE	"\x0F""signature-cache"
 
 int policy_check(knotd_conf_check_args_t *args)
 {
@@ -60,6 +62,7 @@ int bitmap_check(knotd_conf_check_args_t *args)
 const yp_item_t online_sign_conf[] = {
 	{ MOD_POLICY,      YP_TREF, YP_VREF = { C_POLICY }, YP_FNONE, { policy_check } },
 	{ MOD_NSEC_BITMAP, YP_TSTR, YP_VNONE, YP_FMULTI, { bitmap_check } },
+	{ MOD_SIG_CACHE,   YP_TINT, YP_VINT = { 0, UINT32_MAX, 0 } },
 	{ NULL }
 };
 
@@ -87,6 +90,8 @@ typedef struct {
 
 	uint16_t *nsec_force_types;
 
+	sig_cache_t *sig_cache;
+
 	bool zone_doomed;
 } online_sign_ctx_t;
 
@@ -230,37 +235,70 @@ static knot_rrset_t *synth_nsec(knot_pkt_t *pkt, knotd_qdata_t *qdata, knotd_mod
 	return nsec;
 }
 
+/*!
+ * \brief Get the time until cached signatures may be reused.
+ *
+ * Same margin before the signature expiration as for pre-signed zones.
+ */
+static knot_time_t sig_cache_expire(knotd_mod_t *mod, knot_time_t now)
+{
+	const knot_kasp_policy_t *policy = mod->dnssec->policy;
+	if (policy->rrsig_refresh_before >= policy->rrsig_lifetime) {
+		return 0;
+	}
+
+	return now + policy->rrsig_lifetime - policy->rrsig_refresh_before;
+}
+
 static knot_rrset_t *sign_rrset(const knot_dname_t *owner,
                                 const knot_rrset_t *cover,
                                 knotd_mod_t *mod,
                                 zone_sign_ctx_t *sign_ctx,
                                 knot_mm_t *mm)
 {
+	// resulting RRSIG
+
+	knot_rrset_t *rrsig = knot_rrset_new(owner, KNOT_RRTYPE_RRSIG, cover->rclass,
+	                                     cover->ttl, mm);
+	if (!rrsig) {
+		return NULL;
+	}
+
+	online_sign_ctx_t *ctx = knotd_mod_ctx(mod);
+	knot_time_t now = knot_time();
+
+	// cached signatures of the same RR set
+
+	pthread_rwlock_rdlock(&ctx->signing_mutex);
+	bool cached = sig_cache_get(ctx->sig_cache, owner, cover, now, rrsig, mm);
+	pthread_rwlock_unlock(&ctx->signing_mutex);
+	if (cached) {
+		return rrsig;
+	}
+
 	// copy of RR set with replaced owner name
 
 	knot_rrset_t *copy = knot_rrset_new(owner, cover->type, cover->rclass,
 	                                    cover->ttl, NULL);
 	if (!copy) {
+		knot_rrset_free(rrsig, mm);
 		return NULL;
 	}
 
 	if (knot_rdataset_copy(&copy->rrs, &cover->rrs, NULL) != KNOT_EOK) {
 		knot_rrset_free(copy, NULL);
+		knot_rrset_free(rrsig, mm);
 		return NULL;
 	}
 
-	// resulting RRSIG
-
-	knot_rrset_t *rrsig = knot_rrset_new(owner, KNOT_RRTYPE_RRSIG, copy->rclass,
-	                                     copy->ttl, mm);
-	if (!rrsig) {
-		knot_rrset_free(copy, NULL);
-		return NULL;
-	}
-
-	online_sign_ctx_t *ctx = knotd_mod_ctx(mod);
 	pthread_rwlock_rdlock(&ctx->signing_mutex);
 	int ret = knot_sign_rrset2(rrsig, copy, sign_ctx, mm);
+	if (ret == KNOT_EOK && ctx->sig_cache != NULL) {
+		knot_time_t expire = sig_cache_expire(mod, now);
+		if (expire != 0) {
+			sig_cache_put(ctx->sig_cache, owner, cover, expire, rrsig);
+		}
+	}
 	pthread_rwlock_unlock(&ctx->signing_mutex);
 	if (ret != KNOT_EOK) {
 		knot_rrset_free(copy, NULL);
@@ -513,6 +551,7 @@ static knotd_in_state_t pre_routine(knotd_in_state_t state, knot_pkt_t *pkt,
 		ctx->event_rollover = resch.next_rollover;
 
 		pthread_rwlock_wrlock(&ctx->signing_mutex);
+		sig_cache_flush(ctx->sig_cache);
 		knotd_mod_dnssec_unload_keyset(mod);
 		ret = knotd_mod_dnssec_load_keyset(mod, true);
 		if (ret != KNOT_EOK) {
@@ -605,6 +644,7 @@ static void online_sign_ctx_free(online_sign_ctx_t *ctx)
 	pthread_mutex_destroy(&ctx->event_mutex);
 	pthread_rwlock_destroy(&ctx->signing_mutex);
 
+	sig_cache_free(ctx->sig_cache);
 	free(ctx->nsec_force_types);
 	free(ctx);
 }
@@ -712,6 +752,15 @@ int online_sign_load(knotd_mod_t *mod)
 		return ret;
 	}
 
+	conf = knotd_conf_mod(mod, MOD_SIG_CACHE);
+	if (conf.single.integer > 0) {
+		ctx->sig_cache = sig_cache_new(conf.single.integer);
+		if (ctx->sig_cache == NULL) {
+			online_sign_ctx_free(ctx);
+			return KNOT_ENOMEM;
+		}
+	}
+
 	knotd_mod_ctx_set(mod, ctx);
 
 	knotd_mod_in_hook(mod, KNOTD_STAGE_ANSWER, pre_routine);
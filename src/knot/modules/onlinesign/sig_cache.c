@@ -0,0 +1,191 @@
+/*  Copyright (C) 2024 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "knot/modules/onlinesign/sig_cache.h"
+#include "libdnssec/random.h"
+#include "libknot/errcode.h"
+#include "contrib/openbsd/siphash.h"
+#include "contrib/spinlock.h"
+
+typedef struct {
+	uint64_t hash;
+	uint64_t generation;
+	knot_time_t expire;
+	uint16_t type;
+	uint32_t ttl;
+	knot_rdataset_t cover;
+	knot_rdataset_t rrsigs;
+	knot_dname_t owner[];
+} sig_entry_t;
+
+typedef struct {
+	knot_spin_t lock;
+	sig_entry_t *entry;
+} sig_slot_t;
+
+struct sig_cache {
+	SIPHASH_KEY key;
+	uint64_t generation;
+	size_t mask;
+	sig_slot_t slots[];
+};
+
+static uint64_t sig_hash(const sig_cache_t *cache, const knot_dname_t *owner,
+                         const knot_rrset_t *cover)
+{
+	SIPHASH_CTX ctx;
+	SipHash24_Init(&ctx, &cache->key);
+	SipHash24_Update(&ctx, owner, knot_dname_size(owner));
+	SipHash24_Update(&ctx, &cover->type, sizeof(cover->type));
+	SipHash24_Update(&ctx, &cover->ttl, sizeof(cover->ttl));
+	SipHash24_Update(&ctx, cover->rrs.rdata, cover->rrs.size);
+	return SipHash24_End(&ctx);
+}
+
+static bool sig_entry_match(const sig_entry_t *entry, const sig_cache_t *cache,
+                            uint64_t hash, const knot_dname_t *owner,
+                            const knot_rrset_t *cover, knot_time_t now)
+{
+	return entry->hash == hash &&
+	       entry->generation == cache->generation &&
+	       knot_time_cmp(now, entry->expire) < 0 &&
+	       entry->type == cover->type &&
+	       entry->ttl == cover->ttl &&
+	       knot_dname_is_equal(entry->owner, owner) &&
+	       knot_rdataset_eq(&entry->cover, &cover->rrs);
+}
+
+static void sig_entry_free(sig_entry_t *entry)
+{
+	if (entry != NULL) {
+		knot_rdataset_clear(&entry->cover, NULL);
+		knot_rdataset_clear(&entry->rrsigs, NULL);
+		free(entry);
+	}
+}
+
+sig_cache_t *sig_cache_new(size_t size)
+{
+	if (size == 0) {
+		return NULL;
+	}
+
+	size_t count = 1;
+	while (count < size) {
+		count <<= 1;
+	}
+
+	sig_cache_t *cache = calloc(1, sizeof(*cache) + count * sizeof(sig_slot_t));
+	if (cache == NULL) {
+		return NULL;
+	}
+
+	cache->key.k0 = dnssec_random_uint64_t();
+	cache->key.k1 = dnssec_random_uint64_t();
+	cache->mask = count - 1;
+	for (size_t i = 0; i < count; i++) {
+		knot_spin_init(&cache->slots[i].lock);
+	}
+
+	return cache;
+}
+
+void sig_cache_free(sig_cache_t *cache)
+{
+	if (cache == NULL) {
+		return;
+	}
+
+	for (size_t i = 0; i <= cache->mask; i++) {
+		knot_spin_destroy(&cache->slots[i].lock);
+		sig_entry_free(cache->slots[i].entry);
+	}
+
+	free(cache);
+}
+
+void sig_cache_flush(sig_cache_t *cache)
+{
+	if (cache != NULL) {
+		// Entries from older generations are ignored and replaced lazily.
+		cache->generation++;
+	}
+}
+
+bool sig_cache_get(sig_cache_t *cache, const knot_dname_t *owner,
+                   const knot_rrset_t *cover, knot_time_t now,
+                   knot_rrset_t *rrsig, knot_mm_t *mm)
+{
+	if (cache == NULL) {
+		return false;
+	}
+
+	uint64_t hash = sig_hash(cache, owner, cover);
+	sig_slot_t *slot = &cache->slots[hash & cache->mask];
+	bool found = false;
+
+	knot_spin_lock(&slot->lock);
+	const sig_entry_t *entry = slot->entry;
+	if (entry != NULL && sig_entry_match(entry, cache, hash, owner, cover, now)) {
+		found = (knot_rdataset_copy(&rrsig->rrs, &entry->rrsigs, mm) == KNOT_EOK);
+	}
+	knot_spin_unlock(&slot->lock);
+
+	return found;
+}
+
+void sig_cache_put(sig_cache_t *cache, const knot_dname_t *owner,
+                   const knot_rrset_t *cover, knot_time_t expire,
+                   const knot_rrset_t *rrsig)
+{
+	if (cache == NULL) {
+		return;
+	}
+
+	size_t owner_size = knot_dname_size(owner);
+	sig_entry_t *entry = malloc(sizeof(*entry) + owner_size);
+	if (entry == NULL) {
+		return;
+	}
+	if (knot_rdataset_copy(&entry->cover, &cover->rrs, NULL) != KNOT_EOK) {
+		free(entry);
+		return;
+	}
+	if (knot_rdataset_copy(&entry->rrsigs, &rrsig->rrs, NULL) != KNOT_EOK) {
+		knot_rdataset_clear(&entry->cover, NULL);
+		free(entry);
+		return;
+	}
+
+	entry->hash = sig_hash(cache, owner, cover);
+	entry->generation = cache->generation;
+	entry->expire = expire;
+	entry->type = cover->type;
+	entry->ttl = cover->ttl;
+	memcpy(entry->owner, owner, owner_size);
+
+	sig_slot_t *slot = &cache->slots[entry->hash & cache->mask];
+
+	knot_spin_lock(&slot->lock);
+	sig_entry_t *old = slot->entry;
+	slot->entry = entry;
+	knot_spin_unlock(&slot->lock);
+
+	sig_entry_free(old);
+}
@@ -0,0 +1,86 @@
+/*  Copyright (C) 2024 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "contrib/time.h"
+#include "libknot/mm_ctx.h"
+#include "libknot/rrset.h"
+
+/*!
+ * \brief Bounded cache of generated RRSIG records.
+ *
+ * Keyed on the signed owner, type, TTL, and a digest of the covered RDATA.
+ * The covered RDATA is stored and compared on lookup, so a digest collision
+ * can't return signatures of different data.
+ * Entries become invalid at their expiration time or once the cache is
+ * flushed (on a change of the signing keys).
+ *
+ * \note Lookups and insertions may be called concurrently, flushing must be
+ *       serialized with them by the caller.
+ */
+typedef struct sig_cache sig_cache_t;
+
+/*!
+ * \brief Create an empty signature cache.
+ *
+ * \param size  Requested number of entries (rounded up to a power of two).
+ *
+ * \return New cache or NULL on error.
+ */
+sig_cache_t *sig_cache_new(size_t size);
+
+/*!
+ * \brief Free the signature cache including all entries.
+ */
+void sig_cache_free(sig_cache_t *cache);
+
+/*!
+ * \brief Invalidate all entries.
+ */
+void sig_cache_flush(sig_cache_t *cache);
+
+/*!
+ * \brief Fill the RRSIG with cached signatures if available.
+ *
+ * \param cache  Signature cache.
+ * \param owner  Owner of the covered RRSet as signed (lowercased).
+ * \param cover  Covered RRSet.
+ * \param now    Current time.
+ * \param rrsig  Output RRSIG RRSet with empty RDATA.
+ * \param mm     Memory context for the RRSIG RDATA.
+ *
+ * \retval true if the signatures were found and copied.
+ */
+bool sig_cache_get(sig_cache_t *cache, const knot_dname_t *owner,
+                   const knot_rrset_t *cover, knot_time_t now,
+                   knot_rrset_t *rrsig, knot_mm_t *mm);
+
+/*!
+ * \brief Store generated signatures into the cache.
+ *
+ * \param cache   Signature cache.
+ * \param owner   Owner of the covered RRSet as signed (lowercased).
+ * \param cover   Covered RRSet.
+ * \param expire  Time when the entry becomes invalid.
+ * \param rrsig   Generated RRSIG RRSet.
+ */
+void sig_cache_put(sig_cache_t *cache, const knot_dname_t *owner,
+                   const knot_rrset_t *cover, knot_time_t expire,
+                   const knot_rrset_t *rrsig);
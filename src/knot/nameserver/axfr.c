@@ -39,6 +39,8 @@ struct axfr_proc {
 	trie_it_t *i;
 	zone_tree_it_t it;
 	unsigned cur_rrset;
+	axfr_cache_t *cache;
+	size_t cache_idx;
 };
 
 static int axfr_put_rrsets(knot_pkt_t *pkt, zone_node_t *node,
@@ -59,9 +61,10 @@ static int axfr_put_rrsets(knot_pkt_t *pkt, zone_node_t *node,
 			state->cur_rrset = i;
 			return ret;
 		}
-		if (pkt->size > KNOT_WIRE_PTR_MAX) {
+		if (pkt->size > KNOT_WIRE_PTR_MAX && pkt->compr.table == NULL) {
 			// optimization: once the XFR DNS message is > 16 KiB, compression
-			// is limited. Better wrap to next message.
+			// is limited. Better wrap to next message. With the compression
+			// table, the suffixes from the first 16 KiB remain usable.
 			state->cur_rrset = i + 1;
 			return KNOT_ESPACE;
 		}
@@ -97,6 +100,23 @@ static int axfr_process_node_tree(knot_pkt_t *pkt, const void *item,
 	return ret;
 }
 
+static int axfr_process_cached(knot_pkt_t *pkt, knotd_qdata_t *qdata,
+                               struct axfr_proc *axfr)
+{
+	/* Check if the zone wasn't expired during multi-message transfer. */
+	if (qdata->extra->contents == NULL) {
+		return KNOT_ENOZONE;
+	}
+
+	int ret = axfr_cache_get(axfr->cache, axfr->cache_idx, pkt);
+	if (ret != KNOT_EOK) {
+		return ret;
+	}
+
+	axfr->cache_idx += 1;
+	return (axfr->cache_idx < axfr_cache_count(axfr->cache)) ? KNOT_ESPACE : KNOT_EOK;
+}
+
 static void axfr_query_cleanup(knotd_qdata_t *qdata)
 {
 	struct axfr_proc *axfr = (struct axfr_proc *)qdata->extra->ext;
@@ -184,6 +204,11 @@ static int axfr_query_init(knotd_qdata_t *qdata)
 	/* No zone changes during multipacket answer (unlocked in axfr_answer_cleanup) */
 	rcu_read_lock();
 
+	/* Use the pre-built messages, the first transfer builds them. */
+	if (axfr_cache_prepare(contents->axfr_cache, contents) == KNOT_EOK) {
+		axfr->cache = contents->axfr_cache;
+	}
+
 	return KNOT_EOK;
 }
 
@@ -229,8 +254,19 @@ knot_layer_state_t axfr_process_query(knot_pkt_t *pkt, knotd_qdata_t *qdata)
 		return KNOT_STATE_FAIL;
 	}
 
+	/* Copy the pre-built messages if they fit into the response. */
+	axfr = qdata->extra->ext;
+	if (axfr->cache != NULL && axfr->cache_idx == 0 &&
+	    !axfr_cache_fits(axfr->cache, pkt)) {
+		axfr->cache = NULL;
+	}
+
 	/* Answer current packet (or continue). */
-	ret = xfr_process_list(pkt, &axfr_process_node_tree, qdata);
+	if (axfr->cache != NULL) {
+		ret = axfr_process_cached(pkt, qdata, axfr);
+	} else {
+		ret = xfr_process_list(pkt, &axfr_process_node_tree, qdata);
+	}
 	switch (ret) {
 	case KNOT_ESPACE: /* Couldn't write more, send packet and continue. */
 		return KNOT_STATE_PRODUCE; /* Check for more. */
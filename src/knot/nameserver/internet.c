@@ -708,6 +708,22 @@ static knot_layer_state_t answer_query(knot_pkt_t *pkt, knotd_qdata_t *qdata)
 	return KNOT_STATE_DONE;
 }
 
+/*! \brief Check if the answer may be served from or stored into the answer cache. */
+static bool answer_cache_usable(knotd_qdata_t *qdata)
+{
+	if (qdata->extra->contents->answer_cache == NULL ||
+	    knot_pkt_has_tsig(qdata->query) || conf()->cache.srv_ans_rotate) {
+		return false;
+	}
+
+	/* Query modules may alter or inspect the synthesized sections. */
+	if (qdata->extra->zone->query_plan != NULL) {
+		return false;
+	}
+	struct query_plan *plan = conf()->query_plan;
+	return plan == NULL || EMPTY_LIST(plan->stage[KNOTD_STAGE_END]);
+}
+
 knot_layer_state_t internet_process_query(knot_pkt_t *pkt, knotd_qdata_t *qdata)
 {
 	if (pkt == NULL || qdata == NULL) {
@@ -734,5 +750,21 @@ knot_layer_state_t internet_process_query(knot_pkt_t *pkt, knotd_qdata_t *qdata)
 	/* Get answer to QNAME. */
 	qdata->name = knot_pkt_qname(qdata->query);
 
-	return answer_query(pkt, qdata);
+	if (!answer_cache_usable(qdata)) {
+		return answer_query(pkt, qdata);
+	}
+
+	answer_cache_t *cache = qdata->extra->contents->answer_cache;
+	if (answer_cache_get(cache, qdata->query, pkt, &qdata->rcode, &qdata->rcode_ede)) {
+		knot_wire_set_rcode(pkt->wire, qdata->rcode);
+		knot_pkt_begin(pkt, KNOT_ADDITIONAL);
+		return KNOT_STATE_DONE;
+	}
+
+	knot_layer_state_t state = answer_query(pkt, qdata);
+	if (state == KNOT_STATE_DONE && !knot_wire_get_tc(pkt->wire)) {
+		answer_cache_put(cache, qdata->query, pkt, qdata->rcode, qdata->rcode_ede);
+	}
+
+	return state;
 }
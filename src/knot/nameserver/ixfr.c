@@ -53,10 +53,10 @@ static int ixfr_put_chg_part(knot_pkt_t *pkt, struct ixfr_proc *ixfr,
 
 	if (!knot_rrset_empty(&ixfr->cur_rr)) {
 		IXFR_SAFE_PUT(pkt, &ixfr->cur_rr);
-		journal_read_clear_rrset(&ixfr->cur_rr);
+		knot_rrset_init_empty(&ixfr->cur_rr);
 	}
 
-	while (journal_read_rrset(read, &ixfr->cur_rr, true)) {
+	while (journal_read_rrset_view(read, &ixfr->cur_rr, true)) {
 		if (ixfr->cur_rr.type == KNOT_RRTYPE_SOA) {
 			ixfr->in_remove_section = !ixfr->in_remove_section;
 
@@ -69,14 +69,15 @@ static int ixfr_put_chg_part(knot_pkt_t *pkt, struct ixfr_proc *ixfr,
 			}
 		}
 
-		if (pkt->size > KNOT_WIRE_PTR_MAX) {
+		if (pkt->size > KNOT_WIRE_PTR_MAX && pkt->compr.table == NULL) {
 			// optimization: once the XFR DNS message is > 16 KiB, compression
-			// is limited. Better wrap to next message.
+			// is limited. Better wrap to next message. With the compression
+			// table, the suffixes from the first 16 KiB remain usable.
 			return KNOT_ESPACE;
 		}
 
 		IXFR_SAFE_PUT(pkt, &ixfr->cur_rr);
-		journal_read_clear_rrset(&ixfr->cur_rr);
+		knot_rrset_init_empty(&ixfr->cur_rr);
 	}
 
 	return journal_read_get_error(read, KNOT_EOK);
@@ -153,7 +154,7 @@ static void ixfr_answer_cleanup(knotd_qdata_t *qdata)
 {
 	struct ixfr_proc *ixfr = (struct ixfr_proc *)qdata->extra->ext;
 
-	knot_rrset_clear(&ixfr->cur_rr, NULL);
+	// The current RRSet is only a view of the journal, nothing to free.
 	ptrlist_free(&ixfr->proc.nodes, qdata->mm);
 	journal_read_end(ixfr->journal_ctx);
 	mm_free(qdata->mm, qdata->extra->ext);
@@ -399,7 +399,8 @@ knotd_conf_t knotd_conf_env(knotd_mod_t *mod, knotd_conf_env_t env)
 		out.single.integer = config->cache.srv_udp_threads;
 		break;
 	case KNOTD_CONF_ENV_WORKERS_TCP:
-		out.single.integer = config->cache.srv_tcp_threads;
+		out.single.integer = config->cache.srv_tcp_threads +
+		                     config->cache.srv_xfr_threads;
 		break;
 	case KNOTD_CONF_ENV_WORKERS_XDP:
 		out.single.integer = config->cache.srv_xdp_threads;
@@ -33,6 +33,9 @@ int xfr_process_list(knot_pkt_t *pkt, xfr_put_cb put, knotd_qdata_t *qdata)
 	}
 	knot_rrset_t soa_rr = node_rrset(contents->apex, KNOT_RRTYPE_SOA);
 
+	/* Reuse any suffix in the message, fallback to the simple compression. */
+	(void)knot_pkt_init_compr_table(pkt);
+
 	/* Prepend SOA on first packet. */
 	if (xfer->stats.messages == 0) {
 		ret = knot_pkt_put(pkt, 0, &soa_rr, KNOT_PF_NOTRUNC);
@@ -0,0 +1,1154 @@
+/*  Copyright (C) 2025 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <assert.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <urcu.h>
+
+#include "knot/query/async-requestor.h"
+#include "knot/common/fdset.h"
+#include "knot/common/unreachable.h"
+#include "contrib/conn_pool.h"
+#include "contrib/net.h"
+#include "contrib/macros.h"
+#include "contrib/sockaddr.h"
+#include "contrib/time.h"
+#include "libknot/errcode.h"
+#include "libknot/wire.h"
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+#define CONN_BATCH 32 // queries written by one sendmsg() on a shared connection
+
+enum {
+	PHASE_PROCESS = 0, // processing by the layer
+	PHASE_SEND,        // sending the query
+	PHASE_RECV,        // receiving a response
+};
+
+/*! \brief TCP connection shared by the pipelined jobs to the same remote. */
+typedef struct areq_conn {
+	node_t n;
+	struct sockaddr_storage remote, source;
+	int fd;
+	int idx;                   // position in the watched set, -1 if not watched
+	int timeout_ms;            // timeout of the job which opened the connection
+	uint64_t deadline;         // no progress until then closes the connection
+	bool connecting;
+	bool reused;               // taken from the connection pool
+	bool received;             // some response received
+	bool broken;               // a partially sent job was cancelled
+
+	list_t sending;            // jobs with queries to be sent
+	list_t waiting;            // jobs waiting for a response
+	knot_areq_job_t *tx_job;   // partially sent job
+	size_t tx_pos;             // sent part of tx_job including the length prefix
+	uint8_t rx_hdr[4];         // length and message ID of the received message
+	size_t rx_pos;             // received part of the message including the prefix
+	knot_areq_job_t *rx_job;   // job the received message belongs to, NULL to discard
+} areq_conn_t;
+
+/*! \brief Watched socket ready for processing. */
+typedef struct {
+	knot_areq_job_t *job;
+	areq_conn_t *conn;
+} areq_ready_t;
+
+struct knot_areq {
+	pthread_t thread;
+	pthread_mutex_t lock;
+	pthread_cond_t cancelled;  // broadcasted when a cancellation is finished
+
+	list_t queue;              // submitted jobs not taken by the thread yet
+	const void *cancel_owner;  // owner being cancelled
+	bool cancel;               // cancellation requested
+	bool stop;
+	int pipe[2];               // written to wake up the thread
+
+	/* Used only by the thread. */
+	fdset_t set;               // ctx is the shared connection, ctx2 the job otherwise
+	list_t active;             // jobs not queued on a shared connection
+	list_t conns;
+	areq_ready_t *ready;
+	unsigned ready_size;
+	uint64_t next_deadline;    // the earliest deadline of the active jobs (or sooner)
+};
+
+static uint64_t now_ms(void)
+{
+	struct timespec now = time_now();
+	return (uint64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+static bool use_tcp(const knot_request_t *request)
+{
+	return !(request->flags & KNOT_REQUEST_UDP);
+}
+
+static void wake_up(knot_areq_t *areq)
+{
+	uint8_t byte = 0;
+	if (write(areq->pipe[1], &byte, sizeof(byte)) < 0) {
+		// The pipe is full, thus the thread is going to be woken up anyway.
+	}
+}
+
+static uint64_t deadline_in(knot_areq_t *areq, int timeout_ms)
+{
+	if (timeout_ms < 0) {
+		return 0;
+	}
+
+	uint64_t deadline = now_ms() + timeout_ms;
+	if (areq->next_deadline == 0 || deadline < areq->next_deadline) {
+		areq->next_deadline = deadline;
+	}
+	return deadline;
+}
+
+static void set_deadline(knot_areq_t *areq, knot_areq_job_t *job)
+{
+	job->deadline = deadline_in(areq, job->timeout_ms);
+}
+
+static bool is_pipelined(const knot_areq_job_t *job)
+{
+	return job->pipeline && use_tcp(job->request);
+}
+
+static void fd_unwatch(knot_areq_t *areq, int *idx_ptr)
+{
+	if (*idx_ptr < 0) {
+		return;
+	}
+
+	/* The watched socket is a duplicate, the original socket is kept. */
+	unsigned idx = *idx_ptr;
+	(void)fdset_remove(&areq->set, idx);
+	*idx_ptr = -1;
+
+	/* The last watched socket has been moved in place of the removed one. */
+	if (idx < fdset_get_length(&areq->set)) {
+		areq_conn_t *conn = areq->set.ctx[idx];
+		knot_areq_job_t *job = *fdset_ctx2(&areq->set, idx);
+		if (conn != NULL) {
+			conn->idx = idx;
+		} else if (job != NULL) {
+			job->idx = idx;
+		}
+	}
+}
+
+static int fd_watch(knot_areq_t *areq, int *idx_ptr, int orig_fd, fdset_event_t events,
+                    areq_conn_t *conn, knot_areq_job_t *job)
+{
+	if (*idx_ptr >= 0) {
+		return fdset_set_events(&areq->set, *idx_ptr, events);
+	}
+
+	int fd = dup(orig_fd);
+	if (fd < 0) {
+		return knot_map_errno();
+	}
+	int idx = fdset_add(&areq->set, fd, events, conn);
+	if (idx < 0) {
+		close(fd);
+		return idx;
+	}
+	*fdset_ctx2(&areq->set, idx) = job;
+	*idx_ptr = idx;
+
+	return KNOT_EOK;
+}
+
+static void unwatch(knot_areq_t *areq, knot_areq_job_t *job)
+{
+	fd_unwatch(areq, &job->idx);
+}
+
+static int watch(knot_areq_t *areq, knot_areq_job_t *job, fdset_event_t events)
+{
+	return fd_watch(areq, &job->idx, job->request->fd, events, NULL, job);
+}
+
+static int job_connect(knot_areq_t *areq, knot_areq_job_t *job)
+{
+	knot_request_t *request = job->request;
+	bool tcp = use_tcp(request);
+
+	if (tcp) {
+		request->fd = (int)conn_pool_get(global_conn_pool, &request->source,
+		                                 &request->remote);
+		if (request->fd >= 0) {
+			job->requestor.layer.flags |= KNOT_REQUESTOR_REUSED;
+			return watch(areq, job, FDSET_POLLOUT);
+		}
+
+		if (knot_unreachable_is(global_unreachables, &request->remote,
+		                        &request->source)) {
+			return KNOT_EUNREACH;
+		}
+	}
+
+	request->fd = net_connected_socket(tcp ? SOCK_STREAM : SOCK_DGRAM,
+	                                   &request->remote, &request->source, false);
+	if (request->fd < 0) {
+		return request->fd;
+	}
+	job->connecting = tcp;
+
+	return watch(areq, job, FDSET_POLLOUT);
+}
+
+static int job_send(knot_areq_t *areq, knot_areq_job_t *job)
+{
+	knot_request_t *request = job->request;
+
+	if (request->fd < 0) {
+		int ret = job_connect(areq, job);
+		if (ret != KNOT_EOK) {
+			return ret;
+		}
+	}
+	if (job->connecting) {
+		return KNOT_EAGAIN;
+	}
+
+	uint8_t prefix[sizeof(uint16_t)];
+	struct iovec iov[2];
+	int iovcnt = 0;
+	if (use_tcp(request)) {
+		knot_wire_write_u16(prefix, request->query->size);
+		iov[iovcnt++] = (struct iovec){ prefix, sizeof(prefix) };
+	}
+	iov[iovcnt++] = (struct iovec){ request->query->wire, request->query->size };
+
+	size_t skip = job->io_pos, total = 0;
+	for (int i = 0; i < iovcnt; i++) {
+		total += iov[i].iov_len;
+		size_t cut = MIN(skip, iov[i].iov_len);
+		iov[i].iov_base = (uint8_t *)iov[i].iov_base + cut;
+		iov[i].iov_len -= cut;
+		skip -= cut;
+	}
+
+	struct msghdr msg = { .msg_iov = iov, .msg_iovlen = iovcnt };
+	ssize_t sent = sendmsg(request->fd, &msg, MSG_NOSIGNAL);
+	if (sent < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+		return knot_map_errno();
+	}
+
+	job->io_pos += MAX(sent, 0);
+	if (job->io_pos < total) {
+		int ret = watch(areq, job, FDSET_POLLOUT);
+		return (ret == KNOT_EOK) ? KNOT_EAGAIN : ret;
+	}
+
+	/* Query sent, wait for a response. */
+	job->phase = PHASE_RECV;
+	job->io_pos = 0;
+	set_deadline(areq, job);
+
+	int ret = watch(areq, job, FDSET_POLLIN);
+	return (ret == KNOT_EOK) ? KNOT_EAGAIN : ret;
+}
+
+/*! \brief Receive the requested length, return KNOT_EOK when complete. */
+static int recv_part(int fd, uint8_t *buf, size_t len, size_t *pos)
+{
+	while (*pos < len) {
+		ssize_t ret = recv(fd, buf + *pos, len - *pos, 0);
+		if (ret == 0) {
+			return KNOT_ECONN;
+		} else if (ret < 0) {
+			if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+				return KNOT_EAGAIN;
+			}
+			return knot_map_errno();
+		}
+		*pos += ret;
+	}
+
+	return KNOT_EOK;
+}
+
+static int job_recv(knot_areq_t *areq, knot_areq_job_t *job)
+{
+	knot_request_t *request = job->request;
+	knot_pkt_t *resp = request->resp;
+
+	if (job->io_pos == 0) {
+		knot_pkt_clear(resp);
+	}
+
+	if (use_tcp(request)) {
+		size_t pos = MIN(job->io_pos, sizeof(job->len));
+		int ret = recv_part(request->fd, job->len, sizeof(job->len), &pos);
+		job->io_pos = MAX(job->io_pos, pos);
+		if (ret != KNOT_EOK) {
+			return ret;
+		}
+
+		size_t msg_len = knot_wire_read_u16(job->len);
+		if (msg_len > resp->max_size) {
+			return KNOT_ESPACE;
+		}
+		pos = job->io_pos - sizeof(job->len);
+		ret = recv_part(request->fd, resp->wire, msg_len, &pos);
+		job->io_pos = sizeof(job->len) + pos;
+		if (ret != KNOT_EOK) {
+			return ret;
+		}
+		resp->size = msg_len;
+	} else {
+		ssize_t ret = recv(request->fd, resp->wire, resp->max_size, 0);
+		if (ret == 0) {
+			return KNOT_ECONN;
+		} else if (ret < 0) {
+			if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+				return KNOT_EAGAIN;
+			}
+			return knot_map_errno();
+		}
+		resp->size = ret;
+	}
+
+	job->io_pos = 0;
+	job->phase = PHASE_PROCESS;
+	set_deadline(areq, job);
+
+	return KNOT_EOK;
+}
+
+static areq_conn_t *conn_find(knot_areq_t *areq, const knot_request_t *request)
+{
+	areq_conn_t *conn;
+	WALK_LIST(conn, areq->conns) {
+		if (!conn->broken &&
+		    sockaddr_cmp(&conn->remote, &request->remote, false) == 0 &&
+		    sockaddr_cmp(&conn->source, &request->source, false) == 0) {
+			return conn;
+		}
+	}
+	return NULL;
+}
+
+static int conn_connect(areq_conn_t *conn, bool pooled)
+{
+	if (pooled) {
+		conn->fd = (int)conn_pool_get(global_conn_pool, &conn->source, &conn->remote);
+		if (conn->fd >= 0) {
+			conn->reused = true;
+			return KNOT_EOK;
+		}
+	}
+	conn->reused = false;
+
+	if (knot_unreachable_is(global_unreachables, &conn->remote, &conn->source)) {
+		return KNOT_EUNREACH;
+	}
+
+	conn->fd = net_connected_socket(SOCK_STREAM, &conn->remote, &conn->source, false);
+	if (conn->fd < 0) {
+		return conn->fd;
+	}
+	conn->connecting = true;
+
+	return KNOT_EOK;
+}
+
+static int conn_new(knot_areq_t *areq, knot_areq_job_t *job, areq_conn_t **out)
+{
+	areq_conn_t *conn = calloc(1, sizeof(*conn));
+	if (conn == NULL) {
+		return KNOT_ENOMEM;
+	}
+
+	conn->remote = job->request->remote;
+	conn->source = job->request->source;
+	conn->idx = -1;
+	conn->timeout_ms = job->timeout_ms;
+	init_list(&conn->sending);
+	init_list(&conn->waiting);
+
+	int ret = conn_connect(conn, true);
+	if (ret != KNOT_EOK) {
+		free(conn);
+		return ret;
+	}
+	conn->deadline = deadline_in(areq, conn->timeout_ms);
+	add_tail(&areq->conns, &conn->n);
+
+	*out = conn;
+	return KNOT_EOK;
+}
+
+/*!
+ * \brief Watch the connection for writing or, if any response is expected,
+ *        for reading. Queued queries are also written when reading.
+ */
+static int conn_watch(knot_areq_t *areq, areq_conn_t *conn)
+{
+	fdset_event_t events = FDSET_POLLOUT;
+	if (!conn->connecting && (!EMPTY_LIST(conn->waiting) || conn->rx_pos > 0)) {
+		events = FDSET_POLLIN;
+	}
+
+	return fd_watch(areq, &conn->idx, conn->fd, events, conn, NULL);
+}
+
+static void conn_close(knot_areq_t *areq, areq_conn_t *conn, bool keep)
+{
+	assert(EMPTY_LIST(conn->sending) && EMPTY_LIST(conn->waiting));
+
+	fd_unwatch(areq, &conn->idx);
+	if (keep && !conn->connecting && !conn->broken && conn->rx_pos == 0) {
+		conn->fd = (int)conn_pool_put(global_conn_pool, &conn->source,
+		                              &conn->remote, conn->fd);
+	}
+	if (conn->fd >= 0) {
+		close(conn->fd);
+	}
+	rem_node(&conn->n);
+	free(conn);
+}
+
+/*! \brief Queue the query of the pipelined job on the shared connection. */
+static int conn_enqueue(knot_areq_t *areq, knot_areq_job_t *job)
+{
+	areq_conn_t *conn = conn_find(areq, job->request);
+	if (conn == NULL) {
+		int ret = conn_new(areq, job, &conn);
+		if (ret != KNOT_EOK) {
+			return ret;
+		}
+	}
+	if (conn->reused || !EMPTY_LIST(conn->sending) || !EMPTY_LIST(conn->waiting)) {
+		job->requestor.layer.flags |= KNOT_REQUESTOR_REUSED;
+	}
+
+	knot_wire_write_u16(job->len, job->request->query->size);
+	rem_node(&job->n);
+	add_tail(&conn->sending, &job->n);
+	job->conn = conn;
+
+	int ret = conn_watch(areq, conn);
+	if (ret != KNOT_EOK) {
+		rem_node(&job->n);
+		add_tail(&areq->active, &job->n);
+		job->conn = NULL;
+		if (EMPTY_LIST(conn->sending) && EMPTY_LIST(conn->waiting)) {
+			conn_close(areq, conn, false);
+		}
+		return ret;
+	}
+
+	return KNOT_EAGAIN;
+}
+
+/*! \brief Wait for another response to the pipelined job. */
+static int conn_expect(knot_areq_t *areq, knot_areq_job_t *job)
+{
+	areq_conn_t *conn = conn_find(areq, job->request);
+	if (conn == NULL) {
+		return KNOT_ECONN;
+	}
+
+	rem_node(&job->n);
+	add_tail(&conn->waiting, &job->n);
+	job->conn = conn;
+
+	return KNOT_EAGAIN;
+}
+
+static void conn_detach(areq_conn_t *conn, knot_areq_job_t *job)
+{
+	if (conn->rx_job == job) {
+		conn->rx_job = NULL; // the rest of the response is discarded
+	}
+	if (conn->tx_job == job) {
+		conn->tx_job = NULL;
+		conn->broken = true; // the rest of the query can't be sent
+	}
+	job->conn = NULL;
+}
+
+/*!
+ * \brief Continue the processing until it waits for the socket or finishes.
+ *
+ * \retval KNOT_EAGAIN  Waiting for the socket.
+ * \return Otherwise the result of the processing.
+ */
+static int job_io(knot_areq_t *areq, knot_areq_job_t *job)
+{
+	knot_requestor_t *req = &job->requestor;
+	knot_request_t *request = job->request;
+
+	while (knot_requestor_active(req)) {
+		int ret = KNOT_EOK;
+		switch (job->phase) {
+		case PHASE_SEND:
+			ret = is_pipelined(job) ? conn_enqueue(areq, job) : job_send(areq, job);
+			if (ret != KNOT_EOK && ret != KNOT_EAGAIN) {
+				req->layer.flags |= KNOT_REQUESTOR_IOFAIL;
+			}
+			break;
+		case PHASE_RECV:
+			if (is_pipelined(job)) {
+				ret = conn_expect(areq, job);
+				break;
+			}
+			ret = job_recv(areq, job);
+			if (ret == KNOT_EOK) {
+				ret = knot_requestor_consume(req, request);
+			} else if (ret != KNOT_EAGAIN) {
+				req->layer.flags |= KNOT_REQUESTOR_IOFAIL;
+			}
+			break;
+		default:
+			switch (req->layer.state) {
+			case KNOT_STATE_PRODUCE:
+				ret = knot_requestor_produce(req, request);
+				if (ret == KNOT_EOK && req->layer.state == KNOT_STATE_CONSUME) {
+					job->phase = PHASE_SEND;
+					job->io_pos = 0;
+				}
+				break;
+			case KNOT_STATE_CONSUME:
+				job->phase = PHASE_RECV;
+				break;
+			default: // KNOT_STATE_RESET
+				ret = knot_requestor_reset(req, request);
+				if (request->fd < 0) {
+					unwatch(areq, job);
+					job->connecting = false;
+				}
+			}
+		}
+		if (ret != KNOT_EOK) {
+			return ret;
+		}
+	}
+
+	return KNOT_EOK;
+}
+
+static void job_finish(knot_areq_t *areq, knot_areq_job_t *job, int ret)
+{
+	unwatch(areq, job);
+	rem_node(&job->n);
+	if (job->conn != NULL) {
+		conn_detach(job->conn, job);
+	}
+
+	ret = knot_requestor_finish(&job->requestor, job->request, ret);
+	job->done(job, ret);
+}
+
+static void job_run(knot_areq_t *areq, knot_areq_job_t *job)
+{
+	int ret = job_io(areq, job);
+	if (ret != KNOT_EAGAIN) {
+		job_finish(areq, job, ret);
+	}
+}
+
+static void job_start(knot_areq_t *areq, knot_areq_job_t *job)
+{
+	add_tail(&areq->active, &job->n);
+	job->requestor.layer.tsig = &job->request->tsig;
+	set_deadline(areq, job);
+	job_run(areq, job);
+}
+
+static int connect_result(int fd)
+{
+	int err = 0;
+	socklen_t err_len = sizeof(err);
+	if (getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &err_len) != 0) {
+		err = errno;
+	}
+
+	return (err == 0) ? KNOT_EOK : knot_map_errno_code(err);
+}
+
+static void job_event(knot_areq_t *areq, knot_areq_job_t *job)
+{
+	if (job->connecting) {
+		int ret = connect_result(job->request->fd);
+		if (ret != KNOT_EOK) {
+			job->requestor.layer.flags |= KNOT_REQUESTOR_IOFAIL;
+			job_finish(areq, job, ret);
+			return;
+		}
+		job->connecting = false;
+	}
+
+	job_run(areq, job);
+}
+
+static void conn_abort(knot_areq_t *areq, areq_conn_t *conn, int ret)
+{
+	list_t *queues[] = { &conn->sending, &conn->waiting };
+	for (int i = 0; i < 2; i++) {
+		knot_areq_job_t *job, *nxt;
+		WALK_LIST_DELSAFE(job, nxt, *queues[i]) {
+			job->requestor.layer.flags |= KNOT_REQUESTOR_IOFAIL;
+			job_finish(areq, job, ret);
+		}
+	}
+
+	conn_close(areq, conn, false);
+}
+
+/*! \brief Resend the queries over a new connection if the pooled one was stale. */
+static int conn_reconnect(knot_areq_t *areq, areq_conn_t *conn)
+{
+	fd_unwatch(areq, &conn->idx);
+	close(conn->fd);
+	conn->fd = -1;
+
+	/* The sent queries go first, in the original order. */
+	while (!EMPTY_LIST(conn->waiting)) {
+		knot_areq_job_t *job = TAIL(conn->waiting);
+		rem_node(&job->n);
+		add_head(&conn->sending, &job->n);
+	}
+	conn->tx_job = NULL;
+	conn->tx_pos = 0;
+	conn->rx_job = NULL;
+	conn->rx_pos = 0;
+
+	int ret = conn_connect(conn, false);
+	if (ret != KNOT_EOK) {
+		return ret;
+	}
+	conn->deadline = deadline_in(areq, conn->timeout_ms);
+
+	return conn_watch(areq, conn);
+}
+
+static bool conn_id_used(areq_conn_t *conn, const knot_areq_job_t *job,
+                         knot_areq_job_t **batch, int count)
+{
+	uint16_t id = knot_wire_get_id(job->request->query->wire);
+	for (int i = 0; i < count; i++) {
+		if (knot_wire_get_id(batch[i]->request->query->wire) == id) {
+			return true;
+		}
+	}
+
+	knot_areq_job_t *other;
+	WALK_LIST(other, conn->waiting) {
+		if (knot_wire_get_id(other->request->query->wire) == id) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/*!
+ * \brief Write the queued queries, those with a message ID waiting for
+ *        a response are postponed.
+ */
+static int conn_flush(knot_areq_t *areq, areq_conn_t *conn)
+{
+	while (!conn->broken && !EMPTY_LIST(conn->sending)) {
+		knot_areq_job_t *batch[CONN_BATCH];
+		int count = 0;
+		if (conn->tx_job != NULL) {
+			batch[count++] = conn->tx_job;
+		}
+		knot_areq_job_t *job;
+		WALK_LIST(job, conn->sending) {
+			if (count == CONN_BATCH) {
+				break;
+			}
+			if (job != conn->tx_job && !conn_id_used(conn, job, batch, count)) {
+				batch[count++] = job;
+			}
+		}
+		if (count == 0) {
+			return KNOT_EOK;
+		}
+
+		struct iovec iov[2 * CONN_BATCH];
+		size_t skip = conn->tx_pos;
+		for (int i = 0; i < count; i++) {
+			knot_pkt_t *query = batch[i]->request->query;
+			iov[2 * i] = (struct iovec){ batch[i]->len, sizeof(batch[i]->len) };
+			iov[2 * i + 1] = (struct iovec){ query->wire, query->size };
+		}
+		for (int i = 0; i < 2 && skip > 0; i++) {
+			size_t cut = MIN(skip, iov[i].iov_len);
+			iov[i].iov_base = (uint8_t *)iov[i].iov_base + cut;
+			iov[i].iov_len -= cut;
+			skip -= cut;
+		}
+
+		struct msghdr msg = { .msg_iov = iov, .msg_iovlen = 2 * count };
+		ssize_t sent = sendmsg(conn->fd, &msg, MSG_NOSIGNAL);
+		if (sent < 0) {
+			if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+				return KNOT_EOK;
+			}
+			return knot_map_errno();
+		}
+		conn->deadline = deadline_in(areq, conn->timeout_ms);
+
+		size_t done = conn->tx_pos + sent;
+		conn->tx_job = NULL;
+		conn->tx_pos = 0;
+		for (int i = 0; i < count; i++) {
+			size_t len = sizeof(batch[i]->len) + batch[i]->request->query->size;
+			if (done < len) {
+				if (done > 0) {
+					conn->tx_job = batch[i];
+					conn->tx_pos = done;
+				}
+				return KNOT_EOK;
+			}
+			done -= len;
+			rem_node(&batch[i]->n);
+			add_tail(&conn->waiting, &batch[i]->n);
+		}
+	}
+
+	return KNOT_EOK;
+}
+
+static knot_areq_job_t *conn_match(areq_conn_t *conn, uint16_t id)
+{
+	knot_areq_job_t *job;
+	WALK_LIST(job, conn->waiting) {
+		if (knot_wire_get_id(job->request->query->wire) == id) {
+			return job;
+		}
+	}
+	return NULL;
+}
+
+static int recv_discard(int fd, size_t len, size_t *pos)
+{
+	uint8_t buf[1024];
+	while (*pos < len) {
+		size_t part = 0;
+		int ret = recv_part(fd, buf, MIN(sizeof(buf), len - *pos), &part);
+		*pos += part;
+		if (ret != KNOT_EOK) {
+			return ret;
+		}
+	}
+
+	return KNOT_EOK;
+}
+
+static void conn_deliver(knot_areq_t *areq, knot_areq_job_t *job)
+{
+	rem_node(&job->n);
+	add_tail(&areq->active, &job->n);
+	job->conn = NULL;
+	job->phase = PHASE_PROCESS;
+
+	int ret = knot_requestor_consume(&job->requestor, job->request);
+	if (ret == KNOT_EOK) {
+		ret = job_io(areq, job);
+	}
+	if (ret != KNOT_EAGAIN) {
+		job_finish(areq, job, ret);
+	}
+}
+
+/*! \brief Receive the responses and pass them to the jobs. */
+static int conn_recv(knot_areq_t *areq, areq_conn_t *conn)
+{
+	while (!EMPTY_LIST(conn->waiting) || conn->rx_pos > 0) {
+		if (conn->rx_pos < sizeof(conn->rx_hdr)) {
+			int ret = recv_part(conn->fd, conn->rx_hdr, sizeof(conn->rx_hdr),
+			                    &conn->rx_pos);
+			if (ret != KNOT_EOK) {
+				return ret;
+			}
+
+			size_t msg_len = knot_wire_read_u16(conn->rx_hdr);
+			if (msg_len < KNOT_WIRE_HEADER_SIZE) {
+				return KNOT_EMALF;
+			}
+			knot_areq_job_t *job = conn_match(conn, knot_wire_get_id(conn->rx_hdr + 2));
+			if (job != NULL && msg_len > job->request->resp->max_size) {
+				job_finish(areq, job, KNOT_ESPACE);
+			} else if (job != NULL) {
+				knot_pkt_clear(job->request->resp);
+				memcpy(job->request->resp->wire, conn->rx_hdr + 2, sizeof(uint16_t));
+				conn->rx_job = job;
+			}
+		}
+
+		size_t msg_len = knot_wire_read_u16(conn->rx_hdr);
+		size_t pos = conn->rx_pos - sizeof(uint16_t);
+		int ret = (conn->rx_job != NULL) ?
+		          recv_part(conn->fd, conn->rx_job->request->resp->wire, msg_len, &pos) :
+		          recv_discard(conn->fd, msg_len, &pos);
+		conn->rx_pos = sizeof(uint16_t) + pos;
+		if (ret != KNOT_EOK) {
+			return ret;
+		}
+
+		conn->rx_pos = 0;
+		conn->received = true;
+		conn->deadline = deadline_in(areq, conn->timeout_ms);
+
+		knot_areq_job_t *job = conn->rx_job;
+		if (job != NULL) {
+			conn->rx_job = NULL;
+			job->request->resp->size = msg_len;
+			conn_deliver(areq, job);
+		}
+	}
+
+	return KNOT_EOK;
+}
+
+/*! \brief Watch the connection as needed, or close it if broken or unused. */
+static void conn_update(knot_areq_t *areq, areq_conn_t *conn)
+{
+	if (conn->broken) {
+		conn_abort(areq, conn, KNOT_ECONN);
+	} else if (EMPTY_LIST(conn->sending) && EMPTY_LIST(conn->waiting)) {
+		conn_close(areq, conn, true);
+	} else {
+		int ret = conn_watch(areq, conn);
+		if (ret != KNOT_EOK) {
+			conn_abort(areq, conn, ret);
+		}
+	}
+}
+
+static void conn_event(knot_areq_t *areq, areq_conn_t *conn)
+{
+	int ret = KNOT_EOK;
+	if (conn->connecting) {
+		ret = connect_result(conn->fd);
+		if (ret != KNOT_EOK) {
+			conn_abort(areq, conn, ret);
+			return;
+		}
+		conn->connecting = false;
+	}
+
+	ret = conn_recv(areq, conn);
+	if (ret == KNOT_EOK || ret == KNOT_EAGAIN) {
+		ret = conn_flush(areq, conn);
+	}
+	if (ret != KNOT_EOK && ret != KNOT_EAGAIN) {
+		/* The pooled connection may have been closed by the remote meanwhile. */
+		if (conn->reused && !conn->received && !conn->broken &&
+		    conn_reconnect(areq, conn) == KNOT_EOK) {
+			return;
+		}
+		conn_abort(areq, conn, ret);
+		return;
+	}
+
+	conn_update(areq, conn);
+}
+
+static void check_timeouts(knot_areq_t *areq)
+{
+	uint64_t now = now_ms();
+	if (areq->next_deadline == 0 || now < areq->next_deadline) {
+		return;
+	}
+
+	areq->next_deadline = 0;
+	knot_areq_job_t *job, *nxt;
+	WALK_LIST_DELSAFE(job, nxt, areq->active) {
+		if (job->deadline == 0) {
+			continue;
+		} else if (job->deadline > now) {
+			if (areq->next_deadline == 0 || job->deadline < areq->next_deadline) {
+				areq->next_deadline = job->deadline;
+			}
+			continue;
+		}
+
+		knot_request_t *request = job->request;
+		if (use_tcp(request) && (job->connecting || job->phase == PHASE_SEND)) {
+			knot_unreachable_add(global_unreachables, &request->remote,
+			                     &request->source);
+		}
+		job->requestor.layer.flags |= KNOT_REQUESTOR_IOFAIL;
+		job_finish(areq, job, KNOT_ETIMEOUT);
+	}
+
+	areq_conn_t *conn, *cnxt;
+	WALK_LIST_DELSAFE(conn, cnxt, areq->conns) {
+		if (conn->deadline == 0) {
+			continue;
+		} else if (conn->deadline > now) {
+			if (areq->next_deadline == 0 || conn->deadline < areq->next_deadline) {
+				areq->next_deadline = conn->deadline;
+			}
+			continue;
+		}
+
+		if (conn->connecting || conn->tx_job != NULL) {
+			knot_unreachable_add(global_unreachables, &conn->remote, &conn->source);
+		}
+		conn_abort(areq, conn, KNOT_ETIMEOUT);
+	}
+}
+
+/*! \brief Cancel the jobs of the owner, or all the jobs if NULL. */
+static void cancel_jobs(knot_areq_t *areq, list_t *queued, const void *owner)
+{
+	knot_areq_job_t *job, *nxt;
+	WALK_LIST_DELSAFE(job, nxt, *queued) {
+		if (owner == NULL || job->owner == owner) {
+			add_tail(&areq->active, &job->n); // job_finish() removes it
+			job_finish(areq, job, KNOT_ECONNABORTED);
+		}
+	}
+	WALK_LIST_DELSAFE(job, nxt, areq->active) {
+		if (owner == NULL || job->owner == owner) {
+			job_finish(areq, job, KNOT_ECONNABORTED);
+		}
+	}
+
+	areq_conn_t *conn, *cnxt;
+	WALK_LIST_DELSAFE(conn, cnxt, areq->conns) {
+		list_t *queues[] = { &conn->sending, &conn->waiting };
+		for (int i = 0; i < 2; i++) {
+			WALK_LIST_DELSAFE(job, nxt, *queues[i]) {
+				if (owner == NULL || job->owner == owner) {
+					job_finish(areq, job, KNOT_ECONNABORTED);
+				}
+			}
+		}
+		conn_update(areq, conn);
+	}
+}
+
+static void wait_for_events(knot_areq_t *areq)
+{
+	int timeout = -1;
+	if (areq->next_deadline > 0) {
+		uint64_t now = now_ms();
+		timeout = (areq->next_deadline > now) ? areq->next_deadline - now : 0;
+	}
+
+	if (areq->ready_size < fdset_get_length(&areq->set)) {
+		free(areq->ready);
+		areq->ready_size = areq->set.size;
+		areq->ready = malloc(areq->ready_size * sizeof(*areq->ready));
+		if (areq->ready == NULL) {
+			areq->ready_size = 0;
+			return;
+		}
+	}
+
+	/* Collect the ready sockets first as the processing changes the set. */
+	unsigned count = 0;
+	fdset_it_t it;
+	(void)fdset_poll(&areq->set, &it, 0, timeout);
+	while (!fdset_it_is_done(&it)) {
+		areq_conn_t *conn = fdset_it_get_ctx(&it);
+		knot_areq_job_t *job = *fdset_ctx2(&areq->set, fdset_it_get_idx(&it));
+		if (conn == NULL && job == NULL) {
+			uint8_t buf[64];
+			while (read(areq->pipe[0], buf, sizeof(buf)) > 0); /* nop */
+		} else {
+			areq->ready[count++] = (areq_ready_t){ job, conn };
+		}
+		fdset_it_next(&it);
+	}
+
+	for (unsigned i = 0; i < count; i++) {
+		if (areq->ready[i].conn != NULL) {
+			conn_event(areq, areq->ready[i].conn);
+		} else {
+			job_event(areq, areq->ready[i].job);
+		}
+	}
+}
+
+static void *areq_thread(void *arg)
+{
+	knot_areq_t *areq = arg;
+
+	rcu_register_thread();
+
+	while (true) {
+		list_t queued;
+		init_list(&queued);
+
+		pthread_mutex_lock(&areq->lock);
+		knot_areq_job_t *job, *nxt;
+		WALK_LIST_DELSAFE(job, nxt, areq->queue) {
+			rem_node(&job->n);
+			add_tail(&queued, &job->n);
+		}
+		bool stop = areq->stop;
+		bool cancel = areq->cancel;
+		const void *cancel_owner = areq->cancel_owner;
+		pthread_mutex_unlock(&areq->lock);
+
+		if (stop || cancel) {
+			cancel_jobs(areq, &queued, stop ? NULL : cancel_owner);
+
+			pthread_mutex_lock(&areq->lock);
+			areq->cancel = false;
+			pthread_cond_broadcast(&areq->cancelled);
+			pthread_mutex_unlock(&areq->lock);
+		}
+		if (stop) {
+			break;
+		}
+
+		WALK_LIST_DELSAFE(job, nxt, queued) {
+			job_start(areq, job);
+		}
+
+		wait_for_events(areq);
+		check_timeouts(areq);
+	}
+
+	rcu_unregister_thread();
+
+	return NULL;
+}
+
+knot_areq_t *knot_areq_new(void)
+{
+	knot_areq_t *areq = calloc(1, sizeof(*areq));
+	if (areq == NULL) {
+		return NULL;
+	}
+
+	init_list(&areq->queue);
+	init_list(&areq->active);
+	init_list(&areq->conns);
+
+	if (pipe(areq->pipe) != 0) {
+		free(areq);
+		return NULL;
+	}
+	for (int i = 0; i < 2; i++) {
+		if (fcntl(areq->pipe[i], F_SETFL, O_NONBLOCK) != 0 ||
+		    fcntl(areq->pipe[i], F_SETFD, FD_CLOEXEC) != 0) {
+			goto failed;
+		}
+	}
+
+	if (fdset_init(&areq->set, FDSET_RESIZE_STEP) != KNOT_EOK) {
+		goto failed;
+	}
+	if (fdset_add(&areq->set, areq->pipe[0], FDSET_POLLIN, NULL) < 0) {
+		fdset_clear(&areq->set);
+		goto failed;
+	}
+
+	pthread_mutex_init(&areq->lock, NULL);
+	pthread_cond_init(&areq->cancelled, NULL);
+
+	if (pthread_create(&areq->thread, NULL, areq_thread, areq) != 0) {
+		pthread_cond_destroy(&areq->cancelled);
+		pthread_mutex_destroy(&areq->lock);
+		fdset_clear(&areq->set);
+		goto failed;
+	}
+
+	return areq;
+failed:
+	close(areq->pipe[0]);
+	close(areq->pipe[1]);
+	free(areq);
+	return NULL;
+}
+
+void knot_areq_free(knot_areq_t *areq)
+{
+	if (areq == NULL) {
+		return;
+	}
+
+	pthread_mutex_lock(&areq->lock);
+	areq->stop = true;
+	wake_up(areq);
+	pthread_mutex_unlock(&areq->lock);
+
+	pthread_join(areq->thread, NULL);
+
+	/* The watched duplicates have been closed with their jobs and connections. */
+	fdset_clear(&areq->set);
+	close(areq->pipe[0]);
+	close(areq->pipe[1]);
+
+	pthread_cond_destroy(&areq->cancelled);
+	pthread_mutex_destroy(&areq->lock);
+	free(areq->ready);
+	free(areq);
+}
+
+int knot_areq_submit(knot_areq_t *areq, knot_areq_job_t *job)
+{
+	if (areq == NULL || job == NULL || job->request == NULL || job->done == NULL) {
+		return KNOT_EINVAL;
+	} else if (!knot_areq_supported(job->request)) {
+		return KNOT_ENOTSUP;
+	}
+
+	job->idx = -1;
+	job->phase = PHASE_PROCESS;
+	job->connecting = false;
+	job->io_pos = 0;
+	job->deadline = 0;
+	job->conn = NULL;
+
+	pthread_mutex_lock(&areq->lock);
+	add_tail(&areq->queue, &job->n);
+	wake_up(areq);
+	pthread_mutex_unlock(&areq->lock);
+
+	return KNOT_EOK;
+}
+
+void knot_areq_cancel(knot_areq_t *areq, const void *owner)
+{
+	if (areq == NULL || owner == NULL) {
+		return;
+	}
+
+	pthread_mutex_lock(&areq->lock);
+	while (areq->cancel) { // Another cancellation in progress.
+		pthread_cond_wait(&areq->cancelled, &areq->lock);
+	}
+	areq->cancel = true;
+	areq->cancel_owner = owner;
+	wake_up(areq);
+	while (areq->cancel && areq->cancel_owner == owner) {
+		pthread_cond_wait(&areq->cancelled, &areq->lock);
+	}
+	pthread_mutex_unlock(&areq->lock);
+}
@@ -0,0 +1,116 @@
+/*  Copyright (C) 2025 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "contrib/ucw/lists.h"
+#include "knot/query/requestor.h"
+
+struct knot_areq_job;
+
+/*!
+ * \brief Completion callback.
+ *
+ * Called from the requestor thread with the result as from knot_requestor_exec(),
+ * or with KNOT_ECONNABORTED if the job has been cancelled.
+ */
+typedef void (*knot_areq_cb_t)(struct knot_areq_job *job, int ret);
+
+/*! \brief Request executed asynchronously. */
+typedef struct knot_areq_job {
+	node_t n;
+	knot_requestor_t requestor;  /*!< Initialized requestor. */
+	knot_request_t *request;     /*!< Request over UDP or TCP (without TLS). */
+	int timeout_ms;              /*!< Timeout of each operation (-1 for infinity). */
+	bool pipeline;               /*!< Share the TCP connection with other pipelined jobs. */
+	const void *owner;           /*!< Owner for cancellation, e.g. the zone. */
+	knot_areq_cb_t done;         /*!< Completion callback. */
+
+	/* Private, maintained by the requestor thread. */
+	int idx;                     /*!< Position in the watched set, -1 if not watched. */
+	int phase;                   /*!< Processing phase. */
+	bool connecting;             /*!< Waiting for a TCP connection. */
+	size_t io_pos;               /*!< Sent or received part of the message. */
+	uint8_t len[2];              /*!< Length of the message over TCP. */
+	uint64_t deadline;           /*!< [ms] Timeout of the pending operation. */
+	struct areq_conn *conn;      /*!< Shared connection the pipelined job is queued on. */
+} knot_areq_job_t;
+
+/*!
+ * \brief Asynchronous requestor.
+ *
+ * A single thread executes many requests at once, without blocking on the
+ * network. Each job is processed as by knot_requestor_exec() on non-blocking
+ * sockets, TCP connections are taken from and returned to the connection
+ * pool. The completion callback is called from the requestor thread and
+ * it's allowed to submit new jobs.
+ *
+ * Pipelined TCP jobs to the same remote share one connection, their queries
+ * are written back to back without waiting for the responses, which are
+ * matched by the message ID. A shared connection is returned to the pool once
+ * idle. If it makes no progress within the timeout of the job which opened it,
+ * it's closed and all its jobs fail.
+ *
+ * \note TCP Fast Open is not used, QUIC and TLS are not supported.
+ */
+typedef struct knot_areq knot_areq_t;
+
+/*!
+ * \brief Create the requestor and start its thread.
+ *
+ * \return New requestor or NULL on error.
+ */
+knot_areq_t *knot_areq_new(void);
+
+/*!
+ * \brief Cancel all the jobs and stop and free the requestor.
+ */
+void knot_areq_free(knot_areq_t *areq);
+
+/*!
+ * \brief Check if the request can be submitted.
+ */
+inline static bool knot_areq_supported(const knot_request_t *request)
+{
+	return !(request->flags & (KNOT_REQUEST_QUIC | KNOT_REQUEST_TLS));
+}
+
+/*!
+ * \brief Submit a job.
+ *
+ * \note The job must be kept until the completion callback is called.
+ *
+ * \param areq  Requestor.
+ * \param job   Job with the public members filled in.
+ *
+ * \return KNOT_EOK, KNOT_EINVAL, or KNOT_ENOTSUP.
+ */
+int knot_areq_submit(knot_areq_t *areq, knot_areq_job_t *job);
+
+/*!
+ * \brief Cancel the jobs of the owner.
+ *
+ * Once this function returns, the completion callbacks of all the jobs of
+ * the owner have been called and no callback of the owner is running.
+ *
+ * \note Must not be called from a completion callback.
+ *
+ * \param areq   Requestor (can be NULL).
+ * \param owner  Owner of the jobs.
+ */
+void knot_areq_cancel(knot_areq_t *areq, const void *owner);
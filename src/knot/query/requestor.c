@@ -355,7 +355,7 @@ void knot_requestor_clear(knot_requestor_t *requestor)
 	memset(requestor, 0, sizeof(*requestor));
 }
 
-static int request_reset(knot_requestor_t *req, knot_request_t *last)
+int knot_requestor_reset(knot_requestor_t *req, knot_request_t *last)
 {
 	knot_layer_reset(&req->layer);
 	tsig_reset(&last->tsig);
@@ -377,8 +377,7 @@ static int request_reset(knot_requestor_t *req, knot_request_t *last)
 	return KNOT_EOK;
 }
 
-static int request_produce(knot_requestor_t *req, knot_request_t *last,
-                           int timeout_ms)
+int knot_requestor_produce(knot_requestor_t *req, knot_request_t *last)
 {
 	knot_layer_produce(&req->layer, last->query);
 
@@ -399,7 +398,13 @@ static int request_produce(knot_requestor_t *req, knot_request_t *last,
 
 	/* NOTE: it's not necessary to reclaim pkt->reserved space for TSIG, as the following function
 	         does not use knot_pkt_put to insert it, it just writes at the end of wire. */
-	ret = tsig_sign_packet(&last->tsig, last->query);
+	return tsig_sign_packet(&last->tsig, last->query);
+}
+
+static int request_produce(knot_requestor_t *req, knot_request_t *last,
+                           int timeout_ms)
+{
+	int ret = knot_requestor_produce(req, last);
 	if (ret != KNOT_EOK) {
 		return ret;
 	}
@@ -424,16 +429,9 @@ static int request_produce(knot_requestor_t *req, knot_request_t *last,
 	return ret;
 }
 
-static int request_consume(knot_requestor_t *req, knot_request_t *last,
-                           int timeout_ms)
+int knot_requestor_consume(knot_requestor_t *req, knot_request_t *last)
 {
-	int ret = request_recv(last, timeout_ms);
-	if (ret < 0) {
-		req->layer.flags |= KNOT_REQUESTOR_IOFAIL;
-		return ret;
-	}
-
-	ret = knot_pkt_parse(last->resp, 0);
+	int ret = knot_pkt_parse(last->resp, 0);
 	if (ret != KNOT_EOK) {
 		return ret;
 	}
@@ -460,9 +458,21 @@ static int request_consume(knot_requestor_t *req, knot_request_t *last,
 	return KNOT_EOK;
 }
 
-static bool layer_active(knot_layer_state_t state)
+static int request_consume(knot_requestor_t *req, knot_request_t *last,
+                           int timeout_ms)
 {
-	switch (state) {
+	int ret = request_recv(last, timeout_ms);
+	if (ret < 0) {
+		req->layer.flags |= KNOT_REQUESTOR_IOFAIL;
+		return ret;
+	}
+
+	return knot_requestor_consume(req, last);
+}
+
+bool knot_requestor_active(const knot_requestor_t *req)
+{
+	switch (req->layer.state) {
 	case KNOT_STATE_CONSUME:
 	case KNOT_STATE_PRODUCE:
 	case KNOT_STATE_RESET:
@@ -481,7 +491,7 @@ static int request_io(knot_requestor_t *req, knot_request_t *last,
 	case KNOT_STATE_PRODUCE:
 		return request_produce(req, last, timeout_ms);
 	case KNOT_STATE_RESET:
-		return request_reset(req, last);
+		return knot_requestor_reset(req, last);
 	default:
 		return KNOT_EINVAL;
 	}
@@ -499,29 +509,36 @@ int knot_requestor_exec(knot_requestor_t *requestor, knot_request_t *request,
 	requestor->layer.tsig = &request->tsig;
 
 	/* Do I/O until the processing is satisfied or fails. */
-	while (layer_active(requestor->layer.state)) {
+	while (knot_requestor_active(requestor)) {
 		ret = request_io(requestor, request, timeout_ms);
 		if (ret != KNOT_EOK) {
-			knot_layer_finish(&requestor->layer);
-			return ret;
+			break;
 		}
 	}
 
-	/* Expect complete request. */
-	switch (requestor->layer.state) {
-	case KNOT_STATE_DONE:
-		request->flags |= KNOT_REQUEST_KEEP;
-		break;
-	case KNOT_STATE_IGNORE:
-		ret = KNOT_ERROR;
-		break;
-	default:
-		ret = KNOT_EPROCESSING;
-	}
+	return knot_requestor_finish(requestor, request, ret);
+}
 
-	/* Verify last TSIG */
-	if (tsig_unsigned_count(&request->tsig) != 0) {
-		ret = KNOT_TSIG_EBADSIG;
+int knot_requestor_finish(knot_requestor_t *requestor, knot_request_t *request,
+                          int ret)
+{
+	if (ret == KNOT_EOK) {
+		/* Expect complete request. */
+		switch (requestor->layer.state) {
+		case KNOT_STATE_DONE:
+			request->flags |= KNOT_REQUEST_KEEP;
+			break;
+		case KNOT_STATE_IGNORE:
+			ret = KNOT_ERROR;
+			break;
+		default:
+			ret = KNOT_EPROCESSING;
+		}
+
+		/* Verify last TSIG */
+		if (tsig_unsigned_count(&request->tsig) != 0) {
+			ret = KNOT_TSIG_EBADSIG;
+		}
 	}
 
 	/* Finish current query processing. */
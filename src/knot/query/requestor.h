@@ -171,3 +171,42 @@ void knot_requestor_clear(knot_requestor_t *requestor);
 int knot_requestor_exec(knot_requestor_t *requestor,
                         knot_request_t *request,
                         int timeout_ms);
+
+/*
+ * Steps of knot_requestor_exec() for requestors doing the I/O on their own
+ * (see async-requestor.h). Before the first step, requestor->layer.tsig must
+ * point to the request TSIG context.
+ */
+
+/*!
+ * \brief Check if the processing continues (the next step is due).
+ */
+bool knot_requestor_active(const knot_requestor_t *requestor);
+
+/*!
+ * \brief Produce and sign the next query, which is to be sent if the layer
+ *        state is KNOT_STATE_CONSUME afterwards.
+ */
+int knot_requestor_produce(knot_requestor_t *requestor, knot_request_t *request);
+
+/*!
+ * \brief Process the response received into request->resp.
+ */
+int knot_requestor_consume(knot_requestor_t *requestor, knot_request_t *request);
+
+/*!
+ * \brief Reset the processing, close the connection if requested by the layer.
+ */
+int knot_requestor_reset(knot_requestor_t *requestor, knot_request_t *request);
+
+/*!
+ * \brief Finish the processing.
+ *
+ * \param requestor  Requestor instance.
+ * \param request    Request instance.
+ * \param ret        Result of the last step.
+ *
+ * \return KNOT_EOK or error, as from knot_requestor_exec()
+ */
+int knot_requestor_finish(knot_requestor_t *requestor, knot_request_t *request,
+                          int ret);
@@ -39,6 +39,7 @@
 #include "knot/conf/migration.h"
 #include "knot/conf/module.h"
 #include "knot/dnssec/kasp/kasp_db.h"
+#include "knot/events/handlers.h"
 #include "knot/journal/journal_basic.h"
 #include "knot/server/server.h"
 #include "knot/server/udp-handler.h"
@@ -46,6 +47,7 @@
 #include "knot/updates/acl.h"
 #include "knot/zone/timers.h"
 #include "knot/zone/zonedb-load.h"
+#include "knot/worker/parallel.h"
 #include "knot/worker/pool.h"
 #include "contrib/base64.h"
 #include "contrib/conn_pool.h"
@@ -845,8 +847,14 @@ int server_init(server_t *server, int bg_workers)
 		return KNOT_ENOMEM;
 	}
 
+	server->requestor = knot_areq_new();
+	if (server->requestor == NULL) {
+		log_warning("failed to start asynchronous requestor");
+	}
+
 	int ret = catalog_update_init(&server->catalog_upd);
 	if (ret != KNOT_EOK) {
+		knot_areq_free(server->requestor);
 		worker_pool_destroy(server->workers);
 		evsched_deinit(&server->sched);
 		return ret;
@@ -865,7 +873,24 @@ int server_init(server_t *server, int bg_workers)
 	char *journal_dir = conf_db(conf(), C_JOURNAL_DB);
 	conf_val_t journal_size = conf_db_param(conf(), C_JOURNAL_DB_MAX_SIZE);
 	conf_val_t journal_mode = conf_db_param(conf(), C_JOURNAL_DB_MODE);
-	knot_lmdb_init(&server->journaldb, journal_dir, conf_int(&journal_size), journal_env_flags(conf_opt(&journal_mode), false), NULL);
+	conf_val_t journal_shards = conf_db_param(conf(), C_JOURNAL_DB_SHARDS);
+	conf_val_t journal_group = conf_db_param(conf(), C_JOURNAL_DB_GROUP_COMMIT);
+	server->journal_shards = conf_int(&journal_shards);
+	for (unsigned i = 0; i < JOURNAL_SHARDS_MAX; i++) {
+		char *shard_dir = journal_shard_path(journal_dir, i);
+		knot_lmdb_init(&server->journaldb[i], shard_dir,
+		               conf_int(&journal_size) / server->journal_shards,
+		               journal_env_flags(conf_opt(&journal_mode), false), NULL);
+		free(shard_dir);
+		if (i >= server->journal_shards) {
+			continue;
+		}
+		server->journal_batch[i] = journal_batch_new(&server->journaldb[i],
+		                                             conf_int(&journal_group));
+		if (server->journal_batch[i] == NULL) {
+			log_warning("failed to start journal writer, group commit disabled");
+		}
+	}
 	free(journal_dir);
 
 	kasp_db_ensure_init(&server->kaspdb, conf());
@@ -900,7 +925,12 @@ void server_deinit(server_t *server)
 	server_deinit_iface_list(server->ifaces, server->n_ifaces);
 
 	/* Free threads and event handlers. */
+	xfr_pool_free(server->xfr_pool);
+	knot_areq_free(server->requestor);
+	server->requestor = NULL;
+	event_refresh_deinit();
 	worker_pool_destroy(server->workers);
+	parallel_deinit();
 
 	/* Free zone database. */
 	knot_zonedb_deep_free(&server->zone_db, true);
@@ -922,8 +952,11 @@ void server_deinit(server_t *server)
 	/* Close kasp_db. */
 	knot_lmdb_deinit(&server->kaspdb);
 
-	/* Close journal database if open. */
-	knot_lmdb_deinit(&server->journaldb);
+	/* Stop the journal writers and close journal database shards if open. */
+	for (unsigned i = 0; i < JOURNAL_SHARDS_MAX; i++) {
+		journal_batch_free(server->journal_batch[i]);
+		knot_lmdb_deinit(&server->journaldb[i]);
+	}
 
 	/* Close and deinit connection pool. */
 	conn_pool_deinit(global_conn_pool);
@@ -991,7 +1024,7 @@ static void worker_wait_cb(worker_pool_t *pool)
 	/* Too frequent worker_pool_status() call with many zones is expensive. */
 	if (now_ns - last_ns > 1000000000) {
 		int running, queued;
-		worker_pool_status(pool, true, &running, &queued);
+		worker_pool_status(pool, true, &running, &queued, NULL);
 		systemd_tasks_status_notify(running + queued);
 		last_ns = now_ns;
 	}
@@ -1043,6 +1076,10 @@ void server_wait(server_t *server)
 			server_free_handler(&server->handlers[proto].handler);
 		}
 	}
+
+	/* Finish running transfers, drop the rest as the TCP handlers are gone. */
+	xfr_pool_free(server->xfr_pool);
+	server->xfr_pool = NULL;
 }
 
 static int reload_conf(conf_t *new_conf)
@@ -1201,6 +1238,7 @@ static void warn_server_reconfigure(conf_t *conf, server_t *server)
 	static bool warn_udp = true;
 	static bool warn_tcp = true;
 	static bool warn_bg = true;
+	static bool warn_xfr = true;
 	static bool warn_listen = true;
 	static bool warn_xdp_udp = true;
 	static bool warn_xdp_tcp = true;
@@ -1210,6 +1248,7 @@ static void warn_server_reconfigure(conf_t *conf, server_t *server)
 	static bool warn_busypoll_budget = true;
 	static bool warn_busypoll_timeout = true;
 	static bool warn_rmt_pool_limit = true;
+	static bool warn_journal_shards = true;
 
 	if (warn_tcp_reuseport && conf->cache.srv_tcp_reuseport != conf_get_bool(conf, C_SRV, C_TCP_REUSEPORT)) {
 		log_warning(msg, &C_TCP_REUSEPORT[1]);
@@ -1236,6 +1275,11 @@ static void warn_server_reconfigure(conf_t *conf, server_t *server)
 		warn_bg = false;
 	}
 
+	if (warn_xfr && conf->cache.srv_xfr_threads != conf_get_int(conf, C_SRV, C_XFR_WORKERS)) {
+		log_warning(msg, &C_XFR_WORKERS[1]);
+		warn_xfr = false;
+	}
+
 	if (warn_listen && server->ifaces != NULL && listen_changed(conf, server)) {
 		log_warning(msg, "listen(-xdp,-quic,-tls)");
 		warn_listen = false;
@@ -1287,6 +1331,12 @@ static void warn_server_reconfigure(conf_t *conf, server_t *server)
 		log_warning(msg, &C_RMT_POOL_LIMIT[1]);
 		warn_rmt_pool_limit = false;
 	}
+
+	conf_val_t journal_shards = conf_db_param(conf, C_JOURNAL_DB_SHARDS);
+	if (warn_journal_shards && server->journal_shards != conf_int(&journal_shards)) {
+		log_warning(msg, &C_JOURNAL_DB_SHARDS[1]);
+		warn_journal_shards = false;
+	}
 }
 
 int server_reload(server_t *server, reload_t mode)
@@ -1416,7 +1466,23 @@ static int configure_threads(conf_t *conf, server_t *server)
 		}
 	}
 
-	return set_handler(server, IO_TCP, conf->cache.srv_tcp_threads, tcp_master);
+	ret = set_handler(server, IO_TCP, conf->cache.srv_tcp_threads, tcp_master);
+	if (ret != KNOT_EOK) {
+		return ret;
+	}
+
+	/* Transfer workers follow the thread identifiers of the I/O handlers. */
+	if (conf->cache.srv_xfr_threads > 0) {
+		unsigned thread_id = conf->cache.srv_udp_threads + conf->cache.srv_tcp_threads +
+		                     conf->cache.srv_xdp_threads;
+		server->xfr_pool = xfr_pool_new(conf->cache.srv_xfr_threads, thread_id,
+		                                conf->cache.srv_tcp_threads);
+		if (server->xfr_pool == NULL) {
+			return KNOT_ENOMEM;
+		}
+	}
+
+	return KNOT_EOK;
 }
 
 static int reconfigure_journal_db(conf_t *conf, server_t *server)
@@ -1424,8 +1490,16 @@ static int reconfigure_journal_db(conf_t *conf, server_t *server)
 	char *journal_dir = conf_db(conf, C_JOURNAL_DB);
 	conf_val_t journal_size = conf_db_param(conf, C_JOURNAL_DB_MAX_SIZE);
 	conf_val_t journal_mode = conf_db_param(conf, C_JOURNAL_DB_MODE);
-	int ret = knot_lmdb_reinit(&server->journaldb, journal_dir, conf_int(&journal_size),
-	                           journal_env_flags(conf_opt(&journal_mode), false));
+	conf_val_t journal_group = conf_db_param(conf, C_JOURNAL_DB_GROUP_COMMIT);
+	int ret = KNOT_EOK;
+	for (unsigned i = 0; i < server->journal_shards && ret == KNOT_EOK; i++) {
+		char *shard_dir = journal_shard_path(journal_dir, i);
+		ret = knot_lmdb_reinit(&server->journaldb[i], shard_dir,
+		                       conf_int(&journal_size) / server->journal_shards,
+		                       journal_env_flags(conf_opt(&journal_mode), false));
+		free(shard_dir);
+		journal_batch_set_delay(server->journal_batch[i], conf_int(&journal_group));
+	}
 	if (ret != KNOT_EOK) {
 		log_warning("ignored reconfiguration of journal DB (%s)", knot_strerror(ret));
 	}
@@ -1575,6 +1649,9 @@ int server_reconfigure(conf_t *conf, server_t *server)
 		          knot_strerror(ret));
 	}
 
+	/* Reconfigure transfer workers. */
+	xfr_pool_set_zone_limit(server->xfr_pool, conf->cache.srv_xfr_zone_limit);
+
 	return KNOT_EOK;
 }
 
@@ -1609,6 +1686,28 @@ void server_update_zones(conf_t *conf, server_t *server, reload_t mode)
 	log_debug("resumed zone events");
 }
 
+void server_journal_reshard(server_t *server)
+{
+	size_t moved = 0;
+	int ret = journal_shards_migrate(server->journaldb, server->journal_shards, &moved);
+	if (ret != KNOT_EOK) {
+		log_error("journal DB, failed to move zone journals between shards (%s)",
+		          knot_strerror(ret));
+	} else if (moved > 0) {
+		log_info("journal DB, moved %zu zone journals between shards", moved);
+	}
+}
+
+knot_lmdb_db_t *server_journaldb(server_t *server, const knot_dname_t *zone)
+{
+	return &server->journaldb[journal_shard(zone, server->journal_shards)];
+}
+
+journal_batch_t *server_journal_batch(server_t *server, const knot_dname_t *zone)
+{
+	return server->journal_batch[journal_shard(zone, server->journal_shards)];
+}
+
 size_t server_cert_pin(server_t *server, uint8_t *out, size_t out_size)
 {
 	int pin_size = 0;
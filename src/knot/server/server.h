@@ -21,8 +21,12 @@
 #include "knot/catalog/catalog_update.h"
 #include "knot/common/evsched.h"
 #include "knot/common/fdset.h"
+#include "knot/journal/journal_batch.h"
+#include "knot/journal/journal_shard.h"
 #include "knot/journal/knot_lmdb.h"
+#include "knot/query/async-requestor.h"
 #include "knot/server/dthreads.h"
+#include "knot/server/xfr-pool.h"
 #include "knot/worker/pool.h"
 #include "knot/zone/backup.h"
 #include "knot/zone/zonedb.h"
@@ -105,7 +109,9 @@ typedef struct server {
 
 	knot_zonedb_t *zone_db;
 	knot_lmdb_db_t timerdb;
-	knot_lmdb_db_t journaldb;
+	knot_lmdb_db_t journaldb[JOURNAL_SHARDS_MAX];
+	journal_batch_t *journal_batch[JOURNAL_SHARDS_MAX];
+	unsigned journal_shards;
 	knot_lmdb_db_t kaspdb;
 	catalog_t catalog;
 
@@ -115,9 +121,15 @@ typedef struct server {
 		iohandler_t handler;
 	} handlers[3];
 
+	/*! \brief Outgoing transfers handed over from the TCP handlers. */
+	xfr_pool_t *xfr_pool;
+
 	/*! \brief Background jobs. */
 	worker_pool_t *workers;
 
+	/*! \brief Outgoing requests not blocking the background workers. */
+	knot_areq_t *requestor;
+
 	/*! \brief Event scheduler. */
 	evsched_t sched;
 
@@ -216,6 +228,35 @@ int server_reconfigure(conf_t *conf, server_t *server);
  */
 void server_update_zones(conf_t *conf, server_t *server, reload_t mode);
 
+/*!
+ * \brief Move zone journals into the journal DB shards they belong to.
+ *
+ * \note This is needed only if the number of shards has changed.
+ *
+ * \param server  Server instance.
+ */
+void server_journal_reshard(server_t *server);
+
+/*!
+ * \brief Get the journal DB shard of the zone.
+ *
+ * \param server  Server instance.
+ * \param zone    Zone name.
+ *
+ * \return Journal DB.
+ */
+knot_lmdb_db_t *server_journaldb(server_t *server, const knot_dname_t *zone);
+
+/*!
+ * \brief Get the journal writer of the zone's journal DB shard.
+ *
+ * \param server  Server instance.
+ * \param zone    Zone name.
+ *
+ * \return Journal writer or NULL if not running.
+ */
+journal_batch_t *server_journal_batch(server_t *server, const knot_dname_t *zone);
+
 /*!
  * \brief Returns current server certificate public key PIN as base64 string.
  *
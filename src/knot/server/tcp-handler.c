@@ -22,9 +22,11 @@
 #include <sys/socket.h>
 #include <netinet/tcp.h>
 #include <netinet/in.h>
+#include <poll.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <urcu.h>
+#include <gnutls/gnutls.h>
 #ifdef HAVE_SYS_UIO_H	// struct iovec (OpenBSD)
 #include <sys/uio.h>
 #endif // HAVE_SYS_UIO_H
@@ -32,11 +34,13 @@
 #include "knot/server/handler.h"
 #include "knot/server/server.h"
 #include "knot/server/tcp-handler.h"
+#include "knot/server/xfr-pool.h"
 #include "knot/common/log.h"
 #include "knot/common/fdset.h"
 #include "knot/nameserver/process_query.h"
 #include "knot/query/layer.h"
 #include "libknot/quic/tls.h"
+#include "libknot/wire.h"
 #include "contrib/macros.h"
 #include "contrib/mempattern.h"
 #include "contrib/net.h"
@@ -45,11 +49,36 @@
 #include "contrib/time.h"
 #include "contrib/ucw/mempool.h"
 
+/*! \brief Size of the receive buffer, fits an incomplete and a complete message. */
+#define TCP_RX_SIZE	(2 * (sizeof(uint16_t) + KNOT_WIRE_MAX_PKTSIZE))
+/*! \brief Size of the buffer for coalesced responses. */
+#define TCP_OUT_SIZE	(4 * (sizeof(uint16_t) + KNOT_WIRE_MAX_PKTSIZE))
+
+#if defined(__APPLE__) && !defined(MSG_NOSIGNAL)
+#define MSG_NOSIGNAL 0 /* SIGPIPE is ignored by the server. */
+#endif
+
+/*! \brief TCP client connection state. */
+typedef struct {
+	struct sockaddr_storage remote;  /*!< Remote address, obtained once on accept. */
+	struct sockaddr_storage local;   /*!< Local address, obtained once on accept. */
+	knot_tls_conn_t *tls_conn;       /*!< DoT connection (TLS interfaces only). */
+	uint8_t *rx;                     /*!< Received data not processed yet. */
+	size_t rx_len;                   /*!< Length of the unprocessed data. */
+	uint8_t *tx;                     /*!< Responses waiting for the socket to be writable. */
+	size_t tx_len;                   /*!< Length of the waiting responses. */
+	size_t tx_sent;                  /*!< Already sent part of the waiting responses. */
+	bool tls_write;                  /*!< DoT handshake waiting for the socket to be writable. */
+	bool io_watch;                   /*!< Watchdog set to IO timeout for pending data. */
+} tcp_conn_t;
+
 /*! \brief TCP context data. */
 typedef struct tcp_context {
 	knot_layer_t layer;              /*!< Query processing layer. */
 	server_t *server;                /*!< Name server structure. */
 	struct iovec iov[2];             /*!< TX/RX buffers. */
+	uint8_t *out;                    /*!< Coalesced responses to be sent. */
+	size_t out_len;                  /*!< Length of the coalesced responses. */
 	unsigned client_threshold;       /*!< Index of first TCP client. */
 	struct timespec last_poll_time;  /*!< Time of the last socket poll. */
 	bool is_throttled;               /*!< TCP connections throttling switch. */
@@ -59,8 +88,29 @@ typedef struct tcp_context {
 	int idle_timeout;                /*!< [s] TCP idle timeout configuration. */
 	int io_timeout;                  /*!< [ms] TCP send/recv timeout configuration. */
 	struct knot_tls_ctx *tls_ctx;    /*!< DoT answering context. */
+	xfr_pool_t *xfr_pool;            /*!< Transfer workers (optional). */
+	unsigned xfr_owner;              /*!< Index of this worker for the transfer workers. */
+	unsigned xfr_count;              /*!< Connections handed over to the transfer workers. */
 } tcp_context_t;
 
+/*! \brief Result of processing of received data. */
+typedef struct {
+	bool progress;                   /*!< Some message has been processed or sent. */
+	bool xfr;                        /*!< Transfer query to be handed over found. */
+	knot_dname_storage_t zone;       /*!< Zone of the transfer query. */
+} tcp_result_t;
+
+/*! \brief Connection handed over to the transfer workers. */
+typedef struct {
+	xfr_job_t job;
+	server_t *server;                /*!< Name server structure. */
+	const iface_t *iface;            /*!< Interface of the connection. */
+	tcp_conn_t *conn;                /*!< Connection state. */
+	int fd;                          /*!< Duplicated connection socket. */
+	int io_timeout;                  /*!< [ms] TCP send/recv timeout configuration. */
+	bool closed;                     /*!< The connection has been closed by the worker. */
+} tcp_xfr_t;
+
 #define TCP_SWEEP_INTERVAL 2 /*!< [secs] granularity of connection sweeping. */
 
 static void update_sweep_timer(struct timespec *timer)
@@ -78,41 +128,70 @@ static void update_tcp_conf(tcp_context_t *tcp)
 	tcp->idle_timeout = pconf->cache.srv_tcp_idle_timeout;
 	tcp->io_timeout = pconf->cache.srv_tcp_io_timeout;
 	rcu_read_unlock();
+}
 
-	if (tcp->tls_ctx != NULL) {
-		tcp->tls_ctx->io_timeout = tcp->io_timeout;
-	}
+static void tcp_conn_free(tcp_conn_t *conn)
+{
+	knot_tls_conn_del(conn->tls_conn);
+	free(conn->rx);
+	free(conn->tx);
+	free(conn);
 }
 
-static void free_tls_ctx(fdset_t *set, int idx)
+static void free_conn(fdset_t *set, int idx)
 {
-	void **tls_conn = fdset_ctx2(set, idx);
-	if (*tls_conn != NULL) {
-		knot_tls_conn_del(*tls_conn);
-		*tls_conn = NULL;
+	tcp_conn_t **conn = (tcp_conn_t **)fdset_ctx2(set, idx);
+	if (*conn != NULL) {
+		tcp_conn_free(*conn);
+		*conn = NULL;
 	}
 }
 
+/*!
+ * \brief Check if the connection is in the middle of receiving or sending.
+ */
+static bool tcp_conn_pending(const tcp_conn_t *conn)
+{
+	return conn->rx_len > 0 || conn->tx_len > 0 ||
+	       (conn->tls_conn != NULL &&
+	        !(conn->tls_conn->flags & KNOT_TLS_CONN_HANDSHAKE_DONE));
+}
+
+/*!
+ * \brief Check if there is a complete message received and not processed yet.
+ */
+static bool tcp_rx_ready(const tcp_conn_t *conn)
+{
+	return conn->rx_len >= sizeof(uint16_t) &&
+	       conn->rx_len - sizeof(uint16_t) >= knot_wire_read_u16(conn->rx);
+}
+
 static fdset_sweep_state_t tcp_sweep(fdset_t *set, int idx, void *data)
 {
-	const int fd = fdset_get_fd(set, idx);
-	assert(set && fd >= 0);
+	const tcp_conn_t *conn = *fdset_ctx2(set, idx);
+	assert(set && conn);
 
+	/* Pending data means the client didn't finish receiving or sending in time. */
 	server_t *server = data;
-	ATOMIC_ADD(server->stats.tcp_idle_timeout, 1);
+	const bool pending = tcp_conn_pending(conn);
+	if (pending) {
+		ATOMIC_ADD(server->stats.tcp_io_timeout, 1);
+	} else {
+		ATOMIC_ADD(server->stats.tcp_idle_timeout, 1);
+	}
 
 	if (log_enabled_debug()) {
-		/* Best-effort, name and shame. */
-		struct sockaddr_storage ss = { 0 };
-		socklen_t len = sizeof(struct sockaddr_storage);
-		if (getpeername(fd, (struct sockaddr *)&ss, &len) == 0) {
-			char addr_str[SOCKADDR_STRLEN];
-			sockaddr_tostr(addr_str, sizeof(addr_str), &ss);
+		char addr_str[SOCKADDR_STRLEN];
+		sockaddr_tostr(addr_str, sizeof(addr_str), &conn->remote);
+		if (pending) {
+			log_debug("TCP, failed to %s due to IO timeout, closing connection, address %s",
+			          (conn->tx_len > 0) ? "send" : "receive", addr_str);
+		} else {
 			log_debug("TCP, terminated inactive client, address %s", addr_str);
 		}
 	}
 
-	free_tls_ctx(set, idx);
+	free_conn(set, idx);
 
 	return FDSET_SWEEP;
 }
@@ -169,64 +248,216 @@ static unsigned tcp_set_ifaces(const iface_t *ifaces, size_t n_ifaces,
 	return fdset_get_length(fds);
 }
 
-static int tcp_handle(tcp_context_t *tcp, knotd_qdata_params_t *params,
-                      struct iovec *rx, struct iovec *tx)
+/*!
+ * \brief Send as much DoT data as possible without blocking.
+ *
+ * If the socket isn't writable, the last record is kept in the session
+ * and the following call must continue with the same data.
+ */
+static ssize_t tls_send_avail(knot_tls_conn_t *tls, const uint8_t *data, size_t len)
 {
-	rx->iov_len = KNOT_WIRE_MAX_PKTSIZE;
-	tx->iov_len = KNOT_WIRE_MAX_PKTSIZE;
+	size_t sent = 0;
+	while (sent < len) {
+		ssize_t ret = gnutls_record_send(tls->session, data + sent, len - sent);
+		if (ret > 0) {
+			sent += ret;
+		} else if (ret == GNUTLS_E_INTERRUPTED) {
+			continue;
+		} else if (ret == GNUTLS_E_AGAIN) {
+			break;
+		} else {
+			return KNOT_ECONN;
+		}
+	}
 
-	/* Receive data. */
-	int recv;
-	if (params->tls_conn != NULL) {
-		int ret = knot_tls_handshake(params->tls_conn, true);
-		switch (ret) {
-		case KNOT_NET_EAGAIN: // Unfinished handshake, continue later.
-			return KNOT_EOK;
-		case KNOT_EOK:        // Finished handshake, continue with receiving message.
-			recv = knot_tls_recv_dns(params->tls_conn, rx->iov_base, rx->iov_len);
+	return sent;
+}
+
+/*!
+ * \brief Send as much data as possible without blocking.
+ *
+ * \return Number of bytes sent or KNOT_ECONN.
+ */
+static ssize_t send_avail(int fd, knot_tls_conn_t *tls, const uint8_t *data, size_t len)
+{
+	if (tls != NULL) {
+		return tls_send_avail(tls, data, len);
+	}
+
+	size_t sent = 0;
+	while (sent < len) {
+		ssize_t ret = send(fd, data + sent, len - sent, MSG_NOSIGNAL);
+		if (ret > 0) {
+			sent += ret;
+		} else if (ret < 0 && errno == EINTR) {
+			continue;
+		} else if (ret < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
 			break;
-		default:              // E.g. handshake timeout.
-			assert(ret < 0);
-			recv = ret;
+		} else {
+			return KNOT_ECONN;
+		}
+	}
+
+	return sent;
+}
+
+/*!
+ * \brief Send all the data, wait for the socket within the IO timeout.
+ *
+ * \return KNOT_EOK, KNOT_ETIMEOUT, or KNOT_ECONN.
+ */
+static int send_wait(int fd, knot_tls_conn_t *tls, const uint8_t *data, size_t len,
+                     int timeout)
+{
+	if (tls == NULL) {
+		ssize_t sent = net_stream_send(fd, data, len, timeout);
+		if (sent != (ssize_t)len) {
+			return (sent == KNOT_ETIMEOUT) ? KNOT_ETIMEOUT : KNOT_ECONN;
+		}
+		return KNOT_EOK;
+	}
+
+	size_t sent = 0;
+	while (true) {
+		ssize_t ret = tls_send_avail(tls, data + sent, len - sent);
+		if (ret < 0) {
+			return ret;
+		}
+		sent += ret;
+		if (sent == len) {
+			return KNOT_EOK;
+		}
+
+		struct pollfd pfd = { .fd = fd, .events = POLLOUT };
+		ret = poll(&pfd, 1, timeout);
+		if (ret == 0) {
+			return KNOT_ETIMEOUT;
+		} else if (ret < 0 && errno != EINTR) {
+			return KNOT_ECONN;
+		}
+	}
+}
+
+/*!
+ * \brief Receive available data without blocking.
+ *
+ * DoT records are received until the buffer is full or the socket is drained.
+ *
+ * \return Number of bytes received (zero if nothing available), KNOT_EOF
+ *         if the connection was closed, or KNOT_ECONN.
+ */
+static ssize_t recv_avail(int fd, knot_tls_conn_t *tls, uint8_t *data, size_t len)
+{
+	if (len == 0) {
+		return 0;
+	}
+
+	if (tls == NULL) {
+		while (true) {
+			ssize_t ret = recv(fd, data, len, 0);
+			if (ret > 0) {
+				return ret;
+			} else if (ret == 0) {
+				return KNOT_EOF;
+			} else if (errno == EINTR) {
+				continue;
+			} else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+				return 0;
+			} else {
+				return KNOT_ECONN;
+			}
+		}
+	}
+
+	size_t total = 0;
+	while (total < len) {
+		ssize_t ret = gnutls_record_recv(tls->session, data + total, len - total);
+		if (ret > 0) {
+			total += ret;
+		} else if (ret == 0) {
+			return (total > 0) ? total : KNOT_EOF;
+		} else if (ret == GNUTLS_E_INTERRUPTED) {
+			continue;
+		} else if (gnutls_error_is_fatal(ret) != 0) {
+			return KNOT_ECONN;
+		} else { // GNUTLS_E_AGAIN or e.g. a warning alert.
 			break;
 		}
-	} else {
-		recv = net_dns_tcp_recv(params->socket, rx->iov_base, rx->iov_len, tcp->io_timeout);
 	}
-	if (recv > 0) {
-		rx->iov_len = recv;
-	} else {
-		tcp_log_error(params->remote, "receive", recv, tcp->server);
+
+	return total;
+}
+
+/*!
+ * \brief Send the coalesced responses, keep the unsent part in the connection.
+ */
+static int tcp_out_flush(tcp_context_t *tcp, tcp_conn_t *conn,
+                         const knotd_qdata_params_t *params)
+{
+	assert(conn->tx_len == 0);
+
+	ssize_t sent = send_avail(params->socket, params->tls_conn, tcp->out, tcp->out_len);
+	if (sent < 0) {
+		tcp->out_len = 0;
 		return KNOT_EOF;
 	}
+	if (sent < (ssize_t)tcp->out_len) {
+		conn->tx = malloc(tcp->out_len - sent);
+		if (conn->tx == NULL) {
+			tcp->out_len = 0;
+			return KNOT_ENOMEM;
+		}
+		memcpy(conn->tx, tcp->out + sent, tcp->out_len - sent);
+		conn->tx_len = tcp->out_len - sent;
+		conn->tx_sent = 0;
+	}
+	tcp->out_len = 0;
+
+	return KNOT_EOK;
+}
+
+static int tcp_out_add(tcp_context_t *tcp, const knotd_qdata_params_t *params,
+                       const knot_pkt_t *ans)
+{
+	/* Only a response longer than the buffer (e.g. a zone transfer) gets here,
+	   tcp_process() makes room for a message before each query. */
+	if (tcp->out_len + sizeof(uint16_t) + ans->size > TCP_OUT_SIZE) {
+		int ret = send_wait(params->socket, params->tls_conn, tcp->out,
+		                    tcp->out_len, tcp->io_timeout);
+		if (ret != KNOT_EOK) {
+			tcp_log_error(params->remote, "send", ret, tcp->server);
+			return KNOT_EOF;
+		}
+		tcp->out_len = 0;
+	}
+
+	knot_wire_write_u16(tcp->out + tcp->out_len, ans->size);
+	memcpy(tcp->out + tcp->out_len + sizeof(uint16_t), ans->wire, ans->size);
+	tcp->out_len += sizeof(uint16_t) + ans->size;
 
+	return KNOT_EOK;
+}
+
+static int tcp_handle_msg(tcp_context_t *tcp, knotd_qdata_params_t *params,
+                          struct iovec *rx, struct iovec *tx)
+{
 	handle_query(params, &tcp->layer, rx, NULL);
 
-	/* Resolve until NOOP or finished. */
+	/* Resolve until NOOP or finished, collect the responses. */
+	int ret = KNOT_EOK;
 	knot_pkt_t *ans = knot_pkt_new(tx->iov_base, tx->iov_len, tcp->layer.mm);
-	while (active_state(tcp->layer.state)) {
+	while (ret == KNOT_EOK && active_state(tcp->layer.state)) {
 		knot_layer_produce(&tcp->layer, ans);
 		/* Send, if response generation passed and wasn't ignored. */
 		if (ans->size > 0 && send_state(tcp->layer.state)) {
-			int sent;
-			if (params->tls_conn != NULL) {
-				sent = knot_tls_send_dns(params->tls_conn, ans->wire, ans->size);
-			} else {
-				sent = net_dns_tcp_send(params->socket, ans->wire, ans->size,
-				                        tcp->io_timeout, NULL);
-			}
-			if (sent != ans->size) {
-				tcp_log_error(params->remote, "send", sent, tcp->server);
-				handle_finish(&tcp->layer);
-				return KNOT_EOF;
-			}
+			ret = tcp_out_add(tcp, params, ans);
 		}
 	}
 
 	handle_finish(&tcp->layer);
 
+	// Store the qdata params AUTH flag to the DoT connection.
 	if (params->tls_conn != NULL) {
-		// Store the qdata params AUTH flag to the connection.
 		if (params->flags & KNOTD_QUERY_FLAG_AUTHORIZED) {
 			params->tls_conn->flags |= KNOT_TLS_CONN_AUTHORIZED;
 		} else {
@@ -234,6 +465,235 @@ static int tcp_handle(tcp_context_t *tcp, knotd_qdata_params_t *params,
 		}
 	}
 
+	return ret;
+}
+
+/*!
+ * \brief Check if the message is an AXFR or IXFR query, get its zone name.
+ */
+static bool tcp_xfr_query(const uint8_t *msg, size_t len, knot_dname_t *zone)
+{
+	if (len < KNOT_WIRE_HEADER_SIZE || knot_wire_get_qr(msg) ||
+	    knot_wire_get_opcode(msg) != KNOT_OPCODE_QUERY ||
+	    knot_wire_get_qdcount(msg) != 1) {
+		return false;
+	}
+
+	const uint8_t *qname = msg + KNOT_WIRE_HEADER_SIZE;
+	int qname_size = knot_dname_wire_check(qname, msg + len, NULL);
+	if (qname_size <= 0 || KNOT_WIRE_HEADER_SIZE + qname_size + 2 * sizeof(uint16_t) > len) {
+		return false;
+	}
+
+	uint16_t qtype = knot_wire_read_u16(qname + qname_size);
+	if (qtype != KNOT_RRTYPE_AXFR && qtype != KNOT_RRTYPE_IXFR) {
+		return false;
+	}
+
+	memcpy(zone, qname, qname_size);
+	knot_dname_to_lower(zone);
+
+	return true;
+}
+
+/*!
+ * \brief Process the complete messages in the buffer.
+ *
+ * The responses are sent at once, the part which doesn't fit into the socket
+ * is kept in the connection until it's writable. If the coalesced responses
+ * must be sent to make room for another response and the socket isn't
+ * writable, processing stops and the unprocessed messages are kept in the
+ * connection to be continued once the responses are sent. The incomplete
+ * message is kept in the connection too.
+ *
+ * If there are transfer workers, processing stops at a plain TCP transfer
+ * query, which is kept in the connection with the following messages to be
+ * handed over. Processing of DoT messages stops when the connection gets
+ * blocked by an update, whose response is sent by the update event.
+ */
+static int tcp_process(tcp_context_t *tcp, tcp_conn_t *conn,
+                       const knotd_qdata_params_t *params, uint8_t *rx,
+                       size_t rx_len, tcp_result_t *res)
+{
+	assert(conn->tx_len == 0);
+
+	knot_tls_conn_t *tls = params->tls_conn;
+	int ret = KNOT_EOK;
+	size_t pos = 0;
+	while (rx_len - pos >= sizeof(uint16_t)) {
+		size_t msg_len = knot_wire_read_u16(rx + pos);
+		if (rx_len - pos - sizeof(uint16_t) < msg_len) {
+			break;
+		}
+
+		struct iovec msg = {
+			.iov_base = rx + pos + sizeof(uint16_t),
+			.iov_len = msg_len
+		};
+		if (tcp->xfr_pool != NULL && tls == NULL &&
+		    tcp_xfr_query(msg.iov_base, msg_len, res->zone)) {
+			res->xfr = true;
+			break;
+		}
+
+		/* Make room for a response. The update event sends the DoT update
+		   response itself, so the preceding responses must be sent first. */
+		size_t out_max = TCP_OUT_SIZE - sizeof(uint16_t) - KNOT_WIRE_MAX_PKTSIZE;
+		if (tls != NULL && msg_len >= KNOT_WIRE_HEADER_SIZE &&
+		    knot_wire_get_opcode(msg.iov_base) == KNOT_OPCODE_UPDATE) {
+			out_max = 0;
+		}
+		if (tcp->out_len > out_max) {
+			ret = tcp_out_flush(tcp, conn, params);
+			if (ret != KNOT_EOK || conn->tx_len > 0) {
+				break; // Continue once the socket is writable.
+			}
+		}
+
+		knotd_qdata_params_t msg_params = *params;
+		if (tls != NULL) {
+			params_update_tls(&msg_params, tls);
+		}
+		ret = tcp_handle_msg(tcp, &msg_params, &msg, &tcp->iov[1]);
+		if (ret != KNOT_EOK) {
+			break;
+		}
+		pos += sizeof(uint16_t) + msg_len;
+		res->progress = true;
+
+		if (tls != NULL && (tls->flags & KNOT_TLS_CONN_BLOCKED)) {
+			break;
+		}
+	}
+	if (ret != KNOT_EOK) {
+		tcp->out_len = 0;
+		return ret;
+	}
+
+	/* Keep the unprocessed and incomplete messages. */
+	if (pos < rx_len) {
+		conn->rx = malloc(rx_len - pos);
+		if (conn->rx == NULL) {
+			tcp->out_len = 0;
+			return KNOT_ENOMEM;
+		}
+		memcpy(conn->rx, rx + pos, rx_len - pos);
+		conn->rx_len = rx_len - pos;
+	}
+
+	/* Send the coalesced responses unless waiting for the socket already. */
+	if (conn->tx_len > 0) {
+		assert(tcp->out_len == 0);
+		return KNOT_EOK;
+	}
+
+	return tcp_out_flush(tcp, conn, params);
+}
+
+/*!
+ * \brief Receive available data and process the complete messages.
+ *
+ * \see tcp_process
+ */
+static int tcp_handle(tcp_context_t *tcp, tcp_conn_t *conn,
+                      const knotd_qdata_params_t *params, tcp_result_t *res)
+{
+	uint8_t *rx = tcp->iov[0].iov_base;
+	size_t rx_len = conn->rx_len;
+	if (rx_len > 0) {
+		memcpy(rx, conn->rx, rx_len);
+	}
+
+	/* Receive what's available, an incomplete message is continued. */
+	ssize_t recv_len = recv_avail(params->socket, params->tls_conn, rx + rx_len,
+	                              TCP_RX_SIZE - rx_len);
+	if (recv_len < 0) {
+		return KNOT_EOF;
+	} else if (recv_len == 0 && !tcp_rx_ready(conn)) {
+		return KNOT_EOK;
+	}
+	rx_len += recv_len;
+
+	free(conn->rx);
+	conn->rx = NULL;
+	conn->rx_len = 0;
+
+	return tcp_process(tcp, conn, params, rx, rx_len, res);
+}
+
+/*!
+ * \brief Continue the DoT handshake, receive and process the DoT messages.
+ *
+ * The TLS context has zero timeouts, so the session never blocks and
+ * the messages are handled with the same connection state as plain TCP.
+ *
+ * \see tcp_handle
+ */
+static int tcp_handle_tls(tcp_context_t *tcp, tcp_conn_t *conn,
+                          const knotd_qdata_params_t *params, tcp_result_t *res)
+{
+	knot_tls_conn_t *tls = conn->tls_conn;
+
+	/* The session belongs to the update event until it sends the response. */
+	if (tls->flags & KNOT_TLS_CONN_BLOCKED) {
+		return KNOT_EOF;
+	}
+
+	conn->tls_write = false;
+	int ret = knot_tls_handshake(tls, true);
+	switch (ret) {
+	case KNOT_EOK:          // Finished handshake, continue with receiving messages.
+		break;
+	case KNOT_NET_EAGAIN:   // Unfinished handshake, continue later.
+		conn->tls_write = (gnutls_record_get_direction(tls->session) == 1);
+		return KNOT_EOK;
+	case KNOT_NET_ECONNECT: // Socket not writable, continue later.
+		conn->tls_write = true;
+		return KNOT_EOK;
+	default:                // E.g. failed handshake.
+		assert(ret < 0);
+		return KNOT_EOF;
+	}
+
+	/* Decrypted data left in the session doesn't make the socket readable. */
+	do {
+		ret = tcp_handle(tcp, conn, params, res);
+	} while (ret == KNOT_EOK && conn->tx_len == 0 &&
+	         !(tls->flags & KNOT_TLS_CONN_BLOCKED) &&
+	         gnutls_record_check_pending(tls->session) > 0);
+
+	return ret;
+}
+
+/*!
+ * \brief Update the watched events and the watchdog after connection activity.
+ *
+ * Reading is suspended while there are responses waiting or the DoT handshake
+ * waits for the socket to be writable. The IO timeout applies since
+ * an incomplete message, unsent responses, or an unfinished handshake appear
+ * until they are completed, the idle timeout applies otherwise.
+ */
+static int tcp_update_watch(tcp_context_t *tcp, unsigned idx, tcp_conn_t *conn,
+                            bool progress)
+{
+	bool write = (conn->tx_len > 0 || conn->tls_write);
+	int ret = fdset_set_events(&tcp->set, idx, write ? FDSET_POLLOUT : FDSET_POLLIN);
+	if (ret != KNOT_EOK) {
+		return ret;
+	}
+
+	if (!tcp_conn_pending(conn)) {
+		(void)fdset_set_watchdog(&tcp->set, idx, tcp->idle_timeout);
+		conn->io_watch = false;
+	} else if (!conn->io_watch || progress) {
+		int timeout = tcp->idle_timeout;
+		if (tcp->io_timeout > 0) {
+			timeout = MAX(1, (tcp->io_timeout + 999) / 1000); // Seconds precision.
+		}
+		(void)fdset_set_watchdog(&tcp->set, idx, timeout);
+		conn->io_watch = true;
+	}
+
 	return KNOT_EOK;
 }
 
@@ -241,48 +701,94 @@ static void tcp_event_accept(tcp_context_t *tcp, unsigned i, const iface_t *ifac
 {
 	/* Accept client. */
 	int fd = fdset_get_fd(&tcp->set, i);
-	int client = net_accept(fd, NULL);
+	struct sockaddr_storage remote;
+	int client = net_accept(fd, &remote);
 	if (client >= 0) {
+		tcp_conn_t *conn = calloc(1, sizeof(*conn));
+		if (conn == NULL) {
+			close(client);
+			return;
+		}
+
+		/* Get the addresses once for the whole connection. */
+		if (iface->addr.ss_family == AF_UNIX) {
+			memcpy(&conn->remote, &iface->addr, sizeof(conn->remote));
+		} else {
+			memcpy(&conn->remote, &remote, sizeof(conn->remote));
+		}
+		socklen_t local_len = sizeof(conn->local);
+		if (!iface->anyaddr ||
+		    getsockname(client, (struct sockaddr *)&conn->local, &local_len) != 0) {
+			memcpy(&conn->local, &iface->addr, sizeof(conn->local));
+		}
+
 		/* Assign to fdset. */
 		int idx = fdset_add(&tcp->set, client, FDSET_POLLIN, (void *)iface);
 		if (idx < 0) {
+			free(conn);
 			close(client);
 			return;
 		}
+		*fdset_ctx2(&tcp->set, idx) = conn;
 
 		/* Update watchdog timer. */
 		(void)fdset_set_watchdog(&tcp->set, idx, tcp->idle_timeout);
 	}
 }
 
-static int tcp_event_serve(tcp_context_t *tcp, unsigned i, const iface_t *iface)
+/*!
+ * \brief Continue sending the responses waiting in the connection.
+ */
+static int tcp_send_tx(tcp_conn_t *conn, int fd, tcp_result_t *res)
 {
-	int fd = fdset_get_fd(&tcp->set, i);
+	if (conn->tx_len == 0) {
+		return KNOT_EOK;
+	}
 
-	/* Get local address. */
-	sockaddr_t *local = (sockaddr_t *)&iface->addr;
-	sockaddr_t local_buf;
-	if (iface->anyaddr) {
-		socklen_t local_len = sizeof(local_buf);
-		if (getsockname(fd, &local_buf.ip, &local_len) == 0) {
-			local = &local_buf;
-		}
+	ssize_t sent = send_avail(fd, conn->tls_conn, conn->tx + conn->tx_sent,
+	                          conn->tx_len - conn->tx_sent);
+	if (sent < 0) {
+		return KNOT_EOF;
+	}
+	conn->tx_sent += sent;
+	res->progress = (sent > 0);
+
+	if (conn->tx_sent == conn->tx_len) {
+		free(conn->tx);
+		conn->tx = NULL;
+		conn->tx_len = 0;
+		conn->tx_sent = 0;
 	}
 
-	/* Get remote address. */
-	sockaddr_t *remote = (sockaddr_t *)&iface->addr;
-	sockaddr_t remote_buf;
-	if (iface->addr.ss_family != AF_UNIX) {
-		socklen_t remote_len = sizeof(remote_buf);
-		if (getpeername(fd, &remote_buf.ip, &remote_len) == 0) {
-			remote = &remote_buf;
+	return KNOT_EOK;
+}
+
+static int tcp_event_serve(tcp_context_t *tcp, unsigned i, const iface_t *iface,
+                           bool writable, tcp_result_t *res)
+{
+	int fd = fdset_get_fd(&tcp->set, i);
+	tcp_conn_t *conn = *fdset_ctx2(&tcp->set, i);
+	assert(conn);
+
+	/* Send the waiting responses first, then continue with the messages
+	   received meanwhile or with the handshake. */
+	if (writable) {
+		int ret = tcp_send_tx(conn, fd, res);
+		if (ret != KNOT_EOK) {
+			return ret;
+		}
+		bool resume = tcp_rx_ready(conn) || conn->tls_write ||
+		              (conn->tls_conn != NULL &&
+		               gnutls_record_check_pending(conn->tls_conn->session) > 0);
+		if (conn->tx_len > 0 || !resume) {
+			return tcp_update_watch(tcp, i, conn, res->progress);
 		}
 	}
 
 	knotd_qdata_params_t params = params_init(iface->tls ? KNOTD_QUERY_PROTO_TLS
 	                                                     : KNOTD_QUERY_PROTO_TCP,
-	                                          remote, local, fd, tcp->server,
-	                                          tcp->thread_id);
+	                                          &conn->remote, &conn->local, fd,
+	                                          tcp->server, tcp->thread_id);
 
 	// NOTE there is no way to avoid calling accept() on unwanted connections:
 	// - it's not possible to read out the remote IP beforehand
@@ -293,24 +799,26 @@ static int tcp_event_serve(tcp_context_t *tcp, unsigned i, const iface_t *iface)
 		return KNOT_EDENIED; // results in closing connection
 	}
 
-	/* Establish a TLS session. */
+	int ret;
 	if (iface->tls) {
+		/* Establish a TLS session. */
 		assert(tcp->tls_ctx != NULL);
-		knot_tls_conn_t *tls_conn = *fdset_ctx2(&tcp->set, i);
-		if (tls_conn == NULL) {
-			tls_conn = knot_tls_conn_new(tcp->tls_ctx, fd);
-			if (tls_conn == NULL) {
+		if (conn->tls_conn == NULL) {
+			conn->tls_conn = knot_tls_conn_new(tcp->tls_ctx, fd);
+			if (conn->tls_conn == NULL) {
 				return KNOT_ENOMEM;
 			}
-			*fdset_ctx2(&tcp->set, i) = tls_conn;
 		}
-		params_update_tls(&params, tls_conn);
-	}
+		/* The AUTH flag is applied per message, see tcp_process(). */
+		params.tls_conn = conn->tls_conn;
 
-	int ret = tcp_handle(tcp, &params, &tcp->iov[0], &tcp->iov[1]);
-	if (ret == KNOT_EOK) {
+		ret = tcp_handle_tls(tcp, conn, &params, res);
+	} else {
+		ret = tcp_handle(tcp, conn, &params, res);
+	}
+	if (ret == KNOT_EOK && !res->xfr) {
 		/* Update socket activity timer. */
-		(void)fdset_set_watchdog(&tcp->set, i, tcp->idle_timeout);
+		ret = tcp_update_watch(tcp, i, conn, res->progress);
 	}
 
 	(void)process_query_proto(&params, KNOTD_STAGE_PROTO_END);
@@ -318,16 +826,193 @@ static int tcp_event_serve(tcp_context_t *tcp, unsigned i, const iface_t *iface)
 	return ret;
 }
 
+static int tcp_xfr_flush(tcp_xfr_t *xfr)
+{
+	tcp_conn_t *conn = xfr->conn;
+	if (conn->tx_len == 0) {
+		return KNOT_EOK;
+	}
+
+	size_t len = conn->tx_len - conn->tx_sent;
+	ssize_t sent = net_stream_send(xfr->fd, conn->tx + conn->tx_sent, len,
+	                               xfr->io_timeout);
+	free(conn->tx);
+	conn->tx = NULL;
+	conn->tx_len = 0;
+	conn->tx_sent = 0;
+
+	if (sent != (ssize_t)len) {
+		tcp_log_error(&conn->remote, "send", sent, xfr->server);
+		return KNOT_EOF;
+	}
+
+	return KNOT_EOK;
+}
+
+static int tcp_xfr_serve(tcp_context_t *tcp, tcp_xfr_t *xfr)
+{
+	tcp_conn_t *conn = xfr->conn;
+	knotd_qdata_params_t params = params_init(KNOTD_QUERY_PROTO_TCP,
+	                                          &conn->remote, &conn->local, xfr->fd,
+	                                          tcp->server, tcp->thread_id);
+
+	/* Finish sending of the responses preceding the transfer. */
+	int ret = tcp_xfr_flush(xfr);
+	if (ret != KNOT_EOK) {
+		return ret;
+	}
+
+	/* Account the transfer processing as in tcp_event_serve(). */
+	if (process_query_proto(&params, KNOTD_STAGE_PROTO_BEGIN) == KNOTD_PROTO_STATE_BLOCK) {
+		return KNOT_EDENIED; // results in closing connection
+	}
+
+	/* Process the transfer query and the messages received with it, continue
+	   after the responses which didn't fit into the socket are sent. */
+	tcp_result_t res = { 0 };
+	do {
+		uint8_t *rx = conn->rx;
+		size_t rx_len = conn->rx_len;
+		conn->rx = NULL;
+		conn->rx_len = 0;
+
+		ret = tcp_process(tcp, conn, &params, rx, rx_len, &res);
+		free(rx);
+		if (ret == KNOT_EOK) {
+			ret = tcp_xfr_flush(xfr);
+		}
+	} while (ret == KNOT_EOK && tcp_rx_ready(conn));
+
+	(void)process_query_proto(&params, KNOTD_STAGE_PROTO_END);
+
+	return ret;
+}
+
+/*!
+ * \brief Serve the handed over connection in a transfer worker.
+ *
+ * Socket IO may block within the IO timeout here as in the TCP workers
+ * without transfer workers. The connection is then returned to its TCP worker.
+ */
+static void tcp_xfr_run(xfr_job_t *job, unsigned thread_id)
+{
+	tcp_xfr_t *xfr = (tcp_xfr_t *)job;
+
+	knot_mm_t mm;
+	mm_ctx_mempool(&mm, 16 * MM_DEFAULT_BLKSIZE);
+
+	tcp_context_t tcp = {
+		.server = xfr->server,
+		.thread_id = thread_id,
+		.io_timeout = xfr->io_timeout,
+	};
+	knot_layer_init(&tcp.layer, &mm, process_query_layer());
+
+	tcp.iov[1].iov_len = KNOT_WIRE_MAX_PKTSIZE;
+	tcp.iov[1].iov_base = malloc(tcp.iov[1].iov_len);
+	tcp.out = malloc(TCP_OUT_SIZE);
+
+	int ret = KNOT_ENOMEM;
+	if (tcp.iov[1].iov_base != NULL && tcp.out != NULL) {
+		ret = tcp_xfr_serve(&tcp, xfr);
+	}
+
+	free(tcp.iov[1].iov_base);
+	free(tcp.out);
+	mp_delete(mm.ctx);
+
+	if (ret != KNOT_EOK) {
+		close(xfr->fd);
+		tcp_conn_free(xfr->conn);
+		xfr->conn = NULL;
+		xfr->closed = true;
+	}
+}
+
+static void tcp_xfr_drop(xfr_job_t *job, _unused_ unsigned thread_id)
+{
+	tcp_xfr_t *xfr = (tcp_xfr_t *)job;
+	if (!xfr->closed) {
+		close(xfr->fd);
+		tcp_conn_free(xfr->conn);
+	}
+	free(xfr);
+}
+
+static int tcp_xfr_handover(tcp_context_t *tcp, unsigned i, const iface_t *iface,
+                            const tcp_result_t *res)
+{
+	tcp_xfr_t *xfr = calloc(1, sizeof(*xfr));
+	if (xfr == NULL) {
+		return KNOT_ENOMEM;
+	}
+
+	/* The original socket gets closed when removed from the set. */
+	xfr->fd = dup(fdset_get_fd(&tcp->set, i));
+	if (xfr->fd < 0) {
+		free(xfr);
+		return knot_map_errno();
+	}
+
+	xfr->server = tcp->server;
+	xfr->iface = iface;
+	xfr->conn = *fdset_ctx2(&tcp->set, i);
+	xfr->io_timeout = tcp->io_timeout;
+	memcpy(xfr->job.zone, res->zone, knot_dname_size(res->zone));
+	memcpy(&xfr->job.client, &xfr->conn->remote, sizeof(xfr->job.client));
+	xfr->job.owner = tcp->xfr_owner;
+	xfr->job.run = tcp_xfr_run;
+	xfr->job.drop = tcp_xfr_drop;
+
+	*fdset_ctx2(&tcp->set, i) = NULL;
+	tcp->xfr_count++;
+	xfr_pool_submit(tcp->xfr_pool, &xfr->job);
+
+	return KNOT_EOK;
+}
+
+static void tcp_event_xfr_done(tcp_context_t *tcp)
+{
+	list_t done;
+	xfr_pool_done(tcp->xfr_pool, tcp->xfr_owner, &done);
+
+	xfr_job_t *job, *nxt;
+	WALK_LIST_DELSAFE(job, nxt, done) {
+		tcp_xfr_t *xfr = (tcp_xfr_t *)job;
+		assert(tcp->xfr_count > 0);
+		tcp->xfr_count--;
+
+		/* Continue serving the connection. */
+		if (!xfr->closed) {
+			int idx = fdset_add(&tcp->set, xfr->fd, FDSET_POLLIN, (void *)xfr->iface);
+			if (idx < 0) {
+				close(xfr->fd);
+				tcp_conn_free(xfr->conn);
+			} else {
+				*fdset_ctx2(&tcp->set, idx) = xfr->conn;
+				xfr->conn->io_watch = false;
+				(void)tcp_update_watch(tcp, idx, xfr->conn, true);
+			}
+		}
+		free(xfr);
+	}
+}
+
 static void tcp_wait_for_events(tcp_context_t *tcp)
 {
 	fdset_t *set = &tcp->set;
 
 	/* Check if throttled with many open TCP connections. */
-	assert(fdset_get_length(set) <= tcp->max_worker_fds);
-	tcp->is_throttled = fdset_get_length(set) == tcp->max_worker_fds;
+	size_t clients = fdset_get_length(set) + tcp->xfr_count;
+	assert(clients <= tcp->max_worker_fds);
+	tcp->is_throttled = clients == tcp->max_worker_fds;
 
 	/* If throttled, temporarily ignore new TCP connections. */
-	unsigned offset = tcp->is_throttled ? tcp->client_threshold : 0;
+	unsigned offset = 0;
+	if (tcp->is_throttled) {
+		/* Keep watching the finished transfers (the last master socket). */
+		offset = tcp->client_threshold - (tcp->xfr_pool != NULL ? 1 : 0);
+	}
 
 	/* Wait for events. */
 	fdset_it_t it;
@@ -342,25 +1027,37 @@ static void tcp_wait_for_events(tcp_context_t *tcp)
 		unsigned int idx = fdset_it_get_idx(&it);
 		if (fdset_it_is_error(&it)) {
 			should_close = (idx >= tcp->client_threshold);
-		} else if (fdset_it_is_pollin(&it)) {
+		} else if (fdset_it_is_pollin(&it) || fdset_it_is_pollout(&it)) {
 			const iface_t *iface = fdset_it_get_ctx(&it);
-			assert(iface);
+			tcp_result_t res = { 0 };
+			/* Transfer workers - handed over connections to continue with. */
+			if (iface == NULL) {
+				assert(tcp->xfr_pool != NULL && idx < tcp->client_threshold);
+				tcp_event_xfr_done(tcp);
 			/* Master sockets - new connection to accept. */
-			if (idx < tcp->client_threshold) {
+			} else if (idx < tcp->client_threshold) {
 				/* Don't accept more clients than configured. */
-				if (fdset_get_length(set) < tcp->max_worker_fds) {
+				if (fdset_get_length(set) + tcp->xfr_count < tcp->max_worker_fds) {
 					tcp_event_accept(tcp, idx, iface);
 				}
-			/* Client sockets - already accepted connection or
-			   closed connection :-( */
-			} else if (tcp_event_serve(tcp, idx, iface) != KNOT_EOK) {
+			/* Client sockets - already accepted connection, responses
+			   waiting to be sent, or closed connection :-( */
+			} else if (tcp_event_serve(tcp, idx, iface, fdset_it_is_pollout(&it),
+			                           &res) != KNOT_EOK) {
 				should_close = true;
+			/* Client sockets - transfer to be handed over. */
+			} else if (res.xfr) {
+				if (tcp_xfr_handover(tcp, idx, iface, &res) == KNOT_EOK) {
+					fdset_it_remove(&it); // The connection state is handed over.
+				} else {
+					should_close = true;
+				}
 			}
 		}
 
 		/* Evaluate. */
 		if (should_close) {
-			free_tls_ctx(set, idx);
+			free_conn(set, idx);
 			fdset_it_remove(&it);
 		}
 	}
@@ -404,12 +1101,17 @@ int tcp_master(dthread_t *thread)
 	/* Create iovec abstraction. */
 	for (unsigned i = 0; i < 2; ++i) {
 		tcp.iov[i].iov_len = KNOT_WIRE_MAX_PKTSIZE;
-		tcp.iov[i].iov_base = malloc(tcp.iov[i].iov_len);
+		tcp.iov[i].iov_base = malloc(i == 0 ? TCP_RX_SIZE : tcp.iov[i].iov_len);
 		if (tcp.iov[i].iov_base == NULL) {
 			ret = KNOT_ENOMEM;
 			goto finish;
 		}
 	}
+	tcp.out = malloc(TCP_OUT_SIZE);
+	if (tcp.out == NULL) {
+		ret = KNOT_ENOMEM;
+		goto finish;
+	}
 
 	/* Prepare initial buffer for listening and bound sockets. */
 	if (fdset_init(&tcp.set, FDSET_RESIZE_STEP) != KNOT_EOK) {
@@ -426,6 +1128,18 @@ int tcp_master(dthread_t *thread)
 		goto finish; /* Terminate on zero interfaces. */
 	}
 
+	/* Watch for connections returned from the transfer workers. */
+	tcp.xfr_pool = handler->server->xfr_pool;
+	if (tcp.xfr_pool != NULL) {
+		tcp.xfr_owner = dt_get_id(thread);
+		int fd = xfr_pool_done_fd(tcp.xfr_pool, tcp.xfr_owner);
+		if (fdset_add(&tcp.set, fd, FDSET_POLLIN, NULL) < 0) {
+			ret = KNOT_ENOMEM;
+			goto finish;
+		}
+		tcp.client_threshold++;
+	}
+
 	/* Initialize sweep interval and TCP configuration. */
 	struct timespec next_sweep;
 	update_sweep_timer(&next_sweep);
@@ -433,9 +1147,8 @@ int tcp_master(dthread_t *thread)
 
 	/* Initialize TLS context. */
 	if (tls) {
-		// Set the HS timeout to 8x the RMT IO one as the HS duration can be up to 4*roundtrip.
-		tcp.tls_ctx = knot_tls_ctx_new(handler->server->quic_creds,
-		                               tcp.io_timeout, 8 * tcp.io_timeout, true);
+		// Zero timeouts, the sessions never block and the watchdog applies the IO timeout.
+		tcp.tls_ctx = knot_tls_ctx_new(handler->server->quic_creds, 0, 0, true);
 		if (tcp.tls_ctx == NULL) {
 			ret = KNOT_ENOMEM;
 			goto finish;
@@ -463,10 +1176,11 @@ finish:
 	knot_tls_ctx_free(tcp.tls_ctx);
 	free(tcp.iov[0].iov_base);
 	free(tcp.iov[1].iov_base);
+	free(tcp.out);
 	mp_delete(mm.ctx);
 
 	for (int i = 0; i < tcp.set.n; i++) {
-		free_tls_ctx(&tcp.set, i);
+		free_conn(&tcp.set, i);
 	}
 	fdset_clear(&tcp.set);
 
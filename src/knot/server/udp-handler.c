@@ -25,12 +25,16 @@
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
+#include <netinet/udp.h>
 #include <arpa/inet.h>
 #include <sys/param.h>
 #ifdef HAVE_SYS_UIO_H	// struct iovec (OpenBSD)
 #include <sys/uio.h>
 #endif /* HAVE_SYS_UIO_H */
 #include <unistd.h>
+#ifdef ENABLE_IO_URING
+#include <liburing.h>
+#endif /* ENABLE_IO_URING */
 
 #include "contrib/mempattern.h"
 #include "contrib/net.h"
@@ -85,7 +89,7 @@ static void udp_handler(udp_context_t *udp, knotd_qdata_params_t *params,
 }
 
 typedef struct {
-	void* (*udp_init)(udp_context_t *, void *);
+	void* (*udp_init)(udp_context_t *, fdset_t *, void *);
 	void (*udp_deinit)(void *);
 	int (*udp_recv)(int, void *);
 	void (*udp_handle)(udp_context_t *, const iface_t *, void *);
@@ -191,7 +195,8 @@ typedef struct {
 	cmsg_buf_t cmsgs;
 } udp_msg_ctx_t;
 
-static void *udp_msg_init(_unused_ udp_context_t *ctx, _unused_ void *xdp_sock)
+static void *udp_msg_init(_unused_ udp_context_t *ctx, _unused_ fdset_t *fds,
+                          _unused_ void *xdp_sock)
 {
 	udp_msg_ctx_t *rq = calloc(1, sizeof(*rq));
 	if (rq == NULL) {
@@ -289,6 +294,18 @@ static udp_api_t udp_msg_api = {
 };
 
 #ifdef ENABLE_RECVMMSG
+#if defined(UDP_SEGMENT) && defined(UDP_GRO)
+#define ENABLE_UDP_GSO
+#define GSO_MAX_SEGMENT	1400  /*!< Max coalesced reply size to stay below the usual MTU. */
+#define GSO_MAX_SIZE	65000 /*!< Max total size of the coalesced replies. */
+
+/*! \brief Control message to fit IP_PKTINFO/IPv6_RECVPKTINFO and UDP_SEGMENT. */
+typedef union {
+	struct cmsghdr cmsg;
+	uint8_t buf[sizeof(cmsg_buf_t) + CMSG_SPACE(sizeof(uint16_t))];
+} gso_cmsg_buf_t;
+#endif
+
 typedef struct {
 	int fd;
 	unsigned rcvd;
@@ -297,9 +314,195 @@ typedef struct {
 	uint8_t iobuf[NBUFS][RECVMMSG_BATCHLEN][KNOT_WIRE_MAX_PKTSIZE];
 	sockaddr_t addrs[RECVMMSG_BATCHLEN];
 	cmsg_buf_t cmsgs[RECVMMSG_BATCHLEN];
+#ifdef ENABLE_UDP_GSO
+	bool gso;                                     /*!< UDP_SEGMENT supported. */
+	bool coalesce;                                /*!< Coalesce the current batch. */
+	struct mmsghdr gso_msgs[RECVMMSG_BATCHLEN];   /*!< Possibly coalesced replies. */
+	struct iovec gso_iov[RECVMMSG_BATCHLEN];
+	gso_cmsg_buf_t gso_cmsgs[RECVMMSG_BATCHLEN];
+	unsigned gso_first[RECVMMSG_BATCHLEN];        /*!< First reply in each message. */
+	unsigned gso_count[RECVMMSG_BATCHLEN];        /*!< Number of replies in each message. */
+	uint8_t gro_buf[KNOT_WIRE_MAX_PKTSIZE];       /*!< Reply to a GRO segment. */
+#endif // ENABLE_UDP_GSO
 } udp_mmsg_ctx_t;
 
-static void *udp_mmsg_init(_unused_ udp_context_t *ctx, _unused_ void *xdp_sock)
+#ifdef ENABLE_UDP_GSO
+static void udp_gso_setup(udp_mmsg_ctx_t *rq, fdset_t *fds)
+{
+	for (unsigned i = 0; i < fdset_get_length(fds); i++) {
+		const iface_t *iface = fds->ctx[i];
+		int fd = fdset_get_fd(fds, i);
+		if (iface->tls) {
+			continue;
+		}
+
+		/* Check if the kernel supports UDP_SEGMENT (Linux 4.18+). */
+		int val = 0;
+		socklen_t len = sizeof(val);
+		if (getsockopt(fd, IPPROTO_UDP, UDP_SEGMENT, &val, &len) == 0) {
+			rq->gso = true;
+		}
+
+		/* Let the kernel coalesce incoming datagrams if supported (Linux 5.0+). */
+		const int on = 1;
+		(void)setsockopt(fd, IPPROTO_UDP, UDP_GRO, &on, sizeof(on));
+	}
+}
+
+/*! \brief Return the GRO segment size and remove the UDP_GRO control message. */
+static size_t udp_gro_strip(struct msghdr *rx)
+{
+	for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(rx); cmsg != NULL;
+	     cmsg = CMSG_NXTHDR(rx, cmsg)) {
+		if (cmsg->cmsg_level != IPPROTO_UDP || cmsg->cmsg_type != UDP_GRO) {
+			continue;
+		}
+
+		int segment;
+		memcpy(&segment, CMSG_DATA(cmsg), sizeof(segment));
+
+		/* Not accepted in outgoing messages, drop it. */
+		uint8_t *start = (uint8_t *)cmsg;
+		uint8_t *end = (uint8_t *)rx->msg_control + rx->msg_controllen;
+		size_t cmsg_space = MIN(CMSG_SPACE(sizeof(int)), end - start);
+		memmove(start, start + cmsg_space, end - start - cmsg_space);
+		rx->msg_controllen -= cmsg_space;
+
+		return MAX(segment, 0);
+	}
+
+	return 0;
+}
+
+static bool udp_gso_joinable(const struct msghdr *a, const struct msghdr *b)
+{
+	return a->msg_controllen == b->msg_controllen &&
+	       memcmp(a->msg_control, b->msg_control, a->msg_controllen) == 0 &&
+	       sockaddr_cmp(a->msg_name, b->msg_name, false) == 0;
+}
+
+static void udp_gso_cmsg_add(struct msghdr *msg, gso_cmsg_buf_t *buf, uint16_t segment)
+{
+	size_t len = CMSG_ALIGN(msg->msg_controllen);
+	if (msg->msg_controllen > 0) {
+		memcpy(buf->buf, msg->msg_control, msg->msg_controllen);
+	}
+
+	struct cmsghdr *cmsg = (struct cmsghdr *)(buf->buf + len);
+	cmsg->cmsg_level = IPPROTO_UDP;
+	cmsg->cmsg_type = UDP_SEGMENT;
+	cmsg->cmsg_len = CMSG_LEN(sizeof(segment));
+	memcpy(CMSG_DATA(cmsg), &segment, sizeof(segment));
+
+	msg->msg_control = buf->buf;
+	msg->msg_controllen = len + CMSG_SPACE(sizeof(segment));
+}
+
+/*! \brief Merge consecutive equally sized replies to the same peer. */
+static unsigned udp_gso_coalesce(udp_mmsg_ctx_t *rq)
+{
+	unsigned n = 0;
+	for (unsigned i = 0; i < rq->rcvd; n++) {
+		const struct msghdr *first = &rq->msgs[TX][i].msg_hdr;
+		size_t segment = first->msg_iov->iov_len;
+		size_t total = segment;
+
+		unsigned k = i + 1;
+		while (segment <= GSO_MAX_SEGMENT && k < rq->rcvd) {
+			const struct msghdr *next = &rq->msgs[TX][k].msg_hdr;
+			size_t len = next->msg_iov->iov_len;
+			if (len > segment || total + len > GSO_MAX_SIZE ||
+			    !udp_gso_joinable(first, next)) {
+				break;
+			}
+			total += len;
+			k++;
+			if (len < segment) { // Only the last segment can be shorter.
+				break;
+			}
+		}
+
+		struct msghdr *msg = &rq->gso_msgs[n].msg_hdr;
+		*msg = *first;
+		if (k - i > 1) {
+			for (unsigned j = i; j < k; j++) {
+				rq->gso_iov[j] = *rq->msgs[TX][j].msg_hdr.msg_iov;
+			}
+			msg->msg_iov = &rq->gso_iov[i];
+			msg->msg_iovlen = k - i;
+			udp_gso_cmsg_add(msg, &rq->gso_cmsgs[n], segment);
+		}
+		rq->gso_first[n] = i;
+		rq->gso_count[n] = k - i;
+		i = k;
+	}
+
+	return n;
+}
+
+static void udp_gso_send(udp_mmsg_ctx_t *rq)
+{
+	unsigned count = udp_gso_coalesce(rq);
+	unsigned sent = 0;
+	while (sent < count) {
+		int ret = sendmmsg(rq->fd, &rq->gso_msgs[sent], count - sent, 0);
+		if (ret > 0) {
+			sent += ret;
+			continue;
+		}
+
+		/* Coalesced replies can be refused (e.g. exceeding the path MTU),
+		 * send them individually. */
+		if (rq->gso_count[sent] > 1) {
+			ret = sendmmsg(rq->fd, &rq->msgs[TX][rq->gso_first[sent]],
+			               rq->gso_count[sent], 0);
+		}
+		if (ret == -1 && log_enabled_debug()) {
+			log_debug("UDP, failed to send some packets (%s)", strerror(errno));
+		}
+		sent++;
+	}
+}
+
+/*! \brief Process all but the last segment of a GRO coalesced datagram. */
+static void udp_gro_handle(udp_context_t *ctx, udp_mmsg_ctx_t *rq, const iface_t *iface,
+                           const sockaddr_t *remote, struct msghdr *rx,
+                           const struct msghdr *tx, size_t segment)
+{
+	struct iovec *rx_iov = rx->msg_iov;
+	uint8_t *pos = rx_iov->iov_base;
+	size_t left = rx_iov->iov_len;
+
+	while (left > segment) {
+		struct iovec seg = { .iov_base = pos, .iov_len = segment };
+		struct iovec out = { .iov_base = rq->gro_buf, .iov_len = sizeof(rq->gro_buf) };
+		const sockaddr_t *local = local_addr(&ctx->local, iface);
+
+		knotd_qdata_params_t params = params_init(KNOTD_QUERY_PROTO_UDP,
+			remote, local, rq->fd, ctx->server, ctx->thread_id);
+		udp_handler(ctx, &params, &seg, &out);
+
+		if (out.iov_len > 0) {
+			struct msghdr msg = *tx;
+			msg.msg_iov = &out;
+			msg.msg_iovlen = 1;
+			if (sendmsg(rq->fd, &msg, 0) == -1 && log_enabled_debug()) {
+				log_debug("UDP, failed to send a packet (%s)", strerror(errno));
+			}
+		}
+
+		pos += segment;
+		left -= segment;
+	}
+
+	/* The last segment is processed as a regular datagram. */
+	rx_iov->iov_base = pos;
+	rx_iov->iov_len = left;
+}
+#endif // ENABLE_UDP_GSO
+
+static void *udp_mmsg_init(_unused_ udp_context_t *ctx, _unused_ fdset_t *fds,
+                           _unused_ void *xdp_sock)
 {
 	udp_mmsg_ctx_t *rq = calloc(1, sizeof(*rq));
 	if (rq == NULL) {
@@ -319,6 +522,10 @@ static void *udp_mmsg_init(_unused_ udp_context_t *ctx, _unused_ void *xdp_sock)
 		}
 	}
 
+#ifdef ENABLE_UDP_GSO
+	udp_gso_setup(rq, fds);
+#endif // ENABLE_UDP_GSO
+
 	return rq;
 }
 
@@ -357,11 +564,21 @@ static void udp_mmsg_handle(udp_context_t *ctx, const iface_t *iface, void *d)
 		tx->msg_name = rx->msg_name;
 		tx->msg_namelen = rx->msg_namelen;
 
+#ifdef ENABLE_UDP_GSO
+		size_t gro_segment = iface->tls ? 0 : udp_gro_strip(rx);
+#endif // ENABLE_UDP_GSO
+
 		/* Update output message control buffer. */
 		int *p_ecn;
 		cmsg_handle(rx, tx, &ctx->local, &p_ecn, iface);
 		const sockaddr_t *local = local_addr(&ctx->local, iface);
 
+#ifdef ENABLE_UDP_GSO
+		if (gro_segment > 0 && rx->msg_iov->iov_len > gro_segment) {
+			udp_gro_handle(ctx, rq, iface, &rq->addrs[i], rx, tx, gro_segment);
+		}
+#endif // ENABLE_UDP_GSO
+
 		knotd_qdata_params_t params = params_init(
 			iface->tls ? KNOTD_QUERY_PROTO_QUIC : KNOTD_QUERY_PROTO_UDP,
 			&rq->addrs[i], local, rq->fd, ctx->server, ctx->thread_id);
@@ -385,20 +602,31 @@ static void udp_mmsg_handle(udp_context_t *ctx, const iface_t *iface, void *d)
 		}
 
 		/* Reset input context. */
+		rx->msg_iov->iov_base = rq->iobuf[RX][i];
 		rx->msg_iov->iov_len = sizeof(rq->iobuf[RX][i]);
 		rx->msg_namelen = sizeof(rq->addrs[i]);
 		rx->msg_controllen = sizeof(rq->cmsgs[i]);
 	}
 	rq->rcvd = j;
+#ifdef ENABLE_UDP_GSO
+	rq->coalesce = rq->gso && !iface->tls;
+#endif // ENABLE_UDP_GSO
 }
 
 static void udp_mmsg_send(void *d)
 {
 	udp_mmsg_ctx_t *rq = d;
 
-	int ret = sendmmsg(rq->fd, rq->msgs[TX], rq->rcvd, 0);
-	if (ret == -1 && log_enabled_debug()) {
-		log_debug("UDP, failed to send some packets (%s)", strerror(errno));
+#ifdef ENABLE_UDP_GSO
+	if (rq->coalesce) {
+		udp_gso_send(rq);
+	} else
+#endif // ENABLE_UDP_GSO
+	{
+		int ret = sendmmsg(rq->fd, rq->msgs[TX], rq->rcvd, 0);
+		if (ret == -1 && log_enabled_debug()) {
+			log_debug("UDP, failed to send some packets (%s)", strerror(errno));
+		}
 	}
 	for (unsigned i = 0; i < rq->rcvd; ++i) {
 		struct msghdr *tx = &rq->msgs[TX][i].msg_hdr;
@@ -418,8 +646,356 @@ static udp_api_t udp_mmsg_api = {
 };
 #endif /* ENABLE_RECVMMSG */
 
+#ifdef ENABLE_IO_URING
+#define URING_BGID	0                      /*!< Provided buffer group identifier. */
+#define URING_BUFS	64                     /*!< Number of provided RX buffers (power of 2). */
+#define URING_ENTRIES	(2 * URING_BUFS)       /*!< Submission queue size. */
+#define URING_TX_TAG	(UINT64_C(1) << 63)    /*!< CQE user data tag of sent messages. */
+#define URING_BUFSIZE	(sizeof(struct io_uring_recvmsg_out) + sizeof(sockaddr_t) + \
+			 sizeof(cmsg_buf_t) + KNOT_WIRE_MAX_PKTSIZE)
+
+/*! \brief Listening socket served by the ring. */
+typedef struct {
+	int fd;
+	const iface_t *iface;
+	bool armed;          /*!< Multishot receive is active. */
+} udp_uring_sock_t;
+
+/*! \brief Received datagram waiting for processing. */
+typedef struct {
+	const udp_uring_sock_t *sock;
+	unsigned bid;        /*!< Provided buffer identifier. */
+	unsigned len;        /*!< Used buffer length. */
+} udp_uring_rx_t;
+
+typedef struct {
+	struct io_uring ring;
+	struct io_uring_buf_ring *buf_ring;
+	uint8_t *bufs;
+	struct msghdr rx_tpl;           /*!< Multishot receive layout template. */
+	udp_uring_sock_t *socks;
+	unsigned nsocks;
+	udp_uring_rx_t pending[URING_BUFS]; /*!< Completed but unprocessed receives. */
+	unsigned pending_head;
+	unsigned pending_count;
+	udp_uring_rx_t batch[RECVMMSG_BATCHLEN];
+	unsigned rcvd;
+	unsigned tx_count;
+	unsigned tx_inflight;
+	struct {
+		int fd;
+		struct msghdr msg;
+		struct iovec iov;
+		sockaddr_t addr;
+		cmsg_buf_t cmsgs;
+	} tx[RECVMMSG_BATCHLEN];
+	uint8_t txbuf[RECVMMSG_BATCHLEN][KNOT_WIRE_MAX_PKTSIZE];
+} udp_uring_ctx_t;
+
+static uint8_t *uring_buf(udp_uring_ctx_t *rq, unsigned bid)
+{
+	return rq->bufs + (size_t)bid * URING_BUFSIZE;
+}
+
+static void uring_buf_recycle(udp_uring_ctx_t *rq, unsigned bid, int offset)
+{
+	io_uring_buf_ring_add(rq->buf_ring, uring_buf(rq, bid), URING_BUFSIZE, bid,
+	                      io_uring_buf_ring_mask(URING_BUFS), offset);
+}
+
+static struct io_uring_sqe *uring_get_sqe(udp_uring_ctx_t *rq)
+{
+	struct io_uring_sqe *sqe = io_uring_get_sqe(&rq->ring);
+	if (sqe == NULL) {
+		(void)io_uring_submit(&rq->ring);
+		sqe = io_uring_get_sqe(&rq->ring);
+	}
+	return sqe;
+}
+
+static void uring_arm(udp_uring_ctx_t *rq)
+{
+	for (unsigned i = 0; i < rq->nsocks; i++) {
+		udp_uring_sock_t *sock = &rq->socks[i];
+		if (sock->armed) {
+			continue;
+		}
+
+		struct io_uring_sqe *sqe = uring_get_sqe(rq);
+		if (sqe == NULL) {
+			return; // Retry during next sweep.
+		}
+		io_uring_prep_recvmsg_multishot(sqe, sock->fd, &rq->rx_tpl, 0);
+		sqe->flags |= IOSQE_BUFFER_SELECT;
+		sqe->buf_group = URING_BGID;
+		io_uring_sqe_set_data64(sqe, i);
+		sock->armed = true;
+	}
+}
+
+static void uring_reap(udp_uring_ctx_t *rq)
+{
+	struct io_uring_cqe *cqes[URING_BUFS];
+	unsigned count;
+	bool rearm = false;
+
+	while ((count = io_uring_peek_batch_cqe(&rq->ring, cqes, URING_BUFS)) > 0) {
+		for (unsigned i = 0; i < count; i++) {
+			struct io_uring_cqe *cqe = cqes[i];
+			uint64_t data = io_uring_cqe_get_data64(cqe);
+
+			if (data & URING_TX_TAG) {
+				assert(rq->tx_inflight > 0);
+				rq->tx_inflight--;
+				if (cqe->res < 0 && log_enabled_debug()) {
+					log_debug("UDP, failed to send a packet (%s)",
+					          strerror(-cqe->res));
+				}
+				continue;
+			}
+
+			assert(data < rq->nsocks);
+			udp_uring_sock_t *sock = &rq->socks[data];
+			if (!(cqe->flags & IORING_CQE_F_MORE)) {
+				/* Terminated multishot (e.g. out of buffers). */
+				sock->armed = false;
+				rearm = true;
+			}
+			if (cqe->res <= 0 || !(cqe->flags & IORING_CQE_F_BUFFER)) {
+				continue;
+			}
+
+			/* Each pending entry holds a provided buffer, so it can't overflow. */
+			assert(rq->pending_count < URING_BUFS);
+			unsigned idx = (rq->pending_head + rq->pending_count) % URING_BUFS;
+			rq->pending[idx] = (udp_uring_rx_t) {
+				.sock = sock,
+				.bid = cqe->flags >> IORING_CQE_BUFFER_SHIFT,
+				.len = cqe->res,
+			};
+			rq->pending_count++;
+		}
+		io_uring_cq_advance(&rq->ring, count);
+	}
+
+	if (rearm) {
+		uring_arm(rq);
+	}
+}
+
+static void *udp_uring_init(_unused_ udp_context_t *ctx, fdset_t *fds,
+                            _unused_ void *xdp_sock)
+{
+	udp_uring_ctx_t *rq = calloc(1, sizeof(*rq));
+	if (rq == NULL) {
+		return NULL;
+	}
+
+	struct io_uring_params params = {
+		.flags = IORING_SETUP_SINGLE_ISSUER | IORING_SETUP_COOP_TASKRUN,
+	};
+	int ret = io_uring_queue_init_params(URING_ENTRIES, &rq->ring, &params);
+	if (ret == -EINVAL) { // Older kernel without the optimization flags.
+		memset(&params, 0, sizeof(params));
+		ret = io_uring_queue_init_params(URING_ENTRIES, &rq->ring, &params);
+	}
+	if (ret < 0) {
+		free(rq);
+		return NULL;
+	}
+
+	rq->bufs = malloc(URING_BUFS * URING_BUFSIZE);
+	rq->socks = calloc(fdset_get_length(fds), sizeof(*rq->socks));
+	if (rq->bufs != NULL && rq->socks != NULL) {
+		rq->buf_ring = io_uring_setup_buf_ring(&rq->ring, URING_BUFS, URING_BGID,
+		                                       0, &ret);
+	}
+	if (rq->buf_ring == NULL) {
+		io_uring_queue_exit(&rq->ring);
+		free(rq->socks);
+		free(rq->bufs);
+		free(rq);
+		return NULL;
+	}
+	for (unsigned bid = 0; bid < URING_BUFS; bid++) {
+		uring_buf_recycle(rq, bid, bid);
+	}
+	io_uring_buf_ring_advance(rq->buf_ring, URING_BUFS);
+
+	rq->rx_tpl.msg_namelen = sizeof(sockaddr_t);
+	rq->rx_tpl.msg_controllen = sizeof(cmsg_buf_t);
+
+	for (unsigned i = 0; i < RECVMMSG_BATCHLEN; i++) {
+		rq->tx[i].iov.iov_base = rq->txbuf[i];
+		rq->tx[i].iov.iov_len = sizeof(rq->txbuf[i]);
+		rq->tx[i].msg.msg_iov = &rq->tx[i].iov;
+		rq->tx[i].msg.msg_iovlen = 1;
+		rq->tx[i].msg.msg_name = &rq->tx[i].addr;
+	}
+
+	for (unsigned i = 0; i < fdset_get_length(fds); i++) {
+		rq->socks[i].fd = fdset_get_fd(fds, i);
+		rq->socks[i].iface = fds->ctx[i];
+	}
+	rq->nsocks = fdset_get_length(fds);
+	uring_arm(rq);
+
+	return rq;
+}
+
+static void udp_uring_deinit(void *d)
+{
+	udp_uring_ctx_t *rq = d;
+
+	if (rq != NULL) {
+		(void)io_uring_free_buf_ring(&rq->ring, rq->buf_ring, URING_BUFS, URING_BGID);
+		io_uring_queue_exit(&rq->ring);
+		free(rq->socks);
+		free(rq->bufs);
+		free(rq);
+	}
+}
+
+static int udp_uring_recv(_unused_ int fd, void *d)
+{
+	udp_uring_ctx_t *rq = d;
+
+	if (rq->pending_count == 0) {
+		/* Submit the re-armed receives and wait for completions. */
+		struct __kernel_timespec ts = { .tv_sec = 1 };
+		struct io_uring_cqe *cqe;
+		if (io_uring_submit_and_wait_timeout(&rq->ring, &cqe, 1, &ts, NULL) < 0) {
+			return 0;
+		}
+	}
+	uring_reap(rq);
+
+	rq->rcvd = MIN(rq->pending_count, RECVMMSG_BATCHLEN);
+	for (unsigned i = 0; i < rq->rcvd; i++) {
+		rq->batch[i] = rq->pending[rq->pending_head];
+		rq->pending_head = (rq->pending_head + 1) % URING_BUFS;
+	}
+	rq->pending_count -= rq->rcvd;
+
+	return rq->rcvd;
+}
+
+static void udp_uring_handle(udp_context_t *ctx, _unused_ const iface_t *iface, void *d)
+{
+	udp_uring_ctx_t *rq = d;
+
+	unsigned j = 0;
+	for (unsigned i = 0; i < rq->rcvd; ++i) {
+		const udp_uring_rx_t *item = &rq->batch[i];
+		const iface_t *sock_iface = item->sock->iface;
+		uint8_t *buf = uring_buf(rq, item->bid);
+
+		struct io_uring_recvmsg_out *out =
+			io_uring_recvmsg_validate(buf, item->len, &rq->rx_tpl);
+		if (out == NULL || out->namelen > sizeof(sockaddr_t) ||
+		    (out->flags & MSG_TRUNC)) {
+			uring_buf_recycle(rq, item->bid, i);
+			continue;
+		}
+
+		/* Copy the address and control data as the buffer is recycled before sending. */
+		assert(!sock_iface->tls);
+		memcpy(&rq->tx[j].addr, io_uring_recvmsg_name(out), out->namelen);
+		struct cmsghdr *cmsg = io_uring_recvmsg_cmsg_firsthdr(out, &rq->rx_tpl);
+		size_t cmsg_len = 0;
+		if (cmsg != NULL) {
+			cmsg_len = out->controllen;
+			memcpy(rq->tx[j].cmsgs.buf, cmsg, cmsg_len);
+		}
+
+		struct iovec rx_iov = {
+			.iov_base = io_uring_recvmsg_payload(out, &rq->rx_tpl),
+			.iov_len = io_uring_recvmsg_payload_length(out, item->len, &rq->rx_tpl),
+		};
+		struct msghdr rx = {
+			.msg_name = &rq->tx[j].addr,
+			.msg_namelen = out->namelen,
+			.msg_iov = &rx_iov,
+			.msg_iovlen = 1,
+			.msg_control = rq->tx[j].cmsgs.buf,
+			.msg_controllen = cmsg_len,
+		};
+		struct msghdr *tx = &rq->tx[j].msg;
+		tx->msg_namelen = out->namelen;
+
+		int *p_ecn;
+		cmsg_handle(&rx, tx, &ctx->local, &p_ecn, sock_iface);
+		const sockaddr_t *local = local_addr(&ctx->local, sock_iface);
+
+		knotd_qdata_params_t params = params_init(KNOTD_QUERY_PROTO_UDP,
+			&rq->tx[j].addr, local, item->sock->fd, ctx->server, ctx->thread_id);
+		udp_handler(ctx, &params, &rx_iov, tx->msg_iov);
+
+		if (tx->msg_iov->iov_len > 0) {
+			rq->tx[j].fd = item->sock->fd;
+			j++;
+		} else {
+			/* Reset tainted output context. */
+			tx->msg_iov->iov_len = sizeof(rq->txbuf[j]);
+		}
+
+		uring_buf_recycle(rq, item->bid, i);
+	}
+	io_uring_buf_ring_advance(rq->buf_ring, rq->rcvd);
+	rq->tx_count = j;
+}
+
+static void udp_uring_send(void *d)
+{
+	udp_uring_ctx_t *rq = d;
+
+	for (unsigned i = 0; i < rq->tx_count; ++i) {
+		struct io_uring_sqe *sqe = uring_get_sqe(rq);
+		if (sqe == NULL) {
+			break;
+		}
+		io_uring_prep_sendmsg(sqe, rq->tx[i].fd, &rq->tx[i].msg, 0);
+		io_uring_sqe_set_data64(sqe, URING_TX_TAG | i);
+		rq->tx_inflight++;
+	}
+
+	/* Submit the whole batch at once and wait until the TX buffers are free. */
+	while (rq->tx_inflight > 0) {
+		int ret = io_uring_submit_and_wait(&rq->ring, 1);
+		if (ret < 0 && ret != -EINTR) {
+			log_debug("UDP, failed to submit packets (%s)", strerror(-ret));
+			break;
+		}
+		uring_reap(rq);
+	}
+
+	for (unsigned i = 0; i < rq->tx_count; ++i) {
+		/* Reset output context. */
+		rq->tx[i].iov.iov_len = sizeof(rq->txbuf[i]);
+	}
+	rq->tx_count = 0;
+}
+
+static void udp_uring_sweep(_unused_ udp_context_t *ctx, void *d)
+{
+	udp_uring_ctx_t *rq = d;
+
+	/* Re-arm the sockets whose multishot receive terminated. */
+	uring_arm(rq);
+}
+
+static udp_api_t udp_uring_api = {
+	udp_uring_init,
+	udp_uring_deinit,
+	udp_uring_recv,
+	udp_uring_handle,
+	udp_uring_send,
+	udp_uring_sweep,
+};
+#endif /* ENABLE_IO_URING */
+
 #ifdef ENABLE_XDP
-static void *xdp_mmsg_init(udp_context_t *ctx, void *xdp_sock)
+static void *xdp_mmsg_init(udp_context_t *ctx, _unused_ fdset_t *fds, void *xdp_sock)
 {
 	return xdp_handle_init(ctx->server, xdp_sock);
 }
@@ -607,10 +1183,32 @@ int udp_master(dthread_t *thread)
 	}
 #endif // ENABLE_QUIC
 
+	/* Switch to io_uring if configured and possible. */
+	if (!is_xdp_thread(handler->server, thread_id) &&
+	    conf()->cache.srv_udp_backend == UDP_BACKEND_IO_URING) {
+#ifdef ENABLE_IO_URING
+		if (!quic) {
+			api_ctx = udp_uring_api.udp_init(&udp, &fds, NULL);
+		}
+		if (api_ctx != NULL) {
+			api = &udp_uring_api;
+		} else if (dt_get_id(thread) == 0) {
+			log_warning("UDP, failed to initialize io_uring%s, using default backend",
+			            quic ? " together with QUIC" : "");
+		}
+#else
+		if (dt_get_id(thread) == 0) {
+			log_warning("UDP, io_uring not supported, using default backend");
+		}
+#endif /* ENABLE_IO_URING */
+	}
+
 	/* Initialize the networking API. */
-	api_ctx = api->udp_init(&udp, xdp_socket);
 	if (api_ctx == NULL) {
-		goto finish;
+		api_ctx = api->udp_init(&udp, &fds, xdp_socket);
+		if (api_ctx == NULL) {
+			goto finish;
+		}
 	}
 
 	/* Loop until all data is read. */
@@ -620,6 +1218,18 @@ int udp_master(dthread_t *thread)
 			break;
 		}
 
+#ifdef ENABLE_IO_URING
+		/* The ring waits for the sockets itself. */
+		if (api == &udp_uring_api) {
+			if (api->udp_recv(-1, api_ctx) > 0) {
+				api->udp_handle(&udp, NULL, api_ctx);
+				api->udp_send(api_ctx);
+			}
+			api->udp_sweep(&udp, api_ctx);
+			continue;
+		}
+#endif /* ENABLE_IO_URING */
+
 		/* Wait for events. */
 		fdset_it_t it;
 		(void)fdset_poll(&fds, &it, 0, 1000);
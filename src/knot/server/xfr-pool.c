@@ -0,0 +1,282 @@
+/*  Copyright (C) 2025 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <assert.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <urcu.h>
+
+#include "knot/server/xfr-pool.h"
+#include "contrib/sockaddr.h"
+
+/*! \brief Finished jobs of one TCP worker. */
+typedef struct {
+	list_t jobs;
+	int pipe[2];   // written when jobs are added, read by the TCP worker
+} xfr_owner_t;
+
+typedef struct {
+	xfr_pool_t *pool;
+	pthread_t thread;
+	unsigned thread_id;
+} xfr_worker_t;
+
+struct xfr_pool {
+	pthread_mutex_t lock;
+	pthread_cond_t wake;     // new job, finished job, changed limit, or stop
+
+	list_t queue;
+	list_t running;
+	unsigned zone_limit;
+	bool stop;
+
+	xfr_owner_t *owners;
+	unsigned n_owners;
+	xfr_worker_t *workers;
+	unsigned n_workers;
+};
+
+static unsigned count_running(xfr_pool_t *pool, const xfr_job_t *job, bool zone)
+{
+	unsigned count = 0;
+	xfr_job_t *it;
+	WALK_LIST(it, pool->running) {
+		if (zone ? knot_dname_is_equal(it->zone, job->zone)
+		         : sockaddr_cmp(&it->client, &job->client, true) == 0) {
+			count++;
+		}
+	}
+	return count;
+}
+
+/*!
+ * \brief Pick the oldest job of the client with the least running jobs,
+ *        among the jobs within the zone limit.
+ */
+static xfr_job_t *pick_job(xfr_pool_t *pool)
+{
+	xfr_job_t *best = NULL, *job;
+	unsigned best_count = 0;
+	WALK_LIST(job, pool->queue) {
+		if (pool->zone_limit > 0 &&
+		    count_running(pool, job, true) >= pool->zone_limit) {
+			continue;
+		}
+		unsigned count = count_running(pool, job, false);
+		if (best == NULL || count < best_count) {
+			best = job;
+			best_count = count;
+			if (count == 0) {
+				break;
+			}
+		}
+	}
+	return best;
+}
+
+static void *worker_thread(void *arg)
+{
+	xfr_worker_t *worker = arg;
+	xfr_pool_t *pool = worker->pool;
+
+	rcu_register_thread();
+
+	pthread_mutex_lock(&pool->lock);
+	while (!pool->stop) {
+		xfr_job_t *job = pick_job(pool);
+		if (job == NULL) {
+			pthread_cond_wait(&pool->wake, &pool->lock);
+			continue;
+		}
+		rem_node(&job->n);
+		add_tail(&pool->running, &job->n);
+		pthread_mutex_unlock(&pool->lock);
+
+		job->run(job, worker->thread_id);
+
+		pthread_mutex_lock(&pool->lock);
+		rem_node(&job->n);
+		xfr_owner_t *owner = &pool->owners[job->owner];
+		add_tail(&owner->jobs, &job->n);
+		uint8_t byte = 0;
+		if (write(owner->pipe[1], &byte, sizeof(byte)) < 0) {
+			// The pipe is full, thus the owner is going to be woken up anyway.
+		}
+		// Jobs skipped due to the zone limit may be picked now.
+		pthread_cond_broadcast(&pool->wake);
+	}
+	pthread_mutex_unlock(&pool->lock);
+
+	rcu_unregister_thread();
+
+	return NULL;
+}
+
+static void drop_jobs(list_t *jobs)
+{
+	xfr_job_t *job, *nxt;
+	WALK_LIST_DELSAFE(job, nxt, *jobs) {
+		rem_node(&job->n);
+		job->drop(job, 0);
+	}
+}
+
+static int owner_init(xfr_owner_t *owner)
+{
+	init_list(&owner->jobs);
+	if (pipe(owner->pipe) != 0) {
+		owner->pipe[0] = owner->pipe[1] = -1;
+		return -1;
+	}
+	for (int i = 0; i < 2; i++) {
+		if (fcntl(owner->pipe[i], F_SETFL, O_NONBLOCK) != 0 ||
+		    fcntl(owner->pipe[i], F_SETFD, FD_CLOEXEC) != 0) {
+			return -1;
+		}
+	}
+	return 0;
+}
+
+static void owner_deinit(xfr_owner_t *owner)
+{
+	drop_jobs(&owner->jobs);
+	for (int i = 0; i < 2; i++) {
+		if (owner->pipe[i] >= 0) {
+			close(owner->pipe[i]);
+		}
+	}
+}
+
+xfr_pool_t *xfr_pool_new(unsigned workers, unsigned first_thread_id, unsigned owners)
+{
+	if (workers == 0 || owners == 0) {
+		return NULL;
+	}
+
+	xfr_pool_t *pool = calloc(1, sizeof(*pool));
+	if (pool == NULL) {
+		return NULL;
+	}
+
+	pthread_mutex_init(&pool->lock, NULL);
+	pthread_cond_init(&pool->wake, NULL);
+	init_list(&pool->queue);
+	init_list(&pool->running);
+
+	pool->owners = calloc(owners, sizeof(*pool->owners));
+	pool->workers = calloc(workers, sizeof(*pool->workers));
+	if (pool->owners == NULL || pool->workers == NULL) {
+		xfr_pool_free(pool);
+		return NULL;
+	}
+
+	for (unsigned i = 0; i < owners; i++) {
+		pool->n_owners++;
+		if (owner_init(&pool->owners[i]) != 0) {
+			xfr_pool_free(pool);
+			return NULL;
+		}
+	}
+
+	for (unsigned i = 0; i < workers; i++) {
+		xfr_worker_t *worker = &pool->workers[i];
+		worker->pool = pool;
+		worker->thread_id = first_thread_id + i;
+		if (pthread_create(&worker->thread, NULL, worker_thread, worker) != 0) {
+			xfr_pool_free(pool);
+			return NULL;
+		}
+		pool->n_workers++;
+	}
+
+	return pool;
+}
+
+void xfr_pool_free(xfr_pool_t *pool)
+{
+	if (pool == NULL) {
+		return;
+	}
+
+	pthread_mutex_lock(&pool->lock);
+	pool->stop = true;
+	pthread_cond_broadcast(&pool->wake);
+	pthread_mutex_unlock(&pool->lock);
+
+	for (unsigned i = 0; i < pool->n_workers; i++) {
+		pthread_join(pool->workers[i].thread, NULL);
+	}
+
+	drop_jobs(&pool->queue);
+	for (unsigned i = 0; i < pool->n_owners; i++) {
+		owner_deinit(&pool->owners[i]);
+	}
+
+	pthread_cond_destroy(&pool->wake);
+	pthread_mutex_destroy(&pool->lock);
+	free(pool->workers);
+	free(pool->owners);
+	free(pool);
+}
+
+void xfr_pool_set_zone_limit(xfr_pool_t *pool, unsigned limit)
+{
+	if (pool == NULL) {
+		return;
+	}
+
+	pthread_mutex_lock(&pool->lock);
+	pool->zone_limit = limit;
+	pthread_cond_broadcast(&pool->wake);
+	pthread_mutex_unlock(&pool->lock);
+}
+
+void xfr_pool_submit(xfr_pool_t *pool, xfr_job_t *job)
+{
+	assert(job->owner < pool->n_owners);
+
+	pthread_mutex_lock(&pool->lock);
+	add_tail(&pool->queue, &job->n);
+	pthread_cond_signal(&pool->wake);
+	pthread_mutex_unlock(&pool->lock);
+}
+
+int xfr_pool_done_fd(xfr_pool_t *pool, unsigned owner)
+{
+	assert(owner < pool->n_owners);
+
+	return pool->owners[owner].pipe[0];
+}
+
+void xfr_pool_done(xfr_pool_t *pool, unsigned owner, list_t *done)
+{
+	assert(owner < pool->n_owners);
+	xfr_owner_t *own = &pool->owners[owner];
+
+	init_list(done);
+
+	pthread_mutex_lock(&pool->lock);
+	uint8_t buf[64];
+	while (read(own->pipe[0], buf, sizeof(buf)) > 0); /* nop */
+	xfr_job_t *job, *nxt;
+	WALK_LIST_DELSAFE(job, nxt, own->jobs) {
+		rem_node(&job->n);
+		add_tail(done, &job->n);
+	}
+	pthread_mutex_unlock(&pool->lock);
+}
@@ -0,0 +1,101 @@
+/*  Copyright (C) 2025 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <sys/socket.h>
+
+#include "contrib/ucw/lists.h"
+#include "libknot/dname.h"
+
+struct xfr_job;
+
+/*!
+ * \brief Job callback.
+ *
+ * \param job        Job.
+ * \param thread_id  Thread identifier of the transfer worker (see knotd_qdata_params_t).
+ */
+typedef void (*xfr_job_cb_t)(struct xfr_job *job, unsigned thread_id);
+
+/*! \brief Outgoing transfer handed over from a TCP worker. */
+typedef struct xfr_job {
+	node_t n;
+	knot_dname_storage_t zone;       /*!< Transferred zone (lower-case), for the per-zone limit. */
+	struct sockaddr_storage client;  /*!< Client address, for the fair scheduling. */
+	unsigned owner;                  /*!< TCP worker the job is returned to when done. */
+	xfr_job_cb_t run;                /*!< Serve the transfer, called by a transfer worker. */
+	xfr_job_cb_t drop;               /*!< Dispose the job not returned to the owner (thread_id 0). */
+} xfr_job_t;
+
+/*!
+ * \brief Pool of transfer workers.
+ *
+ * TCP workers hand over connections with outgoing zone transfers, so that
+ * long transfers don't delay ordinary queries. A free worker picks the oldest
+ * job of the client with the least jobs running, skipping zones which have
+ * reached the limit of concurrent transfers. Finished jobs are returned to
+ * their owners, which are woken up via a pipe.
+ */
+typedef struct xfr_pool xfr_pool_t;
+
+/*!
+ * \brief Create the pool and start its workers.
+ *
+ * \param workers          Number of transfer workers.
+ * \param first_thread_id  Thread identifier of the first transfer worker.
+ * \param owners           Number of TCP workers handing over jobs.
+ *
+ * \return New pool or NULL on error.
+ */
+xfr_pool_t *xfr_pool_new(unsigned workers, unsigned first_thread_id, unsigned owners);
+
+/*!
+ * \brief Stop the workers after finishing the running jobs, drop the other
+ *        jobs, and free the pool.
+ */
+void xfr_pool_free(xfr_pool_t *pool);
+
+/*!
+ * \brief Set the maximum number of concurrently served transfers of one zone.
+ *
+ * \param pool   Pool (can be NULL).
+ * \param limit  Limit, 0 for unlimited.
+ */
+void xfr_pool_set_zone_limit(xfr_pool_t *pool, unsigned limit);
+
+/*!
+ * \brief Queue a job.
+ *
+ * \note Each TCP connection has at most one job, so the queue is bounded
+ *       by the TCP clients limit.
+ */
+void xfr_pool_submit(xfr_pool_t *pool, xfr_job_t *job);
+
+/*!
+ * \brief Get the file descriptor, which becomes readable when some jobs
+ *        of the owner are done.
+ */
+int xfr_pool_done_fd(xfr_pool_t *pool, unsigned owner);
+
+/*!
+ * \brief Take the finished jobs of the owner.
+ *
+ * \param pool   Pool.
+ * \param owner  TCP worker.
+ * \param done   Out: initialized list of the finished jobs.
+ */
+void xfr_pool_done(xfr_pool_t *pool, unsigned owner, list_t *done);
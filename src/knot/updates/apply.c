@@ -395,6 +395,10 @@ void update_free_zone(zone_contents_t *contents)
 	free(contents->nsec3_nodes);
 
 	dnssec_nsec3_params_free(&contents->nsec3_params);
+	answer_cache_free(contents->answer_cache);
+	axfr_cache_free(contents->axfr_cache);
+	nsec3_cache_free(contents->nsec3_cache);
+	expiry_index_free(contents->expiry_index);
 
 	free(contents);
 }
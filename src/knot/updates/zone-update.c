@@ -197,6 +197,8 @@ int zone_update_from_differences(zone_update_t *update, zone_t *zone, zone_conte
 	case KNOT_ERANGE:
 		additionals_tree_free(update->new_cont->adds_tree);
 		update->new_cont->adds_tree = NULL;
+		expiry_index_free(update->new_cont->expiry_index);
+		update->new_cont->expiry_index = NULL;
 		update->new_cont = NULL; // Prevent deep_free as old_cont will be used later.
 		update->a_ctx->flags &= ~APPLY_UNIFY_FULL; // Prevent Unify of old_cont that will be used later.
 		// FALLTHROUGH
@@ -391,6 +393,8 @@ void zone_update_clear(zone_update_t *update)
 	if (update->new_cont != NULL) {
 		additionals_tree_free(update->new_cont->adds_tree);
 		update->new_cont->adds_tree = NULL;
+		expiry_index_free(update->new_cont->expiry_index);
+		update->new_cont->expiry_index = NULL;
 	}
 
 	if (update->flags & (UPDATE_INCREMENTAL | UPDATE_HYBRID)) {
@@ -919,6 +923,11 @@ int zone_update_commit(conf_t *conf, zone_update_t *update)
 		if (dnssec && (update->flags & UPDATE_SIGNED_FULL)) {
 			zone_set_flag(update->zone, ZONE_LAST_SIGN_OK);
 		}
+		/* Give the expiry index back, signing could only have pruned it. */
+		if (update->zone->contents != NULL && update->zone->contents->expiry_index == NULL) {
+			update->zone->contents->expiry_index = update->new_cont->expiry_index;
+			update->new_cont->expiry_index = NULL;
+		}
 		zone_update_clear(update);
 		return KNOT_EOK;
 	}
@@ -932,6 +941,14 @@ int zone_update_commit(conf_t *conf, zone_update_t *update)
 		return ret;
 	}
 
+	/* The expiry index is built once and then maintained when adjusting. */
+	val = conf_zone_get(conf, C_RRSIG_INDEX, update->zone->name);
+	bool expiry_index = dnssec && conf_bool(&val);
+	if (!expiry_index) {
+		expiry_index_free(update->new_cont->expiry_index);
+		update->new_cont->expiry_index = NULL;
+	}
+
 	conf_val_t thr = conf_zone_get(conf, C_ADJUST_THR, update->zone->name);
 	if ((update->flags & (UPDATE_HYBRID | UPDATE_FULL))) {
 		ret = zone_adjust_full(update->new_cont, conf_int(&thr));
@@ -988,6 +1005,37 @@ int zone_update_commit(conf_t *conf, zone_update_t *update)
 		}
 	}
 
+	/* Attach an empty answer cache, it's published together with the contents. */
+	val = conf_zone_get(conf, C_ANS_CACHE, update->zone->name);
+	size_t ans_cache_size = conf_int(&val);
+	if (ans_cache_size > 0 && update->new_cont->answer_cache == NULL) {
+		update->new_cont->answer_cache = answer_cache_new(ans_cache_size);
+	}
+
+	/* Likewise for the AXFR cache, the messages are built on first transfer. */
+	val = conf_zone_get(conf, C_AXFR_CACHE, update->zone->name);
+	if (conf_bool(&val) && update->new_cont->axfr_cache == NULL) {
+		update->new_cont->axfr_cache = axfr_cache_new();
+	}
+
+	/* The NSEC3 hash cache is useful only if the zone is NSEC3-signed. */
+	val = conf_zone_get(conf, C_NSEC3_CACHE, update->zone->name);
+	size_t nsec3_cache_size = conf_int(&val);
+	if (nsec3_cache_size > 0 && knot_is_nsec3_enabled(update->new_cont) &&
+	    update->new_cont->nsec3_cache == NULL) {
+		update->new_cont->nsec3_cache = nsec3_cache_new(nsec3_cache_size);
+	}
+
+	if (expiry_index && update->new_cont->expiry_index == NULL) {
+		ret = expiry_index_from_trees(&update->new_cont->expiry_index,
+		                              update->new_cont->nodes,
+		                              update->new_cont->nsec3_nodes);
+		if (ret != KNOT_EOK) {
+			log_zone_warning(update->zone->name, "failed to index signature expirations (%s)",
+			                 knot_strerror(ret));
+		}
+	}
+
 	/* Switch zone contents. */
 	zone_contents_t *old_contents;
 	old_contents = zone_switch_contents(update->zone, update->new_cont);
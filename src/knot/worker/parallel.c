@@ -0,0 +1,135 @@
+/*  Copyright (C) 2024 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <pthread.h>
+
+#include "libknot/errcode.h"
+#include "knot/server/dthreads.h"
+#include "knot/worker/parallel.h"
+#include "knot/worker/pool.h"
+
+typedef struct {
+	pthread_mutex_t lock;
+	pthread_cond_t done;
+	unsigned pending;
+	int ret;
+	parallel_cb_t cb;
+	void *ctx;
+} parallel_job_t;
+
+typedef struct {
+	worker_task_t task;
+	parallel_job_t *job;
+	unsigned idx;
+} parallel_task_t;
+
+static pthread_mutex_t pool_lock = PTHREAD_MUTEX_INITIALIZER;
+static worker_pool_t *pool = NULL;
+
+static worker_pool_t *get_pool(void)
+{
+	pthread_mutex_lock(&pool_lock);
+	if (pool == NULL) {
+		pool = worker_pool_create(dt_optimal_size());
+		if (pool != NULL) {
+			worker_pool_start(pool);
+		}
+	}
+	worker_pool_t *ret = pool;
+	pthread_mutex_unlock(&pool_lock);
+
+	return ret;
+}
+
+static void job_finish(parallel_job_t *job, int ret)
+{
+	pthread_mutex_lock(&job->lock);
+	if (job->ret == KNOT_EOK) {
+		job->ret = ret;
+	}
+	if (--job->pending == 0) {
+		pthread_cond_signal(&job->done);
+	}
+	pthread_mutex_unlock(&job->lock);
+}
+
+static void run_task(worker_task_t *task)
+{
+	parallel_task_t *ptask = task->ctx;
+	parallel_job_t *job = ptask->job;
+
+	job_finish(job, job->cb(ptask->idx, job->ctx));
+}
+
+int parallel_run(unsigned count, parallel_cb_t cb, void *ctx)
+{
+	if (cb == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	worker_pool_t *workers = (count > 1) ? get_pool() : NULL;
+	if (workers == NULL) {
+		int ret = KNOT_EOK;
+		for (unsigned i = 0; i < count && ret == KNOT_EOK; i++) {
+			ret = cb(i, ctx);
+		}
+		return ret;
+	}
+
+	parallel_job_t job = {
+		.pending = count,
+		.ret = KNOT_EOK,
+		.cb = cb,
+		.ctx = ctx,
+	};
+	pthread_mutex_init(&job.lock, NULL);
+	pthread_cond_init(&job.done, NULL);
+
+	parallel_task_t tasks[count];
+	for (unsigned i = 1; i < count; i++) {
+		tasks[i] = (parallel_task_t) {
+			.task = { .ctx = &tasks[i], .run = run_task, .prio = WORKER_PRIO_NORMAL },
+			.job = &job,
+			.idx = i,
+		};
+		worker_pool_assign(workers, &tasks[i].task);
+	}
+
+	job_finish(&job, cb(0, ctx));
+
+	pthread_mutex_lock(&job.lock);
+	while (job.pending > 0) {
+		pthread_cond_wait(&job.done, &job.lock);
+	}
+	pthread_mutex_unlock(&job.lock);
+
+	pthread_cond_destroy(&job.done);
+	pthread_mutex_destroy(&job.lock);
+
+	return job.ret;
+}
+
+void parallel_deinit(void)
+{
+	pthread_mutex_lock(&pool_lock);
+	if (pool != NULL) {
+		worker_pool_stop(pool);
+		worker_pool_join(pool);
+		worker_pool_destroy(pool);
+		pool = NULL;
+	}
+	pthread_mutex_unlock(&pool_lock);
+}
@@ -0,0 +1,52 @@
+/*  Copyright (C) 2024 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+/*! \brief Number of tree parts per thread, for balancing uneven subtrees. */
+#define PARALLEL_PARTS_PER_THREAD	4
+
+/*!
+ * \brief Callback processing one of the parts of a parallel job.
+ *
+ * \param idx  Index of the part.
+ * \param ctx  Job context.
+ *
+ * \return KNOT_E*
+ */
+typedef int (*parallel_cb_t)(unsigned idx, void *ctx);
+
+/*!
+ * \brief Run the callback for each index from 0 to count - 1 in parallel.
+ *
+ * The parts are processed by a persistent pool of compute threads shared by
+ * all callers (zone adjusting, zone signing), which is created on first use.
+ * The calling thread processes the first part itself and waits for the rest.
+ *
+ * \note The callback must not wait for another parallel job.
+ *
+ * \param count  Number of parts.
+ * \param cb     Callback processing one part.
+ * \param ctx    Job context.
+ *
+ * \return KNOT_EOK or the first error returned by the callback.
+ */
+int parallel_run(unsigned count, parallel_cb_t cb, void *ctx);
+
+/*!
+ * \brief Stop and free the shared compute pool if created.
+ */
+void parallel_deinit(void);
@@ -17,32 +17,110 @@
 #include <assert.h>
 #include <pthread.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include "libknot/libknot.h"
 #include "knot/server/dthreads.h"
 #include "knot/worker/pool.h"
+#include "contrib/atomic.h"
+
+/*!
+ * \brief Per-worker task queues, one for each priority class.
+ */
+typedef struct {
+	pthread_mutex_t lock;
+	worker_queue_t tasks[WORKER_PRIO_COUNT];
+} worker_deque_t;
 
 /*!
  * \brief Worker pool state.
+ *
+ * Tasks are distributed among per-worker queues, so that assigning and taking
+ * tasks don't contend for a single lock. An idle worker steals tasks from
+ * the queues of other workers. The pool lock only guards sleeping, waking
+ * up, and waiting for the pool.
  */
 struct worker_pool {
 	dt_unit_t *threads;
+	worker_deque_t *deques;
+	unsigned deque_count;
+	unsigned low_limit;	/*!< Max. number of workers running low priority tasks. */
 
 	pthread_mutex_t lock;
-	pthread_cond_t wake;
+	pthread_cond_t wake;	/*!< Signalled if a task is available. */
+	pthread_cond_t done;	/*!< Broadcast if a task is finished and someone waits. */
 
-	bool terminating;	/*!< Is the pool terminating? .*/
-	bool suspended;		/*!< Is execution temporarily suspended? .*/
-	int running;		/*!< Number of running threads. */
-	worker_queue_t tasks;
+	knot_atomic_bool terminating;	/*!< Is the pool terminating? .*/
+	knot_atomic_bool suspended;	/*!< Is execution temporarily suspended? .*/
+	int sleeping;			/*!< Number of idle threads (under lock). */
+	int waiting;			/*!< Number of threads waiting for the pool (under lock). */
+
+	knot_atomic_size_t queued[WORKER_PRIO_COUNT];	/*!< Queued tasks per class. */
+	knot_atomic_size_t pending;			/*!< Queued and running tasks. */
+	knot_atomic_size_t running_low;			/*!< Running low priority tasks. */
 };
 
+static bool has_runnable(worker_pool_t *pool)
+{
+	for (worker_prio_t prio = 0; prio < WORKER_PRIO_COUNT; prio++) {
+		if (prio == WORKER_PRIO_LOW &&
+		    ATOMIC_GET(pool->running_low) >= pool->low_limit) {
+			continue;
+		}
+		if (ATOMIC_GET(pool->queued[prio]) > 0) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/*!
+ * \brief Take the most important task, the own queue is preferred.
+ *
+ * Low priority tasks are left in the queue if they already occupy all but
+ * one worker, so that long-running tasks can't delay the other ones.
+ * The limit is approximate as it's checked without locking.
+ */
+static worker_task_t *take_task(worker_pool_t *pool, unsigned self)
+{
+	for (worker_prio_t prio = 0; prio < WORKER_PRIO_COUNT; prio++) {
+		if (ATOMIC_GET(pool->queued[prio]) == 0) {
+			continue;
+		}
+		if (prio == WORKER_PRIO_LOW &&
+		    ATOMIC_GET(pool->running_low) >= pool->low_limit) {
+			continue;
+		}
+
+		for (unsigned i = 0; i < pool->deque_count; i++) {
+			worker_deque_t *deque = &pool->deques[(self + i) % pool->deque_count];
+
+			pthread_mutex_lock(&deque->lock);
+			worker_task_t *task = worker_queue_dequeue(&deque->tasks[prio]);
+			if (task != NULL) {
+				ATOMIC_SUB(pool->queued[prio], 1);
+			}
+			pthread_mutex_unlock(&deque->lock);
+
+			if (task != NULL) {
+				if (prio == WORKER_PRIO_LOW) {
+					ATOMIC_ADD(pool->running_low, 1);
+				}
+				return task;
+			}
+		}
+	}
+
+	return NULL;
+}
+
 /*!
  * \brief Worker thread.
  *
- * The thread takes a task from the tasks queue and runs it, while checking
+ * The thread takes a task from the tasks queues and runs it, while checking
  * if the dispatching of new tasks is allowed by the thread pool.
  *
  * An execution of a running thread cannot be enforced.
@@ -53,37 +131,47 @@ static int worker_main(dthread_t *thread)
 	assert(thread);
 
 	worker_pool_t *pool = thread->data;
-
-	pthread_mutex_lock(&pool->lock);
+	unsigned self = dt_get_id(thread) % pool->deque_count;
 
 	for (;;) {
-		if (pool->terminating) {
-			break;
-		}
-
 		worker_task_t *task = NULL;
-		if (!pool->suspended) {
-			task = worker_queue_dequeue(&pool->tasks);
+		if (!ATOMIC_GET(pool->terminating) && !ATOMIC_GET(pool->suspended)) {
+			task = take_task(pool, self);
 		}
 
-		if (task == NULL) {
-			pthread_cond_wait(&pool->wake, &pool->lock);
+		if (task != NULL) {
+			assert(task->run);
+			worker_prio_t prio = task->prio;
+			task->run(task);
+
+			pthread_mutex_lock(&pool->lock);
+			ATOMIC_SUB(pool->pending, 1);
+			if (prio == WORKER_PRIO_LOW) {
+				ATOMIC_SUB(pool->running_low, 1);
+				if (pool->sleeping > 0 && has_runnable(pool)) {
+					pthread_cond_signal(&pool->wake);
+				}
+			}
+			if (pool->waiting > 0) {
+				pthread_cond_broadcast(&pool->done);
+			}
+			pthread_mutex_unlock(&pool->lock);
 			continue;
 		}
 
-		assert(task->run);
-		pool->running += 1;
-
-		pthread_mutex_unlock(&pool->lock);
-		task->run(task);
 		pthread_mutex_lock(&pool->lock);
-
-		pool->running -= 1;
-		pthread_cond_broadcast(&pool->wake);
+		if (ATOMIC_GET(pool->terminating)) {
+			pthread_mutex_unlock(&pool->lock);
+			break;
+		}
+		if (ATOMIC_GET(pool->suspended) || !has_runnable(pool)) {
+			pool->sleeping += 1;
+			pthread_cond_wait(&pool->wake, &pool->lock);
+			pool->sleeping -= 1;
+		}
+		pthread_mutex_unlock(&pool->lock);
 	}
 
-	pthread_mutex_unlock(&pool->lock);
-
 	return KNOT_EOK;
 }
 
@@ -97,6 +185,22 @@ worker_pool_t *worker_pool_create(unsigned threads)
 	}
 
 	memset(pool, 0, sizeof(worker_pool_t));
+	pool->deque_count = (threads > 0) ? threads : 1;
+	pool->low_limit = (pool->deque_count > 1) ? pool->deque_count - 1 : 1;
+
+	pool->deques = calloc(pool->deque_count, sizeof(worker_deque_t));
+	if (pool->deques == NULL) {
+		free(pool);
+		return NULL;
+	}
+	for (unsigned i = 0; i < pool->deque_count; i++) {
+		worker_deque_t *deque = &pool->deques[i];
+		pthread_mutex_init(&deque->lock, NULL);
+		for (worker_prio_t prio = 0; prio < WORKER_PRIO_COUNT; prio++) {
+			worker_queue_init(&deque->tasks[prio]);
+		}
+	}
+
 	pool->threads = dt_create(threads, worker_main, NULL, pool);
 	if (pool->threads == NULL) {
 		goto fail;
@@ -110,12 +214,18 @@ worker_pool_t *worker_pool_create(unsigned threads)
 		goto fail;
 	}
 
-	worker_queue_init(&pool->tasks);
+	if (pthread_cond_init(&pool->done, NULL) != 0) {
+		goto fail;
+	}
 
 	return pool;
 
 fail:
 	dt_delete(&pool->threads);
+	for (unsigned i = 0; i < pool->deque_count; i++) {
+		pthread_mutex_destroy(&pool->deques[i].lock);
+	}
+	free(pool->deques);
 	free(pool);
 	return NULL;
 }
@@ -130,8 +240,16 @@ void worker_pool_destroy(worker_pool_t *pool)
 
 	pthread_mutex_destroy(&pool->lock);
 	pthread_cond_destroy(&pool->wake);
+	pthread_cond_destroy(&pool->done);
 
-	worker_queue_deinit(&pool->tasks);
+	for (unsigned i = 0; i < pool->deque_count; i++) {
+		worker_deque_t *deque = &pool->deques[i];
+		pthread_mutex_destroy(&deque->lock);
+		for (worker_prio_t prio = 0; prio < WORKER_PRIO_COUNT; prio++) {
+			worker_queue_deinit(&deque->tasks[prio]);
+		}
+	}
+	free(pool->deques);
 
 	free(pool);
 }
@@ -152,7 +270,7 @@ void worker_pool_stop(worker_pool_t *pool)
 	}
 
 	pthread_mutex_lock(&pool->lock);
-	pool->terminating = true;
+	ATOMIC_SET(pool->terminating, true);
 	pthread_cond_broadcast(&pool->wake);
 	pthread_mutex_unlock(&pool->lock);
 
@@ -166,7 +284,7 @@ void worker_pool_suspend(worker_pool_t *pool)
 	}
 
 	pthread_mutex_lock(&pool->lock);
-	pool->suspended = true;
+	ATOMIC_SET(pool->suspended, true);
 	pthread_mutex_unlock(&pool->lock);
 }
 
@@ -177,7 +295,7 @@ void worker_pool_resume(worker_pool_t *pool)
 	}
 
 	pthread_mutex_lock(&pool->lock);
-	pool->suspended = false;
+	ATOMIC_SET(pool->suspended, false);
 	pthread_cond_broadcast(&pool->wake);
 	pthread_mutex_unlock(&pool->lock);
 }
@@ -198,12 +316,14 @@ void worker_pool_wait_cb(worker_pool_t *pool, wait_callback_t cb)
 	}
 
 	pthread_mutex_lock(&pool->lock);
-	while (!EMPTY_LIST(pool->tasks.list) || pool->running > 0) {
+	pool->waiting += 1;
+	while (ATOMIC_GET(pool->pending) > 0) {
 		if (cb != NULL) {
 			cb(pool);
 		}
-		pthread_cond_wait(&pool->wake, &pool->lock);
+		pthread_cond_wait(&pool->done, &pool->lock);
 	}
+	pool->waiting -= 1;
 	pthread_mutex_unlock(&pool->lock);
 }
 
@@ -218,9 +338,23 @@ void worker_pool_assign(worker_pool_t *pool, struct task *task)
 		return;
 	}
 
+	assert(task->prio < WORKER_PRIO_COUNT);
+
+	// The same task (zone) always lands in the same queue.
+	uintptr_t hash = (uintptr_t)task / sizeof(*task);
+	worker_deque_t *deque = &pool->deques[hash % pool->deque_count];
+
+	ATOMIC_ADD(pool->pending, 1);
+
+	pthread_mutex_lock(&deque->lock);
+	worker_queue_enqueue(&deque->tasks[task->prio], task);
+	ATOMIC_ADD(pool->queued[task->prio], 1);
+	pthread_mutex_unlock(&deque->lock);
+
 	pthread_mutex_lock(&pool->lock);
-	worker_queue_enqueue(&pool->tasks, task);
-	pthread_cond_signal(&pool->wake);
+	if (pool->sleeping > 0) {
+		pthread_cond_signal(&pool->wake);
+	}
 	pthread_mutex_unlock(&pool->lock);
 }
 
@@ -230,24 +364,53 @@ void worker_pool_clear(worker_pool_t *pool)
 		return;
 	}
 
+	for (unsigned i = 0; i < pool->deque_count; i++) {
+		worker_deque_t *deque = &pool->deques[i];
+		pthread_mutex_lock(&deque->lock);
+		for (worker_prio_t prio = 0; prio < WORKER_PRIO_COUNT; prio++) {
+			size_t count = worker_queue_length(&deque->tasks[prio]);
+			worker_queue_deinit(&deque->tasks[prio]);
+			worker_queue_init(&deque->tasks[prio]);
+			ATOMIC_SUB(pool->queued[prio], count);
+			ATOMIC_SUB(pool->pending, count);
+		}
+		pthread_mutex_unlock(&deque->lock);
+	}
+
 	pthread_mutex_lock(&pool->lock);
-	worker_queue_deinit(&pool->tasks);
-	worker_queue_init(&pool->tasks);
+	if (pool->waiting > 0) {
+		pthread_cond_broadcast(&pool->done);
+	}
 	pthread_mutex_unlock(&pool->lock);
 }
 
-void worker_pool_status(worker_pool_t *pool, bool locked, int *running, int *queued)
+void worker_pool_status(worker_pool_t *pool, bool locked, int *running, int *queued,
+                        int queued_prio[WORKER_PRIO_COUNT])
 {
 	if (!pool) {
 		*running = *queued = 0;
+		if (queued_prio != NULL) {
+			memset(queued_prio, 0, WORKER_PRIO_COUNT * sizeof(*queued_prio));
+		}
 		return;
 	}
 
 	if (!locked) {
 		pthread_mutex_lock(&pool->lock);
 	}
-	*running = pool->running;
-	*queued = worker_queue_length(&pool->tasks);
+	int total = 0;
+	for (worker_prio_t prio = 0; prio < WORKER_PRIO_COUNT; prio++) {
+		int count = ATOMIC_GET(pool->queued[prio]);
+		if (queued_prio != NULL) {
+			queued_prio[prio] = count;
+		}
+		total += count;
+	}
+	*queued = total;
+	*running = ATOMIC_GET(pool->pending) - total;
+	if (*running < 0) { // Counters aren't updated at once.
+		*running = 0;
+	}
 	if (!locked) {
 		pthread_mutex_unlock(&pool->lock);
 	}
@@ -77,6 +77,8 @@ void worker_pool_wait_cb(worker_pool_t *pool, wait_callback_t cb);
 
 /*!
  * \brief Assign a task to be performed by a worker in the pool.
+ *
+ * Tasks of higher priority class (see task->prio) are taken first.
  */
 void worker_pool_assign(worker_pool_t *pool, struct task *task);
 
@@ -89,5 +91,8 @@ void worker_pool_clear(worker_pool_t *pool);
  * \brief Obtain info regarding how the pool is busy.
  *
  * \note Locked means if the mutex `pool->lock` is locked.
+ *
+ * \param queued_prio  Optional output for the number of queued tasks per class.
  */
-void worker_pool_status(worker_pool_t *pool, bool locked, int *running, int *queued);
+void worker_pool_status(worker_pool_t *pool, bool locked, int *running, int *queued,
+                        int queued_prio[WORKER_PRIO_COUNT]);
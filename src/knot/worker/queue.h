@@ -21,12 +21,23 @@
 struct task;
 typedef void (*task_cb)(struct task *);
 
+/*!
+ * \brief Task priority classes, in order of precedence.
+ */
+typedef enum {
+	WORKER_PRIO_HIGH = 0, /*!< Short latency-sensitive tasks. */
+	WORKER_PRIO_NORMAL,
+	WORKER_PRIO_LOW,      /*!< Long-running tasks. */
+	WORKER_PRIO_COUNT
+} worker_prio_t;
+
 /*!
  * \brief Task executable by a worker.
  */
 typedef struct task {
 	void *ctx;
 	task_cb run;
+	worker_prio_t prio;
 } worker_task_t;
 
 /*!
@@ -19,6 +19,7 @@
 #include "knot/dnssec/zone-nsec.h"
 #include "knot/zone/adds_tree.h"
 #include "knot/zone/measure.h"
+#include "knot/worker/parallel.h"
 #include "libdnssec/error.h"
 
 static bool node_non_dnssec_exists(const zone_node_t *node)
@@ -320,6 +321,15 @@ int adjust_cb_nsec3_and_wildcard(zone_node_t *node, adjust_ctx_t *ctx)
 	return ret;
 }
 
+int adjust_cb_wildcard_and_additionals(zone_node_t *node, adjust_ctx_t *ctx)
+{
+	int ret = adjust_cb_wildcard_nsec3(node, ctx);
+	if (ret == KNOT_EOK) {
+		ret = adjust_cb_additionals(node, ctx);
+	}
+	return ret;
+}
+
 int adjust_cb_void(_unused_ zone_node_t *node, _unused_ adjust_ctx_t *ctx)
 {
 	return KNOT_EOK;
@@ -335,10 +345,6 @@ typedef struct {
 
 	// just for parallel
 	unsigned threads;
-	unsigned thr_id;
-	size_t i;
-	pthread_t thread;
-	int ret;
 	zone_tree_t *tree;
 } zone_adjust_arg_t;
 
@@ -349,13 +355,6 @@ static int adjust_single(zone_node_t *node, void *data)
 
 	zone_adjust_arg_t *args = (zone_adjust_arg_t *)data;
 
-	// parallel adjust support
-	if (args->threads > 1) {
-		if (args->i++ % args->threads != args->thr_id) {
-			return KNOT_EOK;
-		}
-	}
-
 	if (args->m != NULL) {
 		knot_measure_node(node, args->m);
 	}
@@ -411,13 +410,18 @@ static int zone_adjust_tree(zone_tree_t *tree, adjust_ctx_t *ctx, adjust_cb_t ad
 	return KNOT_EOK;
 }
 
-static void *adjust_tree_thread(void *ctx)
+static int adjust_tree_parts(unsigned idx, void *ctx)
 {
-	zone_adjust_arg_t *arg = ctx;
+	zone_adjust_arg_t *arg = (zone_adjust_arg_t *)ctx + idx;
 
-	arg->ret = zone_tree_apply(arg->tree, adjust_single, ctx);
+	// Interleaved parts even out the differently sized subtrees.
+	unsigned parts = arg->threads * PARALLEL_PARTS_PER_THREAD;
+	int ret = KNOT_EOK;
+	for (unsigned part = idx; part < parts && ret == KNOT_EOK; part += arg->threads) {
+		ret = zone_tree_apply_part(arg->tree, part, parts, adjust_single, arg);
+	}
 
-	return NULL;
+	return ret;
 }
 
 static int zone_adjust_tree_parallel(zone_tree_t *tree, adjust_ctx_t *ctx,
@@ -439,9 +443,6 @@ static int zone_adjust_tree_parallel(zone_tree_t *tree, adjust_ctx_t *ctx,
 		args[i].m = NULL;
 		args[i].tree = tree;
 		args[i].threads = threads;
-		args[i].i = 0;
-		args[i].thr_id = i;
-		args[i].ret = -1;
 		if (ctx->changed_nodes != NULL) {
 			args[i].ctx.changed_nodes = zone_tree_create(true);
 			if (args[i].ctx.changed_nodes == NULL) {
@@ -458,17 +459,9 @@ static int zone_adjust_tree_parallel(zone_tree_t *tree, adjust_ctx_t *ctx,
 		return ret;
 	}
 
-	for (unsigned i = 0; i < threads; i++) {
-		args[i].ret = pthread_create(&args[i].thread, NULL, adjust_tree_thread, &args[i]);
-	}
+	ret = parallel_run(threads, adjust_tree_parts, args);
 
 	for (unsigned i = 0; i < threads; i++) {
-		if (args[i].ret == 0) {
-			args[i].ret = pthread_join(args[i].thread, NULL);
-		}
-		if (args[i].ret != 0) {
-			ret = knot_map_errno_code(args[i].ret);
-		}
 		if (ret == KNOT_EOK && ctx->changed_nodes != NULL) {
 			ret = zone_tree_merge(ctx->changed_nodes, args[i].ctx.changed_nodes);
 		}
@@ -559,6 +552,10 @@ int zone_adjust_full(zone_contents_t *zone, unsigned threads)
 		additionals_tree_free(zone->adds_tree);
 		ret = additionals_tree_from_zone(&zone->adds_tree, zone);
 	}
+	if (ret == KNOT_EOK && zone->expiry_index != NULL) {
+		// any node could have changed, the signing keys identifier is kept
+		ret = expiry_index_rebuild(zone->expiry_index, zone->nodes, zone->nsec3_nodes);
+	}
 	return ret;
 }
 
@@ -595,12 +592,6 @@ int zone_adjust_incremental_update(zone_update_t *update, unsigned threads)
 		if (nsec3change) {
 			ret = zone_adjust_contents(update->new_cont, adjust_cb_nsec3_and_wildcard, NULL,
 			                           false, false, threads, update->a_ctx->adjust_ptrs);
-			if (ret == KNOT_EOK) {
-				// just measure zone size
-				ret = zone_adjust_update(update, adjust_cb_void, adjust_cb_void, true);
-			}
-		} else {
-			ret = zone_adjust_update(update, adjust_cb_wildcard_nsec3, adjust_cb_void, true);
 		}
 	}
 	if (ret == KNOT_EOK) {
@@ -624,7 +615,10 @@ int zone_adjust_incremental_update(zone_update_t *update, unsigned threads)
 		);
 	}
 	if (ret == KNOT_EOK) {
-		ret = zone_adjust_update(update, adjust_cb_additionals, adjust_cb_void, false);
+		// Single pass over the changed nodes, also measuring the zone size.
+		adjust_cb_t nodes_cb = nsec3change ? adjust_cb_additionals
+		                                   : adjust_cb_wildcard_and_additionals;
+		ret = zone_adjust_update(update, nodes_cb, adjust_cb_void, true);
 	}
 	if (ret == KNOT_EOK) {
 		if (!nsec3change) {
@@ -636,5 +630,10 @@ int zone_adjust_incremental_update(zone_update_t *update, unsigned threads)
 			);
 		}
 	}
+	if (ret == KNOT_EOK && update->new_cont->expiry_index != NULL) {
+		ret = expiry_index_update(update->new_cont->expiry_index,
+		                          update->a_ctx->node_ptrs,
+		                          update->a_ctx->nsec3_ptrs);
+	}
 	return ret;
 }
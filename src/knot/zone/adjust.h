@@ -63,6 +63,9 @@ int adjust_cb_nsec3_and_additionals(zone_node_t *node, adjust_ctx_t *ctx);
 // adjust_cb_wildcard_nsec3 and adjust_cb_nsec3_pointer at once
 int adjust_cb_nsec3_and_wildcard(zone_node_t *node, adjust_ctx_t *ctx);
 
+// adjust_cb_wildcard_nsec3 and adjust_cb_additionals at once
+int adjust_cb_wildcard_and_additionals(zone_node_t *node, adjust_ctx_t *ctx);
+
 // dummy callback, just make prev pointers adjusting and zone size measuring work
 int adjust_cb_void(zone_node_t *node, adjust_ctx_t *ctx);
 
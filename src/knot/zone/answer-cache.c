@@ -0,0 +1,224 @@
+/*  Copyright (C) 2024 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "knot/zone/answer-cache.h"
+#include "libdnssec/random.h"
+#include "libknot/packet/wire.h"
+#include "contrib/openbsd/siphash.h"
+#include "contrib/spinlock.h"
+
+/*! \brief Answers bigger than this aren't worth caching. */
+#define ANSWER_MAX_SIZE	4096
+
+typedef struct {
+	uint64_t hash;
+	uint16_t qtype;
+	uint16_t qclass;
+	uint16_t avail;
+	bool dnssec;
+	bool aa;
+	uint16_t rcode;
+	int rcode_ede;
+	uint16_t ancount;
+	uint16_t nscount;
+	uint16_t arcount;
+	uint16_t qname_size;
+	uint16_t wire_size;
+	uint8_t data[];  // Lowercased QNAME followed by the sections wire.
+} answer_entry_t;
+
+typedef struct {
+	knot_spin_t lock;
+	answer_entry_t *entry;
+} answer_slot_t;
+
+struct answer_cache {
+	SIPHASH_KEY key;
+	size_t mask;
+	answer_slot_t slots[];
+};
+
+typedef struct {
+	uint64_t hash;
+	uint16_t qtype;
+	uint16_t qclass;
+	uint16_t avail;
+	bool dnssec;
+} answer_key_t;
+
+static void answer_key_init(answer_key_t *key, const answer_cache_t *cache,
+                            const knot_pkt_t *query, const knot_pkt_t *resp)
+{
+	size_t avail = resp->max_size - resp->reserved;
+
+	key->qtype = knot_pkt_qtype(query);
+	key->qclass = knot_pkt_qclass(query);
+	key->avail = (avail > UINT16_MAX) ? UINT16_MAX : avail;
+	key->dnssec = knot_pkt_has_dnssec(query);
+
+	SIPHASH_CTX ctx;
+	SipHash24_Init(&ctx, &cache->key);
+	SipHash24_Update(&ctx, query->lower_qname, query->qname_size);
+	SipHash24_Update(&ctx, &key->qtype, sizeof(key->qtype));
+	SipHash24_Update(&ctx, &key->qclass, sizeof(key->qclass));
+	SipHash24_Update(&ctx, &key->avail, sizeof(key->avail));
+	SipHash24_Update(&ctx, &key->dnssec, sizeof(key->dnssec));
+	key->hash = SipHash24_End(&ctx);
+}
+
+static bool answer_entry_match(const answer_entry_t *entry, const answer_key_t *key,
+                               const knot_pkt_t *query)
+{
+	return entry->hash == key->hash &&
+	       entry->qtype == key->qtype &&
+	       entry->qclass == key->qclass &&
+	       entry->avail == key->avail &&
+	       entry->dnssec == key->dnssec &&
+	       entry->qname_size == query->qname_size &&
+	       memcmp(entry->data, query->lower_qname, entry->qname_size) == 0;
+}
+
+static answer_slot_t *answer_slot(answer_cache_t *cache, const answer_key_t *key)
+{
+	return &cache->slots[key->hash & cache->mask];
+}
+
+answer_cache_t *answer_cache_new(size_t size)
+{
+	if (size == 0) {
+		return NULL;
+	}
+
+	size_t count = 1;
+	while (count < size) {
+		count <<= 1;
+	}
+
+	answer_cache_t *cache = calloc(1, sizeof(*cache) + count * sizeof(answer_slot_t));
+	if (cache == NULL) {
+		return NULL;
+	}
+
+	cache->key.k0 = dnssec_random_uint64_t();
+	cache->key.k1 = dnssec_random_uint64_t();
+	cache->mask = count - 1;
+	for (size_t i = 0; i < count; i++) {
+		knot_spin_init(&cache->slots[i].lock);
+	}
+
+	return cache;
+}
+
+void answer_cache_free(answer_cache_t *cache)
+{
+	if (cache == NULL) {
+		return;
+	}
+
+	for (size_t i = 0; i <= cache->mask; i++) {
+		knot_spin_destroy(&cache->slots[i].lock);
+		free(cache->slots[i].entry);
+	}
+
+	free(cache);
+}
+
+bool answer_cache_get(answer_cache_t *cache, const knot_pkt_t *query,
+                      knot_pkt_t *resp, uint16_t *rcode, int *rcode_ede)
+{
+	if (cache == NULL || query->qname_size == 0 ||
+	    resp->size != KNOT_WIRE_HEADER_SIZE + knot_pkt_question_size(resp)) {
+		return false;
+	}
+
+	answer_key_t key;
+	answer_key_init(&key, cache, query, resp);
+
+	answer_slot_t *slot = answer_slot(cache, &key);
+	bool found = false;
+
+	knot_spin_lock(&slot->lock);
+	const answer_entry_t *entry = slot->entry;
+	if (entry != NULL && answer_entry_match(entry, &key, query) &&
+	    resp->size + entry->wire_size <= resp->max_size - resp->reserved) {
+		memcpy(resp->wire + resp->size, entry->data + entry->qname_size,
+		       entry->wire_size);
+		resp->size += entry->wire_size;
+
+		knot_wire_set_ancount(resp->wire, entry->ancount);
+		knot_wire_set_nscount(resp->wire, entry->nscount);
+		knot_wire_set_arcount(resp->wire, entry->arcount);
+		if (entry->aa) {
+			knot_wire_set_aa(resp->wire);
+		}
+		*rcode = entry->rcode;
+		*rcode_ede = entry->rcode_ede;
+		found = true;
+	}
+	knot_spin_unlock(&slot->lock);
+
+	return found;
+}
+
+void answer_cache_put(answer_cache_t *cache, const knot_pkt_t *query,
+                      const knot_pkt_t *resp, uint16_t rcode, int rcode_ede)
+{
+	if (cache == NULL || query->qname_size == 0) {
+		return;
+	}
+
+	size_t offset = KNOT_WIRE_HEADER_SIZE + knot_pkt_question_size(resp);
+	if (resp->size <= offset || resp->size - offset > ANSWER_MAX_SIZE) {
+		return;
+	}
+	size_t wire_size = resp->size - offset;
+
+	answer_entry_t *entry = malloc(sizeof(*entry) + query->qname_size + wire_size);
+	if (entry == NULL) {
+		return;
+	}
+
+	answer_key_t key;
+	answer_key_init(&key, cache, query, resp);
+
+	entry->hash = key.hash;
+	entry->qtype = key.qtype;
+	entry->qclass = key.qclass;
+	entry->avail = key.avail;
+	entry->dnssec = key.dnssec;
+	entry->aa = knot_wire_get_aa(resp->wire);
+	entry->rcode = rcode;
+	entry->rcode_ede = rcode_ede;
+	entry->ancount = knot_wire_get_ancount(resp->wire);
+	entry->nscount = knot_wire_get_nscount(resp->wire);
+	entry->arcount = knot_wire_get_arcount(resp->wire);
+	entry->qname_size = query->qname_size;
+	entry->wire_size = wire_size;
+	memcpy(entry->data, query->lower_qname, query->qname_size);
+	memcpy(entry->data + query->qname_size, resp->wire + offset, wire_size);
+
+	answer_slot_t *slot = answer_slot(cache, &key);
+
+	knot_spin_lock(&slot->lock);
+	answer_entry_t *old = slot->entry;
+	slot->entry = entry;
+	knot_spin_unlock(&slot->lock);
+
+	free(old);
+}
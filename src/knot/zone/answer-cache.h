@@ -0,0 +1,78 @@
+/*  Copyright (C) 2024 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "libknot/packet/pkt.h"
+
+/*!
+ * \brief Cache of serialized answers bound to one version of zone contents.
+ *
+ * Entries hold the wire format of the answer, authority, and additional
+ * sections following the question. The cache is keyed on the lowercased
+ * QNAME, QTYPE, QCLASS, DO bit, and the space available for the answer.
+ * It's never invalidated explicitly, it's dropped together with the zone
+ * contents it belongs to.
+ */
+typedef struct answer_cache answer_cache_t;
+
+/*!
+ * \brief Create an empty answer cache.
+ *
+ * \param size  Requested number of entries (rounded up to a power of two).
+ *
+ * \return New cache or NULL on error.
+ */
+answer_cache_t *answer_cache_new(size_t size);
+
+/*!
+ * \brief Free the answer cache including all entries.
+ */
+void answer_cache_free(answer_cache_t *cache);
+
+/*!
+ * \brief Fill the response with a cached answer if available.
+ *
+ * The response must contain just the header and the question. On success,
+ * the sections are appended, section counts and the AA flag are set.
+ *
+ * \param cache      Answer cache.
+ * \param query      Parsed query.
+ * \param resp       Response being constructed.
+ * \param rcode      Output for the cached RCODE.
+ * \param rcode_ede  Output for the cached extended RCODE.
+ *
+ * \retval true if the answer was found and written.
+ */
+bool answer_cache_get(answer_cache_t *cache, const knot_pkt_t *query,
+                      knot_pkt_t *resp, uint16_t *rcode, int *rcode_ede);
+
+/*!
+ * \brief Store a complete answer into the cache.
+ *
+ * \note Must be called before the OPT and TSIG records are added.
+ *
+ * \param cache      Answer cache.
+ * \param query      Parsed query.
+ * \param resp       Finished response (without OPT and TSIG).
+ * \param rcode      Resulting RCODE.
+ * \param rcode_ede  Resulting extended RCODE.
+ */
+void answer_cache_put(answer_cache_t *cache, const knot_pkt_t *query,
+                      const knot_pkt_t *resp, uint16_t rcode, int rcode_ede);
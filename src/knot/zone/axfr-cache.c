@@ -0,0 +1,259 @@
+/*  Copyright (C) 2024 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "knot/zone/axfr-cache.h"
+#include "knot/zone/contents.h"
+#include "libknot/errcode.h"
+#include "contrib/macros.h"
+
+/*! \brief Space left in each message for OPT, TSIG, and EDNS padding. */
+#define AXFR_CACHE_RESERVE	1024
+#define AXFR_CACHE_MSG_SIZE	(KNOT_WIRE_MAX_PKTSIZE - AXFR_CACHE_RESERVE)
+
+typedef struct {
+	uint16_t ancount;
+	uint16_t wire_size;
+	uint8_t wire[];  // Answer section following the question.
+} axfr_msg_t;
+
+typedef enum {
+	AXFR_CACHE_EMPTY = 0,
+	AXFR_CACHE_READY,
+	AXFR_CACHE_FAILED,
+} axfr_cache_state_t;
+
+struct axfr_cache {
+	pthread_mutex_t lock;
+	axfr_cache_state_t state;
+	uint16_t max_size;  // Size of the biggest message.
+	size_t count;
+	size_t alloc;
+	axfr_msg_t **msgs;
+};
+
+typedef struct {
+	axfr_cache_t *cache;
+	knot_pkt_t *pkt;
+	const knot_dname_t *apex;
+} axfr_build_t;
+
+static int build_begin(axfr_build_t *ctx)
+{
+	knot_pkt_clear(ctx->pkt);
+	int ret = knot_pkt_put_question(ctx->pkt, ctx->apex, KNOT_CLASS_IN, KNOT_RRTYPE_AXFR);
+	if (ret == KNOT_EOK) {
+		ret = knot_pkt_init_compr_table(ctx->pkt);
+	}
+	if (ret == KNOT_EOK) {
+		ret = knot_pkt_begin(ctx->pkt, KNOT_ANSWER);
+	}
+
+	return ret;
+}
+
+static int build_flush(axfr_build_t *ctx)
+{
+	axfr_cache_t *cache = ctx->cache;
+	knot_pkt_t *pkt = ctx->pkt;
+
+	if (pkt->rrset_count == 0) {
+		return KNOT_ENOXFR; // RRSet bigger than a message.
+	}
+
+	if (cache->count == cache->alloc) {
+		size_t alloc = MAX(64, 2 * cache->alloc);
+		axfr_msg_t **msgs = realloc(cache->msgs, alloc * sizeof(*msgs));
+		if (msgs == NULL) {
+			return KNOT_ENOMEM;
+		}
+		cache->msgs = msgs;
+		cache->alloc = alloc;
+	}
+
+	size_t offset = KNOT_WIRE_HEADER_SIZE + knot_pkt_question_size(pkt);
+	size_t wire_size = pkt->size - offset;
+	axfr_msg_t *msg = malloc(sizeof(*msg) + wire_size);
+	if (msg == NULL) {
+		return KNOT_ENOMEM;
+	}
+	msg->ancount = knot_wire_get_ancount(pkt->wire);
+	msg->wire_size = wire_size;
+	memcpy(msg->wire, pkt->wire + offset, wire_size);
+
+	cache->msgs[cache->count++] = msg;
+	cache->max_size = MAX(cache->max_size, wire_size);
+
+	return build_begin(ctx);
+}
+
+static int build_put(axfr_build_t *ctx, const knot_rrset_t *rrset, uint16_t flags)
+{
+	int ret = knot_pkt_put(ctx->pkt, 0, rrset, flags);
+	if (ret == KNOT_ESPACE) {
+		ret = build_flush(ctx);
+		if (ret == KNOT_EOK) {
+			ret = knot_pkt_put(ctx->pkt, 0, rrset, flags);
+		}
+	}
+
+	return ret;
+}
+
+static int build_node(zone_node_t *node, void *data)
+{
+	axfr_build_t *ctx = data;
+
+	for (unsigned i = 0; i < node->rrset_count; i++) {
+		knot_rrset_t rrset = node_rrset_at(node, i);
+		if (rrset.type == KNOT_RRTYPE_SOA) {
+			continue;
+		}
+		int ret = build_put(ctx, &rrset, KNOT_PF_NOTRUNC | KNOT_PF_ORIGTTL);
+		if (ret != KNOT_EOK) {
+			return ret;
+		}
+	}
+
+	return KNOT_EOK;
+}
+
+/*! \brief Same message layout as the regular AXFR-out processing. */
+static int build_messages(axfr_cache_t *cache, const zone_contents_t *contents)
+{
+	knot_pkt_t *pkt = knot_pkt_new(NULL, AXFR_CACHE_MSG_SIZE, NULL);
+	if (pkt == NULL) {
+		return KNOT_ENOMEM;
+	}
+
+	axfr_build_t ctx = {
+		.cache = cache,
+		.pkt = pkt,
+		.apex = contents->apex->owner,
+	};
+
+	knot_rrset_t soa_rr = node_rrset(contents->apex, KNOT_RRTYPE_SOA);
+
+	int ret = build_begin(&ctx);
+	if (ret == KNOT_EOK) {
+		ret = build_put(&ctx, &soa_rr, KNOT_PF_NOTRUNC);
+	}
+	if (ret == KNOT_EOK) {
+		ret = zone_tree_apply(contents->nodes, build_node, &ctx);
+	}
+	if (ret == KNOT_EOK) {
+		ret = zone_tree_apply(contents->nsec3_nodes, build_node, &ctx);
+	}
+	if (ret == KNOT_EOK) {
+		ret = build_put(&ctx, &soa_rr, KNOT_PF_NOTRUNC);
+	}
+	if (ret == KNOT_EOK) {
+		ret = build_flush(&ctx);
+	}
+
+	knot_pkt_free(pkt);
+
+	return ret;
+}
+
+static void free_messages(axfr_cache_t *cache)
+{
+	for (size_t i = 0; i < cache->count; i++) {
+		free(cache->msgs[i]);
+	}
+	free(cache->msgs);
+	cache->msgs = NULL;
+	cache->count = 0;
+	cache->alloc = 0;
+	cache->max_size = 0;
+}
+
+axfr_cache_t *axfr_cache_new(void)
+{
+	axfr_cache_t *cache = calloc(1, sizeof(*cache));
+	if (cache == NULL) {
+		return NULL;
+	}
+
+	pthread_mutex_init(&cache->lock, NULL);
+
+	return cache;
+}
+
+void axfr_cache_free(axfr_cache_t *cache)
+{
+	if (cache == NULL) {
+		return;
+	}
+
+	free_messages(cache);
+	pthread_mutex_destroy(&cache->lock);
+	free(cache);
+}
+
+int axfr_cache_prepare(axfr_cache_t *cache, const zone_contents_t *contents)
+{
+	if (cache == NULL || contents == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	pthread_mutex_lock(&cache->lock);
+	if (cache->state == AXFR_CACHE_EMPTY) {
+		if (build_messages(cache, contents) == KNOT_EOK) {
+			cache->state = AXFR_CACHE_READY;
+		} else {
+			free_messages(cache);
+			cache->state = AXFR_CACHE_FAILED;
+		}
+	}
+	int ret = (cache->state == AXFR_CACHE_READY) ? KNOT_EOK : KNOT_ENOENT;
+	pthread_mutex_unlock(&cache->lock);
+
+	return ret;
+}
+
+size_t axfr_cache_count(const axfr_cache_t *cache)
+{
+	return (cache != NULL) ? cache->count : 0;
+}
+
+bool axfr_cache_fits(const axfr_cache_t *cache, const knot_pkt_t *resp)
+{
+	return cache != NULL &&
+	       resp->size + cache->max_size <= resp->max_size - resp->reserved;
+}
+
+int axfr_cache_get(const axfr_cache_t *cache, size_t idx, knot_pkt_t *resp)
+{
+	if (cache == NULL || idx >= cache->count ||
+	    resp->size != KNOT_WIRE_HEADER_SIZE + knot_pkt_question_size(resp)) {
+		return KNOT_EINVAL;
+	}
+
+	const axfr_msg_t *msg = cache->msgs[idx];
+	if (resp->size + msg->wire_size > resp->max_size - resp->reserved) {
+		return KNOT_ESPACE;
+	}
+
+	memcpy(resp->wire + resp->size, msg->wire, msg->wire_size);
+	resp->size += msg->wire_size;
+	knot_wire_set_ancount(resp->wire, msg->ancount);
+
+	return KNOT_EOK;
+}
@@ -0,0 +1,88 @@
+/*  Copyright (C) 2024 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "libknot/packet/pkt.h"
+
+struct zone_contents;
+
+/*!
+ * \brief Pre-built outgoing AXFR messages of one version of zone contents.
+ *
+ * The messages are built by the first transfer of the contents, the
+ * concurrent transfers of the same contents wait for it and then just copy
+ * the messages. Each message holds the answer section wire following the
+ * question (the zone name), compression pointers to the question stay valid
+ * as every AXFR query has the same QNAME length. Message ID, question case,
+ * EDNS, and TSIG are still produced per client.
+ *
+ * The cache is dropped together with the zone contents it belongs to.
+ */
+typedef struct axfr_cache axfr_cache_t;
+
+/*!
+ * \brief Create an empty AXFR cache.
+ *
+ * \return New cache or NULL on error.
+ */
+axfr_cache_t *axfr_cache_new(void);
+
+/*!
+ * \brief Free the AXFR cache including all messages.
+ */
+void axfr_cache_free(axfr_cache_t *cache);
+
+/*!
+ * \brief Build the messages if not built yet.
+ *
+ * \param cache     AXFR cache.
+ * \param contents  Zone contents the cache belongs to.
+ *
+ * \return KNOT_EOK if the messages are available, KNOT_E* otherwise (also
+ *         if building failed before).
+ */
+int axfr_cache_prepare(axfr_cache_t *cache, const struct zone_contents *contents);
+
+/*!
+ * \brief Get the number of prepared messages.
+ */
+size_t axfr_cache_count(const axfr_cache_t *cache);
+
+/*!
+ * \brief Check if any of the prepared messages fits into the response.
+ *
+ * \param cache  Prepared AXFR cache.
+ * \param resp   Response with just the header, question, and reserved space.
+ */
+bool axfr_cache_fits(const axfr_cache_t *cache, const knot_pkt_t *resp);
+
+/*!
+ * \brief Fill the response with a prepared message.
+ *
+ * The response must contain just the header and the question, answer
+ * section count is set.
+ *
+ * \param cache  Prepared AXFR cache.
+ * \param idx    Index of the message.
+ * \param resp   Response being constructed.
+ *
+ * \return KNOT_EOK, KNOT_EINVAL, KNOT_ESPACE
+ */
+int axfr_cache_get(const axfr_cache_t *cache, size_t idx, knot_pkt_t *resp);
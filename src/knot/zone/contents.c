@@ -375,8 +375,8 @@ int zone_contents_find_nsec3_for_name(const zone_contents_t *zone,
 	}
 
 	knot_dname_storage_t nsec3_name;
-	int ret = knot_create_nsec3_owner(nsec3_name, sizeof(nsec3_name),
-	                                  name, zone->apex->owner, &zone->nsec3_params);
+	int ret = nsec3_cache_owner(zone->nsec3_cache, nsec3_name, sizeof(nsec3_name),
+	                            name, zone->apex->owner, &zone->nsec3_params);
 	if (ret != KNOT_EOK) {
 		return ret;
 	}
@@ -502,6 +502,8 @@ int zone_contents_cow(zone_contents_t *from, zone_contents_t **to)
 	}
 	contents->adds_tree = from->adds_tree;
 	from->adds_tree = NULL;
+	contents->expiry_index = from->expiry_index;
+	from->expiry_index = NULL;
 	contents->size = from->size;
 	contents->max_ttl = from->max_ttl;
 
@@ -521,6 +523,10 @@ void zone_contents_free(zone_contents_t *contents)
 
 	dnssec_nsec3_params_free(&contents->nsec3_params);
 	additionals_tree_free(contents->adds_tree);
+	answer_cache_free(contents->answer_cache);
+	axfr_cache_free(contents->axfr_cache);
+	nsec3_cache_free(contents->nsec3_cache);
+	expiry_index_free(contents->expiry_index);
 
 	free(contents);
 }
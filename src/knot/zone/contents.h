@@ -19,6 +19,10 @@
 #include "contrib/atomic.h"
 #include "libdnssec/nsec.h"
 #include "libknot/rrtype/nsec3param.h"
+#include "knot/zone/answer-cache.h"
+#include "knot/zone/axfr-cache.h"
+#include "knot/zone/expiry-index.h"
+#include "knot/zone/nsec3-cache.h"
 #include "knot/zone/node.h"
 #include "knot/zone/zone-tree.h"
 
@@ -40,6 +44,11 @@ typedef struct zone_contents {
 	size_t size;
 	uint32_t max_ttl;
 	bool dnssec;
+
+	answer_cache_t *answer_cache; // optional cache of serialized answers
+	axfr_cache_t *axfr_cache; // optional pre-built AXFR messages
+	nsec3_cache_t *nsec3_cache; // optional cache of hashed next closer names
+	expiry_index_t *expiry_index; // optional index of RRSIG expirations, handed over on update
 } zone_contents_t;
 
 /*!
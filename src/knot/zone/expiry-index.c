@@ -0,0 +1,257 @@
+/*  Copyright (C) 2024 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "knot/dnssec/zone-sign.h"
+#include "knot/zone/expiry-index.h"
+#include "libknot/errcode.h"
+#include "libknot/packet/wire.h"
+#include "libknot/rrtype/rrsig.h"
+
+/*! \brief Key prefix: 32-bit bucket number and NSEC3 flag. */
+#define KEY_PREFIX	5
+
+/*!
+ * \brief Get the bucket of a node, return false if the node has nothing to be indexed.
+ */
+static bool node_bucket(const zone_node_t *node, knot_time_t now, uint32_t *bucket)
+{
+	knot_rrset_t rrsigs = node_rrset(node, KNOT_RRTYPE_RRSIG);
+
+	for (uint16_t i = 0; i < node->rrset_count; i++) {
+		knot_rrset_t rrset = node_rrset_at(node, i);
+		if (knot_zone_sign_rr_should_be_signed(node, &rrset) &&
+		    !rrsig_covers_type(&rrsigs, rrset.type)) {
+			*bucket = 0;
+			return true;
+		}
+	}
+
+	knot_time_t expire = 0;
+	knot_rdata_t *rr = rrsigs.rrs.rdata;
+	for (uint16_t i = 0; i < rrsigs.rrs.count; i++) {
+		uint32_t expiration = knot_rrsig_sig_expiration(rr);
+		expire = knot_time_min(expire, knot_time_from_u32(expiration, now));
+		rr = knot_rdataset_next(rr);
+	}
+	if (expire == 0) {
+		return false;
+	}
+
+	uint64_t b = expire / EXPIRY_INDEX_BUCKET;
+	*bucket = (b > UINT32_MAX) ? UINT32_MAX : b;
+	return true;
+}
+
+static int index_node(expiry_index_t *idx, const zone_node_t *node, bool nsec3,
+                      knot_time_t now)
+{
+	uint32_t bucket;
+	if ((node->flags & NODE_FLAGS_DELETED) || !node_bucket(node, now, &bucket)) {
+		return KNOT_EOK;
+	}
+
+	uint8_t key[KEY_PREFIX + KNOT_DNAME_MAXLEN];
+	knot_wire_write_u32(key, bucket);
+	key[4] = nsec3;
+	size_t owner_size = knot_dname_to_wire(key + KEY_PREFIX, node->owner, KNOT_DNAME_MAXLEN);
+
+	trie_val_t *val = trie_get_ins(idx->trie, key, KEY_PREFIX + owner_size);
+	if (val == NULL) {
+		return KNOT_ENOMEM;
+	}
+	*val = idx;
+
+	return KNOT_EOK;
+}
+
+static int index_tree(expiry_index_t *idx, zone_tree_t *tree, bool nsec3, knot_time_t now)
+{
+	if (zone_tree_is_empty(tree)) {
+		return KNOT_EOK;
+	}
+
+	zone_tree_it_t it = { 0 };
+	int ret = zone_tree_it_begin(tree, &it);
+	while (ret == KNOT_EOK && !zone_tree_it_finished(&it)) {
+		ret = index_node(idx, zone_tree_it_val(&it), nsec3, now);
+		zone_tree_it_next(&it);
+	}
+	zone_tree_it_free(&it);
+
+	return ret;
+}
+
+expiry_index_t *expiry_index_new(void)
+{
+	expiry_index_t *idx = calloc(1, sizeof(*idx));
+	if (idx == NULL) {
+		return NULL;
+	}
+
+	idx->trie = trie_create(NULL);
+	if (idx->trie == NULL) {
+		free(idx);
+		return NULL;
+	}
+
+	return idx;
+}
+
+void expiry_index_free(expiry_index_t *idx)
+{
+	if (idx == NULL) {
+		return;
+	}
+
+	trie_free(idx->trie);
+	free(idx);
+}
+
+int expiry_index_from_trees(expiry_index_t **idx, zone_tree_t *nodes,
+                            zone_tree_t *nsec3_nodes)
+{
+	if (idx == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	*idx = expiry_index_new();
+	if (*idx == NULL) {
+		return KNOT_ENOMEM;
+	}
+
+	int ret = expiry_index_update(*idx, nodes, nsec3_nodes);
+	if (ret != KNOT_EOK) {
+		expiry_index_free(*idx);
+		*idx = NULL;
+	}
+
+	return ret;
+}
+
+int expiry_index_rebuild(expiry_index_t *idx, zone_tree_t *nodes,
+                         zone_tree_t *nsec3_nodes)
+{
+	if (idx == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	trie_clear(idx->trie);
+
+	return expiry_index_update(idx, nodes, nsec3_nodes);
+}
+
+int expiry_index_update(expiry_index_t *idx, zone_tree_t *nodes,
+                        zone_tree_t *nsec3_nodes)
+{
+	if (idx == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	knot_time_t now = knot_time();
+
+	int ret = index_tree(idx, nodes, false, now);
+	if (ret == KNOT_EOK) {
+		ret = index_tree(idx, nsec3_nodes, true, now);
+	}
+
+	return ret;
+}
+
+int expiry_index_apply(expiry_index_t *idx, knot_time_t until,
+                       expiry_index_cb_t cb, void *ctx)
+{
+	if (idx == NULL || cb == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	trie_it_t *it = trie_it_begin(idx->trie);
+	if (it == NULL) {
+		return KNOT_ENOMEM;
+	}
+
+	int ret = KNOT_EOK;
+	while (ret == KNOT_EOK && !trie_it_finished(it)) {
+		size_t len;
+		const uint8_t *key = (const uint8_t *)trie_it_key(it, &len);
+		uint64_t start = (uint64_t)knot_wire_read_u32(key) * EXPIRY_INDEX_BUCKET;
+		if (start > until) {
+			break;
+		}
+		ret = cb(key + KEY_PREFIX, key[4], ctx);
+		trie_it_next(it);
+	}
+	trie_it_free(it);
+
+	return ret;
+}
+
+int expiry_index_drop(expiry_index_t *idx, knot_time_t until)
+{
+	if (idx == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	while (true) {
+		trie_it_t *it = trie_it_begin(idx->trie);
+		if (it == NULL) {
+			return KNOT_ENOMEM;
+		}
+		bool done = trie_it_finished(it);
+		if (!done) {
+			size_t len;
+			const uint8_t *key = (const uint8_t *)trie_it_key(it, &len);
+			uint64_t end = ((uint64_t)knot_wire_read_u32(key) + 1) * EXPIRY_INDEX_BUCKET;
+			done = (end > until);
+		}
+		if (!done) {
+			trie_it_del(it);
+		}
+		trie_it_free(it);
+		if (done) {
+			return KNOT_EOK;
+		}
+	}
+}
+
+knot_time_t expiry_index_next(expiry_index_t *idx, knot_time_t after)
+{
+	if (idx == NULL) {
+		return 0;
+	}
+
+	trie_it_t *it = trie_it_begin(idx->trie);
+	if (it == NULL) {
+		return 0;
+	}
+
+	knot_time_t next = 0;
+	while (!trie_it_finished(it)) {
+		size_t len;
+		const uint8_t *key = (const uint8_t *)trie_it_key(it, &len);
+		uint64_t start = (uint64_t)knot_wire_read_u32(key) * EXPIRY_INDEX_BUCKET;
+		if (start > after) {
+			next = start;
+			break;
+		}
+		trie_it_next(it);
+	}
+	trie_it_free(it);
+
+	return next;
+}
@@ -0,0 +1,142 @@
+/*  Copyright (C) 2024 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "contrib/qp-trie/trie.h"
+#include "contrib/time.h"
+#include "knot/zone/zone-tree.h"
+
+/*! \brief Granularity of the index in seconds. */
+#define EXPIRY_INDEX_BUCKET	3600
+
+/*!
+ * \brief Index of zone nodes by the earliest expiration of their RRSIGs.
+ *
+ * Each node with signatures is indexed under the time bucket of its earliest
+ * RRSIG expiration, a node lacking some signature is indexed as expiring
+ * immediately. The index is maintained for the changed nodes when adjusting
+ * the zone and it's handed over to the next zone contents like the additionals
+ * tree. Entries of nodes which have changed since are left behind and are
+ * dropped once their buckets are processed by signing.
+ *
+ * Complete signing of a new zone contents attaches an empty index, which gets
+ * filled when adjusting, so that the signing keys are known. Otherwise the
+ * index is created on commit without them and the next signing is complete.
+ */
+typedef struct {
+	trie_t *trie;      /*!< Keys: bucket number, NSEC3 flag, owner in wire format. */
+	uint64_t keys_id;  /*!< Signing keys the zone was completely signed with, 0 if none. */
+} expiry_index_t;
+
+/*!
+ * \brief Callback for indexed nodes.
+ *
+ * \param owner  Owner of the indexed node.
+ * \param nsec3  The node belongs to the NSEC3 tree.
+ * \param ctx    Callback context.
+ *
+ * \return KNOT_E*
+ */
+typedef int (*expiry_index_cb_t)(const knot_dname_t *owner, bool nsec3, void *ctx);
+
+/*!
+ * \brief Create an empty index.
+ *
+ * \return New index or NULL on error.
+ */
+expiry_index_t *expiry_index_new(void);
+
+/*!
+ * \brief Free the index.
+ */
+void expiry_index_free(expiry_index_t *idx);
+
+/*!
+ * \brief Create the index from all nodes of the zone trees.
+ *
+ * \param idx          Out: new index.
+ * \param nodes        Zone tree with regular nodes.
+ * \param nsec3_nodes  Zone tree with NSEC3 nodes (can be NULL).
+ *
+ * \return KNOT_E*
+ */
+int expiry_index_from_trees(expiry_index_t **idx, zone_tree_t *nodes,
+                            zone_tree_t *nsec3_nodes);
+
+/*!
+ * \brief Re-index all nodes of the zone trees, keeping the signing keys identifier.
+ *
+ * \param idx          Index to be rebuilt.
+ * \param nodes        Zone tree with regular nodes.
+ * \param nsec3_nodes  Zone tree with NSEC3 nodes (can be NULL).
+ *
+ * \return KNOT_E*
+ */
+int expiry_index_rebuild(expiry_index_t *idx, zone_tree_t *nodes,
+                         zone_tree_t *nsec3_nodes);
+
+/*!
+ * \brief Index changed nodes.
+ *
+ * \note Deleted nodes are skipped, their stale entries don't matter.
+ *
+ * \param idx          Index to be updated.
+ * \param nodes        Changed regular nodes.
+ * \param nsec3_nodes  Changed NSEC3 nodes (can be NULL).
+ *
+ * \return KNOT_E*
+ */
+int expiry_index_update(expiry_index_t *idx, zone_tree_t *nodes,
+                        zone_tree_t *nsec3_nodes);
+
+/*!
+ * \brief Call the callback for nodes indexed in buckets starting until a given time.
+ *
+ * \param idx    Index.
+ * \param until  Time limit.
+ * \param cb     Callback.
+ * \param ctx    Callback context.
+ *
+ * \return KNOT_E*
+ */
+int expiry_index_apply(expiry_index_t *idx, knot_time_t until,
+                       expiry_index_cb_t cb, void *ctx);
+
+/*!
+ * \brief Remove the entries in buckets ending until a given time.
+ *
+ * \note This is to be done after all nodes from such buckets were re-signed.
+ *
+ * \param idx    Index.
+ * \param until  Time limit.
+ *
+ * \return KNOT_E*
+ */
+int expiry_index_drop(expiry_index_t *idx, knot_time_t until);
+
+/*!
+ * \brief Get the start of the first bucket starting after a given time.
+ *
+ * \param idx    Index.
+ * \param after  Time limit.
+ *
+ * \return Start of the bucket, 0 (infinity) if there is none.
+ */
+knot_time_t expiry_index_next(expiry_index_t *idx, knot_time_t after);
@@ -0,0 +1,176 @@
+/*  Copyright (C) 2024 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "knot/dnssec/zone-nsec.h"
+#include "knot/zone/nsec3-cache.h"
+#include "libdnssec/error.h"
+#include "libdnssec/random.h"
+#include "libknot/errcode.h"
+#include "contrib/openbsd/siphash.h"
+#include "contrib/spinlock.h"
+
+/*! \brief Maximal size of a cached raw hash (SHA-1 is the only algorithm). */
+#define HASH_MAX_SIZE	20
+
+/*! \brief Number of entries in one set (the LRU tracking assumes two). */
+#define SET_WAYS	2
+
+typedef struct {
+	uint64_t key;
+	uint8_t name_size;  // zero for an empty entry
+	uint8_t hash_size;
+	uint8_t hash[HASH_MAX_SIZE];
+	knot_dname_storage_t name;
+} nsec3_entry_t;
+
+typedef struct {
+	knot_spin_t lock;
+	unsigned lru;  // index of the least recently used entry
+	nsec3_entry_t entries[SET_WAYS];
+} nsec3_set_t;
+
+struct nsec3_cache {
+	SIPHASH_KEY key;
+	size_t mask;
+	nsec3_set_t sets[];
+};
+
+static bool entry_match(const nsec3_entry_t *entry, uint64_t key,
+                        const knot_dname_t *name, size_t name_size)
+{
+	return entry->key == key && entry->name_size == name_size &&
+	       memcmp(entry->name, name, name_size) == 0;
+}
+
+static bool cache_get(nsec3_cache_t *cache, const knot_dname_t *name, size_t name_size,
+                      uint64_t key, uint8_t *hash, size_t *hash_size)
+{
+	nsec3_set_t *set = &cache->sets[key & cache->mask];
+	bool found = false;
+
+	knot_spin_lock(&set->lock);
+	for (unsigned i = 0; i < SET_WAYS; i++) {
+		nsec3_entry_t *entry = &set->entries[i];
+		if (entry_match(entry, key, name, name_size)) {
+			memcpy(hash, entry->hash, entry->hash_size);
+			*hash_size = entry->hash_size;
+			set->lru = 1 - i; // the other entry
+			found = true;
+			break;
+		}
+	}
+	knot_spin_unlock(&set->lock);
+
+	return found;
+}
+
+static void cache_put(nsec3_cache_t *cache, const knot_dname_t *name, size_t name_size,
+                      uint64_t key, const uint8_t *hash, size_t hash_size)
+{
+	nsec3_set_t *set = &cache->sets[key & cache->mask];
+
+	knot_spin_lock(&set->lock);
+	unsigned victim = set->lru;
+	for (unsigned i = 0; i < SET_WAYS; i++) {
+		if (entry_match(&set->entries[i], key, name, name_size)) {
+			victim = i; // stored meanwhile by a concurrent query
+			break;
+		}
+	}
+	nsec3_entry_t *entry = &set->entries[victim];
+	entry->key = key;
+	entry->name_size = name_size;
+	entry->hash_size = hash_size;
+	memcpy(entry->hash, hash, hash_size);
+	memcpy(entry->name, name, name_size);
+	set->lru = 1 - victim;
+	knot_spin_unlock(&set->lock);
+}
+
+nsec3_cache_t *nsec3_cache_new(size_t size)
+{
+	if (size == 0) {
+		return NULL;
+	}
+
+	size_t count = 1;
+	while (count * SET_WAYS < size) {
+		count <<= 1;
+	}
+
+	nsec3_cache_t *cache = calloc(1, sizeof(*cache) + count * sizeof(nsec3_set_t));
+	if (cache == NULL) {
+		return NULL;
+	}
+
+	cache->key.k0 = dnssec_random_uint64_t();
+	cache->key.k1 = dnssec_random_uint64_t();
+	cache->mask = count - 1;
+	for (size_t i = 0; i < count; i++) {
+		knot_spin_init(&cache->sets[i].lock);
+	}
+
+	return cache;
+}
+
+void nsec3_cache_free(nsec3_cache_t *cache)
+{
+	if (cache == NULL) {
+		return;
+	}
+
+	for (size_t i = 0; i <= cache->mask; i++) {
+		knot_spin_destroy(&cache->sets[i].lock);
+	}
+
+	free(cache);
+}
+
+int nsec3_cache_owner(nsec3_cache_t *cache, uint8_t *out, size_t out_size,
+                      const knot_dname_t *name, const knot_dname_t *apex,
+                      const dnssec_nsec3_params_t *params)
+{
+	if (cache == NULL ||
+	    dnssec_nsec3_hash_length(params->algorithm) > HASH_MAX_SIZE) {
+		return knot_create_nsec3_owner(out, out_size, name, apex, params);
+	}
+
+	if (out == NULL || name == NULL || apex == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	size_t name_size = knot_dname_size(name);
+	uint64_t key = SipHash24(&cache->key, name, name_size);
+
+	uint8_t hash[HASH_MAX_SIZE];
+	size_t hash_size = 0;
+	if (!cache_get(cache, name, name_size, key, hash, &hash_size)) {
+		dnssec_binary_t data = { .data = (uint8_t *)name, .size = name_size };
+		dnssec_binary_t bin_hash = { .data = hash, .size = sizeof(hash) };
+		int ret = dnssec_nsec3_hash_batch(&data, 1, params, &bin_hash);
+		if (ret != DNSSEC_EOK) {
+			return knot_error_from_libdnssec(ret);
+		}
+		hash_size = bin_hash.size;
+		cache_put(cache, name, name_size, key, hash, hash_size);
+	}
+
+	return knot_nsec3_hash_to_dname(out, out_size, hash, hash_size, apex);
+}
@@ -0,0 +1,63 @@
+/*  Copyright (C) 2024 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stddef.h>
+
+#include "libdnssec/nsec.h"
+#include "libknot/dname.h"
+
+/*!
+ * \brief Cache of NSEC3 hashes of names not present in the zone.
+ *
+ * Hashes of names found in the zone are precomputed during adjusting, but
+ * the next closer names of negative answers have to be hashed per query.
+ * The cache is two-way set associative with LRU replacement within a set.
+ * It's bound to one version of zone contents, so the NSEC3 parameters
+ * and the zone apex never change.
+ */
+typedef struct nsec3_cache nsec3_cache_t;
+
+/*!
+ * \brief Create an empty NSEC3 hash cache.
+ *
+ * \param size  Requested number of entries (rounded up to a power of two).
+ *
+ * \return New cache or NULL on error.
+ */
+nsec3_cache_t *nsec3_cache_new(size_t size);
+
+/*!
+ * \brief Free the NSEC3 hash cache.
+ */
+void nsec3_cache_free(nsec3_cache_t *cache);
+
+/*!
+ * \brief Create NSEC3 owner name for a given name, use the cache if any.
+ *
+ * \param cache     NSEC3 hash cache (can be NULL).
+ * \param out       Output buffer.
+ * \param out_size  Size of the output buffer.
+ * \param name      Name to be hashed.
+ * \param apex      Zone apex name.
+ * \param params    NSEC3 parameters.
+ *
+ * \return KNOT_E*
+ */
+int nsec3_cache_owner(nsec3_cache_t *cache, uint8_t *out, size_t out_size,
+                      const knot_dname_t *name, const knot_dname_t *apex,
+                      const dnssec_nsec3_params_t *params);
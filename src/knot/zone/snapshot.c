@@ -0,0 +1,393 @@
+/*  Copyright (C) 2024 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "knot/zone/snapshot.h"
+#include "knot/zone/adjust.h"
+#include "libknot/libknot.h"
+#include "contrib/files.h"
+#include "contrib/string.h"
+
+#define SNAPSHOT_SUFFIX		".snap"
+#define SNAPSHOT_MAGIC		"KNOTSNAP"
+#define SNAPSHOT_VERSION	1
+#define SNAPSHOT_ALIGN		8
+
+#define ALIGN(x) (((x) + SNAPSHOT_ALIGN - 1) & ~((size_t)SNAPSHOT_ALIGN - 1))
+
+typedef struct {
+	uint8_t magic[8];
+	uint32_t version;
+	uint32_t serial;
+	int64_t mtime_sec;
+	int64_t mtime_nsec;
+	uint64_t records;
+	uint64_t origin_size;
+} snap_header_t;
+
+/*! \brief Record header, followed by the rdata array and the owner (padded). */
+typedef struct {
+	uint32_t ttl;
+	uint16_t type;
+	uint16_t count;
+	uint32_t rdata_size;
+	uint16_t owner_size;
+	uint16_t reserved;
+} snap_record_t;
+
+typedef struct {
+	FILE *file;
+	uint64_t records;
+} snap_write_ctx_t;
+
+static const uint8_t padding[SNAPSHOT_ALIGN] = { 0 };
+
+char *zone_snapshot_path(const char *zonefile)
+{
+	if (zonefile == NULL) {
+		return NULL;
+	}
+
+	return sprintf_alloc("%s%s", zonefile, SNAPSHOT_SUFFIX);
+}
+
+#define INCLUDE_DIRECTIVE	"$INCLUDE"
+
+bool zone_snapshot_allowed(const char *zonefile)
+{
+	if (zonefile == NULL) {
+		return false;
+	}
+
+	int fd = open(zonefile, O_RDONLY);
+	if (fd < 0) {
+		return false;
+	}
+
+	struct stat st;
+	if (fstat(fd, &st) != 0) {
+		close(fd);
+		return false;
+	}
+	if (st.st_size == 0) {
+		close(fd);
+		return true;
+	}
+
+	const char *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED) {
+		return false;
+	}
+	(void)madvise((void *)data, st.st_size, MADV_SEQUENTIAL);
+
+	// Directives are case-insensitive, any occurrence is conservatively refused.
+	const size_t len = sizeof(INCLUDE_DIRECTIVE) - 1;
+	bool allowed = true;
+	const char *pos = data, *end = data + st.st_size;
+	while ((pos = memchr(pos, '$', end - pos)) != NULL) {
+		if (end - pos >= len && strncasecmp(pos, INCLUDE_DIRECTIVE, len) == 0) {
+			allowed = false;
+			break;
+		}
+		pos++;
+	}
+
+	munmap((void *)data, st.st_size);
+
+	return allowed;
+}
+
+static int write_data(FILE *file, const void *data, size_t size)
+{
+	if (size > 0 && fwrite(data, size, 1, file) != 1) {
+		return KNOT_EFILE;
+	}
+	return KNOT_EOK;
+}
+
+static int write_padding(FILE *file, size_t size)
+{
+	return write_data(file, padding, ALIGN(size) - size);
+}
+
+static int write_node(zone_node_t *node, void *data)
+{
+	snap_write_ctx_t *ctx = data;
+
+	size_t owner_size = knot_dname_size(node->owner);
+
+	for (uint16_t i = 0; i < node->rrset_count; i++) {
+		const struct rr_data *rr = &node->rrs[i];
+		snap_record_t record = {
+			.ttl = rr->ttl,
+			.type = rr->type,
+			.count = rr->rrs.count,
+			.rdata_size = rr->rrs.size,
+			.owner_size = owner_size,
+		};
+
+		int ret = write_data(ctx->file, &record, sizeof(record));
+		if (ret == KNOT_EOK) {
+			ret = write_data(ctx->file, rr->rrs.rdata, rr->rrs.size);
+		}
+		if (ret == KNOT_EOK) {
+			ret = write_data(ctx->file, node->owner, owner_size);
+		}
+		if (ret == KNOT_EOK) {
+			ret = write_padding(ctx->file, rr->rrs.size + owner_size);
+		}
+		if (ret != KNOT_EOK) {
+			return ret;
+		}
+		ctx->records++;
+	}
+
+	return KNOT_EOK;
+}
+
+int zone_snapshot_write(const char *path, const zone_contents_t *contents,
+                        const struct timespec *mtime)
+{
+	if (path == NULL || contents == NULL || mtime == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	FILE *file = NULL;
+	char *tmp_name = NULL;
+	int ret = open_tmp_file(path, &tmp_name, &file, S_IRUSR | S_IWUSR |
+	                                                S_IRGRP | S_IWGRP);
+	if (ret != KNOT_EOK) {
+		return ret;
+	}
+
+	const knot_dname_t *origin = contents->apex->owner;
+	snap_header_t header = {
+		.version = SNAPSHOT_VERSION,
+		.serial = zone_contents_serial(contents),
+		.mtime_sec = mtime->tv_sec,
+		.mtime_nsec = mtime->tv_nsec,
+		.origin_size = knot_dname_size(origin),
+	};
+	memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+
+	// The header is rewritten with the record count at the end.
+	ret = write_data(file, &header, sizeof(header));
+	if (ret == KNOT_EOK) {
+		ret = write_data(file, origin, header.origin_size);
+	}
+	if (ret == KNOT_EOK) {
+		ret = write_padding(file, header.origin_size);
+	}
+
+	// The contents trees are only read.
+	zone_contents_t *conts = (zone_contents_t *)contents;
+	snap_write_ctx_t ctx = { .file = file };
+	if (ret == KNOT_EOK) {
+		ret = zone_contents_apply(conts, write_node, &ctx);
+	}
+	if (ret == KNOT_EOK) {
+		ret = zone_contents_nsec3_apply(conts, write_node, &ctx);
+	}
+	if (ret == KNOT_EOK) {
+		header.records = ctx.records;
+		if (fseek(file, 0, SEEK_SET) != 0) {
+			ret = knot_map_errno();
+		} else {
+			ret = write_data(file, &header, sizeof(header));
+		}
+	}
+	if (fclose(file) != 0 && ret == KNOT_EOK) {
+		ret = knot_map_errno();
+	}
+
+	if (ret == KNOT_EOK && rename(tmp_name, path) != 0) {
+		ret = knot_map_errno();
+	}
+	if (ret != KNOT_EOK) {
+		unlink(tmp_name);
+	}
+	free(tmp_name);
+
+	return ret;
+}
+
+static bool check_rdata(const snap_record_t *record, const uint8_t *rdata)
+{
+	if (record->count == 0) {
+		return false;
+	}
+
+	size_t size = 0;
+	for (uint16_t i = 0; i < record->count; i++) {
+		if (record->rdata_size - size < sizeof(uint16_t)) {
+			return false;
+		}
+		const knot_rdata_t *rr = (const knot_rdata_t *)(rdata + size);
+		size += knot_rdata_size(rr->len);
+		if (size > record->rdata_size) {
+			return false;
+		}
+	}
+
+	return size == record->rdata_size;
+}
+
+static int load_records(zone_contents_t *contents, const uint8_t *pos,
+                        const uint8_t *end, uint64_t records)
+{
+	for (uint64_t i = 0; i < records; i++) {
+		snap_record_t record;
+		if ((size_t)(end - pos) < sizeof(record)) {
+			return KNOT_EMALF;
+		}
+		memcpy(&record, pos, sizeof(record));
+		pos += sizeof(record);
+
+		size_t data_size = ALIGN((size_t)record.rdata_size + record.owner_size);
+		if ((size_t)(end - pos) < data_size) {
+			return KNOT_EMALF;
+		}
+		const uint8_t *rdata = pos;
+		const uint8_t *owner = pos + record.rdata_size;
+		pos += data_size;
+
+		if (knot_dname_wire_check(owner, owner + record.owner_size, NULL) !=
+		    record.owner_size || !check_rdata(&record, rdata)) {
+			return KNOT_EMALF;
+		}
+
+		knot_rrset_t rrset;
+		knot_rrset_init(&rrset, (knot_dname_t *)owner, record.type,
+		                KNOT_CLASS_IN, record.ttl);
+		rrset.rrs.count = record.count;
+		rrset.rrs.size = record.rdata_size;
+		rrset.rrs.rdata = (knot_rdata_t *)rdata;
+
+		zone_node_t *unused = NULL;
+		int ret = zone_contents_add_rr(contents, &rrset, &unused);
+		if (ret != KNOT_EOK) {
+			return ret;
+		}
+	}
+
+	return (pos == end) ? KNOT_EOK : KNOT_EMALF;
+}
+
+static int load_contents(const uint8_t *data, size_t size,
+                         const knot_dname_t *zone_name,
+                         const struct timespec *mtime, uint32_t serial,
+                         zone_contents_t **contents)
+{
+	snap_header_t header;
+	if (size < sizeof(header)) {
+		return KNOT_EMALF;
+	}
+	memcpy(&header, data, sizeof(header));
+
+	if (memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0 ||
+	    header.version != SNAPSHOT_VERSION) {
+		return KNOT_EMALF;
+	}
+	if (header.serial != serial || header.mtime_sec != mtime->tv_sec ||
+	    header.mtime_nsec != mtime->tv_nsec) {
+		return KNOT_ENOENT;
+	}
+
+	const uint8_t *pos = data + sizeof(header);
+	size_t origin_size = knot_dname_size(zone_name);
+	if (header.origin_size != origin_size ||
+	    size - sizeof(header) < ALIGN(origin_size) ||
+	    knot_dname_wire_check(pos, pos + origin_size, NULL) != (int)origin_size ||
+	    !knot_dname_is_equal(pos, zone_name)) {
+		return KNOT_EMALF;
+	}
+	pos += ALIGN(origin_size);
+
+	zone_contents_t *conts = zone_contents_new(zone_name, true);
+	if (conts == NULL) {
+		return KNOT_ENOMEM;
+	}
+
+	int ret = load_records(conts, pos, data + size, header.records);
+	if (ret == KNOT_EOK && (!node_rrtype_exists(conts->apex, KNOT_RRTYPE_SOA) ||
+	                        zone_contents_serial(conts) != serial)) {
+		ret = KNOT_EMALF;
+	}
+
+	// Same finalization as after parsing the zone file.
+	if (ret == KNOT_EOK) {
+		ret = zone_adjust_contents(conts, adjust_cb_flags_and_nsec3,
+		                           adjust_cb_nsec3_flags, true, true, 1, NULL);
+	}
+	if (ret == KNOT_EOK) {
+		ret = zone_adjust_contents(conts, unadjust_cb_point_to_nsec3, NULL,
+		                           false, false, 1, NULL);
+	}
+	if (ret != KNOT_EOK) {
+		zone_contents_deep_free(conts);
+		return ret;
+	}
+
+	*contents = conts;
+	return KNOT_EOK;
+}
+
+int zone_snapshot_load(const char *path, const knot_dname_t *zone_name,
+                       const struct timespec *mtime, uint32_t serial,
+                       zone_contents_t **contents)
+{
+	if (path == NULL || zone_name == NULL || mtime == NULL || contents == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	int fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		return knot_map_errno();
+	}
+
+	struct stat st;
+	if (fstat(fd, &st) != 0) {
+		int ret = knot_map_errno();
+		close(fd);
+		return ret;
+	}
+	if (st.st_size < (off_t)sizeof(snap_header_t)) {
+		close(fd);
+		return KNOT_EMALF;
+	}
+
+	void *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED) {
+		return knot_map_errno();
+	}
+	(void)madvise(data, st.st_size, MADV_SEQUENTIAL);
+
+	int ret = load_contents(data, st.st_size, zone_name, mtime, serial, contents);
+
+	munmap(data, st.st_size);
+
+	return ret;
+}
@@ -0,0 +1,79 @@
+/*  Copyright (C) 2024 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <time.h>
+
+#include "knot/zone/contents.h"
+
+/*!
+ * \brief Get the path of the binary snapshot belonging to the zone file.
+ *
+ * \param zonefile  Zone file path.
+ *
+ * \return Newly allocated snapshot path or NULL on error.
+ */
+char *zone_snapshot_path(const char *zonefile);
+
+/*!
+ * \brief Check if the zone file can be represented by a snapshot.
+ *
+ * The snapshot is validated only against the zone file, so a zone file with
+ * an $INCLUDE directive (even in a comment) isn't eligible, as changes of
+ * the included files wouldn't be detected.
+ *
+ * \param zonefile  Zone file path.
+ *
+ * \return True if the zone file is readable and without $INCLUDE.
+ */
+bool zone_snapshot_allowed(const char *zonefile);
+
+/*!
+ * \brief Store the zone contents as a binary snapshot.
+ *
+ * The snapshot is a sequence of records in the native byte order, it's
+ * meant only for the same build of the server that created it.
+ *
+ * \param path      Snapshot file path.
+ * \param contents  Zone contents loaded from the zone file.
+ * \param mtime     Modification time of the zone file the contents come from.
+ *
+ * \return KNOT_E*
+ */
+int zone_snapshot_write(const char *path, const zone_contents_t *contents,
+                        const struct timespec *mtime);
+
+/*!
+ * \brief Load zone contents from a binary snapshot.
+ *
+ * The snapshot is accepted only if it belongs to the zone file with the
+ * given modification time and its SOA serial matches.
+ *
+ * \param path       Snapshot file path.
+ * \param zone_name  Zone name.
+ * \param mtime      Current modification time of the zone file.
+ * \param serial     Expected SOA serial.
+ * \param contents   Output for the loaded and adjusted zone contents.
+ *
+ * \retval KNOT_EOK     if success.
+ * \retval KNOT_ENOENT  if the snapshot doesn't exist or is outdated.
+ * \retval KNOT_EMALF   if the snapshot is malformed.
+ * \retval KNOT_E*      if other error.
+ */
+int zone_snapshot_load(const char *path, const knot_dname_t *zone_name,
+                       const struct timespec *mtime, uint32_t serial,
+                       zone_contents_t **contents);
@@ -62,6 +62,7 @@ enum timer_id {
 	TIMER_LAST_MASTER    = 0x8b,
 	TIMER_MASTER_PIN_HIT = 0x8c,
 	TIMER_LAST_SIGNED    = 0x8d,
+	TIMER_SNAPSHOT       = 0x8e,
 };
 
 #define TIMER_SIZE (sizeof(uint8_t) + sizeof(uint64_t))
@@ -100,6 +101,7 @@ static int deserialize_timers(zone_timers_t *timers_ptr,
 		case TIMER_CATALOG_MEMBER: timers.catalog_member = value; break;
 		case TIMER_NEXT_EXPIRE:    timers.next_expire = value; break;
 		case TIMER_MASTER_PIN_HIT: timers.master_pin_hit = value; break;
+		case TIMER_SNAPSHOT:       timers.snapshot_serial = value; break;
 		case TIMER_LAST_SIGNED:
 			timers.last_signed_serial = (value & 0xffffffffLLU);
 			timers.last_signed_s_flags = LAST_SIGNED_SERIAL_FOUND;
@@ -124,8 +126,8 @@ static void txn_write_timers(knot_lmdb_txn_t *txn, const knot_dname_t *zone,
 {
 	const char *format = (timers->last_master.sin6_family == AF_INET ||
 	                      timers->last_master.sin6_family == AF_INET6) ?
-	                     "BLBLBLBLBLBLBLBLBLBLBD" :
-	                     "BLBLBLBLBLBLBLBLBL";
+	                     "BLBLBLBLBLBLBLBLBLBLBLBD" :
+	                     "BLBLBLBLBLBLBLBLBLBL";
 
 	MDB_val k = { knot_dname_size(zone), (void *)zone };
 	MDB_val v = knot_lmdb_make_key(format,
@@ -138,6 +140,7 @@ static void txn_write_timers(knot_lmdb_txn_t *txn, const knot_dname_t *zone,
 		TIMER_CATALOG_MEMBER,(uint64_t)timers->catalog_member,
 		TIMER_NEXT_EXPIRE,   (uint64_t)timers->next_expire,
 		TIMER_LAST_SIGNED,   (uint64_t)timers->last_signed_serial | (((uint64_t)timers->last_signed_s_flags) << 32),
+		TIMER_SNAPSHOT,      timers->snapshot_serial,
 		TIMER_MASTER_PIN_HIT,(uint64_t)timers->master_pin_hit, // those items should be last two
 		TIMER_LAST_MASTER,   &timers->last_master, sizeof(timers->last_master));
 	knot_lmdb_insert(txn, &k, &v);
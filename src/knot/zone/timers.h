@@ -26,6 +26,7 @@
 #define LAST_NOTIFIED_SERIAL_VALID (1LLU << 32)
 #define LAST_SIGNED_SERIAL_FOUND (1 << 0)
 #define LAST_SIGNED_SERIAL_VALID (1 << 1)
+#define SNAPSHOT_SERIAL_VALID (1LLU << 32)
 
 /*!
  * \brief Persistent zone timers.
@@ -45,6 +46,7 @@ struct zone_timers {
 	time_t next_expire;            //!< Timestamp of the zone to expire.
 	struct sockaddr_in6 last_master; //!< Address of pinned master (used last time).
 	time_t master_pin_hit;         //!< Fist occurence of another master more updated than the pinned one.
+	uint64_t snapshot_serial;      //!< SOA serial of the zone file snapshot; (1<<32) if valid.
 };
 
 typedef struct zone_timers zone_timers_t;
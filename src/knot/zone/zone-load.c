@@ -51,6 +51,9 @@ int zone_load_contents(conf_t *conf, const knot_dname_t *zone_name,
 	zl.err_handler = &handler;
 	zl.creator->master = !zone_load_can_bootstrap(conf, zone_name);
 
+	val = conf_zone_get(conf, C_ADJUST_THR, zone_name);
+	zl.parse_threads = conf_int(&val);
+
 	*contents = zonefile_load(&zl, 0);
 	zonefile_close(&zl);
 	if (*contents == NULL) {
@@ -221,6 +221,23 @@ int zone_tree_del_node(zone_tree_t *tree, zone_node_t *node, bool free_deleted);
  */
 int zone_tree_apply(zone_tree_t *tree, zone_tree_apply_cb_t function, void *data);
 
+/*!
+ * \brief Applies given function to each node in one part of the zone tree.
+ *
+ * The tree is split into disjoint parts of contiguous subtrees. Applying
+ * the function to all the parts is equivalent to zone_tree_apply().
+ *
+ * \param tree      Zone tree to apply the function to.
+ * \param part      Index of the part.
+ * \param parts     Total number of parts.
+ * \param function  Function to be applied to each node of the part.
+ * \param data      Arbitrary data to be passed to the function.
+ *
+ * \return KNOT_E*
+ */
+int zone_tree_apply_part(zone_tree_t *tree, unsigned part, unsigned parts,
+                         zone_tree_apply_cb_t function, void *data);
+
 /*!
  * \brief Applies given function to each node in a subtree.
  *
@@ -23,6 +23,7 @@
 #include "knot/common/log.h"
 #include "knot/conf/module.h"
 #include "knot/dnssec/kasp/kasp_db.h"
+#include "knot/dnssec/zone-events.h"
 #include "knot/events/replan.h"
 #include "knot/journal/journal_read.h"
 #include "knot/journal/journal_write.h"
@@ -217,6 +218,11 @@ void zone_free(zone_t **zone_ptr)
 
 	zone_t *zone = *zone_ptr;
 
+	/* Pending requests may schedule zone events. */
+	if (zone->server != NULL) {
+		knot_areq_cancel(zone->server->requestor, zone);
+	}
+
 	zone_events_deinit(zone);
 
 	knot_dname_free(zone->name, NULL);
@@ -237,6 +243,12 @@ void zone_free(zone_t **zone_ptr)
 	pthread_mutex_destroy(&zone->preferred_lock);
 	free(zone->preferred_master);
 
+	/* Finished or waiting SOA check not consumed by a refresh (a plain allocation). */
+	free(zone->soa_check);
+
+	/* Unfinished background NSEC3 re-salt. */
+	knot_dnssec_nsec3resalt_free(zone);
+
 	/* Free zone contents. */
 	zone_contents_deep_free(zone->contents);
 
@@ -359,7 +371,7 @@ int selective_zone_purge(conf_t *conf, zone_t *zone, purge_flag_t params)
 
 knot_lmdb_db_t *zone_journaldb(const zone_t *zone)
 {
-	return &zone->server->journaldb;
+	return server_journaldb(zone->server, zone->name);
 }
 
 knot_lmdb_db_t *zone_kaspdb(const zone_t *zone)
@@ -377,20 +389,32 @@ catalog_update_t *zone_catalog_upd(const zone_t *zone)
 	return &zone->server->catalog_upd;
 }
 
+static int journal_insert_batch(zone_journal_t j, const zone_t *zone,
+                                changeset_t *change, changeset_t *extra,
+                                const zone_diff_t *diff)
+{
+	journal_batch_t *batch = server_journal_batch(zone->server, zone->name);
+	if (journal_batch_enabled(batch)) {
+		return journal_batch_insert(batch, j, change, extra, diff);
+	} else {
+		return journal_insert(j, change, extra, diff);
+	}
+}
+
 static int journal_insert_flush(conf_t *conf, zone_t *zone,
                                 changeset_t *change, changeset_t *extra,
                                 const zone_diff_t *diff)
 {
 	zone_journal_t j = { zone_journaldb(zone), zone->name, conf };
 
-	int ret = journal_insert(j, change, extra, diff);
+	int ret = journal_insert_batch(j, zone, change, extra, diff);
 	if (ret == KNOT_EBUSY) {
 		log_zone_notice(zone->name, "journal, flushing the zone to allow old changesets cleanup to free space");
 
 		/* Transaction rolled back, journal released, we may flush. */
 		ret = flush_journal(conf, zone, true, false);
 		if (ret == KNOT_EOK) {
-			ret = journal_insert(j, change, extra, diff);
+			ret = journal_insert_batch(j, zone, change, extra, diff);
 		}
 	}
 
@@ -33,6 +33,8 @@
 
 struct zone_update;
 struct zone_backup_ctx;
+struct refresh_soa_check;
+struct zone_nsec3_resalt;
 
 /*!
  * \brief Zone flags.
@@ -140,6 +142,10 @@ typedef struct zone
 	pthread_mutex_t preferred_lock;
 	/*! \brief Preferred master for remote operation. */
 	struct sockaddr_storage *preferred_master;
+	/*! \brief SOA query preceding the refresh, protected by preferred_lock. */
+	struct refresh_soa_check *soa_check;
+	/*! \brief NSEC3 re-salt running in background (accessed from zone events only). */
+	struct zone_nsec3_resalt *nsec3_resalt;
 
 	/*! \brief Query modules. */
 	list_t query_modules;
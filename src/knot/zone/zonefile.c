@@ -15,6 +15,7 @@
  */
 
 #include <assert.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -130,6 +131,290 @@ static void process_data(zs_scanner_t *scanner)
 	knot_rrset_clear(&rr, NULL);
 }
 
+/*! \brief Minimal zone file size worth of parallel parsing. */
+#define PARALLEL_MIN_SIZE	(1024 * 1024)
+/*! \brief Number of chunks per parsing thread (for better balancing). */
+#define PARALLEL_CHUNKS		4
+
+/*! \brief Record parsed from a zone file chunk, followed by the owner and rdata. */
+typedef struct {
+	uint32_t size;
+	uint32_t ttl;
+	uint16_t type;
+	uint16_t rclass;
+	uint16_t owner_size;
+	uint8_t owner[];
+} zrecord_t;
+
+#define ZRECORD_ALIGN(x)	(((x) + 7) & ~(size_t)7)
+
+static knot_rdata_t *zrecord_rdata(zrecord_t *rec)
+{
+	return (knot_rdata_t *)((uint8_t *)rec +
+	                        ZRECORD_ALIGN(sizeof(*rec) + rec->owner_size));
+}
+
+static void zrecord_to_rrset(zrecord_t *rec, knot_rrset_t *rr)
+{
+	knot_rrset_init(rr, rec->owner, rec->type, rec->rclass, rec->ttl);
+	rr->rrs.count = 1;
+	rr->rrs.rdata = zrecord_rdata(rec);
+	rr->rrs.size = knot_rdata_size(rr->rrs.rdata->len);
+}
+
+/*! \brief Zone file chunk and its parsed records. */
+typedef struct {
+	zs_chunk_t chunk;
+	const char *source;
+	const knot_dname_t *zone;
+	uint8_t *data;
+	size_t size;
+	size_t capacity;
+	uint64_t errors;
+	int error_code;
+	int ret;
+	bool done;
+} zchunk_t;
+
+/*! \brief Shared context of parallel zone file parsing. */
+typedef struct {
+	zchunk_t *chunks;
+	size_t count;
+	size_t next;      /*!< Next chunk to be parsed. */
+	size_t merged;    /*!< Number of chunks merged into the contents. */
+	size_t window;    /*!< Max. number of parsed chunks waiting for merge. */
+	bool stop;        /*!< Parsing interrupted due to an error. */
+	const char *origin;
+	uint32_t dflt_ttl;
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+} zparallel_t;
+
+static void process_chunk_error(zs_scanner_t *s)
+{
+	zchunk_t *ch = s->process.data;
+
+	ERROR(ch->zone, "%s in zone, file '%s', line %"PRIu64" (%s)",
+	      s->error.fatal ? "fatal error" : "error",
+	      ch->source, s->line_counter,
+	      zs_strerror(s->error.code));
+}
+
+/*! \brief Stores the record from parser input into the chunk buffer. */
+static void process_chunk_data(zs_scanner_t *s)
+{
+	zchunk_t *ch = s->process.data;
+	if (ch->ret != KNOT_EOK) {
+		s->state = ZS_STATE_STOP;
+		return;
+	}
+
+	size_t size = ZRECORD_ALIGN(ZRECORD_ALIGN(sizeof(zrecord_t) + s->r_owner_length) +
+	                            knot_rdata_size(s->r_data_length));
+	if (ch->size + size > ch->capacity) {
+		size_t capacity = MAX(2 * ch->capacity, 64 * 1024);
+		while (capacity < ch->size + size) {
+			capacity *= 2;
+		}
+		uint8_t *data = realloc(ch->data, capacity);
+		if (data == NULL) {
+			ch->ret = KNOT_ENOMEM;
+			return;
+		}
+		ch->data = data;
+		ch->capacity = capacity;
+	}
+
+	zrecord_t *rec = (zrecord_t *)(ch->data + ch->size);
+	rec->size = size;
+	rec->ttl = s->r_ttl;
+	rec->type = s->r_type;
+	rec->rclass = s->r_class;
+	rec->owner_size = s->r_owner_length;
+	memcpy(rec->owner, s->r_owner, s->r_owner_length);
+	knot_rdata_init(zrecord_rdata(rec), s->r_data_length, s->r_data);
+
+	/* Convert RDATA dnames to lowercase before adding to zone. */
+	knot_rrset_t rr;
+	zrecord_to_rrset(rec, &rr);
+	ch->ret = knot_rrset_rr_to_canonical(&rr);
+	if (ch->ret == KNOT_EOK) {
+		ch->size += size;
+	}
+}
+
+static void parse_chunk(zparallel_t *par, zchunk_t *ch)
+{
+	zs_scanner_t *s = malloc(sizeof(*s));
+	if (s == NULL) {
+		ch->ret = KNOT_ENOMEM;
+		return;
+	}
+
+	if (zs_init(s, par->origin, KNOT_CLASS_IN, par->dflt_ttl) != 0 ||
+	    zs_set_processing(s, process_chunk_data, process_chunk_error, ch) != 0 ||
+	    zs_set_input_chunk(s, &ch->chunk) != 0) {
+		ch->ret = KNOT_EFILE;
+	} else if (zs_parse_all(s) != 0 && s->error.counter == 0) {
+		ch->error_code = s->error.code;
+		ch->errors = 1;
+	} else {
+		ch->error_code = s->error.code;
+		ch->errors = s->error.counter;
+	}
+
+	zs_deinit(s);
+	free(s);
+}
+
+static void *parse_chunks_thread(void *data)
+{
+	zparallel_t *par = data;
+
+	pthread_mutex_lock(&par->lock);
+	while (!par->stop && par->next < par->count) {
+		if (par->next >= par->merged + par->window) {
+			pthread_cond_wait(&par->cond, &par->lock);
+			continue;
+		}
+		zchunk_t *ch = &par->chunks[par->next++];
+		pthread_mutex_unlock(&par->lock);
+
+		parse_chunk(par, ch);
+
+		pthread_mutex_lock(&par->lock);
+		ch->done = true;
+		pthread_cond_broadcast(&par->cond);
+	}
+	pthread_mutex_unlock(&par->lock);
+
+	return NULL;
+}
+
+static int merge_chunk(zcreator_t *zc, zchunk_t *ch)
+{
+	for (size_t pos = 0; pos < ch->size; ) {
+		zrecord_t *rec = (zrecord_t *)(ch->data + pos);
+		knot_rrset_t rr;
+		zrecord_to_rrset(rec, &rr);
+
+		int ret = zcreator_step(zc, &rr);
+		if (ret != KNOT_EOK) {
+			return ret;
+		}
+		pos += rec->size;
+	}
+
+	return KNOT_EOK;
+}
+
+/*!
+ * \brief Parses the zone file in chunks concurrently.
+ *
+ * The chunks are parsed by the threads while the calling thread merges
+ * them into the zone contents in the original order. The number of parsed
+ * chunks waiting for merge is limited to bound the memory usage.
+ *
+ * \return False if the zone file wasn't parsed, true otherwise.
+ */
+static bool zonefile_parse_parallel(zloader_t *loader, unsigned threads)
+{
+	zs_scanner_t *scanner = &loader->scanner;
+	zcreator_t *zc = loader->creator;
+
+	size_t size = scanner->input.end - scanner->input.start;
+	if (threads < 2 || size < PARALLEL_MIN_SIZE) {
+		return false;
+	}
+
+	size_t max_chunks = threads * PARALLEL_CHUNKS;
+	zs_chunk_t *split = malloc(max_chunks * sizeof(*split));
+	if (split == NULL) {
+		return false;
+	}
+	size_t count = zs_split_input(scanner->input.start, size, split, max_chunks);
+	if (count < 2) {
+		free(split);
+		return false;
+	}
+
+	char *origin = knot_dname_to_str_alloc(zc->z->apex->owner);
+	zparallel_t par = {
+		.chunks = calloc(count, sizeof(zchunk_t)),
+		.count = count,
+		.window = 2 * threads,
+		.origin = origin,
+		.dflt_ttl = scanner->default_ttl,
+	};
+	if (par.chunks == NULL || origin == NULL) {
+		free(par.chunks);
+		free(origin);
+		free(split);
+		return false;
+	}
+	for (size_t i = 0; i < count; i++) {
+		par.chunks[i].chunk = split[i];
+		par.chunks[i].source = loader->source;
+		par.chunks[i].zone = zc->z->apex->owner;
+	}
+	free(split);
+
+	pthread_mutex_init(&par.lock, NULL);
+	pthread_cond_init(&par.cond, NULL);
+
+	pthread_t thread[threads];
+	unsigned started = 0;
+	for (; started < threads; started++) {
+		if (pthread_create(&thread[started], NULL, parse_chunks_thread, &par) != 0) {
+			break;
+		}
+	}
+
+	for (size_t i = 0; started > 0 && i < count; i++) {
+		zchunk_t *ch = &par.chunks[i];
+
+		pthread_mutex_lock(&par.lock);
+		while (!ch->done) {
+			pthread_cond_wait(&par.cond, &par.lock);
+		}
+		pthread_mutex_unlock(&par.lock);
+
+		scanner->error.counter += ch->errors;
+		if (ch->errors > 0) {
+			scanner->error.code = ch->error_code;
+		}
+		zc->ret = (ch->ret != KNOT_EOK) ? ch->ret : merge_chunk(zc, ch);
+		free(ch->data);
+		ch->data = NULL;
+
+		pthread_mutex_lock(&par.lock);
+		par.merged++;
+		if (zc->ret != KNOT_EOK) {
+			par.stop = true;
+		}
+		pthread_cond_broadcast(&par.cond);
+		pthread_mutex_unlock(&par.lock);
+
+		if (zc->ret != KNOT_EOK) {
+			break;
+		}
+	}
+
+	for (unsigned i = 0; i < started; i++) {
+		pthread_join(thread[i], NULL);
+	}
+	for (size_t i = 0; i < count; i++) {
+		free(par.chunks[i].data);
+	}
+
+	pthread_cond_destroy(&par.cond);
+	pthread_mutex_destroy(&par.lock);
+	free(par.chunks);
+	free(origin);
+
+	return started > 0;
+}
+
 int zonefile_open(zloader_t *loader, const char *source, const knot_dname_t *origin,
                   uint32_t dflt_ttl, semcheck_optional_t semantic_checks, time_t time)
 {
@@ -194,7 +479,10 @@ zone_contents_t *zonefile_load(zloader_t *loader, uint16_t threads)
 	const knot_dname_t *zname = zc->z->apex->owner;
 
 	assert(zc);
-	int ret = zs_parse_all(&loader->scanner);
+	int ret = 0;
+	if (!zonefile_parse_parallel(loader, loader->parse_threads)) {
+		ret = zs_parse_all(&loader->scanner);
+	}
 	if (ret != 0 && loader->scanner.error.counter == 0) {
 		ERROR(zname, "failed to load zone, file '%s' (%s)",
 		      loader->source, zs_strerror(loader->scanner.error.code));
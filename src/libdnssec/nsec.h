@@ -106,6 +106,25 @@ int dnssec_nsec3_hash(const dnssec_binary_t *data,
 		      const dnssec_nsec3_params_t *params,
 		      dnssec_binary_t *hash);
 
+/*!
+ * Compute NSEC3 hashes for multiple data at once.
+ *
+ * SHA-1 hashes of several data are computed in parallel using vector
+ * instructions, which is considerably faster than repeated calls to
+ * \ref dnssec_nsec3_hash when hashing many domain names.
+ *
+ * \param[in]  data    Data to be hashed (usually domain names).
+ * \param[in]  count   Number of data.
+ * \param[in]  params  NSEC3 parameters.
+ * \param[out] hashes  Preallocated hashes of \ref dnssec_nsec3_hash_length
+ *                     size at least, sizes are updated.
+ *
+ * \return Error code, DNSSEC_EOK if successful.
+ */
+int dnssec_nsec3_hash_batch(const dnssec_binary_t *data, size_t count,
+			    const dnssec_nsec3_params_t *params,
+			    dnssec_binary_t *hashes);
+
 /*!
  * Get length of raw NSEC3 hash for a given algorithm.
  *
@@ -21,6 +21,7 @@
 
 #include "libdnssec/error.h"
 #include "libdnssec/nsec.h"
+#include "libdnssec/nsec/sha1_mb.h"
 #include "libdnssec/shared/shared.h"
 
 /*!
@@ -110,6 +111,95 @@ int dnssec_nsec3_hash(const dnssec_binary_t *data,
 	return nsec3_hash(algorithm, params->iterations, &params->salt, data, hash);
 }
 
+/*!
+ * Compute SHA-1 NSEC3 hashes of as many data as the implementation handles at once.
+ */
+static void nsec3_hash_sha1_mb(const dnssec_binary_t *data[], size_t count,
+			       const dnssec_nsec3_params_t *params,
+			       dnssec_binary_t *hashes[])
+{
+	const uint8_t *in[SHA1_MB_MAX_LANES] = { 0 };
+	size_t in_size[SHA1_MB_MAX_LANES] = { 0 };
+	uint8_t digests[SHA1_MB_MAX_LANES][SHA1_MB_DIGEST];
+
+	for (size_t i = 0; i < count; i++) {
+		in[i] = data[i]->data;
+		in_size[i] = data[i]->size;
+	}
+
+	SHA1_MB.nsec3_hash(in, in_size, params->salt.data, params->salt.size,
+	                   params->iterations, count, digests);
+
+	for (size_t i = 0; i < count; i++) {
+		memcpy(hashes[i]->data, digests[i], SHA1_MB_DIGEST);
+		hashes[i]->size = SHA1_MB_DIGEST;
+	}
+}
+
+/*!
+ * Compute NSEC3 hashes for multiple data.
+ */
+_public_
+int dnssec_nsec3_hash_batch(const dnssec_binary_t *data, size_t count,
+			    const dnssec_nsec3_params_t *params,
+			    dnssec_binary_t *hashes)
+{
+	if (!data || !params || !hashes) {
+		return DNSSEC_EINVAL;
+	}
+
+	gnutls_digest_algorithm_t algorithm = algorithm_d2g(params->algorithm);
+	if (algorithm == GNUTLS_DIG_UNKNOWN) {
+		return DNSSEC_INVALID_NSEC3_ALGORITHM;
+	}
+
+	size_t hash_size = gnutls_hash_get_len(algorithm);
+	for (size_t i = 0; i < count; i++) {
+		if (!data[i].data || !hashes[i].data || hashes[i].size < hash_size) {
+			return DNSSEC_EINVAL;
+		}
+	}
+
+	// Data not fitting the vectorized implementation are hashed one by one.
+	size_t max_size = 0;
+	if (algorithm == GNUTLS_DIG_SHA1 &&
+	    params->salt.size <= SHA1_MB_MAX_INPUT - SHA1_MB_DIGEST) {
+		max_size = SHA1_MB_MAX_INPUT - params->salt.size;
+	}
+
+	const dnssec_binary_t *batch_data[SHA1_MB_MAX_LANES];
+	dnssec_binary_t *batch_hashes[SHA1_MB_MAX_LANES];
+	size_t batch = 0;
+
+	for (size_t i = 0; i < count; i++) {
+		if (data[i].size > max_size) {
+			dnssec_binary_t hash = { 0 };
+			int ret = nsec3_hash(algorithm, params->iterations,
+					     &params->salt, &data[i], &hash);
+			if (ret != DNSSEC_EOK) {
+				return ret;
+			}
+			memcpy(hashes[i].data, hash.data, hash.size);
+			hashes[i].size = hash.size;
+			dnssec_binary_free(&hash);
+			continue;
+		}
+
+		batch_data[batch] = &data[i];
+		batch_hashes[batch] = &hashes[i];
+		if (++batch == SHA1_MB.lanes) {
+			nsec3_hash_sha1_mb(batch_data, batch, params, batch_hashes);
+			batch = 0;
+		}
+	}
+
+	if (batch > 0) {
+		nsec3_hash_sha1_mb(batch_data, batch, params, batch_hashes);
+	}
+
+	return DNSSEC_EOK;
+}
+
 /*!
  * Get length of raw NSEC3 hash for a given algorithm.
  */
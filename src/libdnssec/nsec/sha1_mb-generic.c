@@ -0,0 +1,24 @@
+/*  Copyright (C) 2024 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// SSE2 and NEON are part of the baseline of the respective architectures,
+// the compiler chooses them for the 16-byte vectors.
+#define LANES 4
+
+#include "libdnssec/nsec/sha1_mb.inc.c"
+
+const struct sha1_mb_api SHA1_MB_GENERIC = SHA1_MB_INITIALIZER;
+struct sha1_mb_api SHA1_MB = SHA1_MB_INITIALIZER; // generic version is the default
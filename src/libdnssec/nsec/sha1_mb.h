@@ -0,0 +1,60 @@
+/*  Copyright (C) 2024 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*! Maximal number of data hashed at once by any implementation. */
+#define SHA1_MB_MAX_LANES	8
+
+/*! Size of the SHA-1 digest. */
+#define SHA1_MB_DIGEST	20
+
+/*! Maximal total size of the data and the salt. */
+#define SHA1_MB_MAX_INPUT	(9 * 64 - 9)
+
+/*!
+ * Multi-buffer SHA-1 implementation.
+ */
+struct sha1_mb_api {
+	/*! Number of data hashed at once. */
+	size_t lanes;
+
+	/*!
+	 * Compute NSEC3 SHA-1 hashes of up to 'lanes' data in parallel.
+	 *
+	 * \see RFC 5155
+	 *
+	 * \param data        Data to be hashed.
+	 * \param data_len    Lengths of the data.
+	 * \param salt        NSEC3 salt.
+	 * \param salt_len    Length of the salt.
+	 * \param iterations  Number of additional iterations.
+	 * \param count       Number of data (at most 'lanes').
+	 * \param digests     Output hashes.
+	 *
+	 * \note Each data length plus the salt length must not exceed
+	 *       SHA1_MB_MAX_INPUT.
+	 */
+	void (*nsec3_hash)(const uint8_t *data[], const size_t data_len[],
+	                   const uint8_t *salt, size_t salt_len, unsigned iterations,
+	                   size_t count, uint8_t digests[][SHA1_MB_DIGEST]);
+};
+
+extern struct sha1_mb_api SHA1_MB; // the best implementation available
+extern const struct sha1_mb_api SHA1_MB_GENERIC, SHA1_MB_AVX2; // specific implementations, use with care
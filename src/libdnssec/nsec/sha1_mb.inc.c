@@ -0,0 +1,201 @@
+/*  Copyright (C) 2024 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * SHA-1 (FIPS 180-4) processing multiple messages in the lanes of a vector,
+ * included by sha1_mb-*.c with LANES defined.
+ *
+ * GCC vector extensions are used, which compile into SSE2, AVX2, or NEON
+ * instructions depending on the target and into scalar code elsewhere.
+ * The messages may differ in length, lanes with fewer blocks just keep
+ * their state while the longer messages are being finished.
+ */
+
+#include <assert.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "contrib/wire_ctx.h"
+#include "libdnssec/nsec/sha1_mb.h"
+
+_Static_assert(LANES <= SHA1_MB_MAX_LANES, "too many lanes");
+
+#define BLOCK_SIZE	64
+#define MAX_BLOCKS	((SHA1_MB_MAX_INPUT + 9 + BLOCK_SIZE - 1) / BLOCK_SIZE)
+
+typedef uint32_t vec_t __attribute__((vector_size(4 * LANES)));
+
+static inline vec_t splat(uint32_t x)
+{
+	return (vec_t){ 0 } + x;
+}
+
+static inline vec_t rol(vec_t x, int n)
+{
+	return (x << n) | (x >> (32 - n));
+}
+
+#define ROUNDS(from, to, f, k) \
+	for (int t = from; t < to; t++) { \
+		vec_t tmp = rol(a, 5) + (f) + e + k + w[t]; \
+		e = d; \
+		d = c; \
+		c = rol(b, 30); \
+		b = a; \
+		a = tmp; \
+	}
+
+static void compress(vec_t state[5], const uint8_t *blocks[LANES])
+{
+	vec_t w[80];
+	for (int t = 0; t < 16; t++) {
+		uint32_t words[LANES];
+		for (int i = 0; i < LANES; i++) {
+			memcpy(&words[i], blocks[i] + 4 * t, sizeof(words[i]));
+			words[i] = be32toh(words[i]);
+		}
+		memcpy(&w[t], words, sizeof(w[t]));
+	}
+	for (int t = 16; t < 80; t++) {
+		w[t] = rol(w[t - 3] ^ w[t - 8] ^ w[t - 14] ^ w[t - 16], 1);
+	}
+
+	const vec_t k1 = splat(0x5a827999), k2 = splat(0x6ed9eba1),
+	            k3 = splat(0x8f1bbcdc), k4 = splat(0xca62c1d6);
+
+	vec_t a = state[0], b = state[1], c = state[2], d = state[3], e = state[4];
+
+	ROUNDS( 0, 20, d ^ (b & (c ^ d)), k1);
+	ROUNDS(20, 40, b ^ c ^ d, k2);
+	ROUNDS(40, 60, (b & c) | (d & (b | c)), k3);
+	ROUNDS(60, 80, b ^ c ^ d, k4);
+
+	state[0] += a;
+	state[1] += b;
+	state[2] += c;
+	state[3] += d;
+	state[4] += e;
+}
+
+/*!
+ * Write the message with SHA-1 padding into the buffer, return block count.
+ */
+static size_t pad_message(uint8_t *buf, const uint8_t *prefix, size_t prefix_len,
+                          const uint8_t *suffix, size_t suffix_len)
+{
+	size_t len = prefix_len + suffix_len;
+	size_t blocks = (len + 9 + BLOCK_SIZE - 1) / BLOCK_SIZE;
+	assert(blocks <= MAX_BLOCKS);
+
+	memmove(buf, prefix, prefix_len);
+	memcpy(buf + prefix_len, suffix, suffix_len);
+	buf[len] = 0x80;
+	memset(buf + len + 1, 0, blocks * BLOCK_SIZE - len - 1 - 8);
+
+	wire_ctx_t wire = wire_ctx_init(buf + blocks * BLOCK_SIZE - 8, 8);
+	wire_ctx_write_u64(&wire, (uint64_t)len * 8);
+
+	return blocks;
+}
+
+/*!
+ * Hash the padded messages, lanes beyond the count are idle.
+ */
+static void hash_blocks(vec_t state[5], uint8_t buf[][MAX_BLOCKS * BLOCK_SIZE],
+                        const size_t blocks[LANES])
+{
+	static const uint8_t idle_block[BLOCK_SIZE] = { 0 };
+
+	state[0] = splat(0x67452301);
+	state[1] = splat(0xefcdab89);
+	state[2] = splat(0x98badcfe);
+	state[3] = splat(0x10325476);
+	state[4] = splat(0xc3d2e1f0);
+
+	size_t max_blocks = 0;
+	for (int i = 0; i < LANES; i++) {
+		if (blocks[i] > max_blocks) {
+			max_blocks = blocks[i];
+		}
+	}
+
+	for (size_t n = 0; n < max_blocks; n++) {
+		const uint8_t *in[LANES];
+		vec_t active;
+		for (int i = 0; i < LANES; i++) {
+			bool act = (n < blocks[i]);
+			in[i] = act ? buf[i] + n * BLOCK_SIZE : idle_block;
+			active[i] = act ? UINT32_MAX : 0;
+		}
+
+		vec_t prev[5];
+		memcpy(prev, state, sizeof(prev));
+		compress(state, in);
+		for (int j = 0; j < 5; j++) {
+			state[j] = (state[j] & active) | (prev[j] & ~active);
+		}
+	}
+}
+
+static void write_digest(uint8_t *out, const vec_t state[5], int lane)
+{
+	wire_ctx_t wire = wire_ctx_init(out, SHA1_MB_DIGEST);
+	for (int j = 0; j < 5; j++) {
+		wire_ctx_write_u32(&wire, state[j][lane]);
+	}
+}
+
+static void nsec3_hash(const uint8_t *data[], const size_t data_len[],
+                       const uint8_t *salt, size_t salt_len, unsigned iterations,
+                       size_t count, uint8_t digests[][SHA1_MB_DIGEST])
+{
+	assert(count <= LANES);
+
+	uint8_t buf[LANES][MAX_BLOCKS * BLOCK_SIZE];
+	size_t blocks[LANES] = { 0 };
+	vec_t state[5];
+
+	for (size_t i = 0; i < count; i++) {
+		blocks[i] = pad_message(buf[i], data[i], data_len[i], salt, salt_len);
+	}
+	hash_blocks(state, buf, blocks);
+
+	// Further iterations hash the previous digest and the salt, the padded
+	// messages differ just in the digest.
+	if (iterations > 0) {
+		for (size_t i = 0; i < count; i++) {
+			write_digest(buf[i], state, i);
+			blocks[i] = pad_message(buf[i], buf[i], SHA1_MB_DIGEST,
+			                        salt, salt_len);
+		}
+		hash_blocks(state, buf, blocks);
+	}
+	for (unsigned it = 1; it < iterations; it++) {
+		for (size_t i = 0; i < count; i++) {
+			write_digest(buf[i], state, i);
+		}
+		hash_blocks(state, buf, blocks);
+	}
+
+	for (size_t i = 0; i < count; i++) {
+		write_digest(digests[i], state, i);
+	}
+}
+
+#define SHA1_MB_INITIALIZER { \
+	.lanes = LANES, \
+	.nsec3_hash = nsec3_hash, \
+}
@@ -96,6 +96,42 @@ int dnssec_sign_add(dnssec_sign_ctx_t *ctx, const dnssec_binary_t *data);
 int dnssec_sign_write(dnssec_sign_ctx_t *ctx, dnssec_sign_flags_t flags,
                       dnssec_binary_t *signature);
 
+/*!
+ * Get maximal size of a signature in DNSSEC format made with the context key.
+ *
+ * \param ctx  Signing context.
+ *
+ * \return Signature size in bytes, zero if unknown.
+ */
+size_t dnssec_sign_size(const dnssec_sign_ctx_t *ctx);
+
+/*!
+ * Signing job to be processed by \ref dnssec_sign_batch.
+ */
+typedef struct dnssec_sign_job {
+	dnssec_sign_ctx_t *ctx;     //!< Signing context determining the key.
+	dnssec_binary_t data;       //!< Complete data to be signed.
+	dnssec_binary_t signature;  //!< Preallocated output, size set to the signature size.
+	int result;                 //!< Result of the job.
+} dnssec_sign_job_t;
+
+/*!
+ * Write down DNSSEC signatures of multiple data at once.
+ *
+ * Unlike \ref dnssec_sign_write, the data are signed in place without being
+ * copied into the signing context, and the signatures are written directly
+ * into buffers provided by the caller (see \ref dnssec_sign_size), so that
+ * no memory is allocated per signature. The contexts are left untouched.
+ *
+ * \param jobs   Signing jobs.
+ * \param count  Number of the jobs.
+ * \param flags  Additional flags to be used for signing.
+ *
+ * \return Error code of the first failed job, DNSSEC_EOK if all succeeded.
+ */
+int dnssec_sign_batch(dnssec_sign_job_t *jobs, size_t count,
+                      dnssec_sign_flags_t flags);
+
 /*!
  * Verify DNSSEC signature.
  *
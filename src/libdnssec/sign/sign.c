@@ -36,7 +36,8 @@
  *
  * \param ctx   DNSSEC signing context.
  * \param from  Data in source format.
- * \param to    Allocated data in target format.
+ * \param to    Data in target format. Allocated by the callback if empty,
+ *              otherwise written into and its size updated.
  *
  * \return Error code, DNSSEC_EOK if successful.
  */
@@ -44,14 +45,25 @@ typedef int (*signature_convert_cb)(dnssec_sign_ctx_t *ctx,
 				    const dnssec_binary_t *from,
 				    dnssec_binary_t *to);
 
+/*!
+ * Signature size callback.
+ *
+ * \param ctx  DNSSEC signing context.
+ *
+ * \return Maximal size of the signature in DNSSEC format, zero if unknown.
+ */
+typedef size_t (*signature_size_cb)(const dnssec_sign_ctx_t *ctx);
+
 /*!
  * Algorithm specific callbacks.
  */
 typedef struct algorithm_functions {
-	//! Convert X.509 signature to DNSSEC format.
+	//! Convert X.509 signature to DNSSEC format into a preallocated buffer.
 	signature_convert_cb x509_to_dnssec;
 	//! Convert DNSSEC signature to X.509 format.
 	signature_convert_cb dnssec_to_x509;
+	//! Get maximal size of the signature in DNSSEC format.
+	signature_size_cb dnssec_size;
 } algorithm_functions_t;
 
 typedef struct dnssec_buffer {
@@ -74,6 +86,24 @@ struct dnssec_sign_ctx {
 
 /* -- signature format conversions ----------------------------------------- */
 
+/*!
+ * Prepare the output of a signature conversion.
+ *
+ * Allocates the output if empty, otherwise checks that the output buffer
+ * is large enough and sets its final size.
+ */
+static int output_prepare(dnssec_binary_t *to, size_t size)
+{
+	if (to->data == NULL) {
+		return dnssec_binary_alloc(to, size);
+	} else if (to->size < size) {
+		return DNSSEC_ENOMEM;
+	}
+
+	to->size = size;
+	return DNSSEC_EOK;
+}
+
 /*!
  * Conversion of RSA signature between X.509 and DNSSEC format is a NOOP.
  *
@@ -87,15 +117,30 @@ static int rsa_copy_signature(dnssec_sign_ctx_t *ctx,
 	assert(from);
 	assert(to);
 
-	return dnssec_binary_dup(from, to);
+	int result = output_prepare(to, from->size);
+	if (result != DNSSEC_EOK) {
+		return result;
+	}
+
+	memcpy(to->data, from->data, from->size);
+
+	return DNSSEC_EOK;
+}
+
+static size_t rsa_signature_size(const dnssec_sign_ctx_t *ctx)
+{
+	assert(ctx);
+
+	return (dnssec_key_get_size(ctx->key) + 7) / 8;
 }
 
 static const algorithm_functions_t rsa_functions = {
 	.x509_to_dnssec = rsa_copy_signature,
 	.dnssec_to_x509 = rsa_copy_signature,
+	.dnssec_size = rsa_signature_size,
 };
 
-static size_t ecdsa_sign_integer_size(dnssec_sign_ctx_t *ctx)
+static size_t ecdsa_sign_integer_size(const dnssec_sign_ctx_t *ctx)
 {
 	assert(ctx);
 
@@ -135,7 +180,7 @@ static int ecdsa_x509_to_dnssec(dnssec_sign_ctx_t *ctx,
 		return DNSSEC_MALFORMED_DATA;
 	}
 
-	result = dnssec_binary_alloc(dnssec, 2 * int_size);
+	result = output_prepare(dnssec, 2 * int_size);
 	if (result != DNSSEC_EOK) {
 		return result;
 	}
@@ -168,15 +213,35 @@ static int ecdsa_dnssec_to_x509(dnssec_sign_ctx_t *ctx,
 	return dss_sig_value_encode(&value_r, &value_s, x509);
 }
 
+static size_t ecdsa_signature_size(const dnssec_sign_ctx_t *ctx)
+{
+	return 2 * ecdsa_sign_integer_size(ctx);
+}
+
 static const algorithm_functions_t ecdsa_functions = {
 	.x509_to_dnssec = ecdsa_x509_to_dnssec,
 	.dnssec_to_x509 = ecdsa_dnssec_to_x509,
+	.dnssec_size = ecdsa_signature_size,
 };
 
+static size_t eddsa_signature_size(const dnssec_sign_ctx_t *ctx)
+{
+	assert(ctx);
+
+	switch (ctx->sign_algorithm) {
+	case GNUTLS_SIGN_EDDSA_ED25519: return 64;
+#ifdef HAVE_ED448
+	case GNUTLS_SIGN_EDDSA_ED448: return 114;
+#endif
+	default: return 0;
+	};
+}
+
 #define eddsa_copy_signature rsa_copy_signature
 static const algorithm_functions_t eddsa_functions = {
 	.x509_to_dnssec = eddsa_copy_signature,
 	.dnssec_to_x509 = eddsa_copy_signature,
+	.dnssec_size = eddsa_signature_size,
 };
 
 /* -- crypto helper functions --------------------------------------------- */
@@ -309,22 +374,21 @@ int dnssec_sign_add(dnssec_sign_ctx_t *ctx, const dnssec_binary_t *data)
 	return DNSSEC_EOK;
 }
 
-_public_
-int dnssec_sign_write(dnssec_sign_ctx_t *ctx, dnssec_sign_flags_t flags, dnssec_binary_t *signature)
+/*!
+ * Sign the data and write the signature in DNSSEC format.
+ *
+ * \param ctx        Signing context.
+ * \param flags      Signing flags.
+ * \param data       Data to be signed.
+ * \param signature  Signature, allocated if empty, otherwise written into.
+ */
+static int sign_data(dnssec_sign_ctx_t *ctx, dnssec_sign_flags_t flags,
+		     const gnutls_datum_t *data, dnssec_binary_t *signature)
 {
-	if (!ctx || !signature) {
-		return DNSSEC_EINVAL;
-	}
-
 	if (!dnssec_key_can_sign(ctx->key)) {
 		return DNSSEC_NO_PRIVATE_KEY;
 	}
 
-	gnutls_datum_t data = {
-		.data = vpool_get_buf(&ctx->buffer),
-		.size = vpool_get_length(&ctx->buffer)
-	};
-
 	unsigned gnutls_flags = 0;
 	if (flags & DNSSEC_SIGN_REPRODUCIBLE) {
 		gnutls_flags |= GNUTLS_PRIVKEY_FLAG_REPRODUCIBLE;
@@ -334,7 +398,7 @@ int dnssec_sign_write(dnssec_sign_ctx_t *ctx, dnssec_sign_flags_t flags, dnssec_
 	_cleanup_datum_ gnutls_datum_t raw = { 0 };
 	int result = gnutls_privkey_sign_data2(ctx->key->private_key,
 					       ctx->sign_algorithm,
-					       gnutls_flags, &data, &raw);
+					       gnutls_flags, data, &raw);
 	if (result < 0) {
 		return DNSSEC_SIGN_ERROR;
 	}
@@ -344,6 +408,59 @@ int dnssec_sign_write(dnssec_sign_ctx_t *ctx, dnssec_sign_flags_t flags, dnssec_
 	return ctx->functions->x509_to_dnssec(ctx, &bin_raw, signature);
 }
 
+_public_
+int dnssec_sign_write(dnssec_sign_ctx_t *ctx, dnssec_sign_flags_t flags, dnssec_binary_t *signature)
+{
+	if (!ctx || !signature) {
+		return DNSSEC_EINVAL;
+	}
+
+	gnutls_datum_t data = {
+		.data = vpool_get_buf(&ctx->buffer),
+		.size = vpool_get_length(&ctx->buffer)
+	};
+
+	*signature = (dnssec_binary_t) { 0 };
+
+	return sign_data(ctx, flags, &data, signature);
+}
+
+_public_
+size_t dnssec_sign_size(const dnssec_sign_ctx_t *ctx)
+{
+	if (!ctx) {
+		return 0;
+	}
+
+	return ctx->functions->dnssec_size(ctx);
+}
+
+_public_
+int dnssec_sign_batch(dnssec_sign_job_t *jobs, size_t count, dnssec_sign_flags_t flags)
+{
+	if (!jobs) {
+		return DNSSEC_EINVAL;
+	}
+
+	int result = DNSSEC_EOK;
+
+	for (size_t i = 0; i < count; i++) {
+		dnssec_sign_job_t *job = &jobs[i];
+		if (!job->ctx || !job->data.data || !job->signature.data) {
+			job->result = DNSSEC_EINVAL;
+		} else {
+			gnutls_datum_t data = binary_to_datum(&job->data);
+			job->result = sign_data(job->ctx, flags, &data, &job->signature);
+		}
+
+		if (result == DNSSEC_EOK) {
+			result = job->result;
+		}
+	}
+
+	return result;
+}
+
 _public_
 int dnssec_sign_verify(dnssec_sign_ctx_t *ctx, bool sign_cmp, const dnssec_binary_t *signature)
 {
@@ -478,13 +478,7 @@ void knot_dname_to_lower(knot_dname_t *name)
 		return;
 	}
 
-	while (*name != '\0') {
-		uint8_t len = *name;
-		for (uint8_t i = 1; i <= len; ++i) {
-			name[i] = knot_tolower(name[i]);
-		}
-		name += 1 + len;
-	}
+	KNOT_TOLOWER.copy(name, name, knot_dname_size(name));
 }
 
 _public_
@@ -494,16 +488,7 @@ void knot_dname_copy_lower(knot_dname_t *dst, const knot_dname_t *name)
 		return;
 	}
 
-	while (*name != '\0') {
-		uint8_t len = *name;
-		*dst = len;
-		for (uint8_t i = 1; i <= len; ++i) {
-			dst[i] = knot_tolower(name[i]);
-		}
-		dst += 1 + len;
-		name += 1 + len;
-	}
-	*dst = '\0';
+	KNOT_TOLOWER.copy(dst, name, knot_dname_size(name));
 }
 
 _public_
@@ -682,16 +667,14 @@ inline static bool dname_is_equal(const knot_dname_t *d1, const knot_dname_t *d2
 		return false;
 	}
 
-	while (*d1 != '\0' || *d2 != '\0') {
-		if (label_is_equal(d1, d2, no_case)) {
-			d1 = knot_dname_next_label(d1);
-			d2 = knot_dname_next_label(d2);
-		} else {
-			return false;
-		}
+	/* Equal wire bytes imply equal label structure (length octets
+	   aren't affected by lowercasing), so whole names are compared. */
+	size_t size = knot_dname_size(d1);
+	if (size != knot_dname_size(d2)) {
+		return false;
 	}
 
-	return true;
+	return no_case ? KNOT_TOLOWER.equal(d1, d2, size) : memcmp(d1, d2, size) == 0;
 }
 
 _public_
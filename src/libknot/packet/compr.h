@@ -25,7 +25,9 @@
 
 #pragma once
 
+#include <stdbool.h>
 #include <stdint.h>
+#include <string.h>
 
 #include "libknot/packet/wire.h"
 
@@ -63,6 +65,29 @@ typedef struct {
 	uint16_t compress_ptr[KNOT_COMPR_HINT_COUNT]; /* Array of compr. ptr hints. */
 } knot_rrinfo_t;
 
+/*! \brief Compression table parameters. */
+enum knot_compr_table_size {
+	KNOT_COMPR_TABLE_SLOTS   = 2048, /* Number of hash table slots. */
+	KNOT_COMPR_TABLE_MAX     = 1536, /* Maximum number of stored suffixes. */
+};
+
+/*!
+ * \brief Table of name suffixes written to the packet.
+ *
+ * Open-addressing hash of lowercased name suffixes to their positions in the
+ * wire. Unlike the last-suffix heuristics, it allows pointing to any suffix
+ * written within the compression pointer range.
+ */
+typedef struct {
+	struct {
+		uint32_t hash;
+		uint16_t pos;  /* Zero for an empty slot. */
+	} slots[KNOT_COMPR_TABLE_SLOTS];
+	uint16_t log[KNOT_COMPR_TABLE_MAX]; /* Used slots in insertion order. */
+	uint16_t count;  /* Number of used slots. */
+	bool seeded;     /* QNAME suffixes already stored. */
+} knot_compr_table_t;
+
 /*!
  * \brief Name compression context.
  */
@@ -73,6 +98,7 @@ typedef struct knot_compr {
 		uint16_t pos;   /* Position of current suffix. */
 		uint8_t labels; /* Label count of the suffix. */
 	} suffix;
+	knot_compr_table_t *table; /* Optional suffix table (may be NULL). */
 } knot_compr_t;
 
 /*!
@@ -98,4 +124,40 @@ static inline void knot_compr_hint_set(knot_rrinfo_t *info, uint16_t hint_id,
 	}
 }
 
+/*!
+ * \brief Forget all suffixes stored in the compression table.
+ */
+static inline void knot_compr_table_clear(knot_compr_table_t *table)
+{
+	if (table == NULL) {
+		return;
+	}
+	if (table->count > 0) {
+		memset(table->slots, 0, sizeof(table->slots));
+		table->count = 0;
+	}
+	table->seeded = false;
+}
+
+/*!
+ * \brief Remove suffixes stored after the table had given number of them.
+ *
+ * \note Used to drop positions of a partially written RRSet. The slots are
+ *       emptied in reverse insertion order, which restores the exact probing
+ *       state the table had before, so no tombstones are left behind.
+ */
+static inline void knot_compr_table_rollback(knot_compr_table_t *table,
+                                             uint16_t count)
+{
+	if (table == NULL) {
+		return;
+	} else if (count == 0) {
+		knot_compr_table_clear(table);
+		return;
+	}
+	while (table->count > count) {
+		table->slots[table->log[--table->count]].pos = 0;
+	}
+}
+
 /*! @} */
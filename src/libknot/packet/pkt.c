@@ -176,6 +176,7 @@ static void compr_clear(knot_compr_t *compr)
 	compr->rrinfo = NULL;
 	compr->suffix.pos = 0;
 	compr->suffix.labels = 0;
+	knot_compr_table_clear(compr->table);
 }
 
 /*! \brief Clear the packet and switch wireformat pointers (possibly allocate new). */
@@ -398,6 +399,9 @@ void knot_pkt_free(knot_pkt_t *pkt)
 	mm_free(&pkt->mm, pkt->rr);
 	mm_free(&pkt->mm, pkt->rr_info);
 
+	/* Free the compression table. */
+	mm_free(&pkt->mm, pkt->compr.table);
+
 	/* Free the space for wireformat. */
 	if (pkt->flags & KNOT_PF_FREE) {
 		mm_free(&pkt->mm, pkt->wire);
@@ -455,6 +459,27 @@ int knot_pkt_begin(knot_pkt_t *pkt, knot_section_t section_id)
 	return KNOT_EOK;
 }
 
+_public_
+int knot_pkt_init_compr_table(knot_pkt_t *pkt)
+{
+	if (pkt == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	if (pkt->compr.table == NULL) {
+		knot_compr_table_t *table = mm_alloc(&pkt->mm, sizeof(*table));
+		if (table == NULL) {
+			return KNOT_ENOMEM;
+		}
+		memset(table->slots, 0, sizeof(table->slots));
+		table->count = 0;
+		table->seeded = false;
+		pkt->compr.table = table;
+	}
+
+	return KNOT_EOK;
+}
+
 _public_
 int knot_pkt_put_question(knot_pkt_t *pkt, const knot_dname_t *qname, uint16_t qclass, uint16_t qtype)
 {
@@ -540,10 +565,14 @@ int knot_pkt_put_rotate(knot_pkt_t *pkt, uint16_t compr_hint, const knot_rrset_t
 
 	uint8_t *pos = pkt->wire + pkt->size;
 	size_t maxlen = pkt_remaining(pkt);
+	uint16_t compr_mark = (pkt->compr.table != NULL) ? pkt->compr.table->count : 0;
 
 	/* Write RRSet to wireformat. */
 	ret = knot_rrset_to_wire_extra(rr, pos, maxlen, rotate, compr, flags);
 	if (ret < 0) {
+		/* Forget suffixes from the partially written RRSet. */
+		knot_compr_table_rollback(pkt->compr.table, compr_mark);
+
 		/* Truncate packet if required. */
 		if (ret == KNOT_ESPACE && !(flags & KNOT_PF_NOTRUNC)) {
 			knot_wire_set_tc(pkt->wire);
@@ -248,6 +248,19 @@ int knot_pkt_begin(knot_pkt_t *pkt, knot_section_t section_id);
 int knot_pkt_put_question(knot_pkt_t *pkt, const knot_dname_t *qname,
                           uint16_t qclass, uint16_t qtype);
 
+/*!
+ * \brief Enable the compression table for subsequent RRSets in the packet.
+ *
+ * With the table, any name suffix written within the compression pointer
+ * range can be reused, which is useful for large responses (e.g. zone
+ * transfers). The table is kept until the packet is freed.
+ *
+ * \param pkt  Packet.
+ *
+ * \return KNOT_EOK, KNOT_ENOMEM
+ */
+int knot_pkt_init_compr_table(knot_pkt_t *pkt);
+
 /*!
  * \brief Put RRSet into packet.
  *
@@ -174,6 +174,140 @@ static int write_rdata_naptr_header(const uint8_t **src, size_t *src_avail,
 #define CHECK_WIRE_NEXT_LABEL(res) \
 	if (res == NULL) { return KNOT_EINVAL; }
 
+/*! \brief Case-insensitive FNV-1a hash of a label chained with its suffix hash. */
+static uint32_t label_hash(const uint8_t *label, uint32_t suffix_hash)
+{
+	uint32_t hash = suffix_hash ^ 2166136261U;
+	for (uint8_t i = 0; i <= *label; i++) {
+		hash = (hash ^ knot_tolower(label[i])) * 16777619U;
+	}
+	return hash;
+}
+
+/*!
+ * \brief Get positions of labels of an uncompressed name and hashes of
+ *        the suffixes starting at them.
+ *
+ * \return Number of labels (excluding the root label).
+ */
+static unsigned suffix_hashes(const knot_dname_t *dname,
+                              const uint8_t *labels[KNOT_DNAME_MAXLABELS],
+                              uint32_t hashes[KNOT_DNAME_MAXLABELS])
+{
+	unsigned count = 0;
+	while (*dname != '\0') {
+		labels[count++] = dname;
+		dname = knot_dname_next_label(dname);
+	}
+
+	uint32_t hash = 0;
+	for (unsigned i = count; i > 0; i--) {
+		hash = label_hash(labels[i - 1], hash);
+		hashes[i - 1] = hash;
+	}
+
+	return count;
+}
+
+static uint16_t table_find(const knot_compr_table_t *table, const knot_dname_t *suffix,
+                           uint32_t hash, const uint8_t *wire, size_t limit)
+{
+	for (uint16_t i = hash % KNOT_COMPR_TABLE_SLOTS; table->slots[i].pos != 0;
+	     i = (i + 1) % KNOT_COMPR_TABLE_SLOTS) {
+		uint16_t pos = table->slots[i].pos;
+		if (table->slots[i].hash == hash && pos < limit &&
+		    dname_equal_wire(suffix, wire + pos, wire)) {
+			return pos;
+		}
+	}
+
+	return 0;
+}
+
+static void table_insert(knot_compr_table_t *table, uint32_t hash, size_t pos)
+{
+	if (table->count >= KNOT_COMPR_TABLE_MAX || pos >= KNOT_WIRE_PTR_MAX) {
+		return;
+	}
+
+	uint16_t i = hash % KNOT_COMPR_TABLE_SLOTS;
+	while (table->slots[i].pos != 0) {
+		i = (i + 1) % KNOT_COMPR_TABLE_SLOTS;
+	}
+	table->slots[i].hash = hash;
+	table->slots[i].pos = pos;
+	table->log[table->count++] = i;
+}
+
+/*! \brief Store suffixes of the (uncompressed) QNAME. */
+static void table_seed(knot_compr_table_t *table, const uint8_t *wire)
+{
+	const uint8_t *labels[KNOT_DNAME_MAXLABELS];
+	uint32_t hashes[KNOT_DNAME_MAXLABELS];
+
+	if (knot_wire_get_qdcount(wire) > 0) {
+		const knot_dname_t *qname = wire + KNOT_WIRE_HEADER_SIZE;
+		unsigned count = suffix_hashes(qname, labels, hashes);
+		for (unsigned i = 0; i < count; i++) {
+			table_insert(table, hashes[i], labels[i] - wire);
+		}
+	}
+
+	table->seeded = true;
+}
+
+/*!
+ * \brief Write compressed domain name using the compression table.
+ *
+ * The longest suffix already present in the packet is replaced by a pointer,
+ * suffixes of the newly written labels are added to the table.
+ */
+static int compr_put_dname_table(const knot_dname_t *dname, uint8_t *dst, uint16_t max,
+                                 knot_compr_t *compr)
+{
+	knot_compr_table_t *table = compr->table;
+	if (!table->seeded) {
+		table_seed(table, compr->wire);
+	}
+
+	const uint8_t *labels[KNOT_DNAME_MAXLABELS];
+	uint32_t hashes[KNOT_DNAME_MAXLABELS];
+	unsigned count = suffix_hashes(dname, labels, hashes);
+
+	assert(dst >= compr->wire);
+	size_t wire_pos = dst - compr->wire;
+
+	unsigned match = count;
+	uint16_t ptr = 0;
+	for (unsigned i = 0; i < count; i++) {
+		ptr = table_find(table, labels[i], hashes[i], compr->wire, wire_pos);
+		if (ptr != 0) {
+			match = i;
+			break;
+		}
+	}
+
+	uint16_t prefix = (match < count) ? labels[match] - dname
+	                                  : knot_dname_size(dname) - 1;
+	uint16_t written = 0;
+	WRITE_LABEL(dst, written, dname, max, prefix);
+	if (ptr != 0) {
+		if (written + sizeof(uint16_t) > max) {
+			return KNOT_ESPACE;
+		}
+		knot_wire_put_pointer(compr->wire, dst + written, ptr);
+		written += sizeof(uint16_t);
+	} else {
+		WRITE_LABEL(dst, written, dname + prefix, max, 1);
+	}
+
+	for (unsigned i = 0; i < match; i++) {
+		table_insert(table, hashes[i], wire_pos + (labels[i] - dname));
+	}
+
+	return written;
+}
+
 /*!
  * \brief Write compressed domain name to the destination wire.
  *
@@ -193,6 +327,10 @@ static int compr_put_dname(const knot_dname_t *dname, uint8_t *dst, uint16_t max
 		return knot_dname_to_wire(dst, dname, max);
 	}
 
+	if (compr->table != NULL) {
+		return compr_put_dname_table(dname, dst, max, compr);
+	}
+
 	// Get number of labels (should not be a zero label dname).
 	size_t name_labels = knot_dname_labels(dname, NULL);
 	assert(name_labels > 0);
@@ -270,6 +270,30 @@ struct zs_scanner {
 	 */
 };
 
+/*!
+ * \brief Part of the zone data which can be parsed independently.
+ *
+ * The chunk starts with a record with an explicit owner outside of any
+ * multiline record. The last \$ORIGIN and \$TTL directives preceding the
+ * chunk are referenced so that they can be applied before the chunk.
+ */
+typedef struct {
+	/*! Start of the chunk. */
+	const char *start;
+	/*! Length of the chunk. */
+	size_t size;
+	/*! Line number of the chunk start. */
+	uint64_t line;
+	/*! Last preceding ORIGIN directive line (NULL if none). */
+	const char *origin;
+	/*! Length of the ORIGIN directive line. */
+	size_t origin_size;
+	/*! Last preceding TTL directive line (NULL if none). */
+	const char *ttl;
+	/*! Length of the TTL directive line. */
+	size_t ttl_size;
+} zs_chunk_t;
+
 /*!
  * \brief Initializes the scanner context.
  *
@@ -404,4 +428,40 @@ int zs_parse_all(
 	zs_scanner_t *scanner
 );
 
+/*!
+ * \brief Splits zone data into chunks for parallel parsing.
+ *
+ * \note The input isn't split if it contains an INCLUDE directive as relative
+ *       paths depend on the scanner input.
+ *
+ * \param input       Input zone data.
+ * \param size        Size of the input data.
+ * \param chunks      Output array of chunks.
+ * \param max_chunks  Size of the output array.
+ *
+ * \return Number of chunks (one if the input can't be split).
+ */
+size_t zs_split_input(
+	const char *input,
+	size_t size,
+	zs_chunk_t *chunks,
+	size_t max_chunks
+);
+
+/*!
+ * \brief Sets the scanner to parse a zone data chunk.
+ *
+ * The preceding ORIGIN and TTL directives are applied first.
+ *
+ * \note Error code is stored in the scanner context.
+ * \param scanner  Scanner context.
+ * \param chunk    Zone data chunk to parse.
+ * \retval  0  if success.
+ * \retval -1  if error.
+ */
+int zs_set_input_chunk(
+	zs_scanner_t *scanner,
+	const zs_chunk_t *chunk
+);
+
 /*! @} */
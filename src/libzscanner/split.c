@@ -0,0 +1,202 @@
+/*  Copyright (C) 2024 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <stdbool.h>
+#include <string.h>
+#include <strings.h>
+
+#include "libzscanner/scanner.h"
+
+/*!
+ * \brief Checks if the line is the given directive.
+ */
+static bool is_directive(const char *line, const char *end, const char *name)
+{
+	size_t len = strlen(name);
+	return (end - line > len && strncasecmp(line, name, len) == 0 &&
+	        (line[len] == ' ' || line[len] == '\t'));
+}
+
+/*!
+ * \brief Checks if a record with an explicit owner can start with the character.
+ */
+static bool is_owner_start(char c)
+{
+	switch (c) {
+	case ' ': case '\t': case '\r': case '\n':
+	case ';': case '$': case '(': case ')':
+		return false;
+	default:
+		return true;
+	}
+}
+
+/*!
+ * \brief Skips one line while tracking parentheses and comments.
+ *
+ * Quoted strings don't span lines in the zone file, so the quoting state
+ * isn't kept across lines.
+ *
+ * \return Start of the next line.
+ */
+static const char *skip_line(const char *p, const char *end, unsigned *parens,
+                             uint64_t *line)
+{
+	bool quoted = false;
+
+	for (; p < end; p++) {
+		switch (*p) {
+		case '\\':
+			if (p + 1 < end && p[1] == '\n') {
+				(*line)++;
+			}
+			p++;
+			break;
+		case '"':
+			quoted = !quoted;
+			break;
+		case '(':
+			if (!quoted) {
+				(*parens)++;
+			}
+			break;
+		case ')':
+			if (!quoted && *parens > 0) {
+				(*parens)--;
+			}
+			break;
+		case ';':
+			if (!quoted) {
+				p = memchr(p, '\n', end - p);
+				if (p == NULL) {
+					return end;
+				}
+				(*line)++;
+				return p + 1;
+			}
+			break;
+		case '\n':
+			(*line)++;
+			return p + 1;
+		default:
+			break;
+		}
+	}
+
+	return end;
+}
+
+__attribute__((visibility("default")))
+size_t zs_split_input(
+	const char *input,
+	size_t size,
+	zs_chunk_t *chunks,
+	size_t max_chunks)
+{
+	if (input == NULL || chunks == NULL || max_chunks == 0) {
+		return 0;
+	}
+
+	const char *end = input + size;
+	size_t target = size / max_chunks;
+
+	zs_chunk_t *chunk = chunks;
+	memset(chunk, 0, sizeof(*chunk));
+	chunk->start = input;
+	chunk->line = 1;
+
+	const char *origin = NULL, *ttl = NULL;
+	size_t origin_size = 0, ttl_size = 0;
+	const char *next_cut = input + target;
+	unsigned parens = 0;
+	uint64_t line = 1;
+
+	const char *p = input;
+	while (p < end) {
+		const char *line_start = p;
+		uint64_t line_number = line;
+		bool in_record = (parens > 0);
+
+		p = skip_line(p, end, &parens, &line);
+		if (in_record) {
+			continue;
+		}
+
+		if (*line_start == '$') {
+			if (is_directive(line_start, p, "$INCLUDE")) {
+				chunks->size = size;
+				return 1;
+			} else if (is_directive(line_start, p, "$ORIGIN")) {
+				origin = line_start;
+				origin_size = p - line_start;
+			} else if (is_directive(line_start, p, "$TTL")) {
+				ttl = line_start;
+				ttl_size = p - line_start;
+			}
+		} else if (line_start >= next_cut && chunk + 1 < chunks + max_chunks &&
+		           is_owner_start(*line_start)) {
+			chunk->size = line_start - chunk->start;
+			chunk++;
+			*chunk = (zs_chunk_t) {
+				.start = line_start,
+				.line = line_number,
+				.origin = origin,
+				.origin_size = origin_size,
+				.ttl = ttl,
+				.ttl_size = ttl_size,
+			};
+			next_cut = line_start + target;
+		}
+	}
+
+	chunk->size = end - chunk->start;
+
+	return chunk - chunks + 1;
+}
+
+__attribute__((visibility("default")))
+int zs_set_input_chunk(
+	zs_scanner_t *s,
+	const zs_chunk_t *chunk)
+{
+	if (s == NULL) {
+		return -1;
+	}
+
+	if (chunk == NULL || chunk->start == NULL) {
+		s->error.code = ZS_EINVAL;
+		s->error.fatal = true;
+		return -1;
+	}
+
+	// Apply the preceding directives.
+	const char *directives[] = { chunk->origin, chunk->ttl };
+	const size_t sizes[] = { chunk->origin_size, chunk->ttl_size };
+	for (int i = 0; i < 2; i++) {
+		if (directives[i] != NULL &&
+		    (zs_set_input_string(s, directives[i], sizes[i]) != 0 ||
+		     zs_parse_all(s) != 0)) {
+			return -1;
+		}
+	}
+
+	if (zs_set_input_string(s, chunk->start, chunk->size) != 0) {
+		return -1;
+	}
+	s->line_counter = chunk->line;
+
+	return 0;
+}
@@ -21,8 +21,10 @@
 
 #include "libknot/libknot.h"
 #include "knot/journal/journal_basic.h"
+#include "knot/journal/journal_compress.h"
 #include "knot/journal/journal_metadata.h"
 #include "knot/journal/journal_read.h"
+#include "knot/journal/journal_shard.h"
 #include "knot/journal/serialization.h"
 #include "knot/zone/zone-dump.h"
 #include "utils/common/msg.h"
@@ -290,6 +292,16 @@ int print_journal(char *path, knot_dname_t *name, print_params_t *params)
 		printf("Total number of changesets:  %zu\n", params->changes);
 		printf("Occupied this zone (approx): %"PRIu64" KiB\n", occupied / 1024);
 		printf("Occupied all zones together: %"PRIu64" KiB\n", occupied_all / 1024);
+
+		journal_chunk_stats_t cs;
+		ret = journal_chunk_stats(j, &cs);
+		if (ret == KNOT_EOK) {
+			printf("Compressed chunks:           %zu of %zu\n", cs.compressed, cs.chunks);
+			printf("Uncompressed data size:      %"PRIu64" KiB (ratio %.2f)\n",
+			       cs.plain_size / 1024,
+			       cs.stored_size > 0 ? (double)cs.plain_size / cs.stored_size : 1.0);
+			printf("Decompression time:          %.3f ms\n", cs.decompress_ns / 1000000.0);
+		}
 	}
 
 	changeset_free(params->merged);
@@ -334,30 +346,52 @@ static int list_zone(const knot_dname_t *zone, bool detailed, knot_lmdb_db_t *jd
 	return KNOT_EOK;
 }
 
-int list_zones(char *path, bool detailed)
+static int list_shard(char *path, bool detailed, bool *first, uint64_t *occupied_all)
 {
 	knot_lmdb_init(&journal_db, path, 0, journal_env_flags(JOURNAL_MODE_ROBUST, true), NULL);
 
 	list_t zones;
 	init_list(&zones);
 	ptrnode_t *zone;
-	uint64_t occupied_all = 0;
-	bool first = detailed;
 
 	int ret = journals_walk(&journal_db, add_zone_to_list, &zones);
 	WALK_LIST(zone, zones) {
 		if (ret != KNOT_EOK) {
 			break;
-		} else if (first) {
+		} else if (*first) {
 			printf(";; <zone name>              <occupied KiB> <first serial> <last serial> <full zone>\n");
-			first = false;
+			*first = false;
 		}
-		ret = list_zone(zone->d, detailed, &journal_db, &occupied_all);
+		ret = list_zone(zone->d, detailed, &journal_db, occupied_all);
 	}
 
 	knot_lmdb_deinit(&journal_db);
 	ptrlist_deep_free(&zones, NULL);
 
+	return ret;
+}
+
+int list_zones(char *path, unsigned shards, bool detailed)
+{
+	uint64_t occupied_all = 0;
+	bool first = detailed;
+
+	int ret = KNOT_ENODB;
+	for (unsigned i = 0; i < shards; i++) {
+		char *shard_path = journal_shard_path(path, i);
+		if (shard_path == NULL) {
+			return KNOT_ENOMEM;
+		}
+		int shard_ret = list_shard(shard_path, detailed, &first, &occupied_all);
+		free(shard_path);
+		if (shard_ret == KNOT_ENODB) {
+			continue;
+		} else if (shard_ret != KNOT_EOK) {
+			return shard_ret;
+		}
+		ret = KNOT_EOK;
+	}
+
 	if (detailed && ret == KNOT_EOK) {
 		printf(";; Occupied all zones together: %"PRIu64" KiB\n", occupied_all / 1024);
 	}
@@ -464,9 +498,11 @@ int main(int argc, char *argv[])
 	}
 
 	char *db = conf_db(conf(), C_JOURNAL_DB);
+	conf_val_t shards_val = conf_db_param(conf(), C_JOURNAL_DB_SHARDS);
+	unsigned shards = conf_int(&shards_val);
 
 	if (justlist) {
-		int ret = list_zones(db, params.debug);
+		int ret = list_zones(db, shards, params.debug);
 		free(db);
 		switch (ret) {
 		case KNOT_ENOENT:
@@ -493,7 +529,9 @@ int main(int argc, char *argv[])
 		knot_dname_t *name = knot_dname_from_str_alloc(argv[optind]);
 		knot_dname_to_lower(name);
 
-		int ret = print_journal(db, name, &params);
+		char *shard_db = journal_shard_path(db, journal_shard(name, shards));
+		int ret = print_journal(shard_db, name, &params);
+		free(shard_db);
 		free(name);
 		free(db);
 		switch (ret) {
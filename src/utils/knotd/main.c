@@ -796,6 +796,9 @@ int main(int argc, char **argv)
 	/* Now we're going multithreaded. */
 	rcu_register_thread();
 
+	/* Place zone journals according to the number of journal DB shards. */
+	server_journal_reshard(&server);
+
 	/* Populate zone database. */
 	log_info("loading %zu zones", conf_id_count(conf(), C_ZONE));
 	server_update_zones(conf(), &server, RELOAD_ZONES);
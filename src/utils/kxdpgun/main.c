@@ -31,27 +31,33 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/epoll.h>
 #include <sys/ioctl.h>
 #include <sys/resource.h>
 #include <sys/socket.h>
 #include <time.h>
 #include <unistd.h>
+#include <gnutls/gnutls.h>
 
 #include "libknot/libknot.h"
 #include "libknot/xdp.h"
 #include "libknot/xdp/tcp_iobuf.h"
+#include "libknot/quic/tls.h"
+#include "libknot/quic/tls_common.h"
 #ifdef ENABLE_QUIC
-#include <gnutls/gnutls.h>
 #include "libknot/quic/quic.h"
 #endif // ENABLE_QUIC
 #include "contrib/atomic.h"
+#include "contrib/net.h"
 #include "contrib/openbsd/strlcpy.h"
 #include "contrib/os.h"
 #include "contrib/sockaddr.h"
 #include "contrib/toeplitz.h"
 #include "utils/common/msg.h"
 #include "utils/common/params.h"
+#ifdef ENABLE_XDP
 #include "utils/kxdpgun/ip_route.h"
+#endif
 #include "utils/kxdpgun/load_queries.h"
 #include "utils/kxdpgun/main.h"
 #include "utils/kxdpgun/stats.h"
@@ -100,6 +106,7 @@ static unsigned addr_bits(bool ipv6)
 	return ipv6 ? 128 : 32;
 }
 
+#ifdef ENABLE_XDP
 static void shuffle_sockaddr4(struct sockaddr_in *dst, struct sockaddr_in *src,
                               uint64_t increment)
 {
@@ -132,6 +139,7 @@ static void shuffle_sockaddr(struct sockaddr_in6 *dst, struct sockaddr_in6 *src,
 		                  increment);
 	}
 }
+#endif // ENABLE_XDP
 
 static void next_payload(struct pkt_payload **payload, int increment)
 {
@@ -147,6 +155,7 @@ static void next_payload(struct pkt_payload **payload, int increment)
 	}
 }
 
+#ifdef ENABLE_XDP
 static void put_dns_payload(struct iovec *put_into, bool zero_copy, xdp_gun_ctx_t *ctx,
                             struct pkt_payload **payl)
 {
@@ -252,6 +261,7 @@ static unsigned alloc_pkts(knot_xdp_msg_t *pkts, struct knot_xdp_socket *xsk,
 	}
 	return ctx->at_once;
 }
+#endif // ENABLE_XDP
 
 inline static bool check_dns_payload(struct iovec *payl, xdp_gun_ctx_t *ctx,
                                      kxdpgun_stats_t *st)
@@ -266,7 +276,7 @@ inline static bool check_dns_payload(struct iovec *payl, xdp_gun_ctx_t *ctx,
 	return true;
 }
 
-#ifdef ENABLE_QUIC
+#if defined(ENABLE_XDP) && defined(ENABLE_QUIC)
 static int quic_alloc_cb(knot_quic_reply_t *rpl)
 {
 	xdp_gun_ctx_t *ctx = rpl->in_ctx;
@@ -307,7 +317,7 @@ static void quic_free_cb(knot_quic_reply_t *rpl)
 {
 	knot_xdp_send_free(rpl->sock, rpl->out_ctx, 1);
 }
-#endif // ENABLE_QUIC
+#endif // ENABLE_XDP && ENABLE_QUIC
 
 static uint64_t timestamp_ns(void)
 {
@@ -330,6 +340,81 @@ static uint64_t timer_end_ns(const struct timespec *start)
 	return res;
 }
 
+/*!
+ * \brief Update the elapsed time, print the requested statistics, and return
+ *        the time to wait before sending the next batch (rate control).
+ */
+static uint64_t gun_progress(xdp_gun_ctx_t *ctx, const struct timespec *timer,
+                             kxdpgun_stats_t *local_stats, kxdpgun_stats_t *periodic_stats,
+                             unsigned *stats_triggered, uint64_t *duration_us)
+{
+	uint64_t duration_ns = timer_end_ns(timer);
+	*duration_us = duration_ns / 1000;
+	uint64_t dura_exp = ((local_stats->qry_sent + periodic_stats->qry_sent) * 1000000) / ctx->qps;
+	if (ctx->thread_id == 0 && ctx->stats_period_ns != 0 && global_stats.collected == 0
+	    && (duration_ns - (periodic_stats->since - local_stats->since)) >= ctx->stats_period_ns) {
+		ATOMIC_SET(stats_switch, STATS_PERIODIC);
+		ATOMIC_ADD(stats_trigger, 1);
+	}
+
+	if (xdp_trigger == KXDPGUN_STOP && ctx->duration > *duration_us) {
+		ctx->duration = *duration_us;
+	}
+	uint64_t tmp_stats_trigger = ATOMIC_GET(stats_trigger);
+	if (*duration_us < ctx->duration && tmp_stats_trigger > *stats_triggered) {
+		bool tmp_stats_switch = ATOMIC_GET(stats_switch);
+		*stats_triggered = tmp_stats_trigger;
+
+		local_stats->until = periodic_stats->until = local_stats->since + duration_ns;
+		kxdpgun_stats_t cumulative_stats = *periodic_stats;
+		if (tmp_stats_switch == STATS_PERIODIC) {
+			collect_periodic_stats(local_stats, periodic_stats);
+			clear_stats(periodic_stats);
+			periodic_stats->since = local_stats->since + duration_ns;
+		} else {
+			collect_periodic_stats(&cumulative_stats, local_stats);
+			cumulative_stats.since = local_stats->since;
+		}
+
+		pthread_mutex_lock(&stats_lock);
+		size_t collected = collect_stats(&global_stats, &cumulative_stats);
+		assert(collected <= ctx->n_threads);
+		if (collected == ctx->n_threads) {
+			STATS_FMT(ctx, &global_stats, tmp_stats_switch);
+			if (!JSON_MODE(*ctx)) {
+				puts(STATS_SECTION_SEP);
+			}
+			clear_stats(&global_stats);
+			ATOMIC_SET(stats_switch, STATS_SUM);
+		}
+		pthread_mutex_unlock(&stats_lock);
+	}
+
+	uint64_t wait_us = 0;
+	if (dura_exp > *duration_us) {
+		wait_us += dura_exp - *duration_us;
+	}
+	if (*duration_us > ctx->duration) {
+		wait_us += 1000;
+	}
+	return wait_us;
+}
+
+static void gun_finish(xdp_gun_ctx_t *ctx, const struct timespec *timer,
+                       kxdpgun_stats_t *local_stats, kxdpgun_stats_t *periodic_stats,
+                       uint64_t extra_wait)
+{
+	periodic_stats->until = local_stats->since + timer_end_ns(timer) - extra_wait * 1000;
+	collect_periodic_stats(local_stats, periodic_stats);
+
+	STATS_THRD(ctx, local_stats);
+
+	pthread_mutex_lock(&stats_lock);
+	collect_stats(&global_stats, local_stats);
+	pthread_mutex_unlock(&stats_lock);
+}
+
+#ifdef ENABLE_XDP
 void *xdp_gun_thread(void *_ctx)
 {
 	xdp_gun_ctx_t *ctx = _ctx;
@@ -740,63 +825,14 @@ void *xdp_gun_thread(void *_ctx)
 #endif // ENABLE_QUIC
 
 		// speed and signal part
-		uint64_t duration_ns = timer_end_ns(&timer);
-		duration_us = duration_ns / 1000;
-		uint64_t dura_exp = ((local_stats.qry_sent + periodic_stats.qry_sent) * 1000000) / ctx->qps;
-		if (ctx->thread_id == 0 && ctx->stats_period_ns != 0 && global_stats.collected == 0
-		    && (duration_ns - (periodic_stats.since - local_stats.since)) >= ctx->stats_period_ns) {
-			ATOMIC_SET(stats_switch, STATS_PERIODIC);
-			ATOMIC_ADD(stats_trigger, 1);
-		}
-
-		if (xdp_trigger == KXDPGUN_STOP && ctx->duration > duration_us) {
-			ctx->duration = duration_us;
-		}
-		uint64_t tmp_stats_trigger = ATOMIC_GET(stats_trigger);
-		if (duration_us < ctx->duration && tmp_stats_trigger > stats_triggered) {
-			bool tmp_stats_switch = ATOMIC_GET(stats_switch);
-			stats_triggered = tmp_stats_trigger;
-
-			local_stats.until = periodic_stats.until = local_stats.since + duration_ns;
-			kxdpgun_stats_t cumulative_stats = periodic_stats;
-			if (tmp_stats_switch == STATS_PERIODIC) {
-				collect_periodic_stats(&local_stats, &periodic_stats);
-				clear_stats(&periodic_stats);
-				periodic_stats.since = local_stats.since + duration_ns;
-			} else {
-				collect_periodic_stats(&cumulative_stats, &local_stats);
-				cumulative_stats.since = local_stats.since;
-			}
-
-			pthread_mutex_lock(&stats_lock);
-			size_t collected = collect_stats(&global_stats, &cumulative_stats);
-			assert(collected <= ctx->n_threads);
-			if (collected == ctx->n_threads) {
-				STATS_FMT(ctx, &global_stats, tmp_stats_switch);
-				if (!JSON_MODE(*ctx)) {
-					puts(STATS_SECTION_SEP);
-				}
-				clear_stats(&global_stats);
-				ATOMIC_SET(stats_switch, STATS_SUM);
-			}
-			pthread_mutex_unlock(&stats_lock);
-		}
-		if (dura_exp > duration_us) {
-			usleep(dura_exp - duration_us);
-		}
-		if (duration_us > ctx->duration) {
-			usleep(1000);
+		uint64_t wait_us = gun_progress(ctx, &timer, &local_stats, &periodic_stats,
+		                                &stats_triggered, &duration_us);
+		if (wait_us > 0) {
+			usleep(wait_us);
 		}
 		tick++;
 	}
-	periodic_stats.until = local_stats.since + timer_end_ns(&timer) - extra_wait * 1000;
-	collect_periodic_stats(&local_stats, &periodic_stats);
-
-	STATS_THRD(ctx, &local_stats);
-
-	pthread_mutex_lock(&stats_lock);
-	collect_stats(&global_stats, &local_stats);
-	pthread_mutex_unlock(&stats_lock);
+	gun_finish(ctx, &timer, &local_stats, &periodic_stats, extra_wait);
 
 cleanup:
 	knot_xdp_deinit(xsk);
@@ -821,7 +857,585 @@ cleanup:
 
 	return NULL;
 }
+#endif // ENABLE_XDP
+
+#define SOCK_UDP_FDS        8  // UDP sockets (source ports) per thread
+#define SOCK_EVENTS        64
+#define SOCK_TIMEOUT_NS    1000000000UL // connection timeout
+
+typedef enum {
+	SOCK_CONNECTING,
+	SOCK_HANDSHAKE,  // TLS only
+	SOCK_WAITING,    // query sent, waiting for the response
+	SOCK_CLOSING,    // waiting for the close by the counterpart
+	SOCK_IDLE,       // kept for reuse
+} sock_state_t;
+
+typedef struct {
+	node_t n;
+	int fd;
+	sock_state_t state;
+	knot_tls_conn_t *tls;
+	struct pkt_payload *query;  // query to be sent once connected
+	uint64_t start_ns;          // start of the query, including connection setup
+	uint8_t len[2];             // length of the response
+	uint8_t *rx;                // response, allocated once the length is known
+	size_t rx_pos;
+} sock_conn_t;
+
+typedef struct {
+	xdp_gun_ctx_t *ctx;
+	kxdpgun_stats_t *st;
+	struct sockaddr_storage remote;
+	int epfd;
+	int udp_fds[SOCK_UDP_FDS];
+	uint16_t udp_id;            // message ID of the next UDP query
+	uint64_t *udp_sent_ns;      // sending times of UDP queries indexed by message ID
+	uint8_t *buf;
+	size_t buf_size;
+	list_t conns;               // active connections, ordered by the query start
+	list_t idle;                // connections for reuse
+	struct knot_creds *tls_creds;
+	knot_tls_ctx_t *tls_ctx;
+} sock_gun_t;
+
+static uint64_t sock_now_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((uint64_t)ts.tv_sec * 1000000000) + ts.tv_nsec;
+}
+
+static void sock_gun_deinit(sock_gun_t *g);
+
+static int sock_gun_init(sock_gun_t *g, xdp_gun_ctx_t *ctx, kxdpgun_stats_t *st)
+{
+	*g = (sock_gun_t){ .ctx = ctx, .st = st, .remote = ctx->target_ip_ss, .epfd = -1 };
+	for (int i = 0; i < SOCK_UDP_FDS; i++) {
+		g->udp_fds[i] = -1;
+	}
+	init_list(&g->conns);
+	init_list(&g->idle);
+	sockaddr_port_set(&g->remote, ctx->target_port);
+
+	g->epfd = epoll_create1(EPOLL_CLOEXEC);
+	if (g->epfd < 0) {
+		return knot_map_errno();
+	}
+
+	g->buf_size = (size_t)ctx->at_once * ctx->edns_size;
+	g->buf = malloc(g->buf_size);
+	if (g->buf == NULL) {
+		return KNOT_ENOMEM;
+	}
+
+	if (ctx->tls) {
+		g->tls_creds = knot_creds_init_peer(NULL, NULL, 0);
+		if (g->tls_creds == NULL) {
+			return KNOT_ENOMEM;
+		}
+		// Zero timeouts make the TLS operations non-blocking.
+		g->tls_ctx = knot_tls_ctx_new(g->tls_creds, 0, 0, false);
+		if (g->tls_ctx == NULL) {
+			return KNOT_ENOMEM;
+		}
+	}
+	if (ctx->tcp) {
+		return KNOT_EOK;
+	}
+
+	g->udp_sent_ns = calloc(UINT16_MAX + 1, sizeof(*g->udp_sent_ns));
+	if (g->udp_sent_ns == NULL) {
+		return KNOT_ENOMEM;
+	}
+	for (int i = 0; i < SOCK_UDP_FDS; i++) {
+		g->udp_fds[i] = net_connected_socket(SOCK_DGRAM, &g->remote,
+		                                     &ctx->local_ip_ss, false);
+		if (g->udp_fds[i] < 0) {
+			return g->udp_fds[i];
+		}
+		if (ctx->flags & KNOT_XDP_FILTER_DROP) {
+			continue;
+		}
+		struct epoll_event ev = { .events = EPOLLIN, .data.fd = g->udp_fds[i] };
+		if (epoll_ctl(g->epfd, EPOLL_CTL_ADD, g->udp_fds[i], &ev) != 0) {
+			return knot_map_errno();
+		}
+	}
+
+	return KNOT_EOK;
+}
+
+static void sock_conn_close(sock_conn_t *conn)
+{
+	rem_node(&conn->n);
+	knot_tls_conn_del(conn->tls);
+	close(conn->fd); // Also removes it from the epoll set.
+	free(conn->rx);
+	free(conn);
+}
+
+static void sock_gun_deinit(sock_gun_t *g)
+{
+	sock_conn_t *conn, *nxt;
+	WALK_LIST_DELSAFE(conn, nxt, g->conns) {
+		sock_conn_close(conn);
+	}
+	WALK_LIST_DELSAFE(conn, nxt, g->idle) {
+		sock_conn_close(conn);
+	}
+	for (int i = 0; i < SOCK_UDP_FDS; i++) {
+		if (g->udp_fds[i] >= 0) {
+			close(g->udp_fds[i]);
+		}
+	}
+	if (g->epfd >= 0) {
+		close(g->epfd);
+	}
+	knot_tls_ctx_free(g->tls_ctx);
+	knot_creds_free(g->tls_creds);
+	free(g->udp_sent_ns);
+	free(g->buf);
+}
+
+static void sock_send_udp(sock_gun_t *g, struct pkt_payload **payload_ptr, uint64_t tick)
+{
+	xdp_gun_ctx_t *ctx = g->ctx;
+	struct mmsghdr msgs[ctx->at_once];
+	struct iovec iovs[ctx->at_once][2];
+	uint8_t ids[ctx->at_once][2];
+
+	// The message ID is replaced so that the responses can be paired with the queries.
+	memset(msgs, 0, sizeof(msgs));
+	for (unsigned i = 0; i < ctx->at_once; i++) {
+		knot_wire_write_u16(ids[i], g->udp_id++);
+		iovs[i][0] = (struct iovec){ ids[i], sizeof(ids[i]) };
+		iovs[i][1] = (struct iovec){ (*payload_ptr)->payload + sizeof(ids[i]),
+		                             (*payload_ptr)->len - sizeof(ids[i]) };
+		msgs[i].msg_hdr.msg_iov = iovs[i];
+		msgs[i].msg_hdr.msg_iovlen = 2;
+		next_payload(payload_ptr, ctx->n_threads);
+	}
+
+	uint64_t now = sock_now_ns();
+	int sent = sendmmsg(g->udp_fds[tick % SOCK_UDP_FDS], msgs, ctx->at_once, MSG_DONTWAIT);
+	if (sent < 0) {
+		if (errno != EAGAIN && errno != EWOULDBLOCK) {
+			g->st->errors++;
+		}
+		sent = 0;
+	}
+	for (int i = 0; i < sent; i++) {
+		g->udp_sent_ns[knot_wire_read_u16(ids[i])] = now;
+	}
+	g->st->qry_sent += sent;
+	g->st->lost += ctx->at_once - sent;
+}
+
+static void sock_recv_udp(sock_gun_t *g, int fd)
+{
+	xdp_gun_ctx_t *ctx = g->ctx;
+	struct mmsghdr msgs[ctx->at_once];
+	struct iovec iovs[ctx->at_once];
+
+	memset(msgs, 0, sizeof(msgs));
+	for (unsigned i = 0; i < ctx->at_once; i++) {
+		iovs[i] = (struct iovec){ g->buf + i * ctx->edns_size, ctx->edns_size };
+		msgs[i].msg_hdr.msg_iov = &iovs[i];
+		msgs[i].msg_hdr.msg_iovlen = 1;
+	}
+
+	while (true) {
+		int recvd = recvmmsg(fd, msgs, ctx->at_once, MSG_DONTWAIT, NULL);
+		if (recvd < 0) {
+			if (errno != EAGAIN && errno != EWOULDBLOCK) {
+				g->st->errors++;
+			}
+			return;
+		}
+
+		uint64_t now = sock_now_ns();
+		for (int i = 0; i < recvd; i++) {
+			struct iovec payl = { iovs[i].iov_base, msgs[i].msg_len };
+			if (payl.iov_len < KNOT_WIRE_HEADER_SIZE) {
+				continue;
+			}
+			uint16_t id = knot_wire_get_id(payl.iov_base);
+			uint64_t sent = g->udp_sent_ns[id];
+			if (sent == 0) {
+				continue; // unknown or duplicate response
+			}
+			g->udp_sent_ns[id] = 0;
+			memcpy(payl.iov_base, &ctx->msgid, sizeof(ctx->msgid));
+			if (check_dns_payload(&payl, ctx, g->st)) {
+				latency_add(g->st, (now - sent) / 1000);
+			}
+		}
+		if (recvd < (int)ctx->at_once) {
+			return;
+		}
+	}
+}
+
+static int sock_conn_watch(sock_gun_t *g, sock_conn_t *conn, uint32_t events)
+{
+	struct epoll_event ev = { .events = events, .data.ptr = conn };
+	if (epoll_ctl(g->epfd, EPOLL_CTL_MOD, conn->fd, &ev) != 0) {
+		return knot_map_errno();
+	}
+	return KNOT_EOK;
+}
+
+static int sock_conn_done(sock_gun_t *g, sock_conn_t *conn)
+{
+	if (g->ctx->ignore1 & KXDPGUN_REUSE_CONN) {
+		conn->state = SOCK_IDLE;
+		rem_node(&conn->n);
+		add_tail(&g->idle, &conn->n);
+		return sock_conn_watch(g, conn, 0); // Only hang-up or error is reported.
+	}
+
+	knot_tls_conn_del(conn->tls);
+	conn->tls = NULL;
+	if (shutdown(conn->fd, SHUT_WR) != 0) {
+		return knot_map_errno();
+	}
+	conn->state = SOCK_CLOSING;
+	return sock_conn_watch(g, conn, EPOLLIN);
+}
+
+static int sock_conn_query(sock_gun_t *g, sock_conn_t *conn)
+{
+	struct pkt_payload *query = conn->query;
+
+	if (conn->tls != NULL) {
+		ssize_t ret = knot_tls_send_dns(conn->tls, query->payload, query->len);
+		if (ret != (ssize_t)query->len) {
+			return (ret < 0) ? ret : KNOT_NET_ESEND;
+		}
+	} else {
+		uint8_t len[2];
+		knot_wire_write_u16(len, query->len);
+		struct iovec iov[2] = {
+			{ len, sizeof(len) },
+			{ query->payload, query->len }
+		};
+		struct msghdr msg = { .msg_iov = iov, .msg_iovlen = 2 };
+		ssize_t ret = sendmsg(conn->fd, &msg, MSG_NOSIGNAL);
+		if (ret != (ssize_t)(sizeof(len) + query->len)) {
+			return (ret < 0) ? knot_map_errno() : KNOT_NET_ESEND;
+		}
+	}
+
+	if (g->ctx->flags & KNOT_XDP_FILTER_DROP) {
+		return sock_conn_done(g, conn);
+	}
+	conn->state = SOCK_WAITING;
+	return sock_conn_watch(g, conn, EPOLLIN);
+}
+
+static ssize_t sock_conn_read(sock_conn_t *conn, uint8_t *buf, size_t size)
+{
+	if (conn->tls != NULL) {
+		ssize_t ret = gnutls_record_recv(conn->tls->session, buf, size);
+		if (ret >= 0) {
+			return ret;
+		}
+		return (gnutls_error_is_fatal(ret) == 0) ? KNOT_EAGAIN : KNOT_NET_ERECV;
+	}
+
+	ssize_t ret = recv(conn->fd, buf, size, 0);
+	if (ret >= 0) {
+		return ret;
+	}
+	return (errno == EAGAIN || errno == EWOULDBLOCK) ? KNOT_EAGAIN : knot_map_errno();
+}
+
+static int sock_conn_recv(sock_gun_t *g, sock_conn_t *conn)
+{
+	while (conn->rx == NULL || conn->rx_pos < knot_wire_read_u16(conn->len)) {
+		bool hdr = (conn->rx == NULL);
+		uint8_t *dst = hdr ? conn->len : conn->rx;
+		size_t size = hdr ? sizeof(conn->len) : knot_wire_read_u16(conn->len);
+		ssize_t ret = sock_conn_read(conn, dst + conn->rx_pos, size - conn->rx_pos);
+		if (ret == KNOT_EAGAIN) {
+			return KNOT_EOK;
+		} else if (ret < 0) {
+			return ret;
+		} else if (ret == 0) {
+			return KNOT_ECONN;
+		}
+		conn->rx_pos += ret;
+		if (hdr && conn->rx_pos == sizeof(conn->len)) {
+			if (knot_wire_read_u16(conn->len) < KNOT_WIRE_HEADER_SIZE) {
+				return KNOT_EMALF;
+			}
+			conn->rx = malloc(knot_wire_read_u16(conn->len));
+			if (conn->rx == NULL) {
+				return KNOT_ENOMEM;
+			}
+			conn->rx_pos = 0;
+		}
+	}
+
+	struct iovec payl = { conn->rx, conn->rx_pos };
+	if (check_dns_payload(&payl, g->ctx, g->st)) {
+		latency_add(g->st, (sock_now_ns() - conn->start_ns) / 1000);
+	}
+	free(conn->rx);
+	conn->rx = NULL;
+	conn->rx_pos = 0;
+
+	return sock_conn_done(g, conn);
+}
+
+static int sock_conn_drain(sock_conn_t *conn, uint8_t *buf, size_t size)
+{
+	while (true) {
+		ssize_t ret = sock_conn_read(conn, buf, size);
+		if (ret == KNOT_EAGAIN) {
+			return KNOT_EOK;
+		} else if (ret < 0) {
+			return ret;
+		} else if (ret == 0) {
+			return KNOT_ECONN;
+		}
+	}
+}
+
+static int sock_conn_handshake(sock_gun_t *g, sock_conn_t *conn)
+{
+	int ret = knot_tls_handshake(conn->tls, true);
+	if (ret == KNOT_NET_EAGAIN) {
+		return sock_conn_watch(g, conn, EPOLLIN);
+	} else if (ret != KNOT_EOK) {
+		return ret;
+	}
+	return sock_conn_query(g, conn);
+}
+
+static int sock_conn_connected(sock_gun_t *g, sock_conn_t *conn)
+{
+	int err = 0;
+	socklen_t err_len = sizeof(err);
+	if (getsockopt(conn->fd, SOL_SOCKET, SO_ERROR, &err, &err_len) != 0) {
+		return knot_map_errno();
+	} else if (err != 0) {
+		return knot_map_errno_code(err);
+	}
+	g->st->synack_recv++;
+
+	if (!g->ctx->tls) {
+		return sock_conn_query(g, conn);
+	}
+
+	conn->tls = knot_tls_conn_new(g->tls_ctx, conn->fd);
+	if (conn->tls == NULL) {
+		return KNOT_ENOMEM;
+	}
+	conn->state = SOCK_HANDSHAKE;
+	return sock_conn_handshake(g, conn);
+}
+
+static void sock_conn_event(sock_gun_t *g, sock_conn_t *conn, uint32_t events)
+{
+	kxdpgun_stats_t *st = g->st;
+	int ret = KNOT_EOK;
+
+	switch (conn->state) {
+	case SOCK_CONNECTING:
+		ret = sock_conn_connected(g, conn);
+		break;
+	case SOCK_HANDSHAKE:
+		ret = sock_conn_handshake(g, conn);
+		break;
+	case SOCK_WAITING:
+		ret = sock_conn_recv(g, conn);
+		break;
+	case SOCK_CLOSING:
+		ret = sock_conn_drain(conn, g->buf, g->buf_size);
+		break;
+	case SOCK_IDLE:
+		assert(events & (EPOLLHUP | EPOLLERR));
+		ret = KNOT_ECONN;
+		break;
+	}
+
+	switch (ret) {
+	case KNOT_EOK:
+		return;
+	case KNOT_ECONN:
+		st->finack_recv++;
+		break;
+	case KNOT_ECONNREFUSED:
+	case KNOT_ECONNRESET:
+		st->rst_recv++;
+		break;
+	default:
+		st->errors++;
+		break;
+	}
+	sock_conn_close(conn);
+}
+
+static void sock_send_tcp(sock_gun_t *g, struct pkt_payload **payload_ptr)
+{
+	xdp_gun_ctx_t *ctx = g->ctx;
+
+	for (unsigned i = 0; i < ctx->at_once; i++) {
+		struct pkt_payload *query = *payload_ptr;
+		next_payload(payload_ptr, ctx->n_threads);
+
+		if (!EMPTY_LIST(g->idle)) {
+			sock_conn_t *conn = HEAD(g->idle);
+			rem_node(&conn->n);
+			add_tail(&g->conns, &conn->n);
+			conn->query = query;
+			conn->start_ns = sock_now_ns();
+			if (sock_conn_query(g, conn) == KNOT_EOK) {
+				g->st->qry_sent++;
+			} else {
+				g->st->errors++;
+				sock_conn_close(conn);
+			}
+			continue;
+		}
+
+		sock_conn_t *conn = calloc(1, sizeof(*conn));
+		if (conn == NULL) {
+			g->st->lost++;
+			continue;
+		}
+		conn->query = query;
+		conn->start_ns = sock_now_ns();
+		conn->fd = net_connected_socket(SOCK_STREAM, &g->remote,
+		                                &ctx->local_ip_ss, false);
+		if (conn->fd < 0) {
+			g->st->lost++;
+			free(conn);
+			continue;
+		}
+		struct epoll_event ev = { .events = EPOLLOUT, .data.ptr = conn };
+		if (epoll_ctl(g->epfd, EPOLL_CTL_ADD, conn->fd, &ev) != 0) {
+			g->st->lost++;
+			close(conn->fd);
+			free(conn);
+			continue;
+		}
+		conn->state = SOCK_CONNECTING;
+		add_tail(&g->conns, &conn->n);
+		g->st->qry_sent++;
+	}
+}
+
+static void sock_timeout(sock_gun_t *g)
+{
+	uint64_t now = sock_now_ns();
+	while (!EMPTY_LIST(g->conns)) {
+		sock_conn_t *conn = HEAD(g->conns);
+		if (now - conn->start_ns < SOCK_TIMEOUT_NS) {
+			break;
+		}
+		sock_conn_close(conn);
+	}
+}
+
+/*!
+ * \brief Process incoming events for the given time, at least once.
+ */
+static void sock_wait(sock_gun_t *g, uint64_t wait_us)
+{
+	struct epoll_event events[SOCK_EVENTS];
+	struct timespec timer;
+	timer_start(&timer);
+
+	while (true) {
+		uint64_t elapsed_us = timer_end_ns(&timer) / 1000;
+		uint64_t remain_us = (elapsed_us < wait_us) ? wait_us - elapsed_us : 0;
+
+		// Unlike epoll_wait(), ppoll() allows waiting shorter than 1 ms.
+		struct timespec timeout = {
+			.tv_sec = remain_us / 1000000,
+			.tv_nsec = (remain_us % 1000000) * 1000
+		};
+		struct pollfd pfd = { g->epfd, POLLIN, 0 };
+		if (ppoll(&pfd, 1, &timeout, NULL) < 0 && errno != EINTR) {
+			g->st->errors++;
+			return;
+		}
+
+		int count = epoll_wait(g->epfd, events, SOCK_EVENTS, 0);
+		for (int i = 0; i < count; i++) {
+			if (g->ctx->tcp) {
+				sock_conn_event(g, events[i].data.ptr, events[i].events);
+			} else {
+				sock_recv_udp(g, events[i].data.fd);
+			}
+		}
+		if (remain_us == 0 && count < SOCK_EVENTS) {
+			return;
+		}
+	}
+}
+
+void *sock_gun_thread(void *_ctx)
+{
+	xdp_gun_ctx_t *ctx = _ctx;
+	sock_gun_t gun;
+	uint64_t duration_us = 0;
+	struct timespec timer;
+	kxdpgun_stats_t local_stats = { 0 }; // cumulative stats of past periods excluding the current
+	kxdpgun_stats_t periodic_stats = { 0 }; // stats for the current period (see -S option)
+	unsigned stats_triggered = 0;
+	const uint64_t extra_wait = 1000000;
+
+	int ret = sock_gun_init(&gun, ctx, &periodic_stats);
+	if (ret != KNOT_EOK) {
+		ERR2("failed to initialize sockets of thread#%u (%s)",
+		     ctx->thread_id, knot_strerror(ret));
+		goto cleanup;
+	}
+
+	if (ctx->thread_id == 0) {
+		STATS_HDR(ctx);
+	}
+
+	while (xdp_trigger == KXDPGUN_WAIT) {
+		usleep(1000);
+	}
+
+	uint64_t tick = 0;
+	struct pkt_payload *payload_ptr = NULL;
+	next_payload(&payload_ptr, ctx->thread_id);
+
+	local_stats.since = periodic_stats.since = timestamp_ns();
+	timer_start(&timer);
+	ctx->stats_start_us = local_stats.since / 1000;
+
+	while (duration_us < ctx->duration + extra_wait) {
+		if (duration_us < ctx->duration) {
+			if (ctx->tcp) {
+				sock_send_tcp(&gun, &payload_ptr);
+			} else {
+				sock_send_udp(&gun, &payload_ptr, tick);
+			}
+		}
+		sock_timeout(&gun);
+
+		uint64_t wait_us = gun_progress(ctx, &timer, &local_stats, &periodic_stats,
+		                                &stats_triggered, &duration_us);
+		sock_wait(&gun, wait_us);
+		tick++;
+	}
+	gun_finish(ctx, &timer, &local_stats, &periodic_stats, extra_wait);
+
+cleanup:
+	sock_gun_deinit(&gun);
+
+	return NULL;
+}
 
+#ifdef ENABLE_XDP
 static int dev2mac(const char *dev, uint8_t *mac)
 {
 	struct ifreq ifr;
@@ -847,6 +1461,7 @@ static bool mac_empty(const uint8_t *mac)
 	static const uint8_t unset_mac[6] = { 0 };
 	return (memcmp(mac, unset_mac, sizeof(unset_mac)) == 0);
 }
+#endif // ENABLE_XDP
 
 static int mac_sscan(const char *src, uint8_t *dst)
 {
@@ -911,8 +1526,9 @@ static bool configure_target(char *target_str, char *local_ip, xdp_gun_ctx_t *ct
 		return false;
 	}
 
+#ifdef ENABLE_XDP
 	struct sockaddr_storage via = { 0 };
-	if (local_ip == NULL || ctx->dev[0] == '\0' || mac_empty(ctx->target_mac)) {
+	if (!ctx->sock && (local_ip == NULL || ctx->dev[0] == '\0' || mac_empty(ctx->target_mac))) {
 		char auto_dev[IFNAMSIZ];
 		int ret = ip_route_get(&ctx->target_ip_ss,
 		                       &via,
@@ -923,11 +1539,15 @@ static bool configure_target(char *target_str, char *local_ip, xdp_gun_ctx_t *ct
 			return false;
 		}
 	}
+#endif // ENABLE_XDP
 
 	ctx->local_ip_range = addr_bits(ctx->ipv6); // by default use one IP
 	if (local_ip != NULL) {
 		at = strrchr(local_ip, '/');
-		if (at != NULL && (val = atoi(at + 1)) > 0 && val <= ctx->local_ip_range) {
+		if (at != NULL && ctx->sock) {
+			ERR2("local subnet not supported with sockets");
+			return false;
+		} else if (at != NULL && (val = atoi(at + 1)) > 0 && val <= ctx->local_ip_range) {
 			ctx->local_ip_range = val;
 			*at = '\0';
 		}
@@ -943,8 +1563,14 @@ static bool configure_target(char *target_str, char *local_ip, xdp_gun_ctx_t *ct
 				return false;
 			}
 		}
+		ctx->local_ip_ss.ss_family = ctx->ipv6 ? AF_INET6 : AF_INET;
 	}
 
+	if (ctx->sock) {
+		return true;
+	}
+
+#ifdef ENABLE_XDP
 	if (mac_empty(ctx->target_mac)) {
 		const struct sockaddr_storage *neigh = (via.ss_family == AF_UNSPEC) ?
 		                                       &ctx->target_ip_ss : &via;
@@ -982,6 +1608,7 @@ static bool configure_target(char *target_str, char *local_ip, xdp_gun_ctx_t *ct
 			      ctx->dev, knot_strerror(ret));
 		}
 	}
+#endif // ENABLE_XDP
 
 	return true;
 }
@@ -995,13 +1622,15 @@ static void print_help(void)
 	       "                            "SPACE" (default is %"PRIu64" seconds)\n"
 	       " -T, --tcp[=debug_mode]     "SPACE"Send queries over TCP.\n"
 	       " -U, --quic[=debug_mode]    "SPACE"Send queries over QUIC.\n"
+	       " -E, --tls[=debug_mode]     "SPACE"Send queries over TLS (implies --socket).\n"
+	       " -s, --socket[=threads]     "SPACE"Use ordinary sockets instead of XDP (default 1 thread).\n"
 	       " -Q, --qps <qps>            "SPACE"Number of queries-per-second (approximately) to be sent.\n"
 	       "                            "SPACE" (default is %"PRIu64" qps)\n"
 	       " -b, --batch <size>         "SPACE"Send queries in a batch of defined size.\n"
 	       "                            "SPACE" (default is %d for UDP, %d for TCP)\n"
 	       " -r, --drop                 "SPACE"Drop incoming responses (disables response statistics).\n"
 	       " -p, --port <port>          "SPACE"Remote destination port.\n"
-	       "                            "SPACE" (default is %d for UDP/TCP, %u for QUIC)\n"
+	       "                            "SPACE" (default is %d for UDP/TCP, %u for QUIC/TLS)\n"
 	       " -F, --affinity <spec>      "SPACE"CPU affinity in the format [<cpu_start>][s<cpu_step>].\n"
 	       "                            "SPACE" (default is %s)\n"
 	       " -I, --interface <ifname>   "SPACE"Override auto-detected interface for outgoing communication.\n"
@@ -1116,7 +1745,7 @@ static int set_mode(const char *arg, knot_xdp_config_t *config)
 
 static bool get_opts(int argc, char *argv[], xdp_gun_ctx_t *ctx)
 {
-	const char *opts_str = "hV::t:Q:b:rp:T::U::F:I:i:Bl:L:R:v:e:m:G:jS:";
+	const char *opts_str = "hV::t:Q:b:rp:T::U::E::s::F:I:i:Bl:L:R:v:e:m:G:jS:";
 	struct option opts[] = {
 		{ "help",         no_argument,       NULL, 'h' },
 		{ "version",      optional_argument, NULL, 'V' },
@@ -1127,6 +1756,8 @@ static bool get_opts(int argc, char *argv[], xdp_gun_ctx_t *ctx)
 		{ "port",         required_argument, NULL, 'p' },
 		{ "tcp",          optional_argument, NULL, 'T' },
 		{ "quic",         optional_argument, NULL, 'U' },
+		{ "tls",          optional_argument, NULL, 'E' },
+		{ "socket",       optional_argument, NULL, 's' },
 		{ "affinity",     required_argument, NULL, 'F' },
 		{ "interface",    required_argument, NULL, 'I' },
 		{ "infile",       required_argument, NULL, 'i' },
@@ -1205,6 +1836,7 @@ static bool get_opts(int argc, char *argv[], xdp_gun_ctx_t *ctx)
 		case 'T':
 			ctx->tcp = true;
 			ctx->quic = false;
+			ctx->tls = false;
 			ctx->flags &= ~(KNOT_XDP_FILTER_UDP | KNOT_XDP_FILTER_QUIC);
 			ctx->flags |= KNOT_XDP_FILTER_TCP;
 			if (default_at_once) {
@@ -1218,6 +1850,7 @@ static bool get_opts(int argc, char *argv[], xdp_gun_ctx_t *ctx)
 #ifdef ENABLE_QUIC
 			ctx->quic = true;
 			ctx->tcp = false;
+			ctx->tls = false;
 			ctx->flags &= ~(KNOT_XDP_FILTER_UDP | KNOT_XDP_FILTER_TCP);
 			ctx->flags |= KNOT_XDP_FILTER_QUIC;
 			if (ctx->target_port == 0) {
@@ -1234,6 +1867,33 @@ static bool get_opts(int argc, char *argv[], xdp_gun_ctx_t *ctx)
 			return false;
 #endif // ENABLE_QUIC
 			break;
+		case 'E':
+			ctx->tls = true;
+			ctx->tcp = true;
+			ctx->quic = false;
+			ctx->sock = true;
+			if (ctx->target_port == 0) {
+				ctx->target_port = REMOTE_PORT_DOT_DEFAULT;
+			}
+			if (default_at_once) {
+				ctx->at_once = 1;
+			}
+			if (!sending_mode(optarg, ctx)) {
+				return false;
+			}
+			break;
+		case 's':
+			ctx->sock = true;
+			if (optarg != NULL) {
+				arg = atoi(optarg);
+				if (arg > 0) {
+					ctx->n_threads = arg;
+				} else {
+					ERR2("invalid number of threads '%s'", optarg);
+					return false;
+				}
+			}
+			break;
 		case 'F':
 			assert(optarg);
 			if ((arg = atoi(optarg)) > 0) {
@@ -1324,6 +1984,22 @@ static bool get_opts(int argc, char *argv[], xdp_gun_ctx_t *ctx)
 		print_help();
 		return false;
 	}
+#ifndef ENABLE_XDP
+	ctx->sock = true; // The only mode without XDP.
+#endif
+	if (ctx->sock) {
+		if (ctx->quic) {
+			ERR2("QUIC not available with sockets");
+			return false;
+		}
+		if (ctx->sending_mode[0] != '\0' && ctx->sending_mode[0] != 'R') {
+			ERR2("mode '%s' not available with sockets", ctx->sending_mode);
+			return false;
+		}
+		if (ctx->n_threads == 0) {
+			ctx->n_threads = 1;
+		}
+	}
 	size_t qcount = ctx->duration / 1000000 * ctx->qps;
 	if (!load_queries(&input, ctx->edns_size, ctx->msgid, qcount)) {
 		return false;
@@ -1379,7 +2055,7 @@ int main(int argc, char *argv[])
 		thread_ctxs[i].thread_id = i;
 	}
 
-	if (!linux_at_least(5, 11)) {
+	if (!ctx.sock && !linux_at_least(5, 11)) {
 		struct rlimit min_limit = { RLIM_INFINITY, RLIM_INFINITY }, cur_limit = { 0 };
 		if (getrlimit(RLIMIT_MEMLOCK, &cur_limit) != 0 ||
 		    cur_limit.rlim_cur != min_limit.rlim_cur ||
@@ -1397,12 +2073,17 @@ int main(int argc, char *argv[])
 	sigaction(SIGTERM, &stop_action, NULL);
 	sigaction(SIGUSR1, &stats_action, NULL);
 
+#ifdef ENABLE_XDP
+	void *(*gun_thread)(void *) = ctx.sock ? sock_gun_thread : xdp_gun_thread;
+#else
+	void *(*gun_thread)(void *) = sock_gun_thread;
+#endif
 	for (size_t i = 0; i < ctx.n_threads; i++) {
 		unsigned affinity = global_cpu_aff_start + i * global_cpu_aff_step;
 		cpu_set_t set;
 		CPU_ZERO(&set);
 		CPU_SET(affinity, &set);
-		(void)pthread_create(&threads[i], NULL, xdp_gun_thread, &thread_ctxs[i]);
+		(void)pthread_create(&threads[i], NULL, gun_thread, &thread_ctxs[i]);
 		int ret = pthread_setaffinity_np(threads[i], sizeof(cpu_set_t), &set);
 		if (ret != 0) {
 			WARN2("failed to set affinity of thread#%zu to CPU#%u", i, affinity);
@@ -29,6 +29,7 @@
 
 #define REMOTE_PORT_DEFAULT        53
 #define REMOTE_PORT_DOQ_DEFAULT   853
+#define REMOTE_PORT_DOT_DEFAULT   853
 #define LOCAL_PORT_MIN           2000
 #define LOCAL_PORT_MAX          65535
 #define QUIC_THREAD_PORTS         100
@@ -73,6 +74,8 @@ typedef struct xdp_gun_ctx {
 	bool                   tcp;
 	bool                   quic;
 	bool                   quic_full_handshake;
+	bool                   tls;
+	bool                   sock;  // ordinary sockets instead of XDP
 	const char             *qlog_dir;
 	const char             *sending_mode;
 	xdp_gun_ignore_t       ignore1;
@@ -29,6 +29,8 @@
 
 pthread_mutex_t stdout_mtx = PTHREAD_MUTEX_INITIALIZER;
 
+static const double latency_pcts[] = { 50, 90, 99, 99.9, 99.99 };
+
 void clear_stats(kxdpgun_stats_t *st)
 {
 	*st = (kxdpgun_stats_t){ 0 };
@@ -57,16 +59,86 @@ void collect_periodic_stats(kxdpgun_stats_t *into, const kxdpgun_stats_t *what)
 	for (int i = 0; i < RCODE_MAX; i++) {
 		into->rcodes_recv[i] += what->rcodes_recv[i];
 	}
+	into->lat_count   += what->lat_count;
+	into->lat_sum     += what->lat_sum;
+	into->lat_max      = MAX(into->lat_max, what->lat_max);
+	for (int i = 0; i < LATENCY_BUCKETS; i++) {
+		into->lat_hist[i] += what->lat_hist[i];
+	}
+}
+
+static unsigned latency_bucket(uint64_t usecs)
+{
+	if (usecs < (1 << LATENCY_SUB_BITS)) {
+		return usecs;
+	}
+	usecs = MIN(usecs, UINT32_MAX);
+
+	unsigned exp = 63 - __builtin_clzll(usecs);
+	unsigned shift = exp - LATENCY_SUB_BITS;
+	unsigned sub = (usecs >> shift) & ((1 << LATENCY_SUB_BITS) - 1);
+	return ((shift + 1) << LATENCY_SUB_BITS) + sub;
+}
+
+static uint64_t latency_bucket_max(unsigned bucket)
+{
+	if (bucket < (1 << LATENCY_SUB_BITS)) {
+		return bucket;
+	}
+
+	unsigned shift = (bucket >> LATENCY_SUB_BITS) - 1;
+	uint64_t sub = bucket & ((1 << LATENCY_SUB_BITS) - 1);
+	return (((1 << LATENCY_SUB_BITS) + sub + 1) << shift) - 1;
+}
+
+void latency_add(kxdpgun_stats_t *st, uint64_t usecs)
+{
+	st->lat_count++;
+	st->lat_sum += usecs;
+	st->lat_max = MAX(st->lat_max, usecs);
+	st->lat_hist[latency_bucket(usecs)]++;
+}
+
+uint64_t latency_percentile(const kxdpgun_stats_t *st, double pct)
+{
+	uint64_t rank = st->lat_count * pct / 100.0;
+	uint64_t seen = 0;
+	for (unsigned i = 0; i < LATENCY_BUCKETS; i++) {
+		seen += st->lat_hist[i];
+		if (seen > rank) {
+			return MIN(latency_bucket_max(i), st->lat_max);
+		}
+	}
+	return st->lat_max;
+}
+
+static const char *xdp_mode(const xdp_gun_ctx_t *ctx)
+{
+#ifdef ENABLE_XDP
+	if (knot_eth_xdp_mode(if_nametoindex(ctx->dev)) == KNOT_XDP_MODE_FULL) {
+		return "native";
+	}
+#endif
+	return "emulated";
 }
 
 void plain_stats_header(const xdp_gun_ctx_t *ctx)
 {
+	if (ctx->sock) {
+		INFO2("using sockets, threads %u, IPv%c/%s%s%s", ctx->n_threads,
+		      (ctx->ipv6 ? '6' : '4'),
+		      (ctx->tls ? "TLS" : ctx->tcp ? "TCP" : "UDP"),
+		      (ctx->sending_mode[0] != '\0' ? " mode " : ""),
+		      (ctx->sending_mode[0] != '\0' ? ctx->sending_mode : ""));
+		puts(STATS_SECTION_SEP);
+		return;
+	}
 	INFO2("using interface %s, XDP threads %u, IPv%c/%s%s%s, %s mode", ctx->dev, ctx->n_threads,
 	      (ctx->ipv6 ? '6' : '4'),
 	      (ctx->tcp ? "TCP" : ctx->quic ? "QUIC" : "UDP"),
 	      (ctx->sending_mode[0] != '\0' ? " mode " : ""),
 	      (ctx->sending_mode[0] != '\0' ? ctx->sending_mode : ""),
-	      (knot_eth_xdp_mode(if_nametoindex(ctx->dev)) == KNOT_XDP_MODE_FULL ? "native" : "emulated"));
+	      xdp_mode(ctx));
 	puts(STATS_SECTION_SEP);
 }
 
@@ -102,18 +174,24 @@ void json_stats_header(const xdp_gun_ctx_t *ctx)
 		// mirror the info given by the plaintext printout
 		jsonw_object(w, "additional_info");
 		{
-			jsonw_str(w, "interface", ctx->dev);
-			jsonw_int(w, "xdp_threads", ctx->n_threads);
+			if (ctx->sock) {
+				jsonw_int(w, "socket_threads", ctx->n_threads);
+			} else {
+				jsonw_str(w, "interface", ctx->dev);
+				jsonw_int(w, "xdp_threads", ctx->n_threads);
+			}
 			jsonw_int(w, "ip_version", ctx->ipv6 ? 6 : 4);
-			jsonw_str(w, "transport_layer_proto", ctx->tcp ? "TCP" : (ctx->quic ? "QUIC" : "UDP"));
+			jsonw_str(w, "transport_layer_proto", ctx->tls ? "TLS" : ctx->tcp ? "TCP" : (ctx->quic ? "QUIC" : "UDP"));
 			jsonw_object(w, "mode_info");
 			{
 				if (ctx->sending_mode[0] != '\0') {
 					jsonw_str(w, "debug", ctx->sending_mode);
 				}
-				jsonw_str(w, "mode", knot_eth_xdp_mode(if_nametoindex(ctx->dev)) == KNOT_XDP_MODE_FULL
-							? "native"
-							: "emulated");
+				if (ctx->sock) {
+					jsonw_str(w, "mode", "socket");
+				} else {
+					jsonw_str(w, "mode", xdp_mode(ctx));
+				}
 			}
 			jsonw_end(w);
 		}
@@ -219,8 +297,10 @@ void plain_stats(const xdp_gun_ctx_t *ctx, kxdpgun_stats_t *st, stats_type_t stt
 		}
 		printf("average DNS reply size: %"PRIu64" B\n",
 		       st->ans_recv > 0 ? st->size_recv / st->ans_recv : 0);
+		if (!ctx->sock) {
 		printf("average Ethernet reply rate: %"PRIu64" bps (%.2f Mbps)\n",
 		       ps(st->wire_recv * 8), ps((float)st->wire_recv * 8 / (1000 * 1000)));
+		}
 
 		for (int i = 0; i < RCODE_MAX; i++) {
 			if (st->rcodes_recv[i] > 0) {
@@ -231,6 +311,14 @@ void plain_stats(const xdp_gun_ctx_t *ctx, kxdpgun_stats_t *st, stats_type_t stt
 				       rcname, space, "         ", st->rcodes_recv[i]);
 			}
 		}
+		if (st->lat_count > 0) {
+			printf("reply latency: avg %"PRIu64" us, max %"PRIu64" us\n",
+			       st->lat_sum / st->lat_count, st->lat_max);
+			for (size_t i = 0; i < sizeof(latency_pcts) / sizeof(*latency_pcts); i++) {
+				printf("latency %6.2f %%: %"PRIu64" us\n", latency_pcts[i],
+				       latency_percentile(st, latency_pcts[i]));
+			}
+		}
 	}
 	if (stt == STATS_SUM) {
 		printf("duration: %.4f s\n", duration / 1000000.0);
@@ -269,9 +357,23 @@ void json_stats(const xdp_gun_ctx_t *ctx, kxdpgun_stats_t *st, stats_type_t stt)
 			jsonw_end(w);
 		}
 
+		if (st->lat_count > 0) {
+			jsonw_object(w, "response_latency");
+			{
+				jsonw_ulong(w, "avg", st->lat_sum / st->lat_count * 1000);
+				jsonw_ulong(w, "max", st->lat_max * 1000);
+				for (size_t i = 0; i < sizeof(latency_pcts) / sizeof(*latency_pcts); i++) {
+					char name[16];
+					(void)snprintf(name, sizeof(name), "p%g", latency_pcts[i]);
+					jsonw_ulong(w, name, latency_percentile(st, latency_pcts[i]) * 1000);
+				}
+			}
+			jsonw_end(w);
+		}
+
 		jsonw_object(w, "conn_info");
 		{
-			jsonw_str(w, "type", ctx->tcp ? "tcp" : (ctx->quic ? "quic_conn" : "udp"));
+			jsonw_str(w, "type", ctx->tls ? "tls" : ctx->tcp ? "tcp" : (ctx->quic ? "quic_conn" : "udp"));
 			jsonw_ulong(w, "packets_sent", st->qry_sent);
 			jsonw_ulong(w, "packets_recieved", st->ans_recv);
 			jsonw_ulong(w, "socket_errors", st->errors);
@@ -25,6 +25,11 @@
 
 #define RCODE_MAX (0x0F + 1)
 
+/* Log-linear latency histogram (HdrHistogram-like): values up to 2^32 usecs,
+ * each power of two split into 2^LATENCY_SUB_BITS buckets (~3 % precision). */
+#define LATENCY_SUB_BITS 5
+#define LATENCY_BUCKETS  ((32 - LATENCY_SUB_BITS + 1) << LATENCY_SUB_BITS)
+
 #define STATS_SECTION_SEP "--------------------------------------------------------------"
 
 #define JSON_INDENT		"  "
@@ -54,6 +59,10 @@ typedef struct {
 	uint64_t	errors;
 	uint64_t	lost;
 	uint64_t	rcodes_recv[RCODE_MAX];
+	uint64_t	lat_count;
+	uint64_t	lat_sum; // usecs
+	uint64_t	lat_max; // usecs
+	uint64_t	lat_hist[LATENCY_BUCKETS];
 } kxdpgun_stats_t;
 
 typedef enum {
@@ -65,6 +74,9 @@ void clear_stats(kxdpgun_stats_t *st);
 size_t collect_stats(kxdpgun_stats_t *into, const kxdpgun_stats_t *what);
 void collect_periodic_stats(kxdpgun_stats_t *into, const kxdpgun_stats_t *what);
 
+void latency_add(kxdpgun_stats_t *st, uint64_t usecs);
+uint64_t latency_percentile(const kxdpgun_stats_t *st, double pct);
+
 void plain_stats_header(const xdp_gun_ctx_t *ctx);
 void json_stats_header(const xdp_gun_ctx_t *ctx);
 
@@ -19,6 +19,7 @@
 
 #include "utils/kzonecheck/zone_check.h"
 
+#include "knot/server/dthreads.h"
 #include "knot/zone/contents.h"
 #include "knot/zone/digest.h"
 #include "knot/zone/zonefile.h"
@@ -86,6 +87,7 @@ int zone_check(const char *zone_file, const knot_dname_t *zone_name, bool zonemd
 	}
 	zl.err_handler = (sem_handler_t *)&stats;
 	zl.creator->master = true;
+	zl.parse_threads = (threads > 0) ? threads : dt_optimal_size();
 
 	zone_contents_t *contents = zonefile_load(&zl, threads);
 	zonefile_close(&zl);
@@ -103,6 +103,42 @@ static bool str_key_get_leq(trie_t *trie, char **keys, size_t i, size_t size)
 
 }
 
+typedef struct {
+	trie_val_t *vals;
+	size_t count;
+} collect_ctx_t;
+
+static int collect_val(trie_val_t *val, void *d)
+{
+	collect_ctx_t *ctx = d;
+	ctx->vals[ctx->count++] = *val;
+	return KNOT_EOK;
+}
+
+static void test_apply_part(trie_t *trie, size_t count)
+{
+	collect_ctx_t all = { malloc(count * sizeof(trie_val_t)), 0 };
+	collect_ctx_t parts = { malloc(count * sizeof(trie_val_t)), 0 };
+
+	(void)trie_apply(trie, collect_val, &all);
+
+	const unsigned parts_counts[] = { 1, 3, 16, 1000 };
+	for (size_t i = 0; i < sizeof(parts_counts) / sizeof(*parts_counts); ++i) {
+		unsigned n = parts_counts[i];
+		parts.count = 0;
+		bool passed = true;
+		for (unsigned part = 0; part < n && passed; ++part) {
+			passed = trie_apply_part(trie, part, n, collect_val, &parts) == KNOT_EOK;
+		}
+		ok(passed && parts.count == all.count &&
+		   memcmp(parts.vals, all.vals, count * sizeof(trie_val_t)) == 0,
+		   "trie: apply in %u parts", n);
+	}
+
+	free(all.vals);
+	free(parts.vals);
+}
+
 static void test_wildcards(void)
 {
 	/* Test zone. */
@@ -270,6 +306,9 @@ int main(int argc, char *argv[])
 	is_int(inserted, iterated, "trie: sorted iteration");
 	trie_it_free(it);
 
+	/* Partitioned application. */
+	test_apply_part(trie, inserted);
+
 	/* Cleanup */
 	for (unsigned i = 0; i < key_count; ++i) {
 		free(keys[i]);
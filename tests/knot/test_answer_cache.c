@@ -0,0 +1,385 @@
+/*  Copyright (C) 2024 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <assert.h>
+#include <tap/basic.h>
+#include <tap/files.h>
+
+#include "knot/nameserver/internet.c"
+#include "knot/nameserver/process_query.h"
+#include "knot/nameserver/query_module.h"
+#include "knot/updates/zone-update.h"
+#include "knot/zone/answer-cache.h"
+#include "libknot/libknot.h"
+#include "test_conf.h"
+#include "contrib/sockaddr.h"
+#include "contrib/ucw/mempool.h"
+
+#define ZONE	(const knot_dname_t *)"\x07""example"
+#define WWW	(const knot_dname_t *)"\x03""www""\x07""example"
+#define WWW_UP	(const knot_dname_t *)"\x03""WwW""\x07""eXample"
+
+/*! \brief Large enough to make a slot collision of the keys used unlikely. */
+#define CACHE_SIZE	(1 << 16)
+
+static knot_pkt_t *new_query(const knot_dname_t *qname, uint16_t qtype,
+                             uint16_t payload, bool dnssec)
+{
+	knot_pkt_t *wire = knot_pkt_new(NULL, KNOT_WIRE_MAX_PKTSIZE, NULL);
+	assert(wire);
+	knot_pkt_put_question(wire, qname, KNOT_CLASS_IN, qtype);
+
+	if (payload > 0) {
+		knot_rrset_t opt;
+		knot_edns_init(&opt, payload, 0, 0, NULL);
+		if (dnssec) {
+			knot_edns_set_do(&opt);
+		}
+		knot_pkt_begin(wire, KNOT_ADDITIONAL);
+		knot_pkt_put(wire, KNOT_COMPR_HINT_NONE, &opt, 0);
+		knot_rrset_clear(&opt, NULL);
+	}
+
+	// Parse a copy, the OPT is already set in the constructed packet.
+	knot_pkt_t *query = knot_pkt_new(NULL, KNOT_WIRE_MAX_PKTSIZE, NULL);
+	assert(query);
+	memcpy(query->wire, wire->wire, wire->size);
+	query->size = wire->size;
+	knot_pkt_free(wire);
+
+	int ret = knot_pkt_parse(query, 0);
+	assert(ret == KNOT_EOK);
+	(void)ret;
+
+	return query;
+}
+
+static knot_pkt_t *new_resp(const knot_pkt_t *query, size_t size)
+{
+	knot_pkt_t *resp = knot_pkt_new(NULL, size, NULL);
+	assert(resp);
+	knot_pkt_init_response(resp, query);
+	return resp;
+}
+
+static bool cache_get(answer_cache_t *cache, const knot_pkt_t *query, size_t size,
+                      const knot_pkt_t *expected)
+{
+	knot_pkt_t *resp = new_resp(query, size);
+	uint16_t rcode = KNOT_RCODE_SERVFAIL;
+	int rcode_ede = KNOT_EDNS_EDE_NONE;
+	bool found = answer_cache_get(cache, query, resp, &rcode, &rcode_ede);
+	if (found && expected != NULL) {
+		size_t offset = KNOT_WIRE_HEADER_SIZE + knot_pkt_question_size(query);
+		found = rcode == KNOT_RCODE_NOERROR &&
+		        resp->size == expected->size &&
+		        knot_wire_get_aa(resp->wire) &&
+		        knot_wire_get_ancount(resp->wire) == 1 &&
+		        memcmp(resp->wire + offset, expected->wire + offset,
+		               resp->size - offset) == 0 &&
+		        memcmp(resp->wire + KNOT_WIRE_HEADER_SIZE, query->wire + KNOT_WIRE_HEADER_SIZE,
+		               knot_pkt_question_size(query)) == 0;
+	}
+	knot_pkt_free(resp);
+	return found;
+}
+
+static void test_cache(void)
+{
+	uint8_t addr[] = { 192, 0, 2, 1 };
+	knot_rrset_t *rr = knot_rrset_new(WWW, KNOT_RRTYPE_A, KNOT_CLASS_IN, 3600, NULL);
+	assert(rr);
+	knot_rrset_add_rdata(rr, addr, sizeof(addr), NULL);
+
+	ok(answer_cache_new(0) == NULL, "cache: zero size rejected");
+
+	answer_cache_t *cache = answer_cache_new(CACHE_SIZE);
+	ok(cache != NULL, "cache: create");
+
+	knot_pkt_t *query = new_query(WWW, KNOT_RRTYPE_A, 1232, false);
+	ok(!cache_get(cache, query, 1232, NULL), "cache: empty, miss");
+
+	// Nothing to store without the answer.
+	knot_pkt_t *resp = new_resp(query, 1232);
+	answer_cache_put(cache, query, resp, KNOT_RCODE_NOERROR, KNOT_EDNS_EDE_NONE);
+	ok(!cache_get(cache, query, 1232, NULL), "cache: empty answer not stored");
+
+	knot_wire_set_aa(resp->wire);
+	knot_pkt_begin(resp, KNOT_ANSWER);
+	knot_pkt_put(resp, KNOT_COMPR_HINT_QNAME, rr, 0);
+	answer_cache_put(cache, query, resp, KNOT_RCODE_NOERROR, KNOT_EDNS_EDE_NONE);
+	ok(cache_get(cache, query, 1232, resp), "cache: hit");
+
+	knot_pkt_t *other = new_query(WWW_UP, KNOT_RRTYPE_A, 1232, false);
+	ok(cache_get(cache, other, 1232, resp), "cache: hit with different QNAME case");
+	knot_pkt_free(other);
+
+	other = new_query(WWW, KNOT_RRTYPE_AAAA, 1232, false);
+	ok(!cache_get(cache, other, 1232, NULL), "cache: different QTYPE, miss");
+	knot_pkt_free(other);
+
+	other = new_query(ZONE, KNOT_RRTYPE_A, 1232, false);
+	ok(!cache_get(cache, other, 1232, NULL), "cache: different QNAME, miss");
+	knot_pkt_free(other);
+
+	other = new_query(WWW, KNOT_RRTYPE_A, 1232, true);
+	ok(!cache_get(cache, other, 1232, NULL), "cache: DO bit set, miss");
+	knot_pkt_free(other);
+
+	other = new_query(WWW, KNOT_RRTYPE_A, 0, false);
+	ok(!cache_get(cache, other, KNOT_WIRE_MIN_PKTSIZE, NULL), "cache: no EDNS, miss");
+	knot_pkt_free(other);
+
+	ok(!cache_get(cache, query, 4096, NULL), "cache: different EDNS payload, miss");
+
+	// Space reserved for OPT or TSIG is part of the key.
+	knot_pkt_t *reserved = new_resp(query, 1232);
+	knot_pkt_reserve(reserved, 11);
+	uint16_t rcode;
+	int rcode_ede;
+	ok(!answer_cache_get(cache, query, reserved, &rcode, &rcode_ede),
+	   "cache: different reserved space, miss");
+	knot_pkt_free(reserved);
+
+	// Only a response without any section is filled.
+	ok(!answer_cache_get(cache, query, resp, &rcode, &rcode_ede),
+	   "cache: non-empty response not filled");
+
+	// Answers in a larger response are stored separately.
+	knot_pkt_t *large = new_resp(query, 4096);
+	knot_pkt_begin(large, KNOT_ANSWER);
+	knot_pkt_put(large, KNOT_COMPR_HINT_QNAME, rr, 0);
+	answer_cache_put(cache, query, large, KNOT_RCODE_NOERROR, KNOT_EDNS_EDE_NONE);
+	ok(cache_get(cache, query, 1232, resp), "cache: hit of the smaller response kept");
+	knot_pkt_free(large);
+
+	knot_pkt_free(resp);
+	knot_pkt_free(query);
+	answer_cache_free(cache);
+	knot_rrset_free(rr, NULL);
+}
+
+static int update_a(zone_t *zone, zone_update_flags_t flags,
+                    uint8_t remove, uint8_t add)
+{
+	zone_update_t update;
+	int ret = zone_update_init(&update, zone, flags);
+	if (ret != KNOT_EOK) {
+		return ret;
+	}
+
+	knot_rrset_t rr;
+	if (flags & UPDATE_FULL) {
+		const uint8_t soa[] = "\x02""ns\x07""example\x00\x01m\x07""example\x00"
+		                      "\x00\x00\x00\x01\x00\x00\x03\x84\x00\x00\x01\x2c"
+		                      "\x00\x00\x12\xc0\x00\x00\x03\x84";
+		knot_rrset_init(&rr, (knot_dname_t *)ZONE, KNOT_RRTYPE_SOA, KNOT_CLASS_IN, 3600);
+		ret = knot_rrset_add_rdata(&rr, soa, sizeof(soa) - 1, NULL);
+		if (ret == KNOT_EOK) {
+			ret = zone_update_add(&update, &rr);
+		}
+		knot_rdataset_clear(&rr.rrs, NULL);
+	}
+
+	uint8_t addr[] = { 192, 0, 2, remove };
+	knot_rrset_init(&rr, (knot_dname_t *)WWW, KNOT_RRTYPE_A, KNOT_CLASS_IN, 3600);
+	if (ret == KNOT_EOK && remove > 0) {
+		ret = knot_rrset_add_rdata(&rr, addr, sizeof(addr), NULL);
+		if (ret == KNOT_EOK) {
+			ret = zone_update_remove(&update, &rr);
+		}
+		knot_rdataset_clear(&rr.rrs, NULL);
+	}
+	if (ret == KNOT_EOK) {
+		addr[3] = add;
+		ret = knot_rrset_add_rdata(&rr, addr, sizeof(addr), NULL);
+		if (ret == KNOT_EOK) {
+			ret = zone_update_add(&update, &rr);
+		}
+		knot_rdataset_clear(&rr.rrs, NULL);
+	}
+
+	if (ret == KNOT_EOK) {
+		ret = zone_update_commit(conf(), &update);
+	}
+	if (ret != KNOT_EOK) {
+		zone_update_clear(&update);
+	}
+
+	return ret;
+}
+
+/*! \brief Resolve the query, return the last address byte of the answer or 0. */
+static uint8_t resolve_a(knot_layer_t *layer, knotd_qdata_params_t *params)
+{
+	knot_pkt_t *query = new_query(WWW, KNOT_RRTYPE_A, 1232, false);
+	knot_pkt_t *answer = knot_pkt_new(NULL, KNOT_WIRE_MAX_PKTSIZE, NULL);
+	assert(answer);
+
+	knot_layer_begin(layer, params);
+	knot_layer_consume(layer, query);
+	knot_layer_produce(layer, answer);
+	knot_layer_finish(layer);
+
+	uint8_t last = 0;
+	knot_pkt_t *parsed = knot_pkt_new(answer->wire, answer->size, NULL);
+	if (knot_pkt_parse(parsed, 0) == KNOT_EOK &&
+	    knot_wire_get_rcode(parsed->wire) == KNOT_RCODE_NOERROR) {
+		const knot_pktsection_t *section = knot_pkt_section(parsed, KNOT_ANSWER);
+		if (section->count == 1 && knot_pkt_rr(section, 0)->type == KNOT_RRTYPE_A) {
+			last = knot_pkt_rr(section, 0)->rrs.rdata->data[3];
+		}
+	}
+
+	knot_pkt_free(parsed);
+	knot_pkt_free(answer);
+	knot_pkt_free(query);
+
+	return last;
+}
+
+static void test_zone(server_t *server)
+{
+	zone_t *zone = zone_new(ZONE);
+	assert(zone);
+	zone->server = server;
+	knot_zonedb_insert(server->zone_db, zone);
+
+	is_int(KNOT_EOK, update_a(zone, UPDATE_FULL, 0, 1), "zone: load");
+	ok(zone->contents->answer_cache != NULL, "zone: cache attached");
+
+	knot_mm_t mm;
+	mm_ctx_mempool(&mm, MM_DEFAULT_BLKSIZE);
+	knot_layer_t layer = { 0 };
+	knot_layer_init(&layer, &mm, process_query_layer());
+
+	struct sockaddr_storage ss;
+	sockaddr_set(&ss, AF_INET, "127.0.0.1", 53);
+	knotd_qdata_params_t params = {
+		.proto = KNOTD_QUERY_PROTO_TCP,
+		.remote = &ss,
+		.server = server
+	};
+
+	is_int(1, resolve_a(&layer, &params), "zone: answer");
+
+	// Change the data behind the cache's back to see where the answer comes from.
+	knot_rdata_t *rdata = node_rdataset(zone_contents_find_node(zone->contents, WWW),
+	                                    KNOT_RRTYPE_A)->rdata;
+	rdata->data[3] = 9;
+	is_int(1, resolve_a(&layer, &params), "zone: answer from the cache");
+	rdata->data[3] = 1;
+
+	is_int(KNOT_EOK, update_a(zone, UPDATE_INCREMENTAL, 1, 2), "zone: update");
+	ok(zone->contents->answer_cache != NULL, "zone: cache attached after update");
+	is_int(2, resolve_a(&layer, &params), "zone: answer after update");
+
+	rdata = node_rdataset(zone_contents_find_node(zone->contents, WWW),
+	                      KNOT_RRTYPE_A)->rdata;
+	rdata->data[3] = 9;
+	is_int(2, resolve_a(&layer, &params), "zone: updated answer from the cache");
+	rdata->data[3] = 2;
+
+	mp_delete(mm.ctx);
+}
+
+static void test_usable(server_t *server)
+{
+	zone_t *zone = knot_zonedb_find(server->zone_db, ZONE);
+	knot_pkt_t *query = new_query(WWW, KNOT_RRTYPE_A, 1232, false);
+
+	knotd_qdata_extra_t extra = {
+		.zone = zone,
+		.contents = zone->contents
+	};
+	knotd_qdata_t qdata = {
+		.query = query,
+		.extra = &extra
+	};
+
+	ok(answer_cache_usable(&qdata), "usable: plain query");
+
+	zone_contents_t no_cache = { 0 };
+	extra.contents = &no_cache;
+	ok(!answer_cache_usable(&qdata), "usable: contents without cache");
+	extra.contents = zone->contents;
+
+	knot_rrset_t tsig;
+	query->tsig_rr = &tsig;
+	ok(!answer_cache_usable(&qdata), "usable: TSIG signed query");
+	query->tsig_rr = NULL;
+
+	conf()->cache.srv_ans_rotate = true;
+	ok(!answer_cache_usable(&qdata), "usable: answer rotation");
+	conf()->cache.srv_ans_rotate = false;
+
+	zone->query_plan = query_plan_create();
+	ok(!answer_cache_usable(&qdata), "usable: zone query module");
+	query_plan_free(zone->query_plan);
+	zone->query_plan = NULL;
+
+	struct query_plan *plan = conf()->query_plan;
+	conf()->query_plan = query_plan_create();
+	ok(answer_cache_usable(&qdata), "usable: global module without end stage");
+	query_plan_step(conf()->query_plan, KNOTD_STAGE_END, QUERY_HOOK_TYPE_GENERAL,
+	                NULL, NULL);
+	ok(!answer_cache_usable(&qdata), "usable: global module with end stage");
+	query_plan_free(conf()->query_plan);
+	conf()->query_plan = plan;
+
+	knot_pkt_free(query);
+}
+
+int main(int argc, char *argv[])
+{
+	plan_lazy();
+
+	test_cache();
+
+	char *temp_dir = test_mkdtemp();
+	ok(temp_dir != NULL, "make temporary directory");
+
+	char conf_str[512];
+	(void)snprintf(conf_str, sizeof(conf_str),
+	               "database:\n"
+	               "  storage: %s\n"
+	               "zone:\n"
+	               "  - domain: example.\n"
+	               "    answer-cache: 16\n"
+	               "    zonefile-sync: -1\n",
+	               temp_dir);
+	int ret = test_conf(conf_str, NULL);
+	is_int(KNOT_EOK, ret, "load configuration");
+
+	server_t server;
+	ret = server_init(&server, 1);
+	is_int(KNOT_EOK, ret, "server init");
+	if (ret == KNOT_EOK) {
+		knot_zonedb_free(&server.zone_db);
+		server.zone_db = knot_zonedb_new();
+
+		test_zone(&server);
+		test_usable(&server);
+
+		server_deinit(&server);
+	}
+
+	conf_free(conf());
+	test_rm_rf(temp_dir);
+	free(temp_dir);
+
+	return 0;
+}
@@ -0,0 +1,143 @@
+/*  Copyright (C) 2024 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <tap/basic.h>
+
+#include "knot/zone/axfr-cache.h"
+#include "knot/zone/contents.h"
+#include "libknot/libknot.h"
+
+#define HOSTS	5000
+
+static int add_rr(zone_contents_t *contents, const char *owner, uint16_t type,
+                  const uint8_t *rdata, uint16_t rdlen)
+{
+	knot_dname_storage_t owner_bin;
+	if (knot_dname_from_str(owner_bin, owner, sizeof(owner_bin)) == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	knot_rrset_t rrset;
+	knot_rrset_init(&rrset, owner_bin, type, KNOT_CLASS_IN, 3600);
+	int ret = knot_rrset_add_rdata(&rrset, rdata, rdlen, NULL);
+	if (ret == KNOT_EOK) {
+		zone_node_t *unused = NULL;
+		ret = zone_contents_add_rr(contents, &rrset, &unused);
+	}
+	knot_rdataset_clear(&rrset.rrs, NULL);
+
+	return ret;
+}
+
+static zone_contents_t *create_contents(void)
+{
+	zone_contents_t *contents = zone_contents_new((uint8_t *)"\x04""test", true);
+	if (contents == NULL) {
+		return NULL;
+	}
+
+	const uint8_t soa[] = "\x02""ns\x04""test\x00\x01m\x04""test\x00"
+	                      "\x00\x00\x07\xe8\x00\x00\x03\x84\x00\x00\x01\x2c"
+	                      "\x00\x00\x12\xc0\x00\x00\x03\x84";
+	int ret = add_rr(contents, "test.", KNOT_RRTYPE_SOA, soa, sizeof(soa) - 1);
+	if (ret == KNOT_EOK) {
+		ret = add_rr(contents, "test.", KNOT_RRTYPE_NS, (uint8_t *)"\x02""ns\x04""test", 9);
+	}
+	for (unsigned i = 0; i < HOSTS && ret == KNOT_EOK; i++) {
+		char owner[32];
+		(void)snprintf(owner, sizeof(owner), "h%u.test.", i);
+		uint8_t addr[4] = { 192, 0, i >> 8, i & 0xff };
+		ret = add_rr(contents, owner, KNOT_RRTYPE_A, addr, sizeof(addr));
+	}
+	if (ret != KNOT_EOK) {
+		zone_contents_deep_free(contents);
+		return NULL;
+	}
+
+	return contents;
+}
+
+static knot_pkt_t *new_resp(size_t size)
+{
+	knot_pkt_t *resp = knot_pkt_new(NULL, size, NULL);
+	if (resp != NULL &&
+	    knot_pkt_put_question(resp, (uint8_t *)"\x04""TeSt", KNOT_CLASS_IN,
+	                          KNOT_RRTYPE_AXFR) != KNOT_EOK) {
+		knot_pkt_free(resp);
+		return NULL;
+	}
+
+	return resp;
+}
+
+int main(int argc, char *argv[])
+{
+	plan_lazy();
+
+	zone_contents_t *contents = create_contents();
+	ok(contents != NULL, "create contents");
+	if (contents == NULL) {
+		return EXIT_FAILURE;
+	}
+
+	axfr_cache_t *cache = axfr_cache_new();
+	ok(cache != NULL, "create cache");
+	is_int(KNOT_EOK, axfr_cache_prepare(cache, contents), "prepare cache");
+	is_int(KNOT_EOK, axfr_cache_prepare(cache, contents), "prepare cache again");
+	size_t count = axfr_cache_count(cache);
+	ok(count > 1, "multiple messages (%zu)", count);
+
+	// Check that the messages parse and carry the whole zone.
+	knot_pkt_t *resp = new_resp(KNOT_WIRE_MAX_PKTSIZE);
+	ok(resp != NULL && axfr_cache_fits(cache, resp), "response fits");
+	size_t rrs = 0;
+	bool valid = true, soa_first = false, soa_last = false;
+	for (size_t i = 0; i < count && valid; i++) {
+		resp->size = KNOT_WIRE_HEADER_SIZE + knot_pkt_question_size(resp);
+		valid = (axfr_cache_get(cache, i, resp) == KNOT_EOK);
+
+		knot_pkt_t *parsed = knot_pkt_new(resp->wire, resp->size, NULL);
+		valid = valid && knot_pkt_parse(parsed, 0) == KNOT_EOK &&
+		        knot_dname_is_equal(knot_pkt_wire_qname(parsed), (uint8_t *)"\x04""TeSt");
+		const knot_pktsection_t *answer = knot_pkt_section(parsed, KNOT_ANSWER);
+		valid = valid && answer->count > 0;
+		if (valid && i == 0) {
+			soa_first = knot_pkt_rr(answer, 0)->type == KNOT_RRTYPE_SOA;
+		}
+		if (valid && i == count - 1) {
+			soa_last = knot_pkt_rr(answer, answer->count - 1)->type == KNOT_RRTYPE_SOA;
+		}
+		rrs += valid ? answer->count : 0;
+		knot_pkt_free(parsed);
+	}
+	ok(valid, "messages valid");
+	ok(soa_first && soa_last, "messages enclosed by SOA");
+	is_int(HOSTS + 3, rrs, "all records present");
+	is_int(KNOT_EINVAL, axfr_cache_get(cache, count, resp), "message out of range");
+	knot_pkt_free(resp);
+
+	// Too small response.
+	resp = new_resp(1024);
+	ok(resp != NULL && !axfr_cache_fits(cache, resp), "small response doesn't fit");
+	is_int(KNOT_ESPACE, axfr_cache_get(cache, 0, resp), "get into small response");
+	knot_pkt_free(resp);
+
+	axfr_cache_free(cache);
+	zone_contents_deep_free(contents);
+
+	return 0;
+}
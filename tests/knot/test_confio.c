@@ -916,9 +916,12 @@ static void test_conf_io_list(void)
 	      "server.quic-idle-close-timeout\n"
 	      "server.quic-outbuf-max-size\n"
 	      "server.socket-affinity\n"
+	      "server.udp-backend\n"
 	      "server.udp-workers\n"
 	      "server.tcp-workers\n"
 	      "server.background-workers\n"
+	      "server.xfr-workers\n"
+	      "server.xfr-zone-limit\n"
 	      "server.udp-max-payload\n"
 	      "server.udp-max-payload-ipv4\n"
 	      "server.udp-max-payload-ipv6\n"
@@ -983,9 +986,12 @@ static const yp_item_t desc_server[] = {
 	{ C_QUIC_IDLE_CLOSE,	  YP_TINT,  YP_VNONE },
 	{ C_QUIC_OUTBUF_MAX_SIZE, YP_TINT,  YP_VNONE },
 	{ C_SOCKET_AFFINITY,	  YP_TBOOL, YP_VNONE },
+	{ C_UDP_BACKEND,	  YP_TOPT,  YP_VNONE },
 	{ C_UDP_WORKERS,	  YP_TINT,  YP_VNONE },
 	{ C_TCP_WORKERS,	  YP_TINT,  YP_VNONE },
 	{ C_BG_WORKERS,		  YP_TINT,  YP_VNONE },
+	{ C_XFR_WORKERS,	  YP_TINT,  YP_VNONE },
+	{ C_XFR_ZONE_LIMIT,	  YP_TINT,  YP_VNONE },
 	{ C_UDP_MAX_PAYLOAD,      YP_TINT,  YP_VNONE },
 	{ C_UDP_MAX_PAYLOAD_IPV4, YP_TINT,  YP_VNONE },
 	{ C_UDP_MAX_PAYLOAD_IPV6, YP_TINT,  YP_VNONE },
@@ -1035,6 +1041,7 @@ static const knot_lookup_t opts[] = {
 	{ C_MASTER,            YP_TREF,  YP_VREF = { C_RMT }, YP_FMULTI, { check_ref } }, \
 	{ C_ZONEFILE_LOAD,     YP_TOPT,  YP_VOPT = { opts, 0 } }, \
 	{ C_JOURNAL_CONTENT,   YP_TOPT,  YP_VOPT = { opts, 0 } }, \
+	{ C_JOURNAL_COMPRESSION, YP_TBOOL, YP_VNONE }, \
 	{ C_DNSSEC_SIGNING,    YP_TBOOL, YP_VNONE }, \
 	{ C_DNSSEC_VALIDATION, YP_TBOOL, YP_VNONE }, \
 	{ C_SERIAL_MODULO,     YP_TSTR,  YP_VSTR = { "0/1" } }, \
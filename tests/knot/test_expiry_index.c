@@ -0,0 +1,355 @@
+/*  Copyright (C) 2024 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <assert.h>
+#include <signal.h>
+#include <tap/basic.h>
+#include <tap/files.h>
+
+#include "test_conf.h"
+#include "knot/dnssec/zone-events.h"
+#include "knot/server/server.h"
+#include "knot/updates/zone-update.h"
+#include "knot/zone/adjust.h"
+#include "knot/zone/expiry-index.h"
+#include "libknot/descriptor.h"
+#include "libknot/rrtype/rrsig.h"
+
+#define APEX    (const knot_dname_t *)"\x07""example"
+#define NODE_A  (const knot_dname_t *)"\x01""a""\x07""example"
+#define NODE_B  (const knot_dname_t *)"\x01""b""\x07""example"
+#define NODE_C  (const knot_dname_t *)"\x01""c""\x07""example"
+#define NODE_N3 (const knot_dname_t *)"\x02""n3""\x07""example"
+#define NODE_0  (const knot_dname_t *)"\x01""0""\x07""example"
+
+#define HOUR 3600
+
+/*! \brief Owners passed to the apply callback, NSEC3 ones prefixed with '3'. */
+typedef struct {
+	char owners[256];
+} applied_t;
+
+static int applied_cb(const knot_dname_t *owner, bool nsec3, void *ctx)
+{
+	applied_t *applied = ctx;
+	char name[KNOT_DNAME_TXT_MAXLEN];
+	(void)knot_dname_to_str(name, owner, sizeof(name));
+	size_t len = strlen(applied->owners);
+	(void)snprintf(applied->owners + len, sizeof(applied->owners) - len, "%s%s ",
+	               nsec3 ? "3" : "", name);
+	return KNOT_EOK;
+}
+
+static const char *apply(expiry_index_t *idx, knot_time_t until)
+{
+	static applied_t applied;
+	memset(&applied, 0, sizeof(applied));
+	int ret = expiry_index_apply(idx, until, applied_cb, &applied);
+	return (ret == KNOT_EOK) ? applied.owners : "error";
+}
+
+static knot_time_t bucket_start(knot_time_t expire)
+{
+	return expire / EXPIRY_INDEX_BUCKET * EXPIRY_INDEX_BUCKET;
+}
+
+static zone_node_t *add_rr(zone_contents_t *zone, const knot_dname_t *owner,
+                           uint16_t type, const uint8_t *data, uint16_t len)
+{
+	knot_rrset_t *rr = knot_rrset_new(owner, type, KNOT_CLASS_IN, 3600, NULL);
+	assert(rr);
+	int ret = knot_rrset_add_rdata(rr, data, len, NULL);
+	assert(ret == KNOT_EOK);
+
+	zone_node_t *node = NULL;
+	ret = zone_contents_add_rr(zone, rr, &node);
+	assert(ret == KNOT_EOK);
+	(void)ret;
+	knot_rrset_free(rr, NULL);
+
+	return node;
+}
+
+static zone_node_t *add_rrsig(zone_contents_t *zone, const knot_dname_t *owner,
+                              uint16_t covered, knot_time_t expire)
+{
+	uint8_t data[] = {
+		0, 0, 13, 2, 0, 0, 0x0e, 0x10,       // covered type, algorithm, labels, TTL
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0,        // expiration, inception, key tag
+		7, 'e', 'x', 'a', 'm', 'p', 'l', 'e', 0, // signer
+		1, 2, 3, 4                           // signature
+	};
+	knot_wire_write_u16(data, covered);
+	knot_wire_write_u32(data + 8, (uint32_t)expire);
+
+	return add_rr(zone, owner, KNOT_RRTYPE_RRSIG, data, sizeof(data));
+}
+
+static void test_index(void)
+{
+	const uint8_t addr[] = { 192, 0, 2, 1 };
+	const uint8_t nsec3[] = { 1, 0, 0, 10, 0, 1, 0, 0 }; // hash, flags, iterations, salt, next, bitmap
+	knot_time_t now = knot_time();
+	knot_time_t exp_a = now + 2 * HOUR, exp_b = now + 10 * HOUR;
+
+	zone_contents_t *zone = zone_contents_new(APEX, true);
+	assert(zone);
+	zone_node_t *node_a = add_rr(zone, NODE_A, KNOT_RRTYPE_A, addr, sizeof(addr));
+	add_rrsig(zone, NODE_A, KNOT_RRTYPE_A, exp_a);
+	add_rr(zone, NODE_B, KNOT_RRTYPE_A, addr, sizeof(addr));
+	add_rrsig(zone, NODE_B, KNOT_RRTYPE_A, exp_b);
+	zone_node_t *node_c = add_rr(zone, NODE_C, KNOT_RRTYPE_A, addr, sizeof(addr));
+	add_rr(zone, NODE_N3, KNOT_RRTYPE_NSEC3, nsec3, sizeof(nsec3));
+	add_rrsig(zone, NODE_N3, KNOT_RRTYPE_NSEC3, exp_a);
+	ok(zone_tree_count(zone->nsec3_nodes) == 1, "index: NSEC3 node in its tree");
+
+	expiry_index_t *idx = NULL;
+	ok(expiry_index_from_trees(NULL, zone->nodes, zone->nsec3_nodes) == KNOT_EINVAL,
+	   "index: no output rejected");
+	int ret = expiry_index_from_trees(&idx, zone->nodes, zone->nsec3_nodes);
+	is_int(KNOT_EOK, ret, "index: create from trees");
+	if (ret != KNOT_EOK) {
+		zone_contents_deep_free(zone);
+		return;
+	}
+	ok(idx->keys_id == 0, "index: unknown signing keys");
+
+	/* Apply. */
+	is_string("c.example. ", apply(idx, now),
+	          "apply: unsigned node expires immediately, empty apex skipped");
+	is_string("c.example. a.example. 3n3.example. ", apply(idx, exp_a),
+	          "apply: buckets in order, NSEC3 flag after regular nodes");
+	is_string("c.example. a.example. 3n3.example. ", apply(idx, bucket_start(exp_a)),
+	          "apply: bucket starting at the limit included");
+	is_string("c.example. a.example. 3n3.example. b.example. ", apply(idx, exp_b),
+	          "apply: all nodes");
+	ok(expiry_index_apply(idx, now, NULL, NULL) == KNOT_EINVAL, "apply: no callback rejected");
+
+	/* Next expiry. */
+	ok(expiry_index_next(idx, 0) == bucket_start(exp_a), "next: first signed bucket");
+	ok(expiry_index_next(idx, now) == bucket_start(exp_a), "next: bucket after now");
+	ok(expiry_index_next(idx, bucket_start(exp_a)) == bucket_start(exp_b),
+	   "next: bucket starting after the limit");
+	ok(expiry_index_next(idx, exp_b) == 0, "next: nothing later");
+	ok(expiry_index_next(NULL, now) == 0, "next: no index");
+
+	/* Drop. */
+	ret = expiry_index_drop(idx, exp_a);
+	is_int(KNOT_EOK, ret, "drop: until inside a bucket");
+	is_string("a.example. 3n3.example. ", apply(idx, exp_a),
+	          "drop: bucket not ending until the limit kept");
+	ret = expiry_index_drop(idx, bucket_start(exp_a) + EXPIRY_INDEX_BUCKET);
+	is_int(KNOT_EOK, ret, "drop: until the end of a bucket");
+	is_string("b.example. ", apply(idx, exp_b), "drop: bucket ending at the limit dropped");
+	ok(expiry_index_drop(NULL, now) == KNOT_EINVAL, "drop: no index rejected");
+
+	/* Update with changed nodes. */
+	zone_tree_t *changed = zone_tree_create(true);
+	assert(changed);
+	(void)zone_tree_insert(changed, &node_a);
+	(void)zone_tree_insert(changed, &node_c);
+	node_c->flags |= NODE_FLAGS_DELETED;
+	ret = expiry_index_update(idx, changed, NULL);
+	is_int(KNOT_EOK, ret, "update: changed nodes");
+	is_string("a.example. b.example. ", apply(idx, exp_b), "update: deleted node skipped");
+	node_c->flags &= ~NODE_FLAGS_DELETED;
+	ok(expiry_index_update(NULL, changed, NULL) == KNOT_EINVAL, "update: no index rejected");
+	zone_tree_free(&changed);
+
+	/* Rebuild. */
+	idx->keys_id = 42;
+	ret = expiry_index_rebuild(idx, zone->nodes, zone->nsec3_nodes);
+	is_int(KNOT_EOK, ret, "rebuild: all nodes");
+	is_string("c.example. a.example. 3n3.example. b.example. ", apply(idx, exp_b),
+	          "rebuild: nodes indexed again");
+	ok(idx->keys_id == 42, "rebuild: signing keys kept");
+
+	expiry_index_free(idx);
+	zone_contents_deep_free(zone);
+
+	/* Full adjusting keeps the index. */
+	zone = zone_contents_new(APEX, true);
+	assert(zone);
+	add_rr(zone, NODE_A, KNOT_RRTYPE_A, addr, sizeof(addr));
+	add_rrsig(zone, NODE_A, KNOT_RRTYPE_A, exp_a);
+	zone->expiry_index = expiry_index_new();
+	idx = zone->expiry_index;
+	assert(idx);
+	idx->keys_id = 42;
+	ret = zone_adjust_full(zone, 1);
+	is_int(KNOT_EOK, ret, "adjust: full");
+	ok(zone->expiry_index == idx && idx->keys_id == 42, "adjust: index and signing keys kept");
+	is_string("a.example. ", apply(zone->expiry_index, exp_a), "adjust: nodes indexed");
+
+	zone_contents_deep_free(zone);
+}
+
+static void interrupt_handle(int s)
+{
+}
+
+static knot_rdata_t *node_rrsig(zone_contents_t *zone, const knot_dname_t *owner)
+{
+	const zone_node_t *node = zone_contents_find_node(zone, owner);
+	const knot_rdataset_t *rrsigs = node_rdataset(node, KNOT_RRTYPE_RRSIG);
+	return (rrsigs != NULL) ? rrsigs->rdata : NULL;
+}
+
+static int update_rr(zone_update_t *update, const knot_dname_t *owner, uint16_t type,
+                     const uint8_t *data, uint16_t len)
+{
+	knot_rrset_t rr;
+	knot_rrset_init(&rr, (knot_dname_t *)owner, type, KNOT_CLASS_IN, 3600);
+	int ret = knot_rrset_add_rdata(&rr, data, len, NULL);
+	if (ret == KNOT_EOK) {
+		ret = zone_update_add(update, &rr);
+	}
+	knot_rdataset_clear(&rr.rrs, NULL);
+	return ret;
+}
+
+static void test_signing(zone_t *zone)
+{
+	const uint8_t soa[] = {
+		2, 'n', 's', 0, 1, 'm', 0,
+		0, 0, 0, 1, 0, 0, 0x03, 0x84, 0, 0, 0x01, 0x2c, 0, 0, 0x12, 0xc0, 0, 0, 0x03, 0x84
+	};
+	const uint8_t addr[] = { 192, 0, 2, 1 };
+	zone_sign_reschedule_t resch = { 0 };
+
+	/* Completely signed new contents. */
+	zone_update_t up;
+	int ret = zone_update_init(&up, zone, UPDATE_FULL);
+	if (ret == KNOT_EOK) {
+		ret = update_rr(&up, APEX, KNOT_RRTYPE_SOA, soa, sizeof(soa));
+	}
+	if (ret == KNOT_EOK) {
+		ret = update_rr(&up, NODE_A, KNOT_RRTYPE_A, addr, sizeof(addr));
+	}
+	if (ret == KNOT_EOK) {
+		ret = update_rr(&up, NODE_B, KNOT_RRTYPE_A, addr, sizeof(addr));
+	}
+	if (ret == KNOT_EOK) {
+		ret = knot_dnssec_zone_sign(&up, conf(), 0, KEY_ROLL_ALLOW_ALL, 0, &resch);
+	}
+	if (ret == KNOT_EOK) {
+		ret = zone_update_commit(conf(), &up);
+	}
+	is_int(KNOT_EOK, ret, "signing: full update signed and committed");
+	if (ret != KNOT_EOK) {
+		zone_update_clear(&up);
+		return;
+	}
+
+	expiry_index_t *idx = zone->contents->expiry_index;
+	ok(idx != NULL && idx->keys_id != 0, "signing: complete signing indexed with its keys");
+	if (idx == NULL) {
+		return;
+	}
+	uint64_t keys_id = idx->keys_id;
+
+	/* Let a's signature expire soon, then b's one without telling the index. */
+	knot_time_t now = knot_time();
+	knot_rdata_t *rrsig_a = node_rrsig(zone->contents, NODE_A);
+	knot_rdata_t *rrsig_b = node_rrsig(zone->contents, NODE_B);
+	ok(rrsig_a != NULL && rrsig_b != NULL, "signing: nodes signed");
+	if (rrsig_a == NULL || rrsig_b == NULL) {
+		return;
+	}
+	knot_wire_write_u32(rrsig_a->data + 8, (uint32_t)(now + HOUR));
+	ret = expiry_index_rebuild(idx, zone->contents->nodes, zone->contents->nsec3_nodes);
+	ok(ret == KNOT_EOK && strstr(apply(idx, now + HOUR), "a.example.") != NULL &&
+	   strstr(apply(idx, now + HOUR), "b.example.") == NULL,
+	   "signing: node indexed inside the refresh window");
+	knot_wire_write_u32(rrsig_b->data + 8, (uint32_t)(now + HOUR));
+
+	/* Incremental signing after a change not touching the NSEC records of a and b. */
+	ret = zone_update_init(&up, zone, UPDATE_INCREMENTAL);
+	if (ret == KNOT_EOK) {
+		ret = update_rr(&up, NODE_0, KNOT_RRTYPE_A, addr, sizeof(addr));
+	}
+	if (ret == KNOT_EOK) {
+		ret = knot_dnssec_zone_sign(&up, conf(), 0, KEY_ROLL_ALLOW_ALL, 0, &resch);
+	}
+	if (ret == KNOT_EOK) {
+		ret = zone_update_commit(conf(), &up);
+	}
+	is_int(KNOT_EOK, ret, "signing: incremental update signed and committed");
+	if (ret != KNOT_EOK) {
+		zone_update_clear(&up);
+		return;
+	}
+
+	idx = zone->contents->expiry_index;
+	ok(idx != NULL && idx->keys_id == keys_id, "signing: index handed over");
+	rrsig_a = node_rrsig(zone->contents, NODE_A);
+	rrsig_b = node_rrsig(zone->contents, NODE_B);
+	ok(rrsig_a != NULL &&
+	   knot_time_from_u32(knot_rrsig_sig_expiration(rrsig_a), now) > now + 24 * HOUR,
+	   "signing: node inside the refresh window re-signed");
+	ok(rrsig_b != NULL && knot_rrsig_sig_expiration(rrsig_b) == (uint32_t)(now + HOUR),
+	   "signing: node indexed outside the refresh window not visited");
+	ok(node_rrsig(zone->contents, NODE_0) != NULL, "signing: changed node signed");
+	ok(expiry_index_next(idx, 0) > now + 24 * HOUR, "signing: re-signed node indexed");
+}
+
+int main(int argc, char *argv[])
+{
+	plan_lazy();
+
+	test_index();
+
+	char *temp_dir = test_mkdtemp();
+	ok(temp_dir != NULL, "make temporary directory");
+
+	char conf_str[512];
+	snprintf(conf_str, sizeof(conf_str),
+	         "zone:\n"
+	         " - domain: example.\n"
+	         "   dnssec-signing: on\n"
+	         "   rrsig-expiry-index: on\n"
+	         "database:\n"
+	         "   storage: %s\n",
+	         temp_dir);
+
+	int ret = test_conf(conf_str, NULL);
+	is_int(KNOT_EOK, ret, "load configuration");
+
+	/* Stopping the shared compute pool interrupts its threads. */
+	struct sigaction sa;
+	sa.sa_handler = interrupt_handle;
+	sigemptyset(&sa.sa_mask);
+	sa.sa_flags = 0;
+	sigaction(SIGALRM, &sa, NULL);
+
+	server_t server;
+	ret = server_init(&server, 1);
+	is_int(KNOT_EOK, ret, "server init");
+
+	zone_t *zone = zone_new(APEX);
+	assert(zone);
+	zone->server = &server;
+
+	test_signing(zone);
+
+	zone_free(&zone);
+	server_deinit(&server);
+	conf_free(conf());
+	test_rm_rf(temp_dir);
+	free(temp_dir);
+
+	return 0;
+}
@@ -139,6 +139,25 @@ int main(int argc, char *argv[])
 	ret = fdset_poll(&fdset, &it, 0, 100);
 	ok(ret == 0, "fdset_poll return 3");
 
+	int fds3[2];
+	ret = pipe(fds3);
+	ok(ret >= 0, "create pipe 3");
+	ret = fdset_add(&fdset, fds3[1], FDSET_POLLIN, NULL);
+	ok(ret == 0, "add pipe 3 write end to fdset");
+	ret = fdset_poll(&fdset, &it, 0, 0);
+	ok(ret == 0, "fdset_poll nothing to read");
+	ret = fdset_set_events(&fdset, 0, FDSET_POLLOUT);
+	ok(ret == KNOT_EOK, "fdset_set_events pollout");
+	ret = fdset_poll(&fdset, &it, 0, 0);
+	ok(ret == 1 && fdset_it_is_pollout(&it) && !fdset_it_is_pollin(&it),
+	   "fdset can write");
+	ret = fdset_set_events(&fdset, 0, FDSET_POLLIN);
+	ok(ret == KNOT_EOK, "fdset_set_events pollin");
+	ret = fdset_poll(&fdset, &it, 0, 0);
+	ok(ret == 0, "fdset_poll nothing to read again");
+	ret = fdset_remove(&fdset, 0);
+	ok(ret == KNOT_EOK, "fdset remove pipe 3");
+	close(fds3[0]);
 
 	close(fds2[1]);
 	if (fd2_dup >= 0) {
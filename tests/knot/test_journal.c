@@ -24,11 +24,15 @@
 #include <tap/basic.h>
 #include <tap/files.h>
 
+#include "knot/journal/journal_batch.h"
+#include "knot/journal/journal_compress.h"
 #include "knot/journal/journal_read.h"
+#include "knot/journal/journal_shard.h"
 #include "knot/journal/journal_write.h"
 
 #include "libknot/attribute.h"
 #include "libknot/libknot.h"
+#include "contrib/string.h"
 #include "knot/zone/zone.h"
 #include "knot/zone/zone-diff.h"
 #include "test_conf.h"
@@ -301,6 +305,40 @@ static int load_j_list(zone_journal_t *zj, bool zij, uint32_t serial,
 	return ret;
 }
 
+/*! \brief Compare RRSets read as views with the ones read into heap memory. */
+static void test_read_view(uint32_t serial)
+{
+	knot_rrset_t *copies[1024] = { NULL };
+	knot_rrset_t rr = { 0 };
+	size_t count = 0;
+
+	journal_read_t *read = NULL;
+	int ret = journal_read_begin(jj, false, serial, &read);
+	while (ret == KNOT_EOK && count < 1024 && journal_read_rrset(read, &rr, true)) {
+		copies[count++] = knot_rrset_copy(&rr, NULL);
+		journal_read_clear_rrset(&rr);
+	}
+	ret = journal_read_get_error(read, ret);
+	journal_read_end(read);
+	is_int(KNOT_EOK, ret, "journal: read RRSets (%s)", knot_strerror(ret));
+
+	bool equal = (count > 0);
+	size_t pos = 0;
+	ret = journal_read_begin(jj, false, serial, &read);
+	while (ret == KNOT_EOK && journal_read_rrset_view(read, &rr, true)) {
+		equal = equal && pos < count && knot_rrset_equal(&rr, copies[pos], true);
+		pos++;
+	}
+	ret = journal_read_get_error(read, ret);
+	journal_read_end(read);
+	is_int(KNOT_EOK, ret, "journal: read RRSet views (%s)", knot_strerror(ret));
+	ok(equal && pos == count, "journal: RRSet views equal to read RRSets");
+
+	for (size_t i = 0; i < count; i++) {
+		knot_rrset_free(copies[i], NULL);
+	}
+}
+
 /*! \brief Test behavior with real changesets. */
 static void test_store_load(const knot_dname_t *apex)
 {
@@ -328,6 +366,7 @@ static void test_store_load(const knot_dname_t *apex)
 	changesets_free(&l);
 
 	journal_read_end(read);
+	test_read_view(changeset_from(m_ch));
 	ret = journal_set_flushed(jj);
 	is_int(KNOT_EOK, ret, "journal: first simple flush (%s)", knot_strerror(ret));
 
@@ -850,6 +889,174 @@ static void test_stress(const knot_dname_t *apex)
 	test_stress_base(apex, 4000, 10 * 1024 * 1024);
 }
 
+/*! \brief Test group commit of changesets of several zones. */
+static void test_group_commit(void)
+{
+	const knot_dname_t *apexes[] = {
+		(const uint8_t *)"\1a\5group",
+		(const uint8_t *)"\1b\5group",
+		(const uint8_t *)"\1c\5group",
+	};
+	const size_t count = sizeof(apexes) / sizeof(*apexes);
+	changeset_t *chs[count];
+	journal_batch_req_t reqs[count];
+
+	set_conf(1000, 512 * 1024, NULL);
+
+	journal_batch_t *batch = journal_batch_new(&jdb, 50);
+	ok(batch != NULL && journal_batch_enabled(batch), "journal: group commit writer");
+	if (batch == NULL) {
+		unset_conf();
+		return;
+	}
+
+	for (size_t i = 0; i < count; i++) {
+		chs[i] = changeset_new(apexes[i]);
+		init_random_changeset(chs[i], 0, 1, 64, apexes[i], false);
+		zone_journal_t j = { &jdb, apexes[i], jj.conf };
+		journal_batch_submit(batch, &reqs[i], j, chs[i], NULL, NULL);
+	}
+
+	bool all_ok = true, all_eq = true;
+	for (size_t i = 0; i < count; i++) {
+		int ret = journal_batch_wait(batch, &reqs[i]);
+		all_ok = all_ok && ret == KNOT_EOK;
+
+		list_t l;
+		journal_read_t *read = NULL;
+		zone_journal_t j = { &jdb, apexes[i], jj.conf };
+		ret = load_j_list(&j, false, 0, &read, &l);
+		all_eq = all_eq && ret == KNOT_EOK && list_size(&l) == 1 &&
+		         changesets_eq(chs[i], HEAD(l));
+		changesets_free(&l);
+		journal_read_end(read);
+		changeset_free(chs[i]);
+	}
+	ok(all_ok, "journal: changesets stored by group commit");
+	ok(all_eq, "journal: changesets equal after group commit");
+
+	// Refused insertion doesn't affect the others.
+	changeset_t *bad = changeset_new(apexes[0]);
+	init_random_changeset(bad, 5, 5, 1, apexes[0], false);
+	zone_journal_t j = { &jdb, apexes[0], jj.conf };
+	int ret = journal_batch_insert(batch, j, bad, NULL, NULL);
+	is_int(KNOT_ESEMCHECK, ret, "journal: group commit refuses bad changeset");
+	changeset_free(bad);
+
+	journal_batch_free(batch);
+	unset_conf();
+}
+
+static bool shards_placed(knot_lmdb_db_t *dbs, const knot_dname_t **apexes,
+                          size_t count, unsigned shards)
+{
+	for (size_t i = 0; i < count; i++) {
+		for (unsigned s = 0; s < JOURNAL_SHARDS_MAX; s++) {
+			zone_journal_t j = { &dbs[s], apexes[i] };
+			if (journal_is_existing(j) != (s == journal_shard(apexes[i], shards))) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+/*! \brief Test moving of zone journals between shards. */
+static void test_shards(void)
+{
+	const knot_dname_t *apexes[] = {
+		(const uint8_t *)"\1a\5shard",
+		(const uint8_t *)"\1b\5shard",
+		(const uint8_t *)"\1c\5shard",
+		(const uint8_t *)"\1d\5shard",
+		(const uint8_t *)"\1e\5shard",
+	};
+	const size_t count = sizeof(apexes) / sizeof(*apexes);
+
+	set_conf(1000, 512 * 1024, NULL);
+
+	char *base = sprintf_alloc("%s/shards", test_dir_name);
+	knot_lmdb_db_t dbs[JOURNAL_SHARDS_MAX];
+	for (unsigned i = 0; i < JOURNAL_SHARDS_MAX; i++) {
+		char *path = journal_shard_path(base, i);
+		knot_lmdb_init(&dbs[i], path, 2 * 1024 * 1024, env_flag, NULL);
+		free(path);
+	}
+
+	bool stored = true;
+	for (size_t i = 0; i < count; i++) {
+		changeset_t *ch = changeset_new(apexes[i]);
+		init_random_changeset(ch, 0, 1, 16, apexes[i], false);
+		zone_journal_t j = { &dbs[0], apexes[i], jj.conf };
+		stored = stored && knot_lmdb_open(j.db) == KNOT_EOK &&
+		         journal_insert(j, ch, NULL, NULL) == KNOT_EOK;
+		changeset_free(ch);
+	}
+	ok(stored, "journal: changesets stored without sharding");
+
+	size_t moved = 0, expected = 0;
+	for (size_t i = 0; i < count; i++) {
+		expected += (journal_shard(apexes[i], 3) != 0);
+	}
+	int ret = journal_shards_migrate(dbs, 3, &moved);
+	is_int(KNOT_EOK, ret, "journal: move journals to shards (%s)", knot_strerror(ret));
+	ok(moved == expected && shards_placed(dbs, apexes, count, 3),
+	   "journal: journals placed in shards (%zu moved)", moved);
+
+	ret = journal_shards_migrate(dbs, 1, &moved);
+	is_int(KNOT_EOK, ret, "journal: move journals back (%s)", knot_strerror(ret));
+	ok(moved == expected && shards_placed(dbs, apexes, count, 1),
+	   "journal: journals placed without sharding");
+
+	zone_journal_t j = { &dbs[0], apexes[count - 1], jj.conf };
+	ret = journal_sem_check(j);
+	is_int(KNOT_EOK, ret, "journal: check after moving (%s)", knot_strerror(ret));
+
+	for (unsigned i = 0; i < JOURNAL_SHARDS_MAX; i++) {
+		knot_lmdb_deinit(&dbs[i]);
+	}
+	free(base);
+	unset_conf();
+}
+
+#ifdef ENABLE_ZSTD
+/*! \brief Test storing and reading of compressed changesets. */
+static void test_compression(const knot_dname_t *apex)
+{
+	_unused_ int ret = test_conf("template:\n"
+	                             " - id: default\n"
+	                             "   journal-compression: on\n", NULL);
+	assert(ret == KNOT_EOK);
+	jj.conf = conf();
+	jj.zone = apex;
+
+	changeset_t *m_ch = changeset_new(apex);
+	init_random_changeset(m_ch, 0, 1, 1000, apex, false);
+	ret = journal_insert(jj, m_ch, NULL, NULL);
+	is_int(KNOT_EOK, ret, "journal: store compressed changeset (%s)", knot_strerror(ret));
+
+	journal_chunk_stats_t stats;
+	ret = journal_chunk_stats(jj, &stats);
+	is_int(KNOT_EOK, ret, "journal: chunk statistics (%s)", knot_strerror(ret));
+	ok(stats.compressed > 0 && stats.stored_size < stats.plain_size,
+	   "journal: chunks compressed (%zu of %zu)", stats.compressed, stats.chunks);
+
+	list_t l;
+	journal_read_t *read = NULL;
+	ret = load_j_list(&jj, false, changeset_from(m_ch), &read, &l);
+	is_int(KNOT_EOK, ret, "journal: read compressed changeset (%s)", knot_strerror(ret));
+	ok(1 == list_size(&l) && changesets_eq(m_ch, HEAD(l)),
+	   "journal: compressed changeset equal after read");
+	changesets_free(&l);
+	journal_read_end(read);
+
+	test_read_view(changeset_from(m_ch));
+
+	changeset_free(m_ch);
+	unset_conf();
+}
+#endif
+
 int main(int argc, char *argv[])
 {
 	plan_lazy();
@@ -871,6 +1078,14 @@ int main(int argc, char *argv[])
 
 	test_stress(apex);
 
+	test_group_commit();
+
+	test_shards();
+
+#ifdef ENABLE_ZSTD
+	test_compression(apex2);
+#endif
+
 	knot_lmdb_deinit(&jdb);
 
 	test_rm_rf(test_dir_name);
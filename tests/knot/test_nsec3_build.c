@@ -0,0 +1,151 @@
+/*  Copyright (C) 2024 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <tap/basic.h>
+
+#include "knot/dnssec/nsec3-chain.h"
+#include "knot/zone/adjust.h"
+#include "knot/zone/contents.h"
+#include "libknot/libknot.h"
+
+#define APEX	(const knot_dname_t *)"\x07""example"
+#define NAMES	40000	// Enough for the build to be split into more parts.
+#define THREADS	4
+#define TTL	3600
+
+static int add_rr(zone_contents_t *cont, const knot_dname_t *owner, uint16_t type,
+                  const uint8_t *rdata, uint16_t rdlen)
+{
+	knot_rrset_t rr;
+	knot_rrset_init(&rr, (knot_dname_t *)owner, type, KNOT_CLASS_IN, TTL);
+	zone_node_t *node = NULL;
+	int ret = knot_rrset_add_rdata(&rr, rdata, rdlen, NULL);
+	if (ret == KNOT_EOK) {
+		ret = zone_contents_add_rr(cont, &rr, &node);
+	}
+	knot_rdataset_clear(&rr.rrs, NULL);
+
+	return ret;
+}
+
+static zone_contents_t *create_contents(void)
+{
+	zone_contents_t *cont = zone_contents_new(APEX, true);
+	if (cont == NULL) {
+		return NULL;
+	}
+
+	// Root MNAME and RNAME, zero serial and timers.
+	const uint8_t soa[22] = { 0 };
+	int ret = add_rr(cont, APEX, KNOT_RRTYPE_SOA, soa, sizeof(soa));
+
+	const uint8_t addr[] = { 192, 0, 2, 1 };
+	for (int i = 0; i < NAMES && ret == KNOT_EOK; i++) {
+		char name_str[32];
+		(void)snprintf(name_str, sizeof(name_str), "n%d.example.", i);
+		knot_dname_storage_t name;
+		(void)knot_dname_from_str(name, name_str, sizeof(name));
+		ret = add_rr(cont, name, KNOT_RRTYPE_A, addr, sizeof(addr));
+	}
+
+	// Node flags decide which nodes get NSEC3 records.
+	if (ret == KNOT_EOK) {
+		ret = zone_adjust_full(cont, 1);
+	}
+	if (ret != KNOT_EOK) {
+		zone_contents_deep_free(cont);
+		return NULL;
+	}
+
+	return cont;
+}
+
+static bool trees_equal(zone_tree_t *a, zone_tree_t *b)
+{
+	if (zone_tree_count(a) != zone_tree_count(b)) {
+		return false;
+	}
+
+	zone_tree_it_t it_a = { 0 }, it_b = { 0 };
+	bool equal = zone_tree_it_begin(a, &it_a) == KNOT_EOK &&
+	             zone_tree_it_begin(b, &it_b) == KNOT_EOK;
+	while (equal && !zone_tree_it_finished(&it_a)) {
+		zone_node_t *node_a = zone_tree_it_val(&it_a);
+		zone_node_t *node_b = zone_tree_it_val(&it_b);
+		equal = knot_dname_is_equal(node_a->owner, node_b->owner) &&
+		        knot_rdataset_eq(node_rdataset(node_a, KNOT_RRTYPE_NSEC3),
+		                         node_rdataset(node_b, KNOT_RRTYPE_NSEC3));
+		zone_tree_it_next(&it_a);
+		zone_tree_it_next(&it_b);
+	}
+	zone_tree_it_free(&it_a);
+	zone_tree_it_free(&it_b);
+
+	return equal;
+}
+
+int main(int argc, char *argv[])
+{
+	plan_lazy();
+
+	const dnssec_nsec3_params_t params = {
+		.algorithm = DNSSEC_NSEC3_ALGORITHM_SHA1,
+		.salt = { .size = 4, .data = (uint8_t *)"salt" }
+	};
+
+	zone_contents_t *cont = create_contents();
+	ok(cont != NULL, "create zone contents");
+	if (cont == NULL) {
+		return 0;
+	}
+
+	knot_nsec3_build_t build = { 0 };
+	ok(knot_nsec3_build_step(&build, cont, 0, 1) == KNOT_EINVAL, "step: no threads");
+
+	// Whole chain at once.
+	knot_nsec3_build_t whole = { 0 };
+	int ret = knot_nsec3_build_init(&whole, cont, &params, TTL);
+	is_int(KNOT_EOK, ret, "whole: init");
+	ok(whole.parts > 1, "whole: more parts");
+	ret = knot_nsec3_build_step(&whole, cont, THREADS, whole.parts);
+	is_int(KNOT_EOK, ret, "whole: step");
+	ok(knot_nsec3_build_finished(&whole), "whole: finished");
+	is_int(NAMES + 1, zone_tree_count(whole.nsec3_nodes), "whole: all names covered");
+
+	// The same chain in single-part steps.
+	ret = knot_nsec3_build_init(&build, cont, &params, TTL);
+	is_int(KNOT_EOK, ret, "steps: init");
+	unsigned steps = 0;
+	while (ret == KNOT_EOK && !knot_nsec3_build_finished(&build)) {
+		ret = knot_nsec3_build_step(&build, cont, 1, 1);
+		steps++;
+	}
+	is_int(KNOT_EOK, ret, "steps: all steps");
+	is_int(whole.parts, steps, "steps: one part per step");
+	ret = knot_nsec3_build_step(&build, cont, 1, 1);
+	ok(ret == KNOT_EOK && build.parts_done == build.parts, "steps: finished build kept");
+	ok(trees_equal(whole.nsec3_nodes, build.nsec3_nodes), "steps: same chain as whole");
+
+	knot_nsec3_build_deinit(&build);
+	ok(build.nsec3_nodes == NULL && build.parts == 0, "deinit");
+	knot_nsec3_build_deinit(&build);
+	knot_nsec3_build_deinit(&whole);
+
+	zone_contents_deep_free(cont);
+
+	return 0;
+}
@@ -0,0 +1,85 @@
+/*  Copyright (C) 2024 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <tap/basic.h>
+
+#include "knot/dnssec/zone-nsec.h"
+#include "knot/zone/nsec3-cache.h"
+#include "libknot/libknot.h"
+
+#define NAMES	100
+
+static bool owner_match(nsec3_cache_t *cache, const knot_dname_t *name,
+                        const knot_dname_t *apex, const dnssec_nsec3_params_t *params)
+{
+	knot_dname_storage_t expected, owner;
+	int ret = knot_create_nsec3_owner(expected, sizeof(expected), name, apex, params);
+	if (ret != KNOT_EOK) {
+		return false;
+	}
+
+	ret = nsec3_cache_owner(cache, owner, sizeof(owner), name, apex, params);
+	return ret == KNOT_EOK && knot_dname_is_equal(owner, expected);
+}
+
+static void test_owners(size_t size, const knot_dname_t *apex,
+                        const dnssec_nsec3_params_t *params)
+{
+	nsec3_cache_t *cache = nsec3_cache_new(size);
+	ok(cache != NULL, "cache of size %zu: create", size);
+
+	// Each name is looked up twice, the second time from the cache if it fits.
+	bool match = true;
+	for (int round = 0; round < 2; round++) {
+		for (int i = 0; i < NAMES && match; i++) {
+			char name_str[32];
+			(void)snprintf(name_str, sizeof(name_str), "nx%d.example.", i);
+			knot_dname_storage_t name;
+			(void)knot_dname_from_str(name, name_str, sizeof(name));
+			match = owner_match(cache, name, apex, params) &&
+			        owner_match(cache, name, apex, params);
+		}
+	}
+	ok(match, "cache of size %zu: owners match", size);
+
+	nsec3_cache_free(cache);
+}
+
+int main(int argc, char *argv[])
+{
+	plan_lazy();
+
+	const knot_dname_t *apex = (const knot_dname_t *)"\x07""example";
+	const dnssec_nsec3_params_t params = {
+		.algorithm = DNSSEC_NSEC3_ALGORITHM_SHA1,
+		.iterations = 5,
+		.salt = { .size = 4, .data = (uint8_t *)"salt" }
+	};
+
+	ok(nsec3_cache_new(0) == NULL, "no cache of zero size");
+	ok(owner_match(NULL, apex, apex, &params), "no cache: owner matches");
+
+	test_owners(1, apex, &params);
+	test_owners(16, apex, &params);
+	test_owners(4 * NAMES, apex, &params);
+
+	knot_dname_storage_t owner;
+	ok(nsec3_cache_owner(NULL, owner, 10, apex, apex, &params) != KNOT_EOK,
+	   "small output");
+
+	return 0;
+}
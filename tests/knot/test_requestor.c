@@ -24,6 +24,7 @@
 
 #include "libknot/descriptor.h"
 #include "libknot/errcode.h"
+#include "knot/query/async-requestor.h"
 #include "knot/query/layer.h"
 #include "knot/query/requestor.h"
 #include "contrib/mempattern.h"
@@ -66,14 +67,16 @@ static void *responder_thread(void *arg)
 		if (client < 0) {
 			break;
 		}
-		int len = net_dns_tcp_recv(client, buf, sizeof(buf), -1);
-		if (len < KNOT_WIRE_HEADER_SIZE) {
-			close(client);
-			break;
+		/* Answer the pipelined queries until the client closes. */
+		int len;
+		while ((len = net_dns_tcp_recv(client, buf, sizeof(buf), -1)) >= KNOT_WIRE_HEADER_SIZE) {
+			knot_wire_set_qr(buf);
+			net_dns_tcp_send(client, buf, len, -1, NULL);
 		}
-		knot_wire_set_qr(buf);
-		net_dns_tcp_send(client, buf, len, -1, NULL);
 		close(client);
+		if (len > 0) {
+			break;
+		}
 	}
 
 	return NULL;
@@ -120,6 +123,64 @@ static void test_connected(knot_requestor_t *requestor,
 	knot_request_free(req, requestor->mm);
 }
 
+#define ASYNC_JOBS 8
+
+static pthread_mutex_t async_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t async_cond = PTHREAD_COND_INITIALIZER;
+static int async_ok, async_done;
+
+static void async_finished(knot_areq_job_t *job, int ret)
+{
+	knot_request_free(job->request, NULL);
+	knot_requestor_clear(&job->requestor);
+
+	pthread_mutex_lock(&async_lock);
+	async_ok += (ret == KNOT_EOK);
+	async_done++;
+	pthread_cond_signal(&async_cond);
+	pthread_mutex_unlock(&async_lock);
+}
+
+static void test_async(const struct sockaddr_storage *dst,
+                       const struct sockaddr_storage *src,
+                       bool pipeline, bool same_id)
+{
+	const char *mode = !pipeline ? "" : same_id ? "pipelined, same ID " : "pipelined ";
+
+	knot_areq_t *areq = knot_areq_new();
+	ok(areq != NULL, "async requestor: %screate", mode);
+	if (areq == NULL) {
+		return;
+	}
+
+	/* Submit concurrent requests. */
+	knot_areq_job_t jobs[ASYNC_JOBS] = { 0 };
+	int submitted = 0;
+	for (int i = 0; i < ASYNC_JOBS; i++) {
+		knot_areq_job_t *job = &jobs[i];
+		knot_requestor_init(&job->requestor, &dummy_module, NULL, NULL);
+		job->request = make_query(&job->requestor, dst, src);
+		job->request->flags &= ~KNOT_REQUEST_TFO;
+		knot_wire_set_id(job->request->query->wire, same_id ? 0 : i);
+		job->timeout_ms = TIMEOUT;
+		job->pipeline = pipeline;
+		job->done = async_finished;
+		submitted += (knot_areq_submit(areq, job) == KNOT_EOK);
+	}
+	is_int(ASYNC_JOBS, submitted, "async requestor: %ssubmit", mode);
+
+	/* Wait for the responses. */
+	pthread_mutex_lock(&async_lock);
+	while (async_done < submitted) {
+		pthread_cond_wait(&async_cond, &async_lock);
+	}
+	pthread_mutex_unlock(&async_lock);
+	is_int(ASYNC_JOBS, async_ok, "async requestor: %sconnected/exec", mode);
+
+	knot_areq_free(areq);
+	async_ok = async_done = 0;
+}
+
 int main(int argc, char *argv[])
 {
 #if defined(__linux__)
@@ -174,6 +235,11 @@ int main(int argc, char *argv[])
 	/* Test requestor in connected environment. */
 	test_connected(&requestor, &server, &client);
 
+	/* Test asynchronous requestor. */
+	test_async(&server, &client, false, false);
+	test_async(&server, &client, true, false);
+	test_async(&server, &client, true, true);
+
 	/* Terminate responder. */
 	int conn = net_connected_socket(SOCK_STREAM, &server, NULL, false);
 	assert(conn > 0);
@@ -0,0 +1,119 @@
+/*  Copyright (C) 2024 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <tap/basic.h>
+#include <assert.h>
+
+#include "knot/modules/onlinesign/sig_cache.c"
+#include "libknot/descriptor.h"
+
+#define OWNER (const knot_dname_t *)"\x03""www""\x07""example""\x03""com"
+#define NOW 1000
+#define EXPIRE 2000
+
+static knot_rrset_t *make_a(uint8_t last)
+{
+	knot_rrset_t *rr = knot_rrset_new(OWNER, KNOT_RRTYPE_A, KNOT_CLASS_IN, 3600, NULL);
+	uint8_t addr[] = { 192, 0, 2, last };
+	if (rr != NULL) {
+		(void)knot_rrset_add_rdata(rr, addr, sizeof(addr), NULL);
+	}
+	return rr;
+}
+
+static knot_rrset_t *make_rrsig(uint8_t fill)
+{
+	knot_rrset_t *rr = knot_rrset_new(OWNER, KNOT_RRTYPE_RRSIG, KNOT_CLASS_IN, 3600, NULL);
+	uint8_t data[32];
+	memset(data, fill, sizeof(data));
+	if (rr != NULL) {
+		(void)knot_rrset_add_rdata(rr, data, sizeof(data), NULL);
+	}
+	return rr;
+}
+
+static bool cache_get(sig_cache_t *cache, const knot_rrset_t *cover, knot_time_t now,
+                      const knot_rrset_t *expected)
+{
+	knot_rrset_t rrsig;
+	knot_rrset_init(&rrsig, cover->owner, KNOT_RRTYPE_RRSIG, KNOT_CLASS_IN, cover->ttl);
+	bool found = sig_cache_get(cache, OWNER, cover, now, &rrsig, NULL);
+	if (found && expected != NULL) {
+		found = knot_rdataset_eq(&rrsig.rrs, &expected->rrs);
+	}
+	knot_rdataset_clear(&rrsig.rrs, NULL);
+	return found;
+}
+
+int main(int argc, char *argv[])
+{
+	plan_lazy();
+
+	knot_rrset_t *cover = make_a(1);
+	knot_rrset_t *other = make_a(2);
+	knot_rrset_t *sig1 = make_rrsig(1);
+	knot_rrset_t *sig2 = make_rrsig(2);
+	assert(cover && other && sig1 && sig2);
+
+	ok(sig_cache_new(0) == NULL, "sig cache: zero size rejected");
+	ok(!cache_get(NULL, cover, NOW, NULL), "sig cache: no cache, miss");
+
+	sig_cache_t *cache = sig_cache_new(3);
+	ok(cache != NULL && cache->mask == 3, "sig cache: size rounded up");
+	if (cache == NULL) {
+		return 1;
+	}
+
+	ok(!cache_get(cache, cover, NOW, NULL), "sig cache: empty, miss");
+
+	sig_cache_put(cache, OWNER, cover, EXPIRE, sig1);
+	ok(cache_get(cache, cover, NOW, sig1), "sig cache: hit");
+	ok(!cache_get(cache, cover, EXPIRE, NULL), "sig cache: expired, miss");
+
+	ok(!cache_get(cache, other, NOW, NULL), "sig cache: changed rdata, miss");
+
+	cover->ttl++;
+	ok(!cache_get(cache, cover, NOW, NULL), "sig cache: changed TTL, miss");
+	cover->ttl--;
+
+	// Pretend the digest of other rdata collides with the stored entry.
+	uint64_t hash = sig_hash(cache, OWNER, other);
+	sig_slot_t *slot = &cache->slots[sig_hash(cache, OWNER, cover) & cache->mask];
+	sig_entry_t *entry = slot->entry;
+	slot->entry = NULL;
+	entry->hash = hash;
+	sig_entry_free(cache->slots[hash & cache->mask].entry);
+	cache->slots[hash & cache->mask].entry = entry;
+	ok(!cache_get(cache, other, NOW, NULL), "sig cache: digest collision, miss");
+
+	sig_cache_put(cache, OWNER, cover, EXPIRE, sig1);
+	sig_cache_put(cache, OWNER, other, EXPIRE, sig2);
+	ok(cache_get(cache, other, NOW, sig2), "sig cache: hit of other rdata");
+
+	sig_cache_flush(cache);
+	ok(!cache_get(cache, other, NOW, NULL), "sig cache: generation bumped, miss");
+
+	sig_cache_put(cache, OWNER, other, EXPIRE, sig1);
+	ok(cache_get(cache, other, NOW, sig1), "sig cache: hit in new generation");
+
+	sig_cache_free(cache);
+	knot_rrset_free(cover, NULL);
+	knot_rrset_free(other, NULL);
+	knot_rrset_free(sig1, NULL);
+	knot_rrset_free(sig2, NULL);
+
+	return 0;
+}
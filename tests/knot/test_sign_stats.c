@@ -0,0 +1,207 @@
+/*  Copyright (C) 2024 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <pthread.h>
+#include <tap/basic.h>
+
+#include "knot/dnssec/rrset-sign.h"
+#include "knot/dnssec/zone-keys.h"
+#include "libdnssec/crypto.h"
+#include "libdnssec/error.h"
+#include "libdnssec/sample_keys.h"
+#include "libknot/descriptor.h"
+
+#define APEX  (const knot_dname_t *)"\x07""example"
+#define OWNER (const knot_dname_t *)"\x03""www""\x07""example"
+
+#define NOW       1000000
+#define LIFETIME  3600
+#define THREADS   4
+#define SIGNS     25
+
+typedef struct {
+	const zone_keyset_t *keyset;
+	const kdnssec_ctx_t *dnssec_ctx;
+	const knot_rrset_t *covered;
+	int ret;
+} thread_args_t;
+
+static bool stats_eq(const zone_sign_stats_t *stats, size_t rrsig_count,
+                     knot_time_t expire, uint64_t verify_time)
+{
+	return stats->rrsig_count == rrsig_count && stats->expire == expire &&
+	       stats->verify_time == verify_time;
+}
+
+static void test_merge(void)
+{
+	zone_sign_stats_t stats = { .rrsig_count = 1, .expire = 200, .verify_time = 1 };
+	knot_spin_init(&stats.lock);
+
+	zone_sign_stats_t local = { .rrsig_count = 2, .expire = 100, .verify_time = 5 };
+	zone_sign_stats_merge(&stats, &local);
+	ok(stats_eq(&stats, 3, 100, 6), "merge: counters added, earlier expiration");
+
+	local = (zone_sign_stats_t){ .rrsig_count = 1, .expire = 0 };
+	zone_sign_stats_merge(&stats, &local);
+	ok(stats_eq(&stats, 4, 100, 6), "merge: no expiration kept");
+
+	local = (zone_sign_stats_t){ .rrsig_count = 1, .expire = 300 };
+	zone_sign_stats_merge(&stats, &local);
+	ok(stats_eq(&stats, 5, 100, 6), "merge: later expiration ignored");
+
+	local = (zone_sign_stats_t){ 0 };
+	zone_sign_stats_merge(&stats, &local);
+	ok(stats_eq(&stats, 5, 100, 6), "merge: empty statistics");
+
+	zone_sign_stats_merge(NULL, &local);
+	ok(true, "merge: no shared statistics");
+
+	local = (zone_sign_stats_t){ .verify_count = 7, .verify_batches = 3 };
+	zone_sign_stats_merge(&stats, &local);
+	ok(stats_eq(&stats, 5, 100, 6) && stats.verify_count == 7 &&
+	   stats.verify_batches == 3, "merge: verification counters added");
+
+	knot_spin_destroy(&stats.lock);
+}
+
+static void *sign_thread(void *data)
+{
+	thread_args_t *args = data;
+
+	zone_sign_ctx_t *sign_ctx = zone_sign_ctx(args->keyset, args->dnssec_ctx);
+	if (sign_ctx == NULL) {
+		args->ret = KNOT_ENOMEM;
+		return NULL;
+	}
+
+	knot_rrset_t rrsigs;
+	knot_rrset_init(&rrsigs, args->covered->owner, KNOT_RRTYPE_RRSIG, KNOT_CLASS_IN, 3600);
+	const dnssec_key_t *keys[] = { sign_ctx->keys[0].key };
+
+	for (int i = 0; i < SIGNS && args->ret == KNOT_EOK; i++) {
+		args->ret = knot_sign_rrset_keys(&rrsigs, args->covered, keys, sign_ctx->sign_ctxs,
+		                                 1, args->dnssec_ctx, &sign_ctx->stats, NULL);
+		knot_rdataset_clear(&rrsigs.rrs, NULL);
+	}
+	if (args->ret == KNOT_EOK && sign_ctx->stats.rrsig_count != SIGNS) {
+		args->ret = KNOT_ERROR;
+	}
+
+	zone_sign_ctx_free(sign_ctx);
+
+	return NULL;
+}
+
+static void test_signing(dnssec_key_t *key)
+{
+	knot_kasp_policy_t policy = { .rrsig_lifetime = LIFETIME };
+	zone_sign_stats_t stats = { 0 };
+	knot_spin_init(&stats.lock);
+	kdnssec_ctx_t dnssec_ctx = { .now = NOW, .policy = &policy, .stats = &stats };
+
+	const uint8_t addr[] = { 192, 0, 2, 1 };
+	knot_rrset_t *covered = knot_rrset_new(OWNER, KNOT_RRTYPE_A, KNOT_CLASS_IN, 3600, NULL);
+	knot_rrset_t *rrsigs = knot_rrset_new(OWNER, KNOT_RRTYPE_RRSIG, KNOT_CLASS_IN, 3600, NULL);
+	dnssec_sign_ctx_t *sign_ctx = NULL;
+	if (covered == NULL || rrsigs == NULL ||
+	    knot_rrset_add_rdata(covered, addr, sizeof(addr), NULL) != KNOT_EOK ||
+	    dnssec_sign_new(&sign_ctx, key) != DNSSEC_EOK) {
+		ok(false, "signing: prepare");
+		goto cleanup;
+	}
+
+	/* Statistics of the calling thread. */
+	zone_sign_stats_t local = { 0 };
+	const dnssec_key_t *keys[] = { key };
+	int ret = knot_sign_rrset_keys(rrsigs, covered, keys, &sign_ctx, 1, &dnssec_ctx,
+	                               &local, NULL);
+	is_int(KNOT_EOK, ret, "signing: sign with thread statistics");
+	ok(rrsigs->rrs.count == 1, "signing: signature created");
+	ok(stats_eq(&local, 1, NOW + LIFETIME, 0), "signing: thread statistics updated");
+	ok(stats_eq(&stats, 0, 0, 0), "signing: shared statistics untouched");
+
+	ret = knot_sign_rrset_keys(rrsigs, covered, keys, &sign_ctx, 1, &dnssec_ctx,
+	                           NULL, NULL);
+	is_int(KNOT_EOK, ret, "signing: sign without statistics");
+
+	/* Verification of the covered RRs converted to wire just once. */
+	dnssec_binary_t wire = { 0 };
+	ret = knot_covered_to_wire(covered, &wire);
+	is_int(KNOT_EOK, ret, "verifying: covered RRs to wire");
+	ret = knot_check_signature_wire(&wire, rrsigs, 0, sign_ctx, &dnssec_ctx, 0, false);
+	is_int(KNOT_EOK, ret, "verifying: signature valid");
+	ret = knot_check_signature_wire(&wire, rrsigs, 1, sign_ctx, &dnssec_ctx, 0, false);
+	is_int(KNOT_EOK, ret, "verifying: same key context reused");
+	wire.data[wire.size - 1] ^= 0xff;
+	ret = knot_check_signature_wire(&wire, rrsigs, 0, sign_ctx, &dnssec_ctx, 0, false);
+	ok(ret != KNOT_EOK, "verifying: modified RRs invalid");
+	dnssec_binary_free(&wire);
+
+	/* Single-key wrapper merges at once. */
+	ret = knot_sign_rrset(rrsigs, covered, key, sign_ctx, &dnssec_ctx, NULL);
+	is_int(KNOT_EOK, ret, "signing: sign with single key");
+	ok(stats_eq(&stats, 1, NOW + LIFETIME, 0), "signing: shared statistics merged");
+
+	/* Per-thread signing contexts merge on free. */
+	zone_key_t zone_key = { .key = key, .is_zsk = true, .is_active = true, .is_public = true };
+	zone_keyset_t keyset = { .count = 1, .keys = &zone_key };
+	pthread_t threads[THREADS];
+	thread_args_t args[THREADS];
+	for (int i = 0; i < THREADS; i++) {
+		args[i] = (thread_args_t){ &keyset, &dnssec_ctx, covered, KNOT_EOK };
+		pthread_create(&threads[i], NULL, sign_thread, &args[i]);
+	}
+	bool threads_ok = true;
+	for (int i = 0; i < THREADS; i++) {
+		pthread_join(threads[i], NULL);
+		threads_ok = threads_ok && args[i].ret == KNOT_EOK;
+	}
+	ok(threads_ok, "signing: threads signed with their own statistics");
+	ok(stats_eq(&stats, 1 + THREADS * SIGNS, NOW + LIFETIME, 0),
+	   "signing: thread statistics merged on context free");
+
+cleanup:
+	dnssec_sign_free(sign_ctx);
+	knot_rrset_free(covered, NULL);
+	knot_rrset_free(rrsigs, NULL);
+	knot_spin_destroy(&stats.lock);
+}
+
+int main(int argc, char *argv[])
+{
+	plan_lazy();
+
+	dnssec_crypto_init();
+
+	test_merge();
+
+	dnssec_key_t *key = NULL;
+	const key_parameters_t *params = &SAMPLE_ECDSA_KEY;
+	if (dnssec_key_new(&key) != DNSSEC_EOK ||
+	    dnssec_key_set_dname(key, APEX) != DNSSEC_EOK ||
+	    dnssec_key_set_rdata(key, &params->rdata) != DNSSEC_EOK ||
+	    dnssec_key_load_pkcs8(key, &params->pem) != DNSSEC_EOK) {
+		ok(false, "load key");
+	} else {
+		test_signing(key);
+	}
+	dnssec_key_free(key);
+
+	dnssec_crypto_cleanup();
+
+	return 0;
+}
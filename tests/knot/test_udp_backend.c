@@ -0,0 +1,259 @@
+/*  Copyright (C) 2024 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <urcu.h>
+#include <tap/basic.h>
+#include <tap/files.h>
+
+#if defined(ENABLE_IO_URING) && defined(__linux__)
+#include <errno.h>
+#include <stddef.h>
+#include <linux/filter.h>
+#include <linux/seccomp.h>
+#include <sys/prctl.h>
+#include <sys/syscall.h>
+#endif
+
+#include "test_server.h"
+#include "contrib/ucw/mempool.h"
+#include "libknot/libknot.h"
+
+#define QUERY_ATTEMPTS	5
+#define QUERY_TIMEOUT	1 // Seconds.
+
+static void interrupt_handle(int s)
+{
+}
+
+/*! Import the configuration as the server does on startup. */
+static int load_conf(const char *conf_str)
+{
+	conf_t *new_conf = NULL;
+	int ret = conf_new(&new_conf, conf_schema, NULL, 2 * 1024 * 1024, CONF_FNONE);
+	if (ret != KNOT_EOK) {
+		return ret;
+	}
+
+	ret = conf_import(new_conf, conf_str, IMPORT_REINIT_CACHE);
+	if (ret != KNOT_EOK) {
+		conf_free(new_conf);
+		return ret;
+	}
+
+	conf_update(new_conf, CONF_UPD_FNONE);
+
+	return KNOT_EOK;
+}
+
+static int free_port(void)
+{
+	int fd = socket(AF_INET, SOCK_DGRAM, 0);
+	if (fd < 0) {
+		return -1;
+	}
+
+	struct sockaddr_in addr = { .sin_family = AF_INET };
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	socklen_t len = sizeof(addr);
+	int port = -1;
+	if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0 &&
+	    getsockname(fd, (struct sockaddr *)&addr, &len) == 0) {
+		port = ntohs(addr.sin_port);
+	}
+	close(fd);
+
+	return port;
+}
+
+static bool query_soa(int port)
+{
+	int fd = socket(AF_INET, SOCK_DGRAM, 0);
+	if (fd < 0) {
+		return false;
+	}
+	struct timeval tv = { .tv_sec = QUERY_TIMEOUT };
+	(void)setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+	struct sockaddr_in addr = { .sin_family = AF_INET, .sin_port = htons(port) };
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+	knot_pkt_t *query = knot_pkt_new(NULL, KNOT_WIRE_MAX_PKTSIZE, NULL);
+	bool answered = false;
+	if (query == NULL ||
+	    knot_pkt_put_question(query, ROOT_DNAME, KNOT_CLASS_IN, KNOT_RRTYPE_SOA) != KNOT_EOK) {
+		goto finish;
+	}
+
+	// The UDP workers may still be starting up.
+	for (int i = 0; i < QUERY_ATTEMPTS && !answered; i++) {
+		knot_wire_set_id(query->wire, i + 1);
+		if (sendto(fd, query->wire, query->size, 0, (struct sockaddr *)&addr,
+		           sizeof(addr)) != query->size) {
+			continue;
+		}
+		uint8_t buf[KNOT_WIRE_MAX_PKTSIZE];
+		ssize_t len = recv(fd, buf, sizeof(buf), 0);
+		if (len <= 0) {
+			continue;
+		}
+		knot_pkt_t *reply = knot_pkt_new(buf, len, NULL);
+		answered = reply != NULL && knot_pkt_parse(reply, 0) == KNOT_EOK &&
+		           knot_wire_get_id(reply->wire) == i + 1 &&
+		           knot_pkt_ext_rcode(reply) == KNOT_RCODE_NOERROR &&
+		           knot_wire_get_ancount(reply->wire) == 1;
+		knot_pkt_free(reply);
+	}
+
+finish:
+	knot_pkt_free(query);
+	close(fd);
+
+	return answered;
+}
+
+/*! Start the server with the current configuration and query it over UDP. */
+static bool serve(int port)
+{
+	knot_mm_t mm;
+	mm_ctx_mempool(&mm, MM_DEFAULT_BLKSIZE);
+	rcu_register_thread();
+
+	server_t server;
+	bool answered = false;
+	if (server_init(&server, 1) != KNOT_EOK) {
+		goto finish;
+	}
+	if (server_reconfigure(conf(), &server) != KNOT_EOK) {
+		server_deinit(&server);
+		goto finish;
+	}
+	create_root_zone(&server, &mm);
+
+	if (server_start(&server, false) == KNOT_EOK) {
+		answered = query_soa(port);
+		server_stop(&server);
+	}
+	server_wait(&server);
+	server_deinit(&server);
+
+finish:
+	rcu_unregister_thread();
+	mp_delete(mm.ctx);
+
+	return answered;
+}
+
+#if defined(ENABLE_IO_URING) && defined(__NR_io_uring_setup)
+/*! Make io_uring_setup() fail as on a kernel without io_uring support. */
+static bool disable_io_uring(void)
+{
+	struct sock_filter filter[] = {
+		BPF_STMT(BPF_LD | BPF_W | BPF_ABS, offsetof(struct seccomp_data, nr)),
+		BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, __NR_io_uring_setup, 0, 1),
+		BPF_STMT(BPF_RET | BPF_K, SECCOMP_RET_ERRNO | ENOSYS),
+		BPF_STMT(BPF_RET | BPF_K, SECCOMP_RET_ALLOW),
+	};
+	struct sock_fprog prog = {
+		.len = sizeof(filter) / sizeof(filter[0]),
+		.filter = filter,
+	};
+
+	return prctl(PR_SET_NO_NEW_PRIVS, 1, 0, 0, 0) == 0 &&
+	       prctl(PR_SET_SECCOMP, SECCOMP_MODE_FILTER, &prog) == 0;
+}
+
+static void test_no_kernel_support(int port)
+{
+	pid_t pid = fork();
+	if (pid == 0) {
+		_exit(disable_io_uring() && serve(port) ? 0 : 1);
+	}
+
+	int status = -1;
+	ok(pid > 0 && waitpid(pid, &status, 0) == pid && WIFEXITED(status) &&
+	   WEXITSTATUS(status) == 0, "io-uring without kernel support: query answered");
+}
+#else
+static void test_no_kernel_support(int port)
+{
+	skip("io_uring not built, covered by the missing liburing case");
+}
+#endif
+
+int main(int argc, char *argv[])
+{
+	plan_lazy();
+
+	char *temp_dir = test_mkdtemp();
+	ok(temp_dir != NULL, "make temporary directory");
+	int port = free_port();
+	ok(port > 0, "find free port");
+
+	/* Interrupt the workers on stop. */
+	struct sigaction sa;
+	sa.sa_handler = interrupt_handle;
+	sigemptyset(&sa.sa_mask);
+	sa.sa_flags = 0;
+	sigaction(SIGALRM, &sa, NULL);
+
+	/* The running backend is cached from the first configuration. */
+	char conf_str[4096 + 512];
+	(void)snprintf(conf_str, sizeof(conf_str),
+		"server:\n"
+		"    listen: 127.0.0.1@%d\n"
+		"    udp-workers: 1\n"
+		"    tcp-workers: 1\n"
+		"    background-workers: 1\n"
+		"    udp-backend: io-uring\n"
+		"database:\n"
+		"    storage: %s\n"
+		"zone:\n"
+		"  - domain: .\n"
+		"    zonefile-sync: -1\n",
+		port, temp_dir);
+	int ret = load_conf(conf_str);
+	is_int(KNOT_EOK, ret, "config: io-uring accepted");
+	if (ret != KNOT_EOK) {
+		goto finish;
+	}
+	ok(conf()->cache.srv_udp_backend == UDP_BACKEND_IO_URING, "config: io-uring cached");
+
+	ret = load_conf("server:\n    udp-backend: uring\n");
+	ok(ret != KNOT_EOK, "config: unknown backend refused");
+	ok(conf()->cache.srv_udp_backend == UDP_BACKEND_IO_URING, "config: backend kept");
+
+	/* Fork before the server starts its threads. */
+	test_no_kernel_support(port);
+
+	/* Either io_uring, or the default backend if liburing is missing. */
+	ok(serve(port), "io-uring: query answered");
+
+finish:
+	test_conf_free();
+	test_rm_rf(temp_dir);
+	free(temp_dir);
+
+	return 0;
+}
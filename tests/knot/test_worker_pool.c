@@ -61,6 +61,63 @@ static void task_counting(worker_task_t *task)
 	pthread_mutex_unlock(&log->mx);
 }
 
+/*!
+ * Task execution order log.
+ */
+typedef struct order_log {
+	worker_prio_t order[WORKER_PRIO_COUNT];
+	unsigned executed;
+} order_log_t;
+
+static order_log_t order_log;
+
+/*!
+ * Task recording its priority, expected to be run by a single thread.
+ */
+static void task_ordering(worker_task_t *task)
+{
+	order_log.order[order_log.executed++] = task->prio;
+}
+
+static void test_priorities(void)
+{
+	worker_pool_t *pool = worker_pool_create(1);
+	ok(pool != NULL, "priorities: create worker pool");
+	if (!pool) {
+		return;
+	}
+
+	worker_task_t tasks[WORKER_PRIO_COUNT];
+	for (int i = 0; i < WORKER_PRIO_COUNT; i++) {
+		// Assign in the reversed order of priority.
+		tasks[i].prio = WORKER_PRIO_COUNT - 1 - i;
+		tasks[i].run = task_ordering;
+		tasks[i].ctx = NULL;
+		worker_pool_assign(pool, &tasks[i]);
+	}
+
+	int running, queued, queued_prio[WORKER_PRIO_COUNT];
+	worker_pool_status(pool, false, &running, &queued, queued_prio);
+	ok(running == 0 && queued == WORKER_PRIO_COUNT, "priorities: status total");
+	bool each_one = true;
+	for (int i = 0; i < WORKER_PRIO_COUNT; i++) {
+		each_one = each_one && queued_prio[i] == 1;
+	}
+	ok(each_one, "priorities: status per class");
+
+	worker_pool_start(pool);
+	worker_pool_wait(pool);
+
+	ok(order_log.executed == WORKER_PRIO_COUNT &&
+	   order_log.order[0] == WORKER_PRIO_HIGH &&
+	   order_log.order[1] == WORKER_PRIO_NORMAL &&
+	   order_log.order[2] == WORKER_PRIO_LOW, "priorities: execution order");
+
+	worker_pool_stop(pool);
+	worker_pool_join(pool);
+	worker_pool_destroy(pool);
+}
+
 static void interrupt_handle(int s)
 {
 }
@@ -148,5 +205,7 @@ int main(void)
 
 	pthread_mutex_destroy(&log.mx);
 
+	test_priorities();
+
 	return 0;
 }
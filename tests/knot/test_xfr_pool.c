@@ -0,0 +1,256 @@
+/*  Copyright (C) 2024 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <tap/basic.h>
+
+#include <arpa/inet.h>
+#include <poll.h>
+#include <sched.h>
+
+#include "knot/server/xfr-pool.c"
+
+#define ZONE_A (const knot_dname_t *)"\x01""a"
+#define ZONE_B (const knot_dname_t *)"\x01""b"
+
+/*! \brief Job with a recorded run and drop. */
+typedef struct {
+	xfr_job_t job;
+	unsigned runs;
+	unsigned drops;
+	unsigned thread_id;
+} test_job_t;
+
+static pthread_mutex_t gate_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t gate_cond = PTHREAD_COND_INITIALIZER;
+static bool gate_open;
+static bool gate_entered;
+
+static void job_run(xfr_job_t *job, unsigned thread_id)
+{
+	test_job_t *test = (test_job_t *)job;
+	test->runs++;
+	test->thread_id = thread_id;
+}
+
+/*! \brief Running job blocked until the gate is opened. */
+static void job_run_gated(xfr_job_t *job, unsigned thread_id)
+{
+	pthread_mutex_lock(&gate_lock);
+	gate_entered = true;
+	pthread_cond_broadcast(&gate_cond);
+	while (!gate_open) {
+		pthread_cond_wait(&gate_cond, &gate_lock);
+	}
+	pthread_mutex_unlock(&gate_lock);
+
+	job_run(job, thread_id);
+}
+
+static void job_drop(xfr_job_t *job, unsigned thread_id)
+{
+	test_job_t *test = (test_job_t *)job;
+	test->drops++;
+	test->thread_id = thread_id;
+}
+
+static void job_init(test_job_t *test, const knot_dname_t *zone, const char *client)
+{
+	memset(test, 0, sizeof(*test));
+	memcpy(test->job.zone, zone, knot_dname_size(zone));
+	struct sockaddr_in *sin = (struct sockaddr_in *)&test->job.client;
+	sin->sin_family = AF_INET;
+	inet_pton(AF_INET, client, &sin->sin_addr);
+	test->job.run = job_run;
+	test->job.drop = job_drop;
+}
+
+/*! \brief Pool without workers, the jobs are moved by the test. */
+static void pool_init(xfr_pool_t *pool)
+{
+	memset(pool, 0, sizeof(*pool));
+	pthread_mutex_init(&pool->lock, NULL);
+	pthread_cond_init(&pool->wake, NULL);
+	init_list(&pool->queue);
+	init_list(&pool->running);
+}
+
+static void pool_deinit(xfr_pool_t *pool)
+{
+	pthread_cond_destroy(&pool->wake);
+	pthread_mutex_destroy(&pool->lock);
+}
+
+static void test_fairness(void)
+{
+	xfr_pool_t pool;
+	pool_init(&pool);
+
+	test_job_t run1, run2, a1, b1, a2;
+	job_init(&run1, ZONE_A, "192.0.2.1");
+	job_init(&run2, ZONE_B, "192.0.2.1");
+	job_init(&a1, ZONE_A, "192.0.2.1");
+	job_init(&b1, ZONE_A, "192.0.2.2");
+	job_init(&a2, ZONE_B, "192.0.2.1");
+
+	ok(pick_job(&pool) == NULL, "fairness: nothing to pick from empty queue");
+
+	add_tail(&pool.queue, &a1.job.n);
+	add_tail(&pool.queue, &b1.job.n);
+	add_tail(&pool.queue, &a2.job.n);
+	ok(pick_job(&pool) == &a1.job, "fairness: oldest job without running ones");
+
+	add_tail(&pool.running, &run1.job.n);
+	ok(pick_job(&pool) == &b1.job, "fairness: client without running jobs first");
+
+	rem_node(&b1.job.n);
+	add_tail(&pool.running, &b1.job.n);
+	ok(pick_job(&pool) == &a1.job, "fairness: oldest job among equal clients");
+
+	add_tail(&pool.running, &run2.job.n);
+	rem_node(&a1.job.n);
+	add_tail(&pool.queue, &a1.job.n);
+	ok(pick_job(&pool) == &a2.job, "fairness: queue order kept for one client");
+
+	pool_deinit(&pool);
+}
+
+static void test_zone_limit(void)
+{
+	xfr_pool_t pool;
+	pool_init(&pool);
+
+	test_job_t run, a1, b1;
+	job_init(&run, ZONE_A, "192.0.2.1");
+	job_init(&a1, ZONE_A, "192.0.2.2");
+	job_init(&b1, ZONE_B, "192.0.2.1");
+
+	add_tail(&pool.running, &run.job.n);
+	add_tail(&pool.queue, &a1.job.n);
+	add_tail(&pool.queue, &b1.job.n);
+	ok(pick_job(&pool) == &a1.job, "zone limit: unlimited by default");
+
+	xfr_pool_set_zone_limit(&pool, 1);
+	ok(pool.zone_limit == 1, "zone limit: set");
+	ok(pick_job(&pool) == &b1.job, "zone limit: zone at the limit skipped");
+
+	rem_node(&b1.job.n);
+	ok(pick_job(&pool) == NULL, "zone limit: no job within the limit");
+
+	xfr_pool_set_zone_limit(&pool, 2);
+	ok(pick_job(&pool) == &a1.job, "zone limit: raised limit");
+
+	xfr_pool_set_zone_limit(&pool, 0);
+	ok(pick_job(&pool) == &a1.job, "zone limit: unset");
+
+	xfr_pool_set_zone_limit(NULL, 1);
+	ok(true, "zone limit: set on NULL pool");
+
+	pool_deinit(&pool);
+}
+
+static void test_done(void)
+{
+	xfr_pool_t *pool = xfr_pool_new(2, 10, 2);
+	ok(pool != NULL, "done: create pool");
+	if (pool == NULL) {
+		return;
+	}
+
+	test_job_t job;
+	job_init(&job, ZONE_A, "192.0.2.1");
+	job.job.owner = 1;
+	xfr_pool_submit(pool, &job.job);
+
+	struct pollfd pfd = { .fd = xfr_pool_done_fd(pool, 1), .events = POLLIN };
+	ok(poll(&pfd, 1, 5000) == 1, "done: owner woken up");
+
+	list_t done;
+	xfr_pool_done(pool, 1, &done);
+	ok(HEAD(done) == &job.job.n && list_size(&done) == 1, "done: job returned to owner");
+	ok(job.runs == 1 && job.drops == 0, "done: job run once");
+	ok(job.thread_id >= 10 && job.thread_id < 12, "done: worker thread identifier");
+
+	xfr_pool_done(pool, 0, &done);
+	ok(EMPTY_LIST(done), "done: other owner without jobs");
+
+	xfr_pool_free(pool);
+}
+
+static void *pool_free_thread(void *pool)
+{
+	xfr_pool_free(pool);
+	return NULL;
+}
+
+static void test_drop_on_free(void)
+{
+	xfr_pool_t *pool = xfr_pool_new(1, 1, 1);
+	ok(pool != NULL, "drop: create pool");
+	if (pool == NULL) {
+		return;
+	}
+
+	test_job_t running, queued;
+	job_init(&running, ZONE_A, "192.0.2.1");
+	job_init(&queued, ZONE_B, "192.0.2.2");
+	running.job.run = job_run_gated;
+
+	gate_open = false;
+	gate_entered = false;
+	xfr_pool_submit(pool, &running.job);
+
+	// Wait until the only worker is busy.
+	pthread_mutex_lock(&gate_lock);
+	while (!gate_entered) {
+		pthread_cond_wait(&gate_cond, &gate_lock);
+	}
+	pthread_mutex_unlock(&gate_lock);
+
+	xfr_pool_submit(pool, &queued.job);
+
+	// Free the pool, let the running job finish once stopping.
+	pthread_t thread;
+	pthread_create(&thread, NULL, pool_free_thread, pool);
+	bool stop = false;
+	while (!stop) {
+		sched_yield();
+		pthread_mutex_lock(&pool->lock);
+		stop = pool->stop;
+		pthread_mutex_unlock(&pool->lock);
+	}
+	pthread_mutex_lock(&gate_lock);
+	gate_open = true;
+	pthread_cond_broadcast(&gate_cond);
+	pthread_mutex_unlock(&gate_lock);
+	pthread_join(thread, NULL);
+
+	ok(running.runs == 1, "drop: running job finished");
+	ok(running.drops == 1 && running.thread_id == 0, "drop: finished job not taken by owner dropped");
+	ok(queued.runs == 0, "drop: queued job not run");
+	ok(queued.drops == 1 && queued.thread_id == 0, "drop: queued job dropped");
+}
+
+int main(void)
+{
+	plan_lazy();
+
+	test_fairness();
+	test_zone_limit();
+	test_done();
+	test_drop_on_free();
+
+	return 0;
+}
@@ -16,6 +16,7 @@
 
 #include <assert.h>
 #include <pthread.h>
+#include <signal.h>
 #include <tap/basic.h>
 #include <tap/files.h>
 #include <unistd.h>
@@ -37,6 +38,11 @@ static const char *node_str2 = "node.test. 601 IN TXT \"def\"\n";
 
 knot_rrset_t rrset;
 
+// Signal handler
+static void interrupt_handle(int s)
+{
+}
+
 /*!< \brief Returns true if node contains given RR in its RRSets. */
 static bool node_contains_rr(const zone_node_t *node, const knot_rrset_t *data)
 {
@@ -304,6 +310,13 @@ int main(int argc, char *argv[])
 	int ret = test_conf(conf_str, NULL);
 	is_int(KNOT_EOK, ret, "load configuration");
 
+	/* Stopping the shared compute pool interrupts its threads. */
+	struct sigaction sa;
+	sa.sa_handler = interrupt_handle;
+	sigemptyset(&sa.sa_mask);
+	sa.sa_flags = 0;
+	sigaction(SIGALRM, &sa, NULL); // Interrupt
+
 	server_t server;
 	ret = server_init(&server, 1);
 	is_int(KNOT_EOK, ret, "server init");
@@ -0,0 +1,169 @@
+/*  Copyright (C) 2024 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <tap/basic.h>
+#include <tap/files.h>
+#include <unistd.h>
+
+#include "contrib/string.h"
+#include "knot/zone/snapshot.h"
+#include "libknot/libknot.h"
+#include "libzscanner/scanner.h"
+
+static const char *zone_str =
+	"test. 600 IN SOA ns.test. m.test. 2024 900 300 4800 900\n"
+	"test. 600 IN NS ns.test.\n"
+	"test. 600 IN TXT \"apex\" \"text\"\n"
+	"ns.test. 600 IN A 192.0.2.1\n"
+	"ns.test. 600 IN AAAA 2001:db8::1\n"
+	"*.wild.test. 300 IN A 192.0.2.2\n"
+	"a.b.c.test. 300 IN TXT \"odd\"\n"
+	"a.b.c.test. 300 IN TXT \"even\"\n";
+
+static void add_rr(zs_scanner_t *s)
+{
+	zone_contents_t *contents = s->process.data;
+
+	knot_rrset_t rrset;
+	knot_rrset_init(&rrset, s->r_owner, s->r_type, s->r_class, s->r_ttl);
+	if (knot_rrset_add_rdata(&rrset, s->r_data, s->r_data_length, NULL) == KNOT_EOK) {
+		zone_node_t *unused = NULL;
+		(void)zone_contents_add_rr(contents, &rrset, &unused);
+	}
+	knot_rdataset_clear(&rrset.rrs, NULL);
+}
+
+static zone_contents_t *create_contents(void)
+{
+	zone_contents_t *contents = zone_contents_new((uint8_t *)"\x04""test", true);
+	if (contents == NULL) {
+		return NULL;
+	}
+
+	zs_scanner_t s;
+	if (zs_init(&s, "test.", KNOT_CLASS_IN, 3600) != 0 ||
+	    zs_set_processing(&s, add_rr, NULL, contents) != 0 ||
+	    zs_set_input_string(&s, zone_str, strlen(zone_str)) != 0 ||
+	    zs_parse_all(&s) != 0) {
+		zs_deinit(&s);
+		zone_contents_deep_free(contents);
+		return NULL;
+	}
+	zs_deinit(&s);
+
+	return contents;
+}
+
+static int cmp_node(zone_node_t *node, void *data)
+{
+	zone_contents_t *other = data;
+
+	const zone_node_t *found = zone_contents_find_node(other, node->owner);
+	if (found == NULL || found->rrset_count != node->rrset_count) {
+		return KNOT_ENOENT;
+	}
+	for (uint16_t i = 0; i < node->rrset_count; i++) {
+		const struct rr_data *rr = &node->rrs[i];
+		const knot_rdataset_t *rrs = node_rdataset(found, rr->type);
+		if (rrs == NULL || !knot_rdataset_eq(rrs, &rr->rrs) ||
+		    node_rrset(found, rr->type).ttl != rr->ttl) {
+			return KNOT_ENOENT;
+		}
+	}
+
+	return KNOT_EOK;
+}
+
+static bool contents_eq(zone_contents_t *a, zone_contents_t *b)
+{
+	return zone_contents_apply(a, cmp_node, b) == KNOT_EOK &&
+	       zone_contents_apply(b, cmp_node, a) == KNOT_EOK;
+}
+
+int main(int argc, char *argv[])
+{
+	plan_lazy();
+
+	char *dir = test_mkdtemp();
+	if (dir == NULL) {
+		return EXIT_FAILURE;
+	}
+	char *zonefile = sprintf_alloc("%s/test.zone", dir);
+	char *path = zone_snapshot_path(zonefile);
+	ok(path != NULL && strcmp(path + strlen(zonefile), ".snap") == 0,
+	   "snapshot path");
+
+	zone_contents_t *contents = create_contents();
+	ok(contents != NULL && zone_contents_serial(contents) == 2024,
+	   "create contents");
+
+	struct timespec mtime = { .tv_sec = 1700000000, .tv_nsec = 123 };
+	int ret = zone_snapshot_write(path, contents, &mtime);
+	is_int(KNOT_EOK, ret, "write snapshot");
+
+	// Load valid snapshot.
+	zone_contents_t *loaded = NULL;
+	ret = zone_snapshot_load(path, contents->apex->owner, &mtime, 2024, &loaded);
+	is_int(KNOT_EOK, ret, "load snapshot");
+	ok(loaded != NULL && contents_eq(contents, loaded), "loaded contents match");
+	zone_contents_deep_free(loaded);
+	loaded = NULL;
+
+	// Outdated snapshot.
+	struct timespec newer = { .tv_sec = mtime.tv_sec + 1 };
+	ret = zone_snapshot_load(path, contents->apex->owner, &newer, 2024, &loaded);
+	is_int(KNOT_ENOENT, ret, "load snapshot with different mtime");
+	ret = zone_snapshot_load(path, contents->apex->owner, &mtime, 2025, &loaded);
+	is_int(KNOT_ENOENT, ret, "load snapshot with different serial");
+
+	// Wrong zone.
+	ret = zone_snapshot_load(path, (uint8_t *)"\x05""other", &mtime, 2024, &loaded);
+	is_int(KNOT_EMALF, ret, "load snapshot of other zone");
+
+	// Truncated snapshot.
+	ok(truncate(path, 100) == 0, "truncate snapshot");
+	ret = zone_snapshot_load(path, contents->apex->owner, &mtime, 2024, &loaded);
+	is_int(KNOT_EMALF, ret, "load truncated snapshot");
+	ok(loaded == NULL, "no contents on failure");
+
+	// Missing snapshot.
+	unlink(path);
+	ret = zone_snapshot_load(path, contents->apex->owner, &mtime, 2024, &loaded);
+	is_int(KNOT_ENOENT, ret, "load missing snapshot");
+
+	// Zone files with and without an include.
+	FILE *file = fopen(zonefile, "w");
+	ok(file != NULL && fputs(zone_str, file) >= 0 && fclose(file) == 0,
+	   "write zone file");
+	ok(zone_snapshot_allowed(zonefile), "snapshot allowed without include");
+	file = fopen(zonefile, "a");
+	ok(file != NULL && fputs("$include other.zone\n", file) >= 0 && fclose(file) == 0,
+	   "append include");
+	ok(!zone_snapshot_allowed(zonefile), "snapshot refused with include");
+	unlink(zonefile);
+	ok(!zone_snapshot_allowed(zonefile), "snapshot refused without zone file");
+
+	zone_contents_deep_free(contents);
+	free(path);
+	free(zonefile);
+	test_rm_rf(dir);
+	free(dir);
+
+	return 0;
+}
@@ -38,6 +38,7 @@ static const zone_timers_t MOCK_TIMERS = {
 	.master_pin_hit = 1474559966,
 	.last_signed_serial = 12354678,
 	.last_signed_s_flags = LAST_SIGNED_SERIAL_FOUND | LAST_SIGNED_SERIAL_VALID,
+	.snapshot_serial = 2024010101 | SNAPSHOT_SERIAL_VALID,
 };
 
 static bool timers_eq(const zone_timers_t *val, const zone_timers_t *ref)
@@ -53,6 +54,7 @@ static bool timers_eq(const zone_timers_t *val, const zone_timers_t *ref)
 		sockaddr_cmp((struct sockaddr_storage *)&val->last_master,
 		             (struct sockaddr_storage *)&ref->last_master, false) == 0 &&
 		val->master_pin_hit == ref->master_pin_hit &&
+		val->snapshot_serial == ref->snapshot_serial &&
 		(val->last_signed_s_flags & LAST_SIGNED_SERIAL_VALID) == (ref->last_signed_s_flags & LAST_SIGNED_SERIAL_VALID) &&
 		(val->last_signed_serial == ref->last_signed_serial || !(val->last_signed_s_flags & LAST_SIGNED_SERIAL_VALID));
 }
@@ -17,6 +17,7 @@
 #include <string.h>
 #include <tap/basic.h>
 
+#include "binary.h"
 #include "crypto.h"
 #include "error.h"
 #include "nsec.h"
@@ -84,6 +85,57 @@ static void test_hashing(void)
 	dnssec_binary_free(&hash);
 }
 
+static void test_hashing_batch(void)
+{
+	// Lengths around the SHA-1 block boundaries, one too long for vectorization.
+	static const size_t sizes[] = { 1, 13, 46, 55, 56, 63, 64, 119, 120, 255, 600 };
+	static const size_t salt_sizes[] = { 0, 8, 255 };
+	static const int iterations[] = { 0, 1, 12 };
+	const size_t count = sizeof(sizes) / sizeof(sizes[0]);
+
+	uint8_t buf[600];
+	for (size_t i = 0; i < sizeof(buf); i++) {
+		buf[i] = i * 7 + 3;
+	}
+
+	dnssec_binary_t data[count];
+	dnssec_binary_t hashes[count];
+	uint8_t hash_buf[count][20];
+	for (size_t i = 0; i < count; i++) {
+		data[i] = (dnssec_binary_t) { .size = sizes[i], .data = buf + i };
+	}
+
+	for (int s = 0; s < 3; s++) {
+		for (int it = 0; it < 3; it++) {
+			const dnssec_nsec3_params_t params = {
+				.algorithm = DNSSEC_NSEC3_ALGORITHM_SHA1,
+				.iterations = iterations[it],
+				.salt = { .size = salt_sizes[s], .data = buf + 300 }
+			};
+
+			for (size_t i = 0; i < count; i++) {
+				hashes[i] = (dnssec_binary_t) { .size = 20, .data = hash_buf[i] };
+			}
+
+			int result = dnssec_nsec3_hash_batch(data, count, &params, hashes);
+			bool match = (result == DNSSEC_EOK);
+			for (size_t i = 0; i < count && match; i++) {
+				dnssec_binary_t hash = { 0 };
+				result = dnssec_nsec3_hash(&data[i], &params, &hash);
+				match = (result == DNSSEC_EOK && dnssec_binary_cmp(&hash, &hashes[i]) == 0);
+				dnssec_binary_free(&hash);
+			}
+			ok(match, "dnssec_nsec3_hash_batch(), salt %zu, iterations %d",
+			   salt_sizes[s], iterations[it]);
+		}
+	}
+
+	const dnssec_nsec3_params_t params = { .algorithm = DNSSEC_NSEC3_ALGORITHM_SHA1 };
+	hashes[0].size = 19;
+	ok(dnssec_nsec3_hash_batch(data, 1, &params, hashes) == DNSSEC_EINVAL,
+	   "dnssec_nsec3_hash_batch(), small output");
+}
+
 static void test_clear(void)
 {
 	const dnssec_nsec3_params_t empty = { 0 };
@@ -108,6 +160,7 @@ int main(void)
 	test_length();
 	test_parsing();
 	test_hashing();
+	test_hashing_batch();
 	test_clear();
 
 	return 0;
@@ -132,6 +132,37 @@ static void check_key(const key_parameters_t *key_data, const dnssec_binary_t *d
 		dnssec_binary_free(&new_signature);
 	}
 
+	// batch signing
+
+	size_t sig_size = dnssec_sign_size(ctx);
+	ok(sig_size == signature->size, "signature size");
+
+	dnssec_binary_t other = binary_set_string("knot is the best");
+	uint8_t sig_buf[3][sig_size];
+	dnssec_sign_job_t jobs[3] = {
+		{ .ctx = ctx, .data = *data, .signature = { sig_size, sig_buf[0] } },
+		{ .ctx = ctx, .data = other, .signature = { sig_size, sig_buf[1] } },
+		{ .ctx = ctx, .data = other, .signature = { sig_size - 1, sig_buf[2] } },
+	};
+	r = dnssec_sign_batch(jobs, 2, DNSSEC_SIGN_NORMAL);
+	ok(r == DNSSEC_EOK && jobs[0].result == DNSSEC_EOK &&
+	   jobs[1].result == DNSSEC_EOK, "batch sign");
+	if (signature_match) {
+		ok(dnssec_binary_cmp(signature, &jobs[0].signature) == 0,
+		   "batch signature exact match");
+	}
+	r = dnssec_sign_batch(jobs + 2, 1, DNSSEC_SIGN_NORMAL);
+	ok(r != DNSSEC_EOK && jobs[2].result == r, "batch sign, small buffer");
+
+	for (int i = 0; i < 2; i++) {
+		r = dnssec_sign_init(ctx);
+		ok(r == DNSSEC_EOK, "reinitialize context");
+		r = dnssec_sign_add(ctx, &jobs[i].data);
+		ok(r == DNSSEC_EOK, "add data to be verified");
+		r = dnssec_sign_verify(ctx, false, &jobs[i].signature);
+		ok(r == DNSSEC_EOK, "verify batch signature (%d)", i);
+	}
+
 	// context reinitialization
 
 	dnssec_binary_t tmp = { 0 };
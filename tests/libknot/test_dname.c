@@ -17,9 +17,11 @@
 #include <assert.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <tap/basic.h>
 
 #include "libknot/dname.h"
+#include "contrib/tolower.h"
 
 /* Test dname_parse_from_wire */
 static int test_fw(size_t l, const char *w) {
@@ -158,6 +160,68 @@ static void test_dname_storage(void)
 	   "knot_dname_storage: valid name");
 }
 
+static void test_tolower_impl(const struct knot_tolower_api *api, const char *name)
+{
+	uint8_t src[300], dst[300], ref[300];
+	for (size_t i = 0; i < sizeof(src); i++) {
+		src[i] = i * 7 + 13; // covers all byte values
+	}
+
+	bool copy_ok = true, equal_ok = true;
+	for (size_t len = 0; len <= 260; len++) {
+		for (size_t i = 0; i < len; i++) {
+			ref[i] = knot_tolower(src[i]);
+		}
+		memset(dst, 0xAB, sizeof(dst));
+		api->copy(dst, src, len);
+		copy_ok = copy_ok && memcmp(dst, ref, len) == 0 && dst[len] == 0xAB;
+
+		equal_ok = equal_ok && api->equal(src, ref, len) && api->equal(ref, src, len);
+		if (len > 0) {
+			// Differ in a letter only in case -> equal; otherwise not.
+			ref[len - 1] = 'q';
+			dst[len - 1] = 'Q';
+			equal_ok = equal_ok && api->equal(ref, dst, len);
+			dst[len - 1] = 'r';
+			equal_ok = equal_ok && !api->equal(ref, dst, len);
+		}
+	}
+	ok(copy_ok, "%s: lowercase copy", name);
+	ok(equal_ok, "%s: case-insensitive equality", name);
+
+	// Lowercasing in place, non-letters around the letter ranges.
+	uint8_t inplace[] = "@AZ[`az{\xC1\xDA@AZ[`az{\xC1\xDA@AZ[`az{\xC1\xDA@AZ[`az{";
+	api->copy(inplace, inplace, sizeof(inplace) - 1);
+	ok(memcmp(inplace, "@az[`az{\xC1\xDA@az[`az{\xC1\xDA@az[`az{\xC1\xDA@az[`az{",
+	          sizeof(inplace)) == 0, "%s: lowercase in place", name);
+
+	// Rough throughput on typical names, just for information.
+	const knot_dname_t *names[] = {
+		(const uint8_t *)"\x03www\x07Example\x03COM",
+		(const uint8_t *)"\x0a_dmarc-Long\x0fSubdomain-LABEL\x07example\x03org",
+	};
+	clock_t start = clock();
+	size_t total = 0;
+	for (unsigned i = 0; i < 1000000; i++) {
+		const knot_dname_t *n = names[i % 2];
+		size_t size = knot_dname_size(n);
+		api->copy(dst, n, size);
+		total += api->equal(dst, n, size);
+	}
+	diag("%s: %zu names lowercased and compared in %.0f ms", name, total,
+	     (double)(clock() - start) * 1000 / CLOCKS_PER_SEC);
+}
+
+static void test_tolower(void)
+{
+	test_tolower_impl(&KNOT_TOLOWER_GENERIC, "generic");
+	if (KNOT_TOLOWER_AVX2.copy != NULL && __builtin_cpu_supports("avx2")) {
+		test_tolower_impl(&KNOT_TOLOWER_AVX2, "AVX2");
+	} else {
+		diag("AVX2 NOT available");
+	}
+}
+
 int main(int argc, char *argv[])
 {
 	plan_lazy();
@@ -614,5 +678,7 @@ int main(int argc, char *argv[])
 
 	test_dname_storage();
 
+	test_tolower();
+
 	return 0;
 }
@@ -64,6 +64,113 @@ static void packet_match(knot_pkt_t *in, knot_pkt_t *out)
 	is_int(NAMECOUNT, rr_matched, "pkt: RR content match");
 }
 
+/*! \brief Fill the packet with NS records of alternating subdomains. */
+static int compr_fill(knot_pkt_t *pkt, unsigned count)
+{
+	int ret = knot_pkt_put_question(pkt, (const uint8_t *)"\x07""example""\x03""com",
+	                                KNOT_CLASS_IN, KNOT_RRTYPE_AXFR);
+	for (unsigned i = 0; i < count && ret == KNOT_EOK; i++) {
+		char owner[64], target[64];
+		(void)snprintf(owner, sizeof(owner), "h%u.sub%u.example.com.", i, i % 3);
+		(void)snprintf(target, sizeof(target), "ns%u.sub%u.example.com.", i % 5, (i + 1) % 3);
+		knot_dname_storage_t owner_bin, target_bin;
+		(void)knot_dname_from_str(owner_bin, owner, sizeof(owner_bin));
+		(void)knot_dname_from_str(target_bin, target, sizeof(target_bin));
+
+		knot_rrset_t *rr = knot_rrset_new(owner_bin, KNOT_RRTYPE_NS, KNOT_CLASS_IN,
+		                                  TTL, &pkt->mm);
+		(void)knot_rrset_add_rdata(rr, target_bin, knot_dname_size(target_bin), &pkt->mm);
+		ret = knot_pkt_put(pkt, KNOT_COMPR_HINT_NONE, rr, KNOT_PF_FREE | KNOT_PF_NOTRUNC);
+		if (ret != KNOT_EOK) {
+			knot_rrset_free(rr, &pkt->mm);
+		}
+	}
+
+	return ret;
+}
+
+static bool compr_parse_match(knot_pkt_t *out)
+{
+	knot_pkt_t *in = knot_pkt_new(out->wire, out->size, &out->mm);
+	bool match = (knot_pkt_parse(in, 0) == KNOT_EOK) &&
+	             (in->rrset_count == out->rrset_count);
+	for (unsigned i = 0; match && i < out->rrset_count; i++) {
+		match = knot_rrset_equal(&in->rr[i], &out->rr[i], true);
+	}
+	knot_pkt_free(in);
+
+	return match;
+}
+
+static void test_compr_table(knot_mm_t *mm)
+{
+	const unsigned count = 300;
+
+	knot_pkt_t *plain = knot_pkt_new(NULL, KNOT_WIRE_MAX_PKTSIZE, mm);
+	int ret = compr_fill(plain, count);
+	is_int(KNOT_EOK, ret, "pkt: compression without table");
+	ok(compr_parse_match(plain), "pkt: parse without table");
+
+	knot_pkt_t *table = knot_pkt_new(NULL, KNOT_WIRE_MAX_PKTSIZE, mm);
+	ret = knot_pkt_init_compr_table(table);
+	is_int(KNOT_EOK, ret, "pkt: init compression table");
+	ret = compr_fill(table, count);
+	is_int(KNOT_EOK, ret, "pkt: compression with table");
+	ok(compr_parse_match(table), "pkt: parse with table");
+	ok(table->size < plain->size, "pkt: table compresses better (%zu < %zu)",
+	   table->size, plain->size);
+
+	/* Suffixes of a partially written RRSet must not be reused. */
+	knot_pkt_t *small = knot_pkt_new(NULL, 1024, mm);
+	(void)knot_pkt_init_compr_table(small);
+	small->max_size = 512;
+	ret = compr_fill(small, count);
+	is_int(KNOT_ESPACE, ret, "pkt: fill small packet with table");
+	small->max_size = 1024;
+	knot_rrset_t *a = knot_rrset_new((const uint8_t *)"\x02""h0""\x04""sub0""\x07""example""\x03""com",
+	                                 KNOT_RRTYPE_A, KNOT_CLASS_IN, TTL, &small->mm);
+	(void)knot_rrset_add_rdata(a, RDVAL(0), RDLEN(0), &small->mm);
+	ret = knot_pkt_put(small, KNOT_COMPR_HINT_NONE, a, KNOT_PF_FREE);
+	is_int(KNOT_EOK, ret, "pkt: put after failed put with table");
+	ok(compr_parse_match(small), "pkt: parse small packet with table");
+
+	/* Failed put releases the table capacity it used. */
+	uint16_t mark = small->compr.table->count;
+	small->max_size = small->size + 22;
+	knot_rrset_t *ns = knot_rrset_new((const uint8_t *)"\x02""h1""\x04""sub9""\x07""example""\x03""com",
+	                                  KNOT_RRTYPE_NS, KNOT_CLASS_IN, TTL, &small->mm);
+	(void)knot_rrset_add_rdata(ns, (const uint8_t *)"\x03""ns1""\x04""sub9""\x07""example""\x03""com",
+	                           22, &small->mm);
+	ret = knot_pkt_put(small, KNOT_COMPR_HINT_NONE, ns, KNOT_PF_NOTRUNC);
+	is_int(KNOT_ESPACE, ret, "pkt: failed put with table");
+	is_int(mark, small->compr.table->count, "pkt: table rolled back after failed put");
+	knot_rrset_free(ns, &small->mm);
+	small->max_size = 1024;
+
+	/* Cleared packet starts with an empty table. */
+	knot_pkt_clear(small);
+	ok(small->compr.table->count == 0, "pkt: table cleared with packet");
+
+	/* Wire without a question doesn't seed the table. */
+	uint8_t wire[256] = { 0 };
+	memcpy(wire + KNOT_WIRE_HEADER_SIZE, "\x01""x", 3);
+	knot_rrinfo_t info = { 0 };
+	knot_compr_table_t noqd = { .count = 0 };
+	knot_compr_t compr = { .wire = wire, .rrinfo = &info, .table = &noqd };
+	knot_rrset_t *b = knot_rrset_new((const uint8_t *)"\x02""h0""\x07""example""\x03""com",
+	                                 KNOT_RRTYPE_A, KNOT_CLASS_IN, TTL, mm);
+	(void)knot_rrset_add_rdata(b, RDVAL(0), RDLEN(0), mm);
+	ret = knot_rrset_to_wire(b, wire + KNOT_WIRE_HEADER_SIZE,
+	                         sizeof(wire) - KNOT_WIRE_HEADER_SIZE, &compr);
+	ok(ret > 0, "pkt: write without question with table");
+	is_int(3, noqd.count, "pkt: only owner suffixes stored without question");
+	knot_rrset_free(b, mm);
+
+	knot_pkt_free(small);
+	knot_pkt_free(table);
+	knot_pkt_free(plain);
+}
+
 int main(int argc, char *argv[])
 {
 	plan_lazy();
@@ -193,6 +300,9 @@ int main(int argc, char *argv[])
 		knot_rrset_free(rrsets[i], NULL);
 	}
 	free(tsig_key.secret.data);
+
+	test_compr_table(&mm);
+
 	mp_delete((struct mempool *)mm.ctx);
 
 	return 0;
@@ -0,0 +1,144 @@
+/*  Copyright (C) 2024 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <tap/basic.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "libzscanner/scanner.h"
+
+#define MAX_RECORDS 64
+
+static const char zone[] =
+	"$TTL 100\n"
+	"@ SOA ns admin 1 2 3 4 5\n"
+	"  NS ns\n"
+	"ns A 192.0.2.1\n"
+	"txt TXT \"quoted ; ( text\" ; comment (\n"
+	"multi TXT ( a\n"
+	"b\n"
+	"c ) ; end\n"
+	"$ORIGIN sub.example.\n"
+	"a 200 A 192.0.2.2\n"
+	"  AAAA ::1\n"
+	"b A 192.0.2.3\n"
+	"$TTL 300\n"
+	"c A 192.0.2.4\n"
+	"d TXT ( \"x\"\n"
+	"  \"y\" )\n"
+	"e A 192.0.2.5\n";
+
+typedef struct {
+	uint8_t owner[ZS_MAX_DNAME_LENGTH];
+	uint32_t owner_length;
+	uint16_t type;
+	uint32_t ttl;
+	uint64_t line;
+} record_t;
+
+typedef struct {
+	record_t records[MAX_RECORDS];
+	size_t count;
+} records_t;
+
+static void store_record(zs_scanner_t *s)
+{
+	records_t *r = s->process.data;
+	if (r->count < MAX_RECORDS) {
+		record_t *rec = &r->records[r->count++];
+		memcpy(rec->owner, s->r_owner, s->r_owner_length);
+		rec->owner_length = s->r_owner_length;
+		rec->type = s->r_type;
+		rec->ttl = s->r_ttl;
+		rec->line = s->line_counter;
+	}
+}
+
+static int parse(const zs_chunk_t *chunk, records_t *records)
+{
+	zs_scanner_t s;
+	int ret = zs_init(&s, "example.", 1, 3600);
+	if (ret == 0) {
+		ret = zs_set_processing(&s, store_record, NULL, records);
+	}
+	if (ret == 0) {
+		ret = (chunk != NULL) ? zs_set_input_chunk(&s, chunk) :
+		                        zs_set_input_string(&s, zone, strlen(zone));
+	}
+	if (ret == 0) {
+		ret = zs_parse_all(&s);
+	}
+	zs_deinit(&s);
+
+	return ret;
+}
+
+static bool records_equal(const records_t *a, const records_t *b)
+{
+	if (a->count != b->count) {
+		return false;
+	}
+	for (size_t i = 0; i < a->count; i++) {
+		const record_t *x = &a->records[i], *y = &b->records[i];
+		if (x->owner_length != y->owner_length ||
+		    memcmp(x->owner, y->owner, x->owner_length) != 0 ||
+		    x->type != y->type || x->ttl != y->ttl || x->line != y->line) {
+			return false;
+		}
+	}
+	return true;
+}
+
+int main(int argc, char *argv[])
+{
+	plan_lazy();
+
+	records_t serial = { 0 };
+	ok(parse(NULL, &serial) == 0 && serial.count == 11, "serial parsing");
+
+	zs_chunk_t chunks[16];
+	ok(zs_split_input(zone, strlen(zone), chunks, 1) == 1 &&
+	   chunks[0].start == zone && chunks[0].size == strlen(zone),
+	   "split into one chunk");
+
+	for (size_t max = 2; max <= 16; max *= 2) {
+		size_t count = zs_split_input(zone, strlen(zone), chunks, max);
+		ok(count > 1 && count <= max, "split into %zu chunks (max %zu)", count, max);
+
+		bool contiguous = true;
+		const char *pos = zone;
+		for (size_t i = 0; i < count; i++) {
+			contiguous = contiguous && chunks[i].start == pos;
+			pos += chunks[i].size;
+		}
+		ok(contiguous && pos == zone + strlen(zone), "chunks cover the input");
+
+		records_t parallel = { 0 };
+		int ret = 0;
+		for (size_t i = 0; i < count && ret == 0; i++) {
+			ret = parse(&chunks[i], &parallel);
+		}
+		ok(ret == 0 && records_equal(&serial, &parallel),
+		   "chunked parsing matches serial parsing (max %zu)", max);
+	}
+
+	static const char include[] = "a A 192.0.2.1\n$INCLUDE file\nb A 192.0.2.2\n";
+	ok(zs_split_input(include, strlen(include), chunks, 4) == 1,
+	   "no split with include");
+
+	return 0;
+}